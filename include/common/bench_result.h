@@ -3,10 +3,18 @@
 #include <boost/json.hpp>
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 class bench_result {
 private:
+  // the New-Order transactions committed per minute, as tpmC of TPC-C, or
+  // all the transactions of a workload without New-Order
   float tpm_;
+  // all the transactions committed per minute
+  float tpm_total_{};
+  // the arrival rate of the open loop mode, 0 in the closed loop mode
+  float offered_tps_{};
   float abort_;
   float latency_;
   float latency_read_{};
@@ -15,12 +23,18 @@ private:
   float latency_replicate_{};
   float latency_lock_wait_{};
   float latency_part_{};
+  // the latency percentiles in milliseconds, e.g. "lt_p99"
+  std::vector<std::pair<std::string, float>> latency_percentile_;
 
 public:
   bench_result() : tpm_(0), abort_(0), latency_(0) {}
 
   void set_tpm(float tpm) { tpm_ = tpm; }
 
+  void set_tpm_total(float tpm) { tpm_total_ = tpm; }
+
+  void set_offered_tps(float tps) { offered_tps_ = tps; }
+
   void set_latency(float latency) { latency_ = latency; }
 
   void set_latency_read(float v) { latency_read_ = v; }
@@ -35,9 +49,18 @@ public:
 
   void set_latency_part(float v) { latency_part_ = v; }
 
+  void add_latency_percentile(const std::string &key, float v) {
+    latency_percentile_.emplace_back(key, v);
+  }
+
   [[nodiscard]] boost::json::object to_json() const {
     boost::json::object obj;
     obj["tpm"] = tpm_;
+    obj["tpm_total"] = tpm_total_;
+    // the offered load and the achieved throughput, which is lower when the
+    // system is saturated
+    obj["offered_tps"] = offered_tps_;
+    obj["tps"] = tpm_total_ / 60;
     obj["abort"] = abort_;
     obj["lt"] = latency_;
     obj["lt_read"] = latency_read_;
@@ -46,8 +69,11 @@ public:
     obj["lt_app_rlb"] = latency_replicate_;
     obj["lt_lock"] = latency_lock_wait_;
     obj["lt_part"] = latency_part_;
+    for (const auto &kv : latency_percentile_) {
+      obj[kv.first] = kv.second;
+    }
     return obj;
   }
 
-  [[nodiscard]] float_t tps() const { return (float_t) (tpm_/60.0); }
+  [[nodiscard]] float_t tps() const { return (float_t) (tpm_total_/60.0); }
 };
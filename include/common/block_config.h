@@ -27,6 +27,23 @@ private:
 
   uint64_t append_log_entries_batch_min_;
   uint64_t append_log_entries_batch_max_;
+  uint64_t append_log_batch_bytes_max_;
+  uint64_t append_log_batch_deadline_us_;
+  uint64_t append_log_inflight_max_;
+  uint64_t append_log_credit_bytes_;
+  uint64_t append_log_pending_bytes_max_;
+  uint64_t snapshot_chunk_bytes_;
+  uint64_t snapshot_chunk_inflight_;
+  uint64_t warm_up_chunk_bytes_;
+  uint64_t warm_up_chunk_inflight_;
+  bool send_coalesce_;
+  uint64_t send_coalesce_delay_us_;
+  bool thread_per_core_;
+  // 0 for default
+  uint64_t num_cores_;
+  bool shm_transport_;
+  std::string wan_compress_;
+  uint64_t wan_compress_min_bytes_;
 
 public:
   block_config();
@@ -83,5 +100,61 @@ public:
     return append_log_entries_batch_max_;
   }
 
+  [[nodiscard]] uint64_t append_log_batch_bytes_max() const {
+    return append_log_batch_bytes_max_;
+  }
+
+  [[nodiscard]] uint64_t append_log_batch_deadline_us() const {
+    return append_log_batch_deadline_us_;
+  }
+
+  [[nodiscard]] uint64_t append_log_inflight_max() const {
+    return append_log_inflight_max_;
+  }
+
+  [[nodiscard]] uint64_t append_log_credit_bytes() const {
+    return append_log_credit_bytes_;
+  }
+
+  [[nodiscard]] uint64_t append_log_pending_bytes_max() const {
+    return append_log_pending_bytes_max_;
+  }
+
+  [[nodiscard]] uint64_t snapshot_chunk_bytes() const {
+    return snapshot_chunk_bytes_;
+  }
+
+  [[nodiscard]] uint64_t snapshot_chunk_inflight() const {
+    return snapshot_chunk_inflight_;
+  }
+
+  [[nodiscard]] uint64_t warm_up_chunk_bytes() const {
+    return warm_up_chunk_bytes_;
+  }
+
+  [[nodiscard]] uint64_t warm_up_chunk_inflight() const {
+    return warm_up_chunk_inflight_;
+  }
+
+  [[nodiscard]] bool send_coalesce() const { return send_coalesce_; }
+
+  [[nodiscard]] uint64_t send_coalesce_delay_us() const {
+    return send_coalesce_delay_us_;
+  }
+
+  [[nodiscard]] bool thread_per_core() const { return thread_per_core_; }
+
+  [[nodiscard]] uint64_t num_cores() const { return num_cores_; }
+
+  [[nodiscard]] bool shm_transport() const { return shm_transport_; }
+
+  [[nodiscard]] const std::string &wan_compress() const {
+    return wan_compress_;
+  }
+
+  [[nodiscard]] uint64_t wan_compress_min_bytes() const {
+    return wan_compress_min_bytes_;
+  }
+
   void from_json(boost::json::object &obj);
 };
\ No newline at end of file
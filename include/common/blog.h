@@ -0,0 +1,197 @@
+#pragma once
+
+#include "common/enum_str.h"
+#include "common/id.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// a binary logger for the hot paths;
+// BLOG(level, format, args...) copies its arguments to a lock-free ring of
+// the thread, a background thread formats them, an argument for every "{}"
+// of format, and writes them to Boost.Log, so a thread never formats or
+// waits for a sink;
+// the levels below BLOG_MIN_LEVEL are compiled out, their arguments are not
+// evaluated, the levels below the runtime level cost a relaxed load;
+// a record is dropped, and counted, when the ring of its thread is full
+//
+// an argument is an integer, a floating point, a bool, a string, an enum
+// which has enum_strings, or a node id wrapped in blog_node, which is
+// formatted by id_2_name in the background
+
+#define BLOG_LEVEL_trace 0
+#define BLOG_LEVEL_debug 1
+#define BLOG_LEVEL_info 2
+#define BLOG_LEVEL_warning 3
+#define BLOG_LEVEL_error 4
+#define BLOG_LEVEL_fatal 5
+
+// -DBLOG_MIN_LEVEL=0 builds the trace and debug records in
+#ifndef BLOG_MIN_LEVEL
+#define BLOG_MIN_LEVEL BLOG_LEVEL_info
+#endif
+
+#define BLOG(level, format, ...)                                               \
+  do {                                                                         \
+    if constexpr (BLOG_LEVEL_##level >= BLOG_MIN_LEVEL) {                      \
+      if (blog_enabled(BLOG_LEVEL_##level)) {                                  \
+        static constexpr blog_site _blog_site{BLOG_LEVEL_##level, format,      \
+                                              __FILE__, __LINE__};             \
+        blog_record(&_blog_site __VA_OPT__(, ) __VA_ARGS__);                   \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+struct blog_site {
+  int level_;
+  const char *format_;
+  const char *file_;
+  int line_;
+};
+
+struct blog_node {
+  node_id_t id_;
+
+  explicit blog_node(node_id_t id) : id_(id) {}
+};
+
+enum blog_tag : uint8_t {
+  BLOG_TAG_I64 = 0,
+  BLOG_TAG_U64,
+  BLOG_TAG_F64,
+  BLOG_TAG_BOOL,
+  BLOG_TAG_STR,
+  BLOG_TAG_ENUM,
+  BLOG_TAG_NODE,
+};
+
+typedef std::string (*blog_enum_fn)(int64_t);
+
+// a record is 8 bytes aligned in a ring
+struct blog_header {
+  uint32_t size_;
+  // the bytes of the arguments, BLOG_PAD_MARKER for the padding to the end
+  // of a ring, of which only size_ and args_ are written
+  uint32_t args_;
+  const blog_site *site_;
+  uint64_t ts_ns_;
+};
+
+const uint32_t BLOG_PAD_MARKER = UINT32_MAX;
+
+extern std::atomic<int> blog_runtime_level;
+
+// the runtime level, of BLOG and of Boost.Log
+void blog_set_level(int level);
+
+// the level of a name, trace, debug, info, warning, error or fatal
+int blog_level_of(const std::string &name);
+
+inline int blog_level() {
+  return blog_runtime_level.load(std::memory_order_relaxed);
+}
+
+inline bool blog_enabled(int level) { return level >= blog_level(); }
+
+// a contiguous space of size bytes in the ring of this thread, nullptr if
+// the ring is full
+char *blog_reserve(uint32_t size);
+
+void blog_commit(uint32_t size);
+
+// write the records of all the threads, and wait for them to be written
+void blog_flush();
+
+// stop the background thread after the records are written, called at exit
+void blog_stop();
+
+// the records dropped because a ring was full
+uint64_t blog_dropped();
+
+// the rings allocated, exposed for the tests
+size_t blog_num_rings();
+
+template<class T> std::string blog_enum_str(int64_t v) {
+  return enum2str(T(v));
+}
+
+template<class T> uint32_t blog_arg_size(const T &v) {
+  typedef std::decay_t<T> D;
+  if constexpr (std::is_same_v<D, blog_node>) {
+    return 1 + sizeof(node_id_t);
+  } else if constexpr (std::is_same_v<D, bool>) {
+    return 2;
+  } else if constexpr (std::is_enum_v<D>) {
+    return 1 + sizeof(int64_t) + sizeof(blog_enum_fn);
+  } else if constexpr (std::is_arithmetic_v<D>) {
+    return 1 + 8;
+  } else {
+    return 1 + sizeof(uint32_t) + uint32_t(std::string_view(v).size());
+  }
+}
+
+template<class T> void blog_put(char *&p, const T &v) {
+  typedef std::decay_t<T> D;
+  if constexpr (std::is_same_v<D, blog_node>) {
+    *p++ = char(BLOG_TAG_NODE);
+    std::memcpy(p, &v.id_, sizeof(node_id_t));
+    p += sizeof(node_id_t);
+  } else if constexpr (std::is_same_v<D, bool>) {
+    *p++ = char(BLOG_TAG_BOOL);
+    *p++ = char(v ? 1 : 0);
+  } else if constexpr (std::is_enum_v<D>) {
+    *p++ = char(BLOG_TAG_ENUM);
+    int64_t i = int64_t(v);
+    blog_enum_fn fn = &blog_enum_str<D>;
+    std::memcpy(p, &i, sizeof(i));
+    p += sizeof(i);
+    std::memcpy(p, &fn, sizeof(fn));
+    p += sizeof(fn);
+  } else if constexpr (std::is_floating_point_v<D>) {
+    *p++ = char(BLOG_TAG_F64);
+    double d = double(v);
+    std::memcpy(p, &d, sizeof(d));
+    p += sizeof(d);
+  } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+    *p++ = char(BLOG_TAG_I64);
+    int64_t i = int64_t(v);
+    std::memcpy(p, &i, sizeof(i));
+    p += sizeof(i);
+  } else if constexpr (std::is_integral_v<D>) {
+    *p++ = char(BLOG_TAG_U64);
+    uint64_t u = uint64_t(v);
+    std::memcpy(p, &u, sizeof(u));
+    p += sizeof(u);
+  } else {
+    std::string_view s(v);
+    uint32_t n = uint32_t(s.size());
+    *p++ = char(BLOG_TAG_STR);
+    std::memcpy(p, &n, sizeof(n));
+    p += sizeof(n);
+    std::memcpy(p, s.data(), n);
+    p += n;
+  }
+}
+
+uint64_t blog_now_ns();
+
+template<class... ARGS>
+void blog_record(const blog_site *site, const ARGS &...args) {
+  uint32_t args_size = (0 + ... + blog_arg_size(args));
+  uint32_t size = (uint32_t(sizeof(blog_header)) + args_size + 7) & ~7u;
+  char *p = blog_reserve(size);
+  if (p == nullptr) {
+    return;
+  }
+  blog_header header{size, args_size, site, blog_now_ns()};
+  std::memcpy(p, &header, sizeof(header));
+  [[maybe_unused]] char *a = p + sizeof(header);
+  (blog_put(a, args), ...);
+  blog_commit(size);
+}
+
+// format a record, exposed for the tests
+std::string blog_format(const char *format, const char *args, size_t size);
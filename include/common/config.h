@@ -7,6 +7,7 @@
 #include "common/schema_mgr.h"
 #include "common/test_config.h"
 #include "common/tpcc_config.h"
+#include "common/ycsb_config.h"
 #include <boost/json.hpp>
 #include <fstream>
 #include <iostream>
@@ -23,6 +24,7 @@ class config {
 private:
   node_config node_conf_;
   tpcc_config tpcc_config_;
+  ycsb_config ycsb_config_;
   block_config block_config_;
   std::vector<node_config> node_client_list_;
   // the order of node_config in each node would be consistent
@@ -105,6 +107,10 @@ public:
 
   tpcc_config &mutable_tpcc_config() { return tpcc_config_; };
 
+  const ycsb_config &get_ycsb_config() const { return ycsb_config_; }
+
+  ycsb_config &mutable_ycsb_config() { return ycsb_config_; }
+
   const std::vector<node_config> &node_client_list() const { return node_client_list_; }
 
   std::vector<node_config> &mutable_client_config() { return node_client_list_; };
@@ -3,16 +3,27 @@
 #include <boost/regex.hpp>
 
 static const boost::regex url_message_count{"/msg_count.*"};
+static const boost::regex url_compress{"/compress"};
+// the registered metrics in the Prometheus text format
+static const boost::regex url_metrics{"/metrics"};
+// the spans of the sampled transactions as Chrome trace events, of the last
+// TX_SPAN_WINDOW_MILLIS or the given milliseconds
+static const boost::regex url_trace{"/trace(/\\d+)?"};
+static const boost::regex url_trace_ms{"/trace/(\\d+)"};
 
 static const boost::regex url_json_prefix{"/json/.*"};
 static const boost::regex url_dep{"/json/dep.*"};
 static const boost::regex url_lock{"/lock.*"};
+// the keys of the most lock waits of every table
+static const boost::regex url_hot_key{"/hot_key"};
+static const boost::regex url_json_hot_key{"/json/hot_key"};
 static const boost::regex url_tx{"/tx_rm"};
 static const boost::regex url_tx_xid{"/tx_rm/(\\d+)"};
 
 static const boost::regex url_log{"/log"};
 static const boost::regex url_log_xid{"/log/(\\d+)"};
 static const boost::regex url_log_offset{"/log_offset"};
+static const boost::regex url_log_batch{"/log_batch"};
 
 static const boost::regex url_deadlock{"/deadlock"};
 static const boost::regex url_json_deadlock{"/json/deadlock"};
\ No newline at end of file
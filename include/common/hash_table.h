@@ -2,26 +2,107 @@
 
 #include <boost/functional/hash.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <list>
 #include <mutex>
+#include <string_view>
 #include <tbb/concurrent_hash_map.h>
+#include <tbb/version.h>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
-template<class KEY> struct MyHashCompare {
+// the lookup distance of find_many, the buckets of the keys this far ahead
+// are prefetched, and the nodes of the keys half this far ahead
+const size_t HASH_TABLE_PREFETCH_DISTANCE = 8;
 
-  inline static size_t hash(const KEY &x) { return boost::hash_value(x); }
+// hash compare of concurrent_hash_table, transparent to the keys which
+// compare equal to KEY, e.g. std::string_view of std::string keys
+template<class KEY> struct table_hash_compare {
+  typedef void is_transparent;
+
+  // an integral key of another type is converted to KEY, so its
+  // comparison does not mix signedness
+  template<class K> static decltype(auto) as_key(const K &x) {
+    if constexpr (std::is_arithmetic_v<KEY> && std::is_arithmetic_v<K>) {
+      return static_cast<KEY>(x);
+    } else {
+      return (x);
+    }
+  }
+
+  template<class K> size_t hash(const K &x) const {
+    if constexpr (std::is_convertible_v<const KEY &, std::string_view> &&
+                  std::is_convertible_v<const K &, std::string_view>) {
+      return std::hash<std::string_view>()(std::string_view(x));
+    } else {
+      return std::hash<KEY>()(static_cast<KEY>(x));
+    }
+  }
 
   //! True if keys are equal
-  inline static bool equal(const KEY &x, const KEY &y) { return x==y; }
+  template<class K1, class K2> bool equal(const K1 &x, const K2 &y) const {
+    return as_key(x)==as_key(y);
+  }
 };
 
+// the visitors of concurrent_hash_table are template parameters invoked
+// directly, a lookup builds no std::function
 template<class KEY, class VALUE> class concurrent_hash_table {
 private:
-  typedef tbb::concurrent_hash_map<KEY, VALUE> tbb_hash_map;
+  // exposes the buckets of tbb::concurrent_hash_map to prefetch them
+  class tbb_hash_map
+      : public tbb::concurrent_hash_map<KEY, VALUE, table_hash_compare<KEY>> {
+  private:
+#if TBB_VERSION_MAJOR >= 2021
+    auto bucket_of(size_t hash) const {
+      return this->get_bucket(hash &
+                              this->my_mask.load(std::memory_order_acquire));
+    }
+#endif
+
+  public:
+    explicit tbb_hash_map(size_t size)
+        : tbb::concurrent_hash_map<KEY, VALUE, table_hash_compare<KEY>>(size) {}
+
+    template<class K> size_t hash(const K &key) const {
+      return this->my_hash_compare.hash(key);
+    }
+
+    // the bucket of a hash, and then the first node of the bucket
+    void prefetch_bucket(size_t hash) const {
+#if TBB_VERSION_MAJOR >= 2021
+      __builtin_prefetch(bucket_of(hash));
+#endif
+    }
+
+    void prefetch_node(size_t hash) const {
+#if TBB_VERSION_MAJOR >= 2021
+      __builtin_prefetch(
+          bucket_of(hash)->node_list.load(std::memory_order_relaxed));
+#endif
+    }
+
+  };
+
   tbb_hash_map hash_map_;
 
+  // a visitor may be nullptr, or a null function pointer, which is not
+  // invoked
+  template<class FN, class... ARGS> static void visit(FN &&fn, ARGS &&...args) {
+    if constexpr (std::is_null_pointer_v<std::decay_t<FN>>) {
+      return;
+    } else if constexpr (std::is_pointer_v<std::decay_t<FN>>) {
+      if (fn) {
+        fn(std::forward<ARGS>(args)...);
+      }
+    } else {
+      fn(std::forward<ARGS>(args)...);
+    }
+  }
+
 private:
 public:
   concurrent_hash_table() : hash_map_(128) {}
@@ -32,9 +113,10 @@ public:
 
   // find if exist
   // insert if absent
-  std::pair<VALUE, bool>
-  find_or_insert(KEY item, std::function<void(VALUE &value)> fn_if_exist,
-                 std::function<VALUE()> fn_if_absent) {
+  template<class K, class FN_IF_EXIST, class FN_IF_ABSENT>
+  std::pair<VALUE, bool> find_or_insert(const K &item,
+                                        FN_IF_EXIST &&fn_if_exist,
+                                        FN_IF_ABSENT &&fn_if_absent) {
     typename tbb_hash_map::accessor accessor;
     auto is_new = this->hash_map_.insert(accessor, item);
     if (is_new) {
@@ -43,12 +125,12 @@ public:
       return std::make_pair(value, false);
     } else {
       VALUE value = accessor->second;
-      fn_if_exist(accessor->second);
+      visit(fn_if_exist, accessor->second);
       return std::make_pair(value, true);
     }
   }
 
-  std::pair<VALUE, bool> find(KEY item) {
+  template<class K> std::pair<VALUE, bool> find(const K &item) {
     typename tbb_hash_map::const_accessor accessor;
     bool found = this->hash_map_.find(accessor, item);
     if (found) {
@@ -58,17 +140,64 @@ public:
     }
   }
 
-  bool find(KEY item, std::function<void(VALUE value)> fn_if_exist) {
+  template<class K, class FN_IF_EXIST>
+  bool find(const K &item, FN_IF_EXIST &&fn_if_exist) {
     typename tbb_hash_map::const_accessor accessor;
     bool found = this->hash_map_.find(accessor, item);
     if (found) {
-      fn_if_exist(accessor->second);
+      visit(fn_if_exist, accessor->second);
+      return true;
     } else {
       return false;
     }
   }
 
-  bool insert(KEY item, std::function<VALUE()> fn_if_absent) {
+  // find the keys of [begin, end), fn_if_exist(index, value) for the keys
+  // found, return the number of the keys found;
+  // the buckets and the nodes of the keys ahead are prefetched while
+  // looking up a key
+  template<class ITER, class FN_IF_EXIST>
+  size_t find_many(ITER begin, ITER end, FN_IF_EXIST &&fn_if_exist) {
+    const size_t distance = HASH_TABLE_PREFETCH_DISTANCE;
+    size_t n = size_t(std::distance(begin, end));
+    std::vector<size_t> hashes;
+    hashes.reserve(n);
+    for (ITER i = begin; i!=end; ++i) {
+      hashes.push_back(this->hash_map_.hash(*i));
+    }
+    for (size_t i = 0; i < n && i < distance; i++) {
+      this->hash_map_.prefetch_bucket(hashes[i]);
+      if (i < distance / 2) {
+        this->hash_map_.prefetch_node(hashes[i]);
+      }
+    }
+    size_t found = 0;
+    typename tbb_hash_map::const_accessor accessor;
+    ITER iter = begin;
+    for (size_t i = 0; i < n; i++, ++iter) {
+      if (i + distance < n) {
+        this->hash_map_.prefetch_bucket(hashes[i + distance]);
+      }
+      if (i + distance / 2 < n) {
+        this->hash_map_.prefetch_node(hashes[i + distance / 2]);
+      }
+      if (this->hash_map_.find(accessor, *iter)) {
+        found++;
+        visit(fn_if_exist, i, accessor->second);
+        accessor.release();
+      }
+    }
+    return found;
+  }
+
+  template<class KEYS, class FN_IF_EXIST>
+  size_t find_many(const KEYS &keys, FN_IF_EXIST &&fn_if_exist) {
+    return find_many(std::begin(keys), std::end(keys),
+                     std::forward<FN_IF_EXIST>(fn_if_exist));
+  }
+
+  template<class K, class FN_IF_ABSENT>
+  bool insert(const K &item, FN_IF_ABSENT &&fn_if_absent) {
     typename tbb_hash_map::accessor accessor;
     auto is_new = this->hash_map_.insert(accessor, item);
     if (is_new) {
@@ -79,7 +208,7 @@ public:
     }
   }
 
-  bool insert(KEY item, VALUE &value) {
+  template<class K> bool insert(const K &item, VALUE &value) {
     typename tbb_hash_map::accessor accessor;
     auto is_new = this->hash_map_.insert(accessor, item);
     if (is_new) {
@@ -90,20 +219,37 @@ public:
     }
   }
 
-  bool remove(KEY item, std::function<void(VALUE value)> fn_if_exist) {
+  template<class K> bool remove(const K &item) {
+    return this->hash_map_.erase(item);
+  }
+
+  template<class K, class FN_IF_EXIST>
+  bool remove(const K &item, FN_IF_EXIST &&fn_if_exist) {
     typename tbb_hash_map::const_accessor accessor;
     bool found = this->hash_map_.find(accessor, item);
     if (found) {
-      if (fn_if_exist) {
-        fn_if_exist(accessor->second);
-      }
+      visit(fn_if_exist, accessor->second);
+      this->hash_map_.erase(accessor);
       return true;
     } else {
       return false;
     }
   }
 
-  void traverse(std::function<void(KEY, VALUE)> fn_key_value) {
+  // remove the item only if fn_pred returns true on its value
+  template<class K, class FN_PRED>
+  bool remove_if(const K &item, FN_PRED &&fn_pred) {
+    typename tbb_hash_map::accessor accessor;
+    bool found = this->hash_map_.find(accessor, item);
+    if (found && fn_pred(accessor->second)) {
+      this->hash_map_.erase(accessor);
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  template<class FN_KEY_VALUE> void traverse(FN_KEY_VALUE &&fn_key_value) {
     for (auto i = this->hash_map_.begin(); i!=this->hash_map_.end(); ++i) {
       fn_key_value(i->first, i->second);
     }
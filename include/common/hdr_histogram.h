@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// a histogram of the values in [0, 2^36), with two significant decimal
+// digits, the log linear buckets of HdrHistogram: a value v >= 256 falls in
+// the bucket of its highest bit, split into 128 sub buckets
+class hdr_histogram {
+private:
+  static const uint32_t SUB_BUCKET_BITS = 8;
+  static const uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+  static const uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+  static const uint32_t MAX_BITS = 36;
+  static const uint64_t MAX_VALUE = (uint64_t(1) << MAX_BITS) - 1;
+
+  // allocated by the first record
+  std::vector<uint64_t> counts_;
+  uint64_t total_;
+  uint64_t max_;
+
+  static size_t index_of(uint64_t v) {
+    if (v < SUB_BUCKET_COUNT) {
+      return size_t(v);
+    }
+    uint32_t bucket = uint32_t(std::bit_width(v)) - SUB_BUCKET_BITS;
+    return size_t(SUB_BUCKET_COUNT + (bucket - 1) * SUB_BUCKET_HALF +
+                  (v >> bucket) - SUB_BUCKET_HALF);
+  }
+
+  // the highest value of the index
+  static uint64_t value_of(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+      return index;
+    }
+    uint64_t k = index - SUB_BUCKET_COUNT;
+    uint64_t bucket = k / SUB_BUCKET_HALF + 1;
+    uint64_t sub_bucket = k % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+    return (sub_bucket << bucket) + (uint64_t(1) << bucket) - 1;
+  }
+
+public:
+  static const size_t NUM_COUNTS =
+      SUB_BUCKET_COUNT + (MAX_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+  hdr_histogram() : total_(0), max_(0) {}
+
+  void record(uint64_t value) { add_at(index_of(std::min(value, MAX_VALUE)), 1); }
+
+  void add_at(size_t index, uint64_t count) {
+    if (index >= NUM_COUNTS || count == 0) {
+      return;
+    }
+    if (counts_.empty()) {
+      counts_.resize(NUM_COUNTS, 0);
+    }
+    counts_[index] += count;
+    total_ += count;
+    max_ = std::max(max_, value_of(index));
+  }
+
+  void add(const hdr_histogram &h) {
+    for (size_t i = 0; i < h.counts_.size(); i++) {
+      add_at(i, h.counts_[i]);
+    }
+  }
+
+  void reset() {
+    counts_.clear();
+    total_ = 0;
+    max_ = 0;
+  }
+
+  [[nodiscard]] uint64_t count() const { return total_; }
+
+  [[nodiscard]] uint64_t max() const { return max_; }
+
+  // the value which percentile (in [0, 100]) of the recorded values are
+  // less than or equal to
+  [[nodiscard]] uint64_t value_at_percentile(double percentile) const {
+    if (total_ == 0) {
+      return 0;
+    }
+    auto target = uint64_t(std::ceil(percentile / 100.0 * double(total_)));
+    target = std::clamp<uint64_t>(target, 1, total_);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+      sum += counts_[i];
+      if (sum >= target) {
+        return std::min(value_of(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  // fn(index, count) of the non zero counts
+  template<class FN> void for_each(FN &&fn) const {
+    for (size_t i = 0; i < counts_.size(); i++) {
+      if (counts_[i] != 0) {
+        fn(i, counts_[i]);
+      }
+    }
+  }
+};
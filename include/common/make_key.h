@@ -36,3 +36,19 @@ inline uint64_t make_order_line_key(uint64_t wid, uint64_t did, uint64_t oid,
       (num_order + 1)*(num_warehouse + 1)*
           (num_district_per_warehouse + 1)*olid;
 }
+
+// the history rows have no primary key, a terminal numbers its own rows
+inline uint64_t make_history_key(uint64_t terminal_id, uint64_t seq) {
+  return (terminal_id << 32) | seq;
+}
+
+// ds_block::load_order loads the orders first, first + num_warehouse, ...
+// up to num_order of every district of a warehouse
+inline uint64_t first_loaded_order_id(uint64_t wid, uint64_t num_order) {
+  return num_order % wid + 1;
+}
+
+// the loaded orders not delivered yet, they have rows in NEW_ORDER
+inline uint64_t first_undelivered_order_id(uint64_t num_order) {
+  return num_order * 7 / 10 + 1;
+}
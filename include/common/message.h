@@ -32,6 +32,8 @@ enum message_type {
   RAFT_PRE_VOTE_RESP,
   RAFT_TRANSFER_LEADER,
   RAFT_TRANSFER_NOTIFY,
+  RAFT_READ_INDEX_REQ,
+  RAFT_READ_INDEX_RESP,
 
   C2R_APPEND_LOG_REQ,
   C2R_REPLAY_LOG_RESP,
@@ -39,6 +41,8 @@ enum message_type {
   C2R_REGISTER_REQ,
   D2R_REGISTER_REQ,
   C2R_REPORT_STATUS_RESP,
+  C2R_READ_INDEX_REQ,
+  D2R_SNAPSHOT_INSTALLED,
   RLB_MESSAGE_END,
 
   // the following message are processed by CCB
@@ -46,6 +50,7 @@ enum message_type {
   R2C_REGISTER_RESP,
   COMMIT_LOG_ENTRIES,
   D2C_READ_DATA_RESP,
+  R2C_READ_INDEX_RESP,
 
   R2C_REPORT_STATUS_REQ,
 
@@ -55,6 +60,7 @@ enum message_type {
   CLIENT_CCB_STATE_REQ,
   CCB_HANDLE_WARM_UP_REQ,
   CCB_HANDLE_WARM_UP_RESP,
+  D2C_WARM_UP_CHUNK,
   TX_TM_COMMIT,
   TX_TM_ABORT,
   TX_TM_END,
@@ -82,8 +88,12 @@ enum message_type {
   C2D_READ_DATA_REQ,
   R2D_REGISTER_RESP,
   R2D_REPLAY_TO_DSB_REQ,
+  R2D_SNAPSHOT_REQ,
+  D2D_SNAPSHOT_CHUNK,
+  D2D_SNAPSHOT_ACK,
   CLIENT_LOAD_DATA_REQ,
   DSB_HANDLE_WARM_UP_REQ,
+  C2D_WARM_UP_ACK,
   DSB_ERROR_CONSISTENCY, _ERROR_CONSISTENCY,
   DSB_MESSAGE_END,
 
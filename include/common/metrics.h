@@ -0,0 +1,235 @@
+#pragma once
+
+#include "common/enum_str.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// a registry of counters, gauges and histograms exposed in the Prometheus
+// text format;
+// a metric is a range of cells, every thread updates the cells of its own
+// shard with relaxed atomics, and a scrape sums the shards of all the
+// threads, so an update is a store to a cache line of the thread and never
+// contends; the shards of the threads which have ended are kept and summed
+// metrics are defined as static objects, a labeled family has a metric for
+// every value of an enum known at compile time, e.g. message_type, or of a
+// small integer id, e.g. a shard id, and is indexed by the value
+
+const uint32_t METRICS_CHUNK_CELLS = 1024;
+const uint32_t METRICS_MAX_CHUNKS = 1024;
+// the shard ids of the families labeled by shard, the larger ones are
+// unknown
+const uint32_t METRICS_MAX_SHARDS = 256;
+
+// log-linear buckets of a histogram, the values below 2^SUB_BITS are exact,
+// every power of 2 above has 2^SUB_BITS linear sub-buckets
+const uint32_t METRICS_HISTOGRAM_SUB_BITS = 2;
+const uint32_t METRICS_HISTOGRAM_SUB = 1u << METRICS_HISTOGRAM_SUB_BITS;
+// the values above 2^MAX_BITS are in the last bucket
+const uint32_t METRICS_HISTOGRAM_MAX_BITS = 40;
+const uint32_t METRICS_HISTOGRAM_BUCKETS =
+    METRICS_HISTOGRAM_SUB +
+    (METRICS_HISTOGRAM_MAX_BITS - METRICS_HISTOGRAM_SUB_BITS + 1) *
+        METRICS_HISTOGRAM_SUB;
+
+// the cell of the shard of this thread
+std::atomic<uint64_t> &metrics_cell(uint32_t cell);
+
+// the sum of a cell of all the shards
+uint64_t metrics_cell_sum(uint32_t cell);
+
+// allocate num contiguous cells, return the first
+uint32_t metrics_alloc_cells(uint32_t num);
+
+class metric_counter {
+private:
+  uint32_t cell_;
+
+public:
+  metric_counter() : cell_(metrics_alloc_cells(1)) {}
+
+  void inc(uint64_t n = 1) {
+    std::atomic<uint64_t> &c = metrics_cell(cell_);
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const { return metrics_cell_sum(cell_); }
+
+  void write(std::ostream &os, const std::string &name,
+             const std::string &labels) const;
+
+  static const char *type() { return "counter"; }
+};
+
+// a gauge is either added to, from any thread, or set by its owner; the
+// value is the last value set plus the deltas of the shards
+class metric_gauge {
+private:
+  uint32_t cell_;
+  std::atomic<int64_t> set_;
+
+public:
+  metric_gauge() : cell_(metrics_alloc_cells(1)), set_(0) {}
+
+  void add(int64_t n) {
+    std::atomic<uint64_t> &c = metrics_cell(cell_);
+    c.store(c.load(std::memory_order_relaxed) + uint64_t(n),
+            std::memory_order_relaxed);
+  }
+
+  void sub(int64_t n) { add(-n); }
+
+  void set(int64_t v) { set_.store(v, std::memory_order_relaxed); }
+
+  int64_t value() const {
+    return set_.load(std::memory_order_relaxed) +
+           int64_t(metrics_cell_sum(cell_));
+  }
+
+  void write(std::ostream &os, const std::string &name,
+             const std::string &labels) const;
+
+  static const char *type() { return "gauge"; }
+};
+
+class metric_histogram {
+private:
+  // the buckets, and then the sum of the values
+  uint32_t cell_;
+
+public:
+  metric_histogram()
+      : cell_(metrics_alloc_cells(METRICS_HISTOGRAM_BUCKETS + 1)) {}
+
+  static uint32_t bucket_of(uint64_t v) {
+    if (v < METRICS_HISTOGRAM_SUB) {
+      return uint32_t(v);
+    }
+    uint32_t bits = 63 - uint32_t(__builtin_clzll(v));
+    if (bits > METRICS_HISTOGRAM_MAX_BITS) {
+      return METRICS_HISTOGRAM_BUCKETS - 1;
+    }
+    uint32_t shift = bits - METRICS_HISTOGRAM_SUB_BITS;
+    uint32_t sub = uint32_t(v >> shift) & (METRICS_HISTOGRAM_SUB - 1);
+    return METRICS_HISTOGRAM_SUB + shift * METRICS_HISTOGRAM_SUB + sub;
+  }
+
+  // the largest value of a bucket
+  static uint64_t bucket_upper(uint32_t bucket) {
+    if (bucket < METRICS_HISTOGRAM_SUB) {
+      return bucket;
+    }
+    uint32_t shift = (bucket - METRICS_HISTOGRAM_SUB) / METRICS_HISTOGRAM_SUB;
+    uint32_t sub = (bucket - METRICS_HISTOGRAM_SUB) % METRICS_HISTOGRAM_SUB;
+    return (uint64_t(METRICS_HISTOGRAM_SUB + sub + 1) << shift) - 1;
+  }
+
+  void record(uint64_t v) {
+    std::atomic<uint64_t> &b = metrics_cell(cell_ + bucket_of(v));
+    b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic<uint64_t> &s = metrics_cell(cell_ + METRICS_HISTOGRAM_BUCKETS);
+    s.store(s.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const;
+
+  uint64_t sum() const {
+    return metrics_cell_sum(cell_ + METRICS_HISTOGRAM_BUCKETS);
+  }
+
+  void write(std::ostream &os, const std::string &name,
+             const std::string &labels) const;
+
+  static const char *type() { return "histogram"; }
+};
+
+// a registered metric, written to /metrics
+class metric_entry {
+protected:
+  const char *name_;
+  const char *help_;
+
+public:
+  metric_entry(const char *name, const char *help);
+
+  virtual ~metric_entry() = default;
+
+  metric_entry(const metric_entry &) = delete;
+
+  metric_entry &operator=(const metric_entry &) = delete;
+
+  virtual void write(std::ostream &os) const = 0;
+
+protected:
+  void write_header(std::ostream &os, const char *type) const;
+};
+
+template<class METRIC> class metric : public metric_entry {
+private:
+  METRIC metric_;
+
+public:
+  metric(const char *name, const char *help) : metric_entry(name, help) {}
+
+  METRIC *operator->() { return &metric_; }
+
+  const METRIC &get() const { return metric_; }
+
+  void write(std::ostream &os) const override {
+    write_header(os, METRIC::type());
+    metric_.write(os, name_, "");
+  }
+};
+
+// a metric for every value of LABEL in [0, N), the values out of the range,
+// e.g. read from the wire, share the "unknown" one; the values which have
+// never been updated are not written
+template<class METRIC, class LABEL, size_t N>
+class metric_family : public metric_entry {
+private:
+  const char *label_;
+  std::array<METRIC, N + 1> metric_;
+
+public:
+  metric_family(const char *name, const char *help, const char *label)
+      : metric_entry(name, help), label_(label) {}
+
+  METRIC &operator[](LABEL value) {
+    size_t i = size_t(value);
+    return metric_[i < N ? i : N];
+  }
+
+  void write(std::ostream &os) const override {
+    write_header(os, METRIC::type());
+    for (size_t i = 0; i <= N; i++) {
+      if (is_zero(metric_[i])) {
+        continue;
+      }
+      std::string labels = std::string(label_) + "=\"" +
+                           (i < N ? label_value(LABEL(i)) : "unknown") + "\"";
+      metric_[i].write(os, name_, labels);
+    }
+  }
+
+private:
+  static std::string label_value(LABEL value) {
+    if constexpr (std::is_enum_v<LABEL>) {
+      return enum2str(value);
+    } else {
+      return std::to_string(value);
+    }
+  }
+
+  static bool is_zero(const metric_counter &m) { return m.value() == 0; }
+
+  static bool is_zero(const metric_gauge &m) { return m.value() == 0; }
+
+  static bool is_zero(const metric_histogram &m) { return m.count() == 0; }
+};
+
+// all the registered metrics in the Prometheus text format
+void metrics_prometheus(std::ostream &os);
@@ -10,11 +10,14 @@
 #include "proto/hello.pb.h"
 #include "proto/raft.pb.h"
 #include <boost/functional/hash.hpp>
+#include <google/protobuf/arena.h>
 
 using namespace boost::endian;
 
 const static uint16_t MSG_HDR_MAGIC_NUMBER1 = 1988;
 const static uint16_t MSG_HDR_MAGIC_NUMBER2 = 2021;
+// the bit of message type set when the body is compressed
+const static uint16_t MSG_HDR_COMPRESSED = 0x8000;
 
 extern std::mutex __mutex;
 extern std::atomic<uint64_t> _sequence;
@@ -77,7 +80,15 @@ public:
 #endif
   }
 
-  message_type type() const { return message_type(type_.value()); }
+  message_type type() const {
+    return message_type(type_.value() & ~MSG_HDR_COMPRESSED);
+  }
+
+  void set_compressed() {
+    type_ = uint16_t(type_.value() | MSG_HDR_COMPRESSED);
+  }
+
+  bool compressed() const { return (type_.value() & MSG_HDR_COMPRESSED) != 0; }
 
 #ifdef TEST_NETWORK_TIME
   void set_millis_since_epoch(uint64_t ms) { millis_since_epoch_ = ms; }
@@ -166,9 +177,11 @@ public:
 
 typedef std::function<void(msg_hdr &)> fn_msg_hdr;
 
+// the message body is msg followed by payload_size bytes of serialized
+// fields, which the caller writes after the buffer without copying them
 template<class PROTOBUF>
 result<void> proto_to_buf(byte_buffer &buffer, message_type id, PROTOBUF &msg,
-                          fn_msg_hdr fn) {
+                          uint64_t payload_size, fn_msg_hdr fn) {
   uint64_t header_and_tailer_size;
 #ifdef DEBUG_NETWORK_SEND_RECV
   header_and_tailer_size = msg_hdr::size() * 2;
@@ -193,7 +206,7 @@ result<void> proto_to_buf(byte_buffer &buffer, message_type id, PROTOBUF &msg,
   uint64_t wpos = buffer.get_write_pos();
   msg_hdr header;
   header.set_type(id);
-  header.set_length(body_size + header_and_tailer_size);
+  header.set_length(body_size + payload_size + header_and_tailer_size);
 
 #ifdef DEBUG_NETWORK_SEND_RECV
   uint64_t hash =
@@ -229,6 +242,12 @@ result<void> proto_to_buf(byte_buffer &buffer, message_type id, PROTOBUF &msg,
   return outcome::success();
 }
 
+template<class PROTOBUF>
+result<void> proto_to_buf(byte_buffer &buffer, message_type id, PROTOBUF &msg,
+                          fn_msg_hdr fn) {
+  return proto_to_buf(buffer, id, msg, 0, fn);
+}
+
 inline result<msg_hdr> buf_to_msg_hdr(byte_buffer &buffer) {
   if (buffer.read_available_size() < msg_hdr::size()) {
     return outcome::failure(EC::EC_INSUFFICIENT_SPACE);
@@ -255,3 +274,46 @@ result<void> buf_to_proto(byte_buffer &buffer, PROTOBUF &msg) {
   }
   return outcome::success();
 }
+
+// the arena a received message is parsed on, the message and its nested
+// fields live in the arena and are freed with it; a small message takes
+// only the allocation of the arena itself
+class message_arena {
+public:
+  explicit message_arena(size_t body_size)
+      : arena_(arena_options(block_, body_size)) {}
+
+  google::protobuf::Arena *arena() { return &arena_; }
+
+private:
+  static google::protobuf::ArenaOptions arena_options(char *block,
+                                                      size_t body_size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = MESSAGE_ARENA_BLOCK_SIZE;
+    // the parsed message takes about twice the size of its encoding
+    options.start_block_size =
+        std::max(size_t(MESSAGE_ARENA_BLOCK_SIZE), body_size * 2);
+    options.max_block_size = std::max(options.max_block_size,
+                                      options.start_block_size);
+    return options;
+  }
+
+  alignas(std::max_align_t) char block_[MESSAGE_ARENA_BLOCK_SIZE];
+  google::protobuf::Arena arena_;
+};
+
+template<class PROTOBUF>
+result<ptr<PROTOBUF>> buf_to_arena_proto(byte_buffer &buffer) {
+  auto arena = cs_new<message_arena>(buffer.read_available_size());
+  PROTOBUF *msg =
+      google::protobuf::Arena::CreateMessage<PROTOBUF>(arena->arena());
+  bool ok =
+      msg->ParseFromArray(buffer.read_begin(), buffer.read_available_size());
+  if (!ok) {
+    LOG(fatal) << "unmarshall error";
+    return outcome::failure(EC::EC_UNMARSHALL_ERROR);
+  }
+  // the message shares the ownership of its arena
+  return outcome::success(ptr<PROTOBUF>(arena, msg));
+}
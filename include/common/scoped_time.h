@@ -4,6 +4,7 @@
 #include "common/logger.hpp"
 #include "common/utils.h"
 #include <boost/format.hpp>
+#include <string_view>
 
 #ifdef TEST_HANDLE_TIME
 #define SCOPED_TIME(message, time)                                             \
@@ -18,7 +19,9 @@ class scoped_time {
   std::string message_;
 #endif
 public:
-  scoped_time(const std::string &msg) {
+  // a string_view, a literal message costs nothing when TEST_HANDLE_TIME is
+  // not defined
+  scoped_time(std::string_view msg) {
     POSSIBLE_UNUSED(msg);
 #ifdef TEST_HANDLE_TIME
     ;
@@ -28,9 +31,9 @@ public:
 #endif
   }
 #ifndef TEST_HANDLE_TIME
-  scoped_time(const std::string &, uint64_t) {
+  scoped_time(std::string_view, uint64_t) {
 #else
-    scoped_time(const std::string &_msg, uint64_t _ms) {
+    scoped_time(std::string_view _msg, uint64_t _ms) {
       max_ms_ = _ms;
       begin_ = steady_clock_ms_since_epoch();
       message_ = _msg;
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include "common/id.h"
 #include "common/panic.h"
+#include <boost/format.hpp>
 
 inline node_id_t node_id_of_shard(
     shard_id_t shard_id,
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// a space-saving sketch of the heavy hitters of a stream of keys, Metwally
+// et al., "Efficient Computation of Frequent and Top-k Elements in Data
+// Streams";
+// at most capacity keys are kept, a key not kept replaces the one of the
+// minimum count and inherits the count as its error, so the count of a kept
+// key over-estimates its true count by at most error, and a key whose true
+// count is larger than the minimum count is always kept.
+// STAT is the statistic of a kept key, it is reset when the key replaces
+// another one
+template<class KEY, class STAT> class space_saving {
+public:
+  struct entry {
+    KEY key_;
+    uint64_t count_;
+    uint64_t error_;
+    STAT stat_;
+  };
+
+private:
+  size_t capacity_;
+  // a min-heap by count
+  std::vector<entry> heap_;
+  std::unordered_map<KEY, size_t> index_;
+
+public:
+  explicit space_saving(size_t capacity) : capacity_(capacity) {
+    heap_.reserve(capacity);
+    index_.reserve(capacity);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  size_t size() const { return heap_.size(); }
+
+  // add weight to the count of key, return the statistic of key
+  STAT &add(const KEY &key, uint64_t weight = 1) {
+    auto i = index_.find(key);
+    if (i != index_.end()) {
+      heap_[i->second].count_ += weight;
+      return heap_[sift_down(i->second)].stat_;
+    }
+    if (heap_.size() < capacity_) {
+      heap_.push_back(entry{key, weight, 0, STAT()});
+      index_[key] = heap_.size() - 1;
+      return heap_[sift_up(heap_.size() - 1)].stat_;
+    }
+    entry &min = heap_.front();
+    index_.erase(min.key_);
+    min.key_ = key;
+    min.error_ = min.count_;
+    min.count_ += weight;
+    min.stat_ = STAT();
+    index_[key] = 0;
+    return heap_[sift_down(0)].stat_;
+  }
+
+  // the statistic of key, nullptr if key is not kept
+  STAT *find(const KEY &key) {
+    auto i = index_.find(key);
+    return i == index_.end() ? nullptr : &heap_[i->second].stat_;
+  }
+
+  // the k keys of the largest counts, in descending order of count
+  std::vector<entry> top(size_t k) const {
+    std::vector<entry> vec(heap_.begin(), heap_.end());
+    k = std::min(k, vec.size());
+    std::partial_sort(vec.begin(), vec.begin() + k, vec.end(),
+                      [](const entry &x, const entry &y) {
+                        return x.count_ > y.count_;
+                      });
+    vec.resize(k);
+    return vec;
+  }
+
+  void clear() {
+    heap_.clear();
+    index_.clear();
+  }
+
+private:
+  void swap_entry(size_t i, size_t j) {
+    std::swap(heap_[i], heap_[j]);
+    index_[heap_[i].key_] = i;
+    index_[heap_[j].key_] = j;
+  }
+
+  size_t sift_up(size_t i) {
+    while (i > 0) {
+      size_t parent = (i - 1) / 2;
+      if (heap_[parent].count_ <= heap_[i].count_) {
+        break;
+      }
+      swap_entry(i, parent);
+      i = parent;
+    }
+    return i;
+  }
+
+  size_t sift_down(size_t i) {
+    size_t n = heap_.size();
+    while (true) {
+      size_t min = i;
+      size_t l = 2 * i + 1;
+      size_t r = l + 1;
+      if (l < n && heap_[l].count_ < heap_[min].count_) {
+        min = l;
+      }
+      if (r < n && heap_[r].count_ < heap_[min].count_) {
+        min = r;
+      }
+      if (min == i) {
+        return i;
+      }
+      swap_entry(i, min);
+      i = min;
+    }
+  }
+};
@@ -1,15 +1,42 @@
 #pragma once
 
 #include <boost/json.hpp>
+#include <string>
+#include <vector>
+
+// the shaping of the messages sent from the nodes of a zone to the nodes of
+// another one, simulates a WAN link on one host
+struct net_link_shaping {
+  std::string from_zone_;
+  std::string to_zone_;
+  uint32_t latency_ms_;
+  // the latency is uniformly distributed in [latency - jitter, latency + jitter]
+  uint32_t jitter_ms_;
+  // 0 for unlimited
+  uint64_t bandwidth_mbps_;
+
+  net_link_shaping() : latency_ms_(0), jitter_ms_(0), bandwidth_mbps_(0) {}
+
+  [[nodiscard]] boost::json::object to_json() const;
+
+  void from_json(boost::json::object &obj);
+};
 
 class test_config {
 private:
+  // the latency of the zone pairs not in net_shaping_
   uint32_t wan_latency_ms_;
   float_t cached_tuple_percentage_;
+  // CCB is warmed up by a sample of the rows of a shard scanned by DSB,
+  // instead of a sample of the keys the transactions access
+  bool warm_up_scan_;
   uint32_t deadlock_detection_ms_;
   bool deadlock_detection_;
   uint64_t lock_timeout_ms_;
+  // the runtime level of the log, trace, debug, info, warning, error or fatal
+  std::string log_level_;
   std::string label_;
+  std::vector<net_link_shaping> net_shaping_;
 
 public:
   test_config();
@@ -20,6 +47,10 @@ public:
 
   float_t percent_cached_tuple() const { return cached_tuple_percentage_; }
 
+  bool warm_up_scan() const { return warm_up_scan_; }
+
+  void set_warm_up_scan(bool scan) { warm_up_scan_ = scan; }
+
   const std::string &label() const { return label_; }
 
   void set_wan_latency_ms(uint32_t ms) { wan_latency_ms_ = ms; }
@@ -38,9 +69,20 @@ public:
 
   void set_label(const std::string &label) { label_ = label; }
 
+  const std::vector<net_link_shaping> &net_shaping() const {
+    return net_shaping_;
+  }
+
+  void add_net_shaping(const net_link_shaping &link) {
+    net_shaping_.push_back(link);
+  }
+
   void set_lock_timeout_ms(uint64_t ms) { lock_timeout_ms_ = ms; }
   uint64_t lock_timeout_ms() const { return lock_timeout_ms_; }
 
+  void set_log_level(const std::string &level) { log_level_ = level; }
+  const std::string &log_level() const { return log_level_; }
+
   [[nodiscard]] boost::json::object to_json() const;
 
   void from_json(boost::json::object &obj);
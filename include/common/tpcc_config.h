@@ -4,9 +4,11 @@
 #include "common/variable.h"
 #include <boost/json.hpp>
 #include <cstdint>
+#include <string>
 
 class tpcc_config {
 private:
+  std::string benchmark_;
   uint64_t num_warehouse_;
   uint64_t num_item_;
   uint64_t num_order_initialize_per_district_;
@@ -21,6 +23,7 @@ private:
   double_t percent_read_only_;
   uint32_t read_only_rows_;
   bool additional_read_only_terminal_;
+  bool replica_read_;
   uint64_t hot_item_num_;
   uint64_t raft_leader_tick_ms_;
   uint64_t raft_follow_tick_num_;
@@ -29,22 +32,40 @@ private:
   uint64_t az_rtt_ms_;
   uint64_t flow_control_rtt_count_;
   bool control_percent_dist_tx_;
+  uint32_t weight_new_order_;
+  uint32_t weight_payment_;
+  uint32_t weight_order_status_;
+  uint32_t weight_delivery_;
+  uint32_t weight_stock_level_;
+  double open_loop_tps_;
+  uint32_t client_window_;
+  double trace_sample_rate_;
 
 public:
   tpcc_config()
-      : num_warehouse_(0), num_item_(0), num_order_initialize_per_district_(0),
+      : benchmark_(BENCHMARK), num_warehouse_(0), num_item_(0), num_order_initialize_per_district_(0),
         num_district_per_warehouse_(0), num_max_order_line_(0),
         num_terminal_(0), num_customer_per_district_(0), num_new_order_(0),
         percent_non_exist_item_(0.0), percent_remote_warehouse_(0.0),
         percent_hot_row_(0.0), percent_read_only_(PERCENTAGE_READ_ONLY),
         read_only_rows_(READ_ONLY_ROWS),
         additional_read_only_terminal_(ADDITIONAL_READ_ONLY_TERMINAL),
+        replica_read_(REPLICA_READ),
         hot_item_num_(1),
         raft_leader_tick_ms_(RAFT_LEADER_ELECTION_TICK_MILLI_SECONDS),
         raft_follow_tick_num_(RAFT_FOLLOW_TICK_NUM),
         calvin_epoch_ms_(CALVIN_EPOCH_MILLISECOND),
         num_output_result_(TPM_CAL_NUM), az_rtt_ms_(100),
-        flow_control_rtt_count_(10), control_percent_dist_tx_(DIST_TX_PERCENTAGE) {}
+        flow_control_rtt_count_(10), control_percent_dist_tx_(DIST_TX_PERCENTAGE),
+        weight_new_order_(WEIGHT_NEW_ORDER), weight_payment_(WEIGHT_PAYMENT),
+        weight_order_status_(WEIGHT_ORDER_STATUS),
+        weight_delivery_(WEIGHT_DELIVERY),
+        weight_stock_level_(WEIGHT_STOCK_LEVEL),
+        open_loop_tps_(OPEN_LOOP_TPS), client_window_(CLIENT_WINDOW),
+        trace_sample_rate_(TX_SPAN_SAMPLE_RATE) {}
+
+  // "tpcc" or "ycsb"
+  [[nodiscard]] const std::string &benchmark() const { return benchmark_; }
 
   [[nodiscard]] uint64_t num_warehouse() const { return num_warehouse_; }
 
@@ -106,8 +127,36 @@ public:
 
   bool additional_read_only_terminal() const { return additional_read_only_terminal_; }
 
+  // read only transactions are served by the nearest replica
+  bool replica_read() const { return replica_read_; }
+
   [[nodiscard]] uint64_t hot_item_num() const { return hot_item_num_; }
 
+  // the weights of the transaction mix
+  [[nodiscard]] uint32_t weight_new_order() const { return weight_new_order_; }
+
+  [[nodiscard]] uint32_t weight_payment() const { return weight_payment_; }
+
+  [[nodiscard]] uint32_t weight_order_status() const {
+    return weight_order_status_;
+  }
+
+  [[nodiscard]] uint32_t weight_delivery() const { return weight_delivery_; }
+
+  [[nodiscard]] uint32_t weight_stock_level() const {
+    return weight_stock_level_;
+  }
+
+  // the arrival rate of the transactions of all terminals, 0 for closed loop
+  [[nodiscard]] double open_loop_tps() const { return open_loop_tps_; }
+
+  [[nodiscard]] uint32_t client_window() const { return client_window_; }
+
+  // the fraction of the transactions whose spans are recorded
+  [[nodiscard]] double trace_sample_rate() const { return trace_sample_rate_; }
+
+  void set_benchmark(const std::string &v) { benchmark_ = v; }
+
   void set_num_warehouse(uint64_t v) { num_warehouse_ = v; }
 
   void set_num_item(uint64_t v) { num_item_ = v; }
@@ -140,6 +189,21 @@ public:
 
   void set_control_percent_dist_tx(bool v) { control_percent_dist_tx_ = v; }
 
+  void set_tx_mix(uint32_t new_order, uint32_t payment, uint32_t order_status,
+                  uint32_t delivery, uint32_t stock_level) {
+    weight_new_order_ = new_order;
+    weight_payment_ = payment;
+    weight_order_status_ = order_status;
+    weight_delivery_ = delivery;
+    weight_stock_level_ = stock_level;
+  }
+
+  void set_open_loop_tps(double v) { open_loop_tps_ = v; }
+
+  void set_client_window(uint32_t v) { client_window_ = v; }
+
+  void set_trace_sample_rate(double v) { trace_sample_rate_ = v; }
+
   void set_num_output_result(uint64_t v) { num_output_result_ = v; }
 
   void set_az_rtt_ms(uint64_t ms) { az_rtt_ms_ = ms; }
@@ -150,6 +214,7 @@ public:
 
   boost::json::object to_json() const {
     boost::json::object j;
+    j["benchmark"] = benchmark_;
     j["num_warehouse"] = num_warehouse_;
     j["num_item"] = num_item_;
     j["num_max_order_line"] = num_max_order_line_;
@@ -165,6 +230,7 @@ public:
     j["percent_read_only"] = percent_read_only_;
     j["num_read_only_rows"] = read_only_rows_;
     j["additional_read_only_terminal"] = additional_read_only_terminal_;
+    j["replica_read"] = replica_read_;
     j["hot_item_num"] = hot_item_num_;
     j["raft_follow_tick_num"] = raft_follow_tick_num_;
     j["raft_leader_election_tick_ms"] = raft_leader_tick_ms_;
@@ -173,10 +239,19 @@ public:
     j["az_rtt_ms"] = az_rtt_ms_;
     j["flow_control_rtt_count"] = flow_control_rtt_count_;
     j["control_percent_dist_tx"] = control_percent_dist_tx_;
+    j["weight_new_order"] = weight_new_order_;
+    j["weight_payment"] = weight_payment_;
+    j["weight_order_status"] = weight_order_status_;
+    j["weight_delivery"] = weight_delivery_;
+    j["weight_stock_level"] = weight_stock_level_;
+    j["open_loop_tps"] = open_loop_tps_;
+    j["client_window"] = client_window_;
+    j["trace_sample_rate"] = trace_sample_rate_;
     return j;
   }
 
   void from_json(boost::json::object &j) {
+    benchmark_ = boost::json::value_to<std::string>(j["benchmark"]);
     num_warehouse_ =
         (uint64_t) boost::json::value_to<int64_t>(j["num_warehouse"]);
     num_item_ = (uint64_t) boost::json::value_to<int64_t>(j["num_item"]);
@@ -206,6 +281,7 @@ public:
         (uint32_t) boost::json::value_to<uint32_t>(j["num_read_only_rows"]);
     additional_read_only_terminal_ =
         boost::json::value_to<bool>(j["additional_read_only_terminal"]);
+    replica_read_ = boost::json::value_to<bool>(j["replica_read"]);
     hot_item_num_ =
         (uint64_t) boost::json::value_to<uint64_t>(j["hot_item_num"]);
     raft_follow_tick_num_ =
@@ -221,5 +297,19 @@ public:
         (uint64_t) boost::json::value_to<int64_t>(j["flow_control_rtt_count"]);
     control_percent_dist_tx_ =
         boost::json::value_to<bool>(j["control_percent_dist_tx"]);
+    weight_new_order_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["weight_new_order"]);
+    weight_payment_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["weight_payment"]);
+    weight_order_status_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["weight_order_status"]);
+    weight_delivery_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["weight_delivery"]);
+    weight_stock_level_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["weight_stock_level"]);
+    open_loop_tps_ = boost::json::value_to<double>(j["open_loop_tps"]);
+    client_window_ =
+        (uint32_t) boost::json::value_to<uint32_t>(j["client_window"]);
+    trace_sample_rate_ = boost::json::value_to<double>(j["trace_sample_rate"]);
   }
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/endian.h"
+#include "common/id.h"
 #include "common/ptr.hpp"
 #include "proto/proto.h"
 #include "common/panic.h"
@@ -13,8 +14,29 @@ class log_buffer;
 
 const uint64_t OFFSET_TIMESTAMP = sizeof(uint64_t)*1;
 const uint64_t OFFSET_NODE_ID = sizeof(uint64_t)*2;
+const uint64_t OFFSET_SHARD_MAP = sizeof(uint64_t)*3;
 const uint64_t OFFSET_PAYLOAD_SIZE = 0;
-const uint64_t HEADER_SIZE = 3*sizeof(uint64_t);
+const uint64_t HEADER_SIZE = 4*sizeof(uint64_t);
+
+// the high bits of the payload size word are the version of the header,
+// version 1 added the shard map; the raft logs written by an older version
+// have no version and must be wiped before an upgrade
+const uint64_t TX_LOG_VERSION = 1;
+const uint32_t TX_LOG_VERSION_SHIFT = 48;
+const uint64_t TX_LOG_PAYLOAD_SIZE_MASK =
+    (uint64_t(1) << TX_LOG_VERSION_SHIFT) - 1;
+
+// bit shard_id is set for every shard a log writes to, RLB routes logs to DSB
+// by this map without parsing the payload; config::valid_check rejects a
+// shard id that does not fit in the map
+typedef uint64_t shard_map_t;
+
+const uint32_t SHARD_MAP_BITS = sizeof(shard_map_t) * 8;
+
+inline shard_map_t shard_id_to_map(shard_id_t shard_id) {
+  BOOST_ASSERT(shard_id < SHARD_MAP_BITS);
+  return shard_map_t(1) << shard_id;
+}
 
 typedef std::function<void(log_buffer &)> fn_handle_log_buffer;
 typedef std::function<void(const void *buf, size_t length)>
@@ -31,11 +53,13 @@ private:
 
 public:
   inline static void format(char *buffer_pointer, size_t capacity, char *src,
-                            size_t len, uint64_t timestamp, node_id_t node_id) {
+                            size_t len, uint64_t timestamp, node_id_t node_id,
+                            shard_map_t shard_map) {
     log_buffer buffer(buffer_pointer, capacity);
     buffer.set_payload_size(len);
     buffer.set_timestamp(timestamp);
     buffer.set_node_id(node_id);
+    buffer.set_shard_map(shard_map);
     buffer.copy_payload(src, len);
   }
 
@@ -70,7 +94,13 @@ public:
   inline uint64_t payload_size() const {
     uint64_buf_t u64_buf;
     memcpy(&u64_buf, get_data(OFFSET_PAYLOAD_SIZE), sizeof(uint64_t));
-    return u64_buf.value();
+    return u64_buf.value() & TX_LOG_PAYLOAD_SIZE_MASK;
+  }
+
+  inline uint64_t version() const {
+    uint64_buf_t u64_buf;
+    memcpy(&u64_buf, get_data(OFFSET_PAYLOAD_SIZE), sizeof(uint64_t));
+    return u64_buf.value() >> TX_LOG_VERSION_SHIFT;
   }
 
   inline node_id_t node_id() const {
@@ -79,6 +109,12 @@ public:
     return node_id_t(u64_buf.value());
   }
 
+  inline shard_map_t shard_map() const {
+    uint64_buf_t u64_buf;
+    memcpy(&u64_buf, get_data(OFFSET_SHARD_MAP), sizeof(uint64_t));
+    return shard_map_t(u64_buf.value());
+  }
+
   inline const char *payload_data() const { return get_data(header_size()); }
 
   inline void set_timestamp(uint64_t timestamp) {
@@ -88,8 +124,9 @@ public:
   }
 
   inline void set_payload_size(uint64_t payload_size) {
+    BOOST_ASSERT(payload_size <= TX_LOG_PAYLOAD_SIZE_MASK);
     uint64_buf_t u64_buf;
-    u64_buf = payload_size;
+    u64_buf = payload_size | (TX_LOG_VERSION << TX_LOG_VERSION_SHIFT);
     memcpy(get_data(OFFSET_PAYLOAD_SIZE), &u64_buf, sizeof(uint64_t));
   }
 
@@ -99,6 +136,12 @@ public:
     memcpy(get_data(OFFSET_NODE_ID), &u64_buf, sizeof(uint64_t));
   }
 
+  inline void set_shard_map(shard_map_t shard_map) {
+    uint64_buf_t u64_buf;
+    u64_buf = uint64_t(shard_map);
+    memcpy(get_data(OFFSET_SHARD_MAP), &u64_buf, sizeof(uint64_t));
+  }
+
   inline void copy_payload(const char *src, size_t length) {
     BOOST_ASSERT(size() >= length + header_size());
     memcpy(get_data(header_size()), src, length);
@@ -109,6 +152,16 @@ inline tx_log_binary tx_log_proto_to_binary(const tx_log_proto &proto) {
   return proto.SerializeAsString();
 }
 
+inline shard_map_t tx_log_proto_shard_map(const tx_log_proto &proto) {
+  shard_map_t shard_map = 0;
+  for (const tx_operation &op : proto.operations()) {
+    if (is_write_operation(op.op_type())) {
+      shard_map |= shard_id_to_map(op.tuple_row().shard_id());
+    }
+  }
+  return shard_map;
+}
+
 inline tx_log_proto tx_log_binary_to_proto(const tx_log_binary &binary) {
   tx_log_proto proto;
   bool ok = proto.ParseFromString(binary);
@@ -123,6 +176,11 @@ inline void handle_repeated_tx_logs_to_buffer(repeated_tx_logs &logs,
   size_t log_size = logs.size();
   while (size < log_size) {
     log_buffer b(const_cast<char *>(logs.data()) + size, log_size - size);
+    if (b.version() != TX_LOG_VERSION) {
+      PANIC("tx log header version " + std::to_string(b.version()) +
+            ", expected " + std::to_string(TX_LOG_VERSION) +
+            ", wipe the raft logs written by an older version");
+    }
     size_t buffer_size = b.payload_size() + log_buffer::header_size();
     log_buffer b1(const_cast<char *>(logs.data()) + size, buffer_size);
     fn(b1);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// the spans of the sampled transactions, e.g. a lock wait or a read from
+// DSB; the client samples a transaction and flags its tx_request, the blocks
+// record the spans of the flagged ones.
+// a thread records to its own ring of the last TX_SPAN_RING_SIZE spans,
+// lock-free, the debug server reads the rings as Chrome trace events
+enum tx_span_kind {
+  SPAN_CLIENT_SEND = 0,
+  // from the request received to the transaction run on its strand
+  SPAN_CCB_DISPATCH,
+  SPAN_LOCK_WAIT,
+  SPAN_DSB_READ,
+  SPAN_WAL_APPEND,
+  SPAN_RAFT_REPLICATE,
+  // from the log committed to the transaction handles it
+  SPAN_COMMIT_NOTIFY,
+  // from the coordinator appends its commit log to the log committed
+  SPAN_TM_COMMIT,
+  SPAN_RESPONSE,
+  SPAN_KIND_MAX,
+};
+
+const char *tx_span_name(tx_span_kind kind);
+
+inline uint64_t tx_span_now_ns() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count());
+}
+
+inline uint64_t tx_span_ns(std::chrono::steady_clock::time_point ts) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      ts.time_since_epoch())
+                      .count());
+}
+
+// the sampled fraction of the transactions of this process, [0, 1]
+void tx_span_set_sample_rate(double rate);
+
+double tx_span_sample_rate();
+
+// true for the sampled fraction of calls
+bool tx_span_sample();
+
+// id is the trace_id of the tx_request, the same at the client and the blocks
+void tx_span_record(tx_span_kind kind, uint64_t id, uint32_t terminal_id,
+                    uint64_t begin_ns, uint64_t end_ns);
+
+// the rings allocated, the rings of the ended threads are reused
+size_t tx_span_num_rings();
+
+// the spans which end in the last window_ms milliseconds, 0 for all of them
+void tx_span_chrome_trace(std::ostream &os, uint64_t window_ms);
+
+// a span of a transaction, not recorded unless the transaction is sampled
+class tx_span {
+private:
+  uint64_t begin_ns_;
+
+public:
+  tx_span() : begin_ns_(0) {}
+
+  void begin(bool sampled) {
+    if (sampled) {
+      begin_ns_ = tx_span_now_ns();
+    }
+  }
+
+  void end(bool sampled, tx_span_kind kind, uint64_t id, uint32_t terminal_id) {
+    // no clock read for an unsampled transaction
+    if (sampled && begin_ns_ != 0) {
+      end_ts(sampled, kind, id, terminal_id, tx_span_now_ns());
+    }
+  }
+
+  void end_ts(bool sampled, tx_span_kind kind, uint64_t id,
+              uint32_t terminal_id, uint64_t end_ns) {
+    if (sampled && begin_ns_ != 0) {
+      tx_span_record(kind, id, terminal_id, begin_ns_, end_ns);
+      begin_ns_ = 0;
+    }
+  }
+};
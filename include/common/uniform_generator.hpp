@@ -14,5 +14,8 @@ public:
   uniform_generator(INT_TYPE lower_bound, INT_TYPE upper_bound)
       : rand_(std::random_device{}()), gen_(lower_bound, upper_bound) {}
 
+  uniform_generator(INT_TYPE lower_bound, INT_TYPE upper_bound, uint64_t seed)
+      : rand_(seed), gen_(lower_bound, upper_bound) {}
+
   INT_TYPE generate() { return gen_(rand_); }
 };
@@ -17,6 +17,12 @@ inline uint64_t steady_clock_ms_since_epoch() {
   return uint64_t(s.count()*1000.0);
 }
 
+inline uint64_t steady_clock_us_since_epoch() {
+  auto now = std::chrono::steady_clock::now();
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+      now - EPOCH_TIME_STEADY_CLOCK).count());
+}
+
 inline double_t to_microseconds(std::chrono::nanoseconds ns) {
   return double_t(ns.count()/1000.0);
 }
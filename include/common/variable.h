@@ -11,6 +11,14 @@ const float_t TEST_CACHED_TUPLE_PERCENTAGE = 0.5;
 const uint64_t NUM_ORDER_MAX = 100000000;
 
 const uint64_t MESSAGE_BUFFER_SIZE = 8192;
+// free send buffers kept by a connection
+const uint64_t SEND_BUFFER_POOL_SIZE = 64;
+// receive buffer is compacted when its free space is below the low water,
+// and shrinks after a message larger than the shrink size is processed
+const uint64_t RECV_BUFFER_LOW_WATER = MESSAGE_BUFFER_SIZE / 4;
+const uint64_t RECV_BUFFER_SHRINK_SIZE = MESSAGE_BUFFER_SIZE * 64;
+// the first block of the arena a received message is parsed on
+const uint64_t MESSAGE_ARENA_BLOCK_SIZE = 1024;
 
 const uint32_t CONNECTIONS_PER_PEER = 10;
 const uint32_t NUM_TERMINAL = 10;
@@ -33,14 +41,127 @@ const uint32_t THREADS_ASYNC_CONTEXT = 4;
 const uint32_t THREADS_CC = 4;
 const uint32_t THREADS_REPLICATION = 1;
 const uint32_t THREADS_IO = 20;
+// run every core by a pinned single-threaded io_context instead of the
+// thread pools of the service types
+const bool THREAD_PER_CORE = false;
+// cores of thread-per-core mode, 0 for the hardware concurrency
+const uint32_t NUM_CORES = 0;
+// capacity of a queue between two cores
+const uint64_t CORE_MAILBOX_CAPACITY = 4096;
+const uint32_t CORE_NONE = UINT32_MAX;
+// use the shared memory rings for the peers on the same host
+const bool SHM_TRANSPORT = true;
+// bytes of a shared memory ring, one ring for each direction
+const uint64_t SHM_RING_BYTES = 16 * 1024 * 1024;
+// polls of a shared memory ring before waiting on futex, no polling on a
+// single CPU
+const uint64_t SHM_RING_SPIN = 2000;
+const uint64_t SHM_RING_WAIT_MILLIS = 100;
+// a writer waiting on a full ring gives up when the reader has not read for
+// this long, the reader is taken as stalled
+const uint64_t SHM_RING_STALL_MILLIS = 1000;
+// interval of writing the messages queued while the ring of a peer is full
+const uint64_t SHM_RING_DRAIN_MICROS = 50;
+// interval of opening the ring of a peer which has not created it yet
+const uint64_t SHM_RING_RETRY_MILLIS = 1000;
+// interval of checking that the ring of a peer is not orphaned by a restart
+const uint64_t SHM_RING_CHECK_MILLIS = 1000;
+// compress the messages sent to the peers in other AZs, "none", "lz4" or
+// "zstd"
+const char *const WAN_COMPRESS = "none";
+// messages smaller than this are sent uncompressed
+const uint64_t WAN_COMPRESS_MIN_BYTES = 1024;
+const int WAN_COMPRESS_ZSTD_LEVEL = 1;
+// the largest raw size of a compressed message, a larger one on the wire is
+// rejected before the buffer is allocated
+const uint64_t WAN_DECOMPRESS_MAX_BYTES = 256 * 1024 * 1024;
+// the tick of the timing wheels of the io_contexts, which time the messages
+// delayed by the net shaping, transaction timeouts and lock waits
+const uint64_t TIMING_WHEEL_TICK_US = 250;
+// the sampled fraction of the transactions traced as spans by the client
+const double TX_SPAN_SAMPLE_RATE = 0.01;
+// spans kept by the ring of a thread, a power of 2
+const uint64_t TX_SPAN_RING_SIZE = 8192;
+// the window of the spans served by the debug server by default
+const uint64_t TX_SPAN_WINDOW_MILLIS = 10000;
+
+// the ring of the binary log records of a thread, a power of 2, and the
+// interval of the background thread writing the records when idle
+const uint32_t BLOG_RING_BYTES = 1u << 20;
+const uint64_t BLOG_FLUSH_MICROS = 1000;
+const char *const LOG_LEVEL = "info";
 const uint32_t TPM_CAL_NUM = 100;
 
 const float PERCENT_REMOTE = 1.0;
+// the weights of the TPC-C transaction mix, new-order, payment, order-status,
+// delivery and stock-level
+const uint32_t WEIGHT_NEW_ORDER = 45;
+const uint32_t WEIGHT_PAYMENT = 43;
+const uint32_t WEIGHT_ORDER_STATUS = 4;
+const uint32_t WEIGHT_DELIVERY = 4;
+const uint32_t WEIGHT_STOCK_LEVEL = 4;
+// the payments paid by a customer of a remote warehouse
+const float PERCENT_PAYMENT_REMOTE = 0.15;
+// the payments and order-status transactions selecting the customer by last
+// name, through the CUST_LAST_INDEX table
+const float PERCENT_BY_LAST_NAME = 0.6;
+const uint32_t NUM_CUSTOMER_LAST_NAME = 1000;
+// the recent orders examined by a stock-level transaction
+const uint32_t STOCK_LEVEL_ORDERS = 20;
+// the transactions per second sent by all the terminals of a shard in the
+// open loop mode, 0 runs the terminals in a closed loop
+const double OPEN_LOOP_TPS = 0.0;
+// the transactions a terminal keeps in flight on a connection, 1 sends them
+// one at a time over a blocking client
+const uint32_t CLIENT_WINDOW = 1;
+
+// the benchmark run by the clients, "tpcc" or "ycsb"
+const char *const BENCHMARK = "tpcc";
+// the records of the YCSB table, split evenly among the shards
+const uint64_t YCSB_NUM_RECORD = 100000;
+// the YCSB core workload, "A" to "F"
+const char *const YCSB_WORKLOAD = "A";
+// the distribution of the YCSB keys, "zipfian", "latest" or "uniform"
+const char *const YCSB_DISTRIBUTION = "zipfian";
+const double YCSB_ZIPF_THETA = 0.99;
+const uint32_t YCSB_OPS_PER_TX = 10;
+const float YCSB_PERCENT_CROSS_SHARD = 0.1;
+const uint32_t YCSB_MAX_SCAN_LENGTH = 100;
+// the seed of the YCSB key and operation generators, a terminal derives its
+// own from it, the same seed generates the same transactions
+const uint64_t YCSB_SEED = 1;
 const float PERCENT_HOT_ROW = 0.1;
 const uint64_t HOT_ROW_NUM = NUM_ITEM*0.001;
 const uint64_t APPEND_LOG_ENTRIES_BATCH_MIN = 1;
 
 const uint64_t APPEND_LOG_ENTRIES_BATCH_MAX = 32;
+const uint64_t APPEND_LOG_BATCH_BYTES_MAX = 256 * 1024;
+// upper bound of the adaptive append log batch deadline
+const uint64_t APPEND_LOG_BATCH_DEADLINE_MICROS = 2000;
+// raft log entries appended but not committed yet
+const uint64_t APPEND_LOG_INFLIGHT_MAX = 4;
+// log bytes a CCB can send to RLB before being granted credits again
+const uint64_t APPEND_LOG_CREDIT_BYTES = 4 * 1024 * 1024;
+// CCB rejects new transactions when so many log bytes wait for credits
+const uint64_t APPEND_LOG_PENDING_BYTES_MAX = 1024 * 1024;
+// rows bytes of a snapshot chunk sent from DSB to DSB
+const uint64_t SNAPSHOT_CHUNK_BYTES = 1024 * 1024;
+// snapshot chunks sent but not acknowledged yet
+const uint64_t SNAPSHOT_CHUNK_INFLIGHT = 4;
+// rows bytes of a warm up chunk streamed from DSB to CCB
+const uint64_t WARM_UP_CHUNK_BYTES = 256 * 1024;
+// warm up chunks sent but not cached by CCB yet, CCB caches them in parallel
+const uint64_t WARM_UP_CHUNK_INFLIGHT = 8;
+// a warm up scan which fails this many times, e.g. DSB cannot scan the shard,
+// falls back to reading a sample of the keys of the shard
+const uint32_t WARM_UP_SCAN_RETRY = 3;
+// leader retries to send snapshot when a follower has not installed it
+const uint64_t SNAPSHOT_TIMEOUT_MILLIS = 600000;
+// buffer the messages sent to a peer, and send them together
+const bool SEND_COALESCE = true;
+// delay of flushing the buffered messages, 0 flushes them after the current
+// handler returns
+const uint64_t SEND_COALESCE_DELAY_MICROS = 0;
 
 const std::chrono::steady_clock::time_point
     EPOCH_TIME_STEADY_CLOCK(std::chrono::steady_clock::now());
@@ -54,10 +175,25 @@ const uint64_t RLB_REPORT_MILLIS = 2000;
 const uint32_t DEADLOCK_DETECTION_TIMEOUT_MILLIS = 1000;
 const uint64_t LOCK_WAIT_TIMEOUT_MILLIS = 800;
 const bool DEADLOCK_DETECTION = false;
+// the keys kept by the hot key sketch of a lock manager, and the hot keys of
+// a table shown by /hot_key
+const uint32_t LOCK_HOT_KEY_CAPACITY = 256;
+const uint32_t LOCK_HOT_KEY_TOP = 16;
 const uint64_t TX_TIMEOUT_MILLIS = 40000;
+// a client retries a transaction rejected by the admission control of a CCB
+// (EC_FLOW_CONTROL) after a back off, doubled on every rejection up to the max
+const uint64_t CLIENT_FLOW_CONTROL_BACKOFF_MIN_MICROS = 200;
+const uint64_t CLIENT_FLOW_CONTROL_BACKOFF_MAX_MICROS = 50000;
+// the transactions in flight of a terminal kept in its slots of cc_block,
+// the others are kept in an overflow hash table
+const uint32_t TX_SLOTS_PER_TERMINAL = 4;
 
 const bool DIST_TX_PERCENTAGE = false;
 
 const float PERCENTAGE_READ_ONLY = 0.1;
 const uint32_t READ_ONLY_ROWS = 20;
 const bool ADDITIONAL_READ_ONLY_TERMINAL = false;
+const bool REPLICA_READ = false;
+// a read only transaction at a follower CCB gives up the read index after
+// it, and answers EC_NOT_LEADER, the client retries it at the leader
+const uint64_t REPLICA_READ_TIMEOUT_MILLIS = 2000;
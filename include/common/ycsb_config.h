@@ -0,0 +1,89 @@
+#pragma once
+
+#include "common/variable.h"
+#include <boost/json.hpp>
+#include <cstdint>
+#include <string>
+
+class ycsb_config {
+private:
+  uint64_t num_record_;
+  std::string workload_;
+  std::string distribution_;
+  double zipf_theta_;
+  uint32_t ops_per_tx_;
+  double percent_cross_shard_;
+  uint32_t max_scan_length_;
+  uint64_t seed_;
+
+public:
+  ycsb_config()
+      : num_record_(YCSB_NUM_RECORD), workload_(YCSB_WORKLOAD),
+        distribution_(YCSB_DISTRIBUTION), zipf_theta_(YCSB_ZIPF_THETA),
+        ops_per_tx_(YCSB_OPS_PER_TX),
+        percent_cross_shard_(YCSB_PERCENT_CROSS_SHARD),
+        max_scan_length_(YCSB_MAX_SCAN_LENGTH), seed_(YCSB_SEED) {}
+
+  [[nodiscard]] uint64_t num_record() const { return num_record_; }
+
+  // "A" to "F"
+  [[nodiscard]] const std::string &workload() const { return workload_; }
+
+  // "zipfian", "latest" or "uniform"
+  [[nodiscard]] const std::string &distribution() const {
+    return distribution_;
+  }
+
+  [[nodiscard]] double zipf_theta() const { return zipf_theta_; }
+
+  [[nodiscard]] uint32_t ops_per_tx() const { return ops_per_tx_; }
+
+  [[nodiscard]] double percent_cross_shard() const {
+    return percent_cross_shard_;
+  }
+
+  [[nodiscard]] uint32_t max_scan_length() const { return max_scan_length_; }
+
+  [[nodiscard]] uint64_t seed() const { return seed_; }
+
+  void set_num_record(uint64_t v) { num_record_ = v; }
+
+  void set_workload(const std::string &v) { workload_ = v; }
+
+  void set_distribution(const std::string &v) { distribution_ = v; }
+
+  void set_zipf_theta(double v) { zipf_theta_ = v; }
+
+  void set_ops_per_tx(uint32_t v) { ops_per_tx_ = v; }
+
+  void set_percent_cross_shard(double v) { percent_cross_shard_ = v; }
+
+  void set_max_scan_length(uint32_t v) { max_scan_length_ = v; }
+
+  void set_seed(uint64_t v) { seed_ = v; }
+
+  boost::json::object to_json() const {
+    boost::json::object j;
+    j["num_record"] = num_record_;
+    j["workload"] = workload_;
+    j["distribution"] = distribution_;
+    j["zipf_theta"] = zipf_theta_;
+    j["ops_per_tx"] = ops_per_tx_;
+    j["percent_cross_shard"] = percent_cross_shard_;
+    j["max_scan_length"] = max_scan_length_;
+    j["seed"] = seed_;
+    return j;
+  }
+
+  void from_json(boost::json::object &j) {
+    num_record_ = boost::json::value_to<uint64_t>(j["num_record"]);
+    workload_ = boost::json::value_to<std::string>(j["workload"]);
+    distribution_ = boost::json::value_to<std::string>(j["distribution"]);
+    zipf_theta_ = boost::json::value_to<double>(j["zipf_theta"]);
+    ops_per_tx_ = boost::json::value_to<uint32_t>(j["ops_per_tx"]);
+    percent_cross_shard_ =
+        boost::json::value_to<double>(j["percent_cross_shard"]);
+    max_scan_length_ = boost::json::value_to<uint32_t>(j["max_scan_length"]);
+    seed_ = boost::json::value_to<uint64_t>(j["seed"]);
+  }
+};
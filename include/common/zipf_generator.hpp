@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+// the zipfian distribution of [0, n), rank 0 is the most frequent,
+// Gray et al., Quickly Generating Billion-Record Synthetic Databases
+// zeta(n) costs O(n), it is computed once and shared by the generators
+template<class INT_TYPE = uint64_t> class zipf_distribution {
+private:
+  INT_TYPE n_;
+  double theta_;
+  double alpha_;
+  double zeta_n_;
+  double eta_;
+  double half_pow_theta_;
+
+  static double zeta(INT_TYPE n, double theta) {
+    double sum = 0;
+    for (INT_TYPE i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(double(i), theta);
+    }
+    return sum;
+  }
+
+public:
+  // theta in (0, 1), YCSB uses 0.99
+  zipf_distribution(INT_TYPE n, double theta)
+      : n_(n < 1 ? 1 : n), theta_(theta), alpha_(1.0 / (1.0 - theta)),
+        zeta_n_(zeta(n_, theta)),
+        eta_((1.0 - std::pow(2.0 / double(n_), 1.0 - theta)) /
+             (1.0 - zeta(2, theta) / zeta_n_)),
+        half_pow_theta_(1.0 + std::pow(0.5, theta)) {}
+
+  INT_TYPE n() const { return n_; }
+
+  double theta() const { return theta_; }
+
+  // the rank of a value drawn uniformly from [0, 1)
+  INT_TYPE rank(double u) const {
+    double uz = u * zeta_n_;
+    if (uz < 1.0 || n_ == 1) {
+      return 0;
+    }
+    if (uz < half_pow_theta_) {
+      return 1;
+    }
+    auto r = INT_TYPE(double(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return r < n_ ? r : n_ - 1;
+  }
+};
+
+template<class INT_TYPE = uint64_t> class zipf_generator {
+private:
+  std::default_random_engine rand_;
+  std::uniform_real_distribution<double> real_;
+  std::shared_ptr<const zipf_distribution<INT_TYPE>> dist_;
+
+public:
+  zipf_generator(std::shared_ptr<const zipf_distribution<INT_TYPE>> dist,
+                 uint64_t seed)
+      : rand_(seed), real_(0.0, 1.0), dist_(std::move(dist)) {}
+
+  zipf_generator(INT_TYPE n, double theta, uint64_t seed = 0)
+      : zipf_generator(
+            std::make_shared<const zipf_distribution<INT_TYPE>>(n, theta),
+            seed) {}
+
+  INT_TYPE n() const { return dist_->n(); }
+
+  // the rank of a value
+  INT_TYPE generate() { return dist_->rank(real_(rand_)); }
+
+  // the popular values spread over [0, n) instead of being clustered at the
+  // head, YCSB scrambled zipfian
+  INT_TYPE generate_scrambled() {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint64_t v = generate();
+    for (int i = 0; i < 8; i++) {
+      h ^= (v & 0xff);
+      h *= 0x100000001b3ULL;
+      v >>= 8;
+    }
+    return INT_TYPE(h % uint64_t(dist_->n()));
+  }
+};
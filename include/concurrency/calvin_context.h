@@ -59,7 +59,8 @@ private:
   bool commit_;
   bool timeout_invoked_;
   uint64_t start_ms_;
-  ptr<timer> timer_ticker_;
+  // the transaction timeout, on the timing wheel of the context of strand
+  wheel_timer timer_ticker_;
 public:
   calvin_context(
           boost::asio::io_context::strand s, xid_t xid,
@@ -95,6 +96,11 @@ public:
 private:
   void send_read(const tx_operation &op);
   node_id_t shard2node(shard_id_t shard_id);
+#ifdef TX_TRACE
+  void async_tick_timeout();
+
+  void handle_tick_timeout();
+#endif
 };
 
 #endif // DB_TYPE_CALVIN
\ No newline at end of file
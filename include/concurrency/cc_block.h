@@ -4,7 +4,6 @@
 #include "common/config.h"
 #include "common/db_type.h"
 #include "common/hash_table.h"
-#include "common/msg_time.h"
 #include "common/timer.h"
 #include "concurrency/lock_mgr_global.h"
 #include "concurrency/calvin_collector.h"
@@ -14,6 +13,7 @@
 #include "concurrency/deadlock.h"
 #include "concurrency/tx_context.h"
 #include "concurrency/tx_coordinator.h"
+#include "concurrency/tx_slot_table.h"
 #include "concurrency/write_ahead_log.h"
 #include "access/access_mgr.h"
 #include "network/net_service.h"
@@ -26,17 +26,17 @@
 class cc_block : public block, public std::enable_shared_from_this<cc_block> {
 private:
 #ifdef DB_TYPE_NON_DETERMINISTIC
-  typedef concurrent_hash_table<uint64_t, ptr<tx_context>> context_table_t;
+  typedef tx_slot_table<tx_context> context_table_t;
+  typedef concurrent_hash_table<uint64_t,
+                                std::pair<ptr<connection>, ptr<tx_request>>>
+      replica_read_table_t;
 #ifdef DB_TYPE_SHARE_NOTHING
-  typedef concurrent_hash_table<uint64_t, ptr<tx_coordinator>>
-      coordinator_table_t;
+  typedef tx_slot_table<tx_coordinator> coordinator_table_t;
 #endif // DB_TYPE_SHARE_NOTHING
 #endif // #ifdef DB_TYPE_NON_DETERMINISTIC
 #ifdef DB_TYPE_CALVIN
-  typedef concurrent_hash_table<uint64_t, ptr<calvin_context>>
-      calvin_context_table_t;
-  typedef concurrent_hash_table<uint64_t, ptr<calvin_collector>>
-      calvin_collector_table_t;
+  typedef tx_slot_table<calvin_context> calvin_context_table_t;
+  typedef tx_slot_table<calvin_collector> calvin_collector_table_t;
 #endif // DB_TYPE_CALVIN
   config conf_;
   uint64_t cno_;
@@ -68,20 +68,21 @@ private:
   notify timer_clean_up_stop_;
 
 #ifdef DB_TYPE_NON_DETERMINISTIC
-  std::vector<context_table_t> tx_context_;
+  context_table_t tx_context_;
+  // read only transactions waiting the read index from RLB
+  replica_read_table_t replica_read_waiting_;
 #ifdef DB_TYPE_SHARE_NOTHING
-  std::vector<coordinator_table_t> tx_coordinator_;
+  coordinator_table_t tx_coordinator_;
 #endif // DB_TYPE_SHARE_NOTHING
 #endif // #ifdef DB_TYPE_NON_DETERMINISTIC
 #ifdef DB_TYPE_CALVIN
   boost::asio::io_context::strand strand_calvin_;
   ptr<calvin_scheduler> calvin_scheduler_;
   ptr<calvin_sequencer> calvin_sequencer_;
-  std::vector<calvin_context_table_t> calvin_context_;
-  std::vector<calvin_collector_table_t> calvin_collector_;
+  calvin_context_table_t calvin_context_;
+  calvin_collector_table_t calvin_collector_;
 #endif // DB_TYPE_CALVIN
   fn_schedule_after fn_schedule_after_;
-  msg_time time_;
 
   boost::asio::io_context::strand strand_ccb_tick_;
 
@@ -89,6 +90,23 @@ private:
       term_connection_table_t;
   term_connection_table_t term_connection_table_;
 
+  // the chunks of a warm up scan being cached
+  struct warm_up_recv {
+    uint64_t stream_;
+    std::atomic<uint64_t> cached_;
+    // the number of chunks, known when the last one is received
+    std::atomic<uint64_t> total_;
+    std::atomic<bool> failed_;
+
+    explicit warm_up_recv(uint64_t stream)
+        : stream_(stream), cached_(0), total_(UINT64_MAX), failed_(false) {}
+  };
+  typedef concurrent_hash_table<uint64_t, ptr<warm_up_recv>>
+      warm_up_recv_table_t;
+  // by term
+  warm_up_recv_table_t warm_up_recv_;
+  std::atomic<uint64_t> warm_up_stream_;
+
 public:
   cc_block(const config &conf, net_service *service,
            fn_schedule_before fn_before, fn_schedule_after fn_after);
@@ -130,6 +148,9 @@ private:
   result<void> ccb_handle_message(const ptr<connection>, message_type,
                                   const ptr<warm_up_resp> m);
 
+  result<void> ccb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<warm_up_chunk> m);
+
   result<void> ccb_handle_message(const ptr<connection>, message_type,
                                   const ptr<tx_request> m);
 
@@ -142,6 +163,9 @@ private:
   result<void> ccb_handle_message(const ptr<connection>, message_type,
                                   const ptr<dsb_read_response> m);
 
+  result<void> ccb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<rlb_read_index_response> m);
+
   result<void> ccb_handle_message(const ptr<connection>, message_type,
                                   const ptr<calvin_part_commit> m);
 
@@ -200,7 +224,8 @@ private:
 
 #ifdef DB_TYPE_NON_DETERMINISTIC
 
-  void create_tx_context(const ptr<connection> conn, const tx_request &req);
+  void create_tx_context(const ptr<connection> conn, const tx_request &req,
+                         bool replica_read);
 
   ptr<tx_context> create_tx_context_gut(xid_t xid, bool distributed,
                                         ptr<connection> conn);
@@ -212,6 +237,16 @@ private:
   void handle_non_deterministic_tx_request(const ptr<connection> conn,
                                            const ptr<tx_request> request);
 
+  void handle_replica_read_request(const ptr<connection> conn,
+                                   const ptr<tx_request> request);
+
+  void handle_read_index_response(const rlb_read_index_response &response);
+
+  // answer a read only transaction waiting the read index with ec
+  void response_replica_read(xid_t xid, EC ec);
+
+  void send_warm_up_ack(const ptr<warm_up_ack> ack);
+
 #ifdef DB_TYPE_SHARE_NOTHING
 
   void handle_tx_tm_request(const tx_request &req);
@@ -268,8 +303,10 @@ private:
 
   void debug_deadlock(std::ostream &os);
 
-  static void async_run_tx_routine(boost::asio::io_context::strand strand,
-                                   std::function<void()> routine);
+  // in thread-per-core mode, the routine is sent to the core of the strand by
+  // the lock-free mailbox of the cores
+  void async_run_tx_routine(boost::asio::io_context::strand strand,
+                            std::function<void()> routine);
 
   void strand_ccb_handle_state(ptr<connection> conn, ptr<ccb_state_req> req);
 
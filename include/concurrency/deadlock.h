@@ -12,6 +12,15 @@
 typedef std::function<void(xid_t)> fn_victim;
 typedef std::function<void(ptr<tx_wait> ds_out)> fn_handle_wait_set;
 typedef std::function<result<void>(fn_handle_wait_set)> fn_wait_lock;
+
+// a lock wait, its timer is re-armed until the wait ends
+struct lock_wait {
+  explicit lock_wait(fn_wait_lock fn) : fn_wait_(std::move(fn)) {}
+
+  wheel_timer timer_;
+  fn_wait_lock fn_wait_;
+};
+
 class deadlock : public ctx_strand,
                  public std::enable_shared_from_this<deadlock> {
 private:
@@ -62,6 +71,10 @@ private:
   void tick();
   void add_dependency(const ptr<dependency_set> ds);
 
+  void arm_wait_lock(const ptr<lock_wait> &wait);
+
+  void handle_wait_lock(const ptr<lock_wait> &wait);
+
   void detect();
   void async_victim(xid_t xid);
   void add_wait_set(const ptr<tx_wait> ws);
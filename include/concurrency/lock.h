@@ -8,6 +8,7 @@
 #include "concurrency/lock_pred.h"
 #include "concurrency/tx.h"
 #include <boost/date_time.hpp>
+#include <chrono>
 
 template<> enum_strings<lock_mode>::e2s_t enum_strings<lock_mode>::enum2str;
 
@@ -27,6 +28,8 @@ struct tx_lock_ctx {
   lock_mode type_;
   bool acquired_;
   ptr<predicate> predicate_;
+  // when the lock began to wait, the epoch if it has not waited
+  std::chrono::steady_clock::time_point wait_ts_;
 #ifdef TEST_TRACE_LOCK
   std::stringstream trace_;
   boost::posix_time::ptime time_acquire_;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "common/id.h"
+#include "common/ptr.hpp"
+#include "common/space_saving.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// the contention of the row locks of a lock manager, always on;
+// a lock request which waits is counted to the key in a space-saving sketch,
+// so the hot keys are kept in a bounded space;
+// each thread counts to sketches of its own, which top merges, so the waits
+// of the hot keys of a lock manager are not serialized on one mutex
+struct lock_contention_stat {
+  // the holders and the earlier waiters a wait queued behind
+  uint64_t conflict_;
+  // the waits granted, and the time they waited
+  uint64_t granted_;
+  uint64_t wait_us_;
+
+  lock_contention_stat() : conflict_(0), granted_(0), wait_us_(0) {}
+};
+
+struct lock_hot_key {
+  table_id_t table_id_;
+  shard_id_t shard_id_;
+  tuple_id_t key_;
+  // the waits of the key, over-estimated by error_ at most
+  uint64_t wait_;
+  uint64_t error_;
+  lock_contention_stat stat_;
+};
+
+class lock_contention {
+private:
+  // the sketches of one thread, the mutex is contended only by top
+  struct thread_sketch {
+    thread_sketch();
+
+    std::mutex mutex_;
+    // counted by the waits
+    space_saving<tuple_id_t, lock_contention_stat> wait_;
+    // counted by the grants of the waits, a wait may be granted by another
+    // thread than the one it waits on
+    space_saving<tuple_id_t, lock_contention_stat> granted_;
+  };
+
+  uint64_t id_;
+  std::mutex mutex_;
+  std::vector<ptr<thread_sketch>> sketches_;
+
+public:
+  lock_contention();
+
+  // a request of key waits, conflict is the number of the transactions it
+  // queued behind; deferred until flush
+  void on_wait(tuple_id_t key, uint64_t conflict);
+
+  // deferred until flush
+  void on_granted(tuple_id_t key, uint64_t wait_us);
+
+  // count the waits and grants deferred by the calling thread, called after
+  // the lock slot mutex is released
+  static void flush();
+
+  // the k keys of the most waits
+  std::vector<lock_hot_key> top(table_id_t table_id, shard_id_t shard_id,
+                                size_t k);
+
+private:
+  thread_sketch &local();
+};
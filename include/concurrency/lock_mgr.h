@@ -7,6 +7,7 @@
 #include "common/tx_wait.h"
 #include "concurrency/deadlock.h"
 #include "concurrency/lock.h"
+#include "concurrency/lock_contention.h"
 #include "concurrency/lock_mgr_trait.h"
 #include "concurrency/lock_pred.h"
 #include "concurrency/lock_slot.h"
@@ -42,6 +43,14 @@ struct tx_conflict {
 };
 
 typedef std::map<xid_t, tx_conflict> tx_conflict_set;
+
+// a row lock of a batch, e.g. the operations of a calvin epoch
+struct row_lock_request {
+  oid_t oid_;
+  lock_mode lt_;
+  tuple_id_t key_;
+  ptr<tx_rm> tx_;
+};
 typedef boost::icl::interval_map<tuple_id_t, tx_conflict_set> predicate_map;
 
 class lock_mgr : public lock_mgr_trait {
@@ -55,6 +64,7 @@ private:
   fn_schedule_after fn_after_;
   lock_table_t key_row_locks_;
   boost::asio::io_context::strand strand_;
+  lock_contention contention_;
 
 public:
   lock_mgr(table_id_t table_id, shard_id_t, boost::asio::io_context &context, deadlock *dl,
@@ -69,12 +79,21 @@ public:
 
   void lock(xid_t xid, oid_t oid, lock_mode lt, predicate key, ptr<tx_rm> txn);
 
+  // acquire the row locks in the order of requests, the lock slots are
+  // looked up in a batch
+  void lock_rows(std::vector<row_lock_request> requests);
+
   void unlock(uint64_t xid, lock_mode mode, predicate key);
 
   void debug_lock(std::ostream &os);
 
   void debug_dependency(tx_wait_set &dep);
 
+  lock_contention &contention() { return contention_; }
+
+  // the k keys of the most lock waits
+  std::vector<lock_hot_key> hot_keys(size_t k);
+
 private:
   void lock_gut(
 
@@ -84,6 +103,8 @@ private:
 
   void row_lock(oid_t oid, lock_mode lt, tuple_id_t key, const ptr<tx_rm> &tx);
 
+  void lock_rows_gut(const std::vector<row_lock_request> &requests);
+
   std::pair<ptr<lock_slot>, bool> get_lock_slot(tuple_id_t key);
 
   std::pair<ptr<lock_slot>, bool> find_slot(tuple_id_t key);
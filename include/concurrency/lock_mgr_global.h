@@ -34,6 +34,9 @@ public:
   void lock_row(xid_t xid, oid_t op_id, lock_mode lt, uint32_t table_id, uint32_t shard_id,
                 const predicate &key, const ptr<tx_rm> &tx);
 
+  void lock_rows(uint32_t table_id, uint32_t shard_id,
+                 std::vector<row_lock_request> requests);
+
   void unlock(xid_t xid, lock_mode lt, uint32_t table_id, uint32_t shard_id,
               const predicate &pred);
 			  
@@ -51,4 +54,8 @@ public:
 
   void debug_dependency(tx_wait_set &dep);
 
+  // the hot keys of every table, of the most lock waits
+  std::map<table_id_t, std::vector<lock_hot_key>> hot_keys(size_t k);
+
+  void debug_hot_key(std::ostream &os, bool as_json);
 };
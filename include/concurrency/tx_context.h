@@ -12,6 +12,7 @@
 #include "common/ptr.hpp"
 #include "common/time_tracer.h"
 #include "common/tuple.h"
+#include "common/tx_span.h"
 #include "concurrency/lock_mgr_global.h"
 #include "concurrency/tx.h"
 #include "concurrency/deadlock.h"
@@ -107,9 +108,21 @@ private:
   uint32_t num_read_violate_;
   uint32_t num_write_violate_;
   uint32_t num_lock_;
-  ptr<timer> timer_tick_;
+  // the transaction timeout, on the timing wheel of the context of strand
+  wheel_timer timer_tick_;
   bool timeout_invoked_;
   bool read_only_;
+  // a read only transaction served by a follower, its CCB cache is stale
+  bool replica_read_;
+  uint64_t client_seq_;
+  // sampled by the client, the spans of the transaction are recorded
+  bool traced_;
+  uint64_t trace_id_;
+  uint32_t terminal_id_;
+  uint64_t construct_ns_;
+  tx_span lock_wait_span_;
+  tx_span read_span_;
+  tx_span append_span_;
 public:
   tx_context(boost::asio::io_context::strand s, uint64_t xid, uint32_t node_id,
              std::optional<node_id_t> rlb_node_id,
@@ -121,12 +134,18 @@ public:
 
   virtual ~tx_context() = default;
 
+  // the dispatch span of a sampled transaction begins when it is created, an
+  // unsampled one reads no clock
+  void begin_dispatch_span() { construct_ns_ = tx_span_now_ns(); }
+
   void begin();
 
   void async_lock_acquire(EC ec, oid_t oid) override;
 
   bool distributed() const { return distributed_; }
 
+  void set_replica_read() { replica_read_ = true; }
+
   void notify_lock_acquire(EC ec, const ptr<std::vector<ptr<tx_context>>> &in);
 
   void process_tx_request(const tx_request &req);
@@ -196,6 +215,12 @@ private:
 
   void handle_finish_tx_phase1_abort();
 
+#ifdef TX_TRACE
+  void async_tick_timeout();
+
+  void handle_tick_timeout();
+#endif
+
 #ifdef DB_TYPE_SHARE_NOTHING
 public:
   void on_prepare_committed_log_commit();
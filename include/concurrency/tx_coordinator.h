@@ -8,6 +8,7 @@
 #include "common/enum_str.h"
 #include "common/error_code.h"
 #include "common/result.hpp"
+#include "common/tx_span.h"
 #include "concurrency/write_ahead_log.h"
 #include "network/connection.h"
 #include "network/net_service.h"
@@ -94,6 +95,13 @@ private:
   uint32_t num_lock_;
   uint32_t num_read_violate_;
   uint32_t num_write_violate_;
+  uint64_t client_seq_;
+  // sampled by the client, the spans of the coordinator are recorded
+  bool traced_;
+  uint64_t trace_id_;
+  uint32_t terminal_id_;
+  uint64_t construct_ns_;
+  tx_span commit_span_;
 
 public:
   tx_coordinator(boost::asio::io_context::strand s, uint64_t xid,
@@ -104,6 +112,9 @@ public:
 
   virtual ~tx_coordinator() = default;
 
+  // the dispatch span of a sampled transaction begins when it is created
+  void begin_dispatch_span() { construct_ns_ = tx_span_now_ns(); }
+
   uint64_t xid() const { return xid_; }
 
   result<void> handle_tx_request(const tx_request &req);
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "common/hash_table.h"
+#include "common/id.h"
+#include "common/ptr.hpp"
+#include "common/variable.h"
+#include <array>
+#include <atomic>
+#include <boost/assert.hpp>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// the transactions in flight by terminal, a terminal has TX_SLOTS_PER_TERMINAL
+// slots in a cache aligned block, a slot is tagged by the xid of the
+// transaction it keeps;
+// a lookup scans the tags of the terminal without lock, a miss takes no lock,
+// a hit copies the value under the spin lock of the slot and checks the tag
+// again, an xid is never reused, so a slot reused by another transaction
+// does not match;
+// insert and remove of a terminal are serialized by the terminal,
+// the transactions of the terminals beyond the slots, or of the terminals out
+// of range, are kept in the overflow hash table
+template<class VALUE> class tx_slot_table {
+private:
+  struct alignas(64) terminal_slots {
+    terminal_slots() : xid_(), locked_(), overflow_(0), writing_(false) {}
+
+    // 0 if the slot is empty
+    std::array<std::atomic<xid_t>, TX_SLOTS_PER_TERMINAL> xid_;
+    std::array<std::atomic<bool>, TX_SLOTS_PER_TERMINAL> locked_;
+    // the transactions of this terminal in the overflow table
+    std::atomic<uint32_t> overflow_;
+    // serializes insert and remove of the terminal
+    std::atomic<bool> writing_;
+    std::array<ptr<VALUE>, TX_SLOTS_PER_TERMINAL> value_;
+  };
+
+  // held for a few instructions, by a slot to copy or set its value, and by
+  // a terminal to insert or remove
+  class spin_lock {
+  private:
+    std::atomic<bool> &locked_;
+
+  public:
+    explicit spin_lock(std::atomic<bool> &locked) : locked_(locked) {
+      while (locked_.exchange(true, std::memory_order_acquire)) {
+        while (locked_.load(std::memory_order_relaxed)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    ~spin_lock() { locked_.store(false, std::memory_order_release); }
+  };
+
+  std::unique_ptr<terminal_slots[]> terminals_;
+  size_t num_terminal_;
+  std::atomic<uint64_t> overflow_out_of_range_;
+  concurrent_hash_table<xid_t, ptr<VALUE>> overflow_;
+
+public:
+  tx_slot_table() : num_terminal_(0), overflow_out_of_range_(0), overflow_(16) {}
+
+  // not thread safe, called before the table is used
+  void resize(size_t num_terminal) {
+    terminals_.reset(new terminal_slots[num_terminal]);
+    num_terminal_ = num_terminal;
+  }
+
+  std::pair<ptr<VALUE>, bool> find(uint32_t terminal_id, xid_t xid) {
+    if (xid == 0) {
+      // the tag of the empty slots
+      return std::make_pair(ptr<VALUE>(), false);
+    }
+    if (terminal_id < num_terminal_) {
+      terminal_slots &t = terminals_[terminal_id];
+      for (uint32_t i = 0; i < TX_SLOTS_PER_TERMINAL; i++) {
+        if (t.xid_[i].load(std::memory_order_relaxed) != xid) {
+          continue;
+        }
+        spin_lock l(t.locked_[i]);
+        if (t.xid_[i].load(std::memory_order_relaxed) == xid) {
+          return std::make_pair(t.value_[i], true);
+        }
+      }
+      if (t.overflow_.load(std::memory_order_acquire) == 0) {
+        return std::make_pair(ptr<VALUE>(), false);
+      }
+    } else if (overflow_out_of_range_.load(std::memory_order_acquire) == 0) {
+      return std::make_pair(ptr<VALUE>(), false);
+    }
+    return overflow_.find(xid);
+  }
+
+  // false if xid exists
+  bool insert(uint32_t terminal_id, xid_t xid, const ptr<VALUE> &value) {
+    BOOST_ASSERT(xid != 0);
+    if (terminal_id >= num_terminal_) {
+      ptr<VALUE> v = value;
+      bool ok = overflow_.insert(xid, v);
+      if (ok) {
+        overflow_out_of_range_++;
+      }
+      return ok;
+    }
+    terminal_slots &t = terminals_[terminal_id];
+    spin_lock l(t.writing_);
+    uint32_t empty = TX_SLOTS_PER_TERMINAL;
+    for (uint32_t i = 0; i < TX_SLOTS_PER_TERMINAL; i++) {
+      xid_t x = t.xid_[i].load(std::memory_order_relaxed);
+      if (x == xid) {
+        return false;
+      } else if (x == 0 && empty == TX_SLOTS_PER_TERMINAL) {
+        empty = i;
+      }
+    }
+    if (t.overflow_.load(std::memory_order_relaxed) != 0 &&
+        overflow_.find(xid).second) {
+      return false;
+    }
+    if (empty < TX_SLOTS_PER_TERMINAL) {
+      spin_lock sl(t.locked_[empty]);
+      t.value_[empty] = value;
+      t.xid_[empty].store(xid, std::memory_order_relaxed);
+      return true;
+    }
+    ptr<VALUE> v = value;
+    if (overflow_.insert(xid, v)) {
+      t.overflow_++;
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  bool remove(uint32_t terminal_id, xid_t xid) {
+    if (terminal_id >= num_terminal_) {
+      bool ok = overflow_.remove(xid);
+      if (ok) {
+        overflow_out_of_range_--;
+      }
+      return ok;
+    }
+    ptr<VALUE> removed;
+    terminal_slots &t = terminals_[terminal_id];
+    spin_lock l(t.writing_);
+    for (uint32_t i = 0; i < TX_SLOTS_PER_TERMINAL; i++) {
+      if (t.xid_[i].load(std::memory_order_relaxed) == xid) {
+        spin_lock sl(t.locked_[i]);
+        t.xid_[i].store(0, std::memory_order_relaxed);
+        removed.swap(t.value_[i]);
+        return true;
+      }
+    }
+    if (t.overflow_.load(std::memory_order_relaxed) != 0 &&
+        overflow_.remove(xid)) {
+      t.overflow_--;
+      return true;
+    }
+    return false;
+  }
+
+  // fn_xid_value(xid, value) for the transactions
+  template<class FN_XID_VALUE> void traverse(FN_XID_VALUE &&fn_xid_value) {
+    for (size_t n = 0; n < num_terminal_; n++) {
+      terminal_slots &t = terminals_[n];
+      for (uint32_t i = 0; i < TX_SLOTS_PER_TERMINAL; i++) {
+        if (t.xid_[i].load(std::memory_order_relaxed) == 0) {
+          continue;
+        }
+        xid_t xid = 0;
+        ptr<VALUE> value;
+        {
+          spin_lock l(t.locked_[i]);
+          xid = t.xid_[i].load(std::memory_order_relaxed);
+          value = t.value_[i];
+        }
+        if (xid != 0) {
+          fn_xid_value(xid, value);
+        }
+      }
+    }
+    overflow_.traverse(fn_xid_value);
+  }
+};
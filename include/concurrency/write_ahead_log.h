@@ -5,6 +5,7 @@
 #include "network/net_service.h"
 #include "proto/proto.h"
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
 
@@ -18,12 +19,39 @@ private:
   net_service *service_;
   std::recursive_mutex mutex_;
 
+  // credit based flow control, RLB grants credits back when committing logs
+  uint64_t credit_bytes_max_;
+  uint64_t credit_bytes_;
+  uint64_t pending_bytes_max_;
+  std::atomic<uint64_t> pending_bytes_;
+  std::deque<ptr<ccb_append_log_request>> pending_;
+
 public:
-  write_ahead_log(node_id_t node_id, node_id_t rlb_node, net_service *service);
+  write_ahead_log(node_id_t node_id, node_id_t rlb_node,
+                  uint64_t credit_bytes, uint64_t pending_bytes_max,
+                  net_service *service);
 
   void set_cno(uint64_t cno);
 
   void async_append(tx_log_binary &entry);
 
-  void async_append(std::vector<tx_log_binary> &entry);
-};
\ No newline at end of file
+  // shard_map[i] is the shard map of entry[i]
+  void async_append(std::vector<tx_log_binary> &entry,
+                    const std::vector<shard_map_t> &shard_map);
+
+  void add_credit(uint64_t bytes);
+
+  // RLB failed to append the logs, their credits may never be granted back,
+  // the window restarts as a new term does
+  void reset_credit();
+
+  // too many logs are waiting for credits, no more transactions are accepted
+  bool overloaded() const {
+    return pending_bytes_.load() >= pending_bytes_max_;
+  }
+
+private:
+  void send_append_log_request(const ptr<ccb_append_log_request> &req);
+
+  void send_pending();
+};
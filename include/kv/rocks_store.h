@@ -32,6 +32,13 @@ public:
 
   result<ptr<tuple_pb>> get(table_id_t table_id, tuple_id_t tuple_id);
 
+  result<ptr<store_snapshot>> create_snapshot();
+
+  result<ptr<store_snapshot>> create_scan(table_id_t table_id,
+                                          tuple_id_t lower, tuple_id_t upper);
+
+  result<void> install_snapshot(const dsb_snapshot_chunk &chunk);
+
   void close();
 
   result<void> sync();
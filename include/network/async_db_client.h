@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common/config.h"
+#include "common/ptr.hpp"
+#include "common/result.hpp"
+#include "network/client.h"
+#include "proto/proto.h"
+#include <atomic>
+#include <boost/asio.hpp>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+// the response of a transaction, ec is not EC_OK when the connection failed
+// before the response arrived
+typedef std::function<void(EC ec, const tx_response &response)>
+    fn_tx_response;
+
+// a client keeping many transactions in flight on one connection, the
+// responses are matched to the requests by client_seq; at most window
+// transactions are in flight, the others wait in the client. The IO and the
+// callbacks run on the io_context passed in, a few threads running it drive
+// many clients
+class async_db_client : public std::enable_shared_from_this<async_db_client> {
+private:
+  struct waiting_tx {
+    ptr<tx_request> request_;
+    fn_tx_response fn_;
+  };
+
+  az_id_t az_id_;
+  node_config conf_;
+  boost::asio::io_context::strand strand_;
+  ptr<client> cli_;
+  uint32_t window_;
+  uint64_t next_seq_;
+  // accessed on strand_ only
+  std::unordered_map<uint64_t, fn_tx_response> in_flight_;
+  std::deque<waiting_tx> waiting_;
+  // the transactions in flight or waiting
+  std::atomic<uint64_t> num_outstanding_;
+
+public:
+  async_db_client(boost::asio::io_context &context, az_id_t az_id,
+                  node_config conf, uint32_t window);
+
+  bool connect();
+
+  // thread safe, fn is invoked on the strand of this client
+  void async_submit(const ptr<tx_request> &request, fn_tx_response fn);
+
+  [[nodiscard]] uint64_t num_outstanding() const {
+    return num_outstanding_.load();
+  }
+
+  [[nodiscard]] uint32_t window() const { return window_; }
+
+  [[nodiscard]] node_id_t peer_id() const { return conf_.node_id(); }
+
+  void close();
+
+private:
+  void send(waiting_tx tx);
+
+  void send_waiting();
+
+  result<void> handle_message(message_type id, byte_buffer &buffer);
+
+  void handle_response(EC ec, const tx_response &response);
+
+  void fail_all(EC ec);
+};
@@ -4,11 +4,11 @@
 #include "common/define.h"
 #include "common/id.h"
 #include "common/message.h"
-#include "common/msg_time.h"
 #include "common/ptr.hpp"
 #include "common/panic.h"
 #include "common/read_write_pb.hpp"
 #include "common/result.hpp"
+#include "network/frame_compress.h"
 #include "network/message_handler.h"
 #include <boost/archive/polymorphic_binary_oarchive.hpp>
 #include <boost/endian/conversion.hpp>
@@ -17,6 +17,8 @@
 #include <boost/iostreams/stream.hpp>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 using boost_ec = boost::system::error_code;
 using boost::asio::ip::tcp;
@@ -25,8 +27,19 @@ class sender;
 // do not use private inheritance
 class connection : public std::enable_shared_from_this<connection> {
 private:
+  // a segment of the send queue, [begin_, end_) of a buffer of serialized
+  // messages, or a payload shared with other connections
+  struct send_segment {
+    ptr<byte_buffer> buffer_;
+    uint64_t begin_;
+    uint64_t end_;
+    ptr<const std::string> payload_;
+  };
+
   node_id_t peer_;
   message_handler handler_;
+  // invoked on the strand when the peer closed or the connection failed
+  std::function<void(berror)> error_handler_;
   uint64_t offset_;
   ptr<tcp::socket> socket_;
   // there may be more than one write IO action at a time, so mutex is necessary
@@ -36,52 +49,82 @@ private:
   byte_buffer recv_buf_;
   std::stringstream ssm_;
   byte_buffer send_buf_;
-  std::vector<ptr<byte_buffer>> send_msg_pending_;
+  // messages waiting to be written, and the ones being written
+  std::vector<send_segment> send_queue_;
+  std::vector<send_segment> send_writing_;
+  // the buffer messages are serialized into, shared by the segments
+  ptr<byte_buffer> send_tail_;
+  std::vector<boost::asio::const_buffer> send_iov_;
+  std::vector<ptr<byte_buffer>> send_buf_pool_;
+  // bodies not smaller than compress_min_bytes_ are compressed by compress_
+  compress_codec compress_;
+  uint64_t compress_min_bytes_;
+  byte_buffer compress_buf_;
+  byte_buffer decompress_buf_;
 
   bool connected_;
   bool client_;
   bool writing_in_action_;
-  msg_time time1_;
-  msg_time time2_;
+  // messages are queued but not written when write is held
+  bool write_held_;
   boost::asio::io_context::strand strand_;
   uint64_t read_start_;
 
 public:
   connection(boost::asio::io_context::strand s, node_id_t id)
-      : peer_(id), offset_(0), connected_(false), client_(true),
-        writing_in_action_(false), time1_("conn"), strand_(s) {}
+      : peer_(id), offset_(0), compress_(COMPRESS_NONE),
+        compress_min_bytes_(0), compress_buf_(0), decompress_buf_(0),
+        connected_(false), client_(true), writing_in_action_(false),
+        write_held_(false), strand_(s) {}
 
   connection(boost::asio::io_context::strand s, ptr<tcp::socket> socket,
              message_handler handler, bool client)
-      : handler_(handler), offset_(0), socket_(socket),
-        connected_(socket_->is_open()), client_(client),
-        writing_in_action_(false), time1_("conn"), strand_(s) {}
+      : peer_(0), handler_(handler), offset_(0), socket_(socket),
+        compress_(COMPRESS_NONE), compress_min_bytes_(0), compress_buf_(0),
+        decompress_buf_(0), connected_(socket_->is_open()), client_(client),
+        writing_in_action_(false), write_held_(false), strand_(s) {}
 
   const boost::asio::io_context::strand &get_strand() const { return strand_; }
 
+  // 0 if the connection is accepted
+  node_id_t peer_id() const { return peer_; }
+
   void connected();
 
   virtual void connected(ptr<tcp::socket> sock, message_handler h);
 
   virtual ~connection() {
     close();
-    // time1_.print();
-    // LOG(info) << "time2:";
-    // time2_.print();
   }
 
   void close();
 
   void async_read();
 
-  void async_write(const byte_buffer &buffer);
+  void async_write();
 
   void async_read_done(berror ec, size_t bytes_recv);
 
   void async_write_done();
 
+  // queue the messages sent until release_write, and write them at once
+  void hold_write() { write_held_ = true; }
+
+  void release_write();
+
+  // compress the messages sent on this connection, the peer decompresses the
+  // frames flagged compressed
+  void set_compress(compress_codec codec, uint64_t min_bytes) {
+    compress_ = codec;
+    compress_min_bytes_ = min_bytes;
+  }
+
   void set_handler(message_handler handler) { handler_ = handler; };
 
+  void set_error_handler(std::function<void(berror)> handler) {
+    error_handler_ = std::move(handler);
+  }
+
   result<void> process_message_buffer();
 
   result<void> process_message_body(message_type msg_id, msg_hdr *hdr);
@@ -194,14 +237,38 @@ public:
   template<typename M>
   result<void> async_send(message_type id, const ptr<M> msg,
                           bool non_connect = false) {
-    return gut_async_send(id, msg, non_connect);
+    return gut_async_send(id, msg, {}, non_connect);
+  }
+
+  // the message body is msg followed by the payload, serialized fields of M,
+  // such as the raft log entries sent to several followers; the payload is
+  // written without being copied
+  template<typename M>
+  result<void> async_send(message_type id, const ptr<M> msg,
+                          const std::vector<ptr<const std::string>> &payload,
+                          bool non_connect = false) {
+    return gut_async_send(id, msg, payload, non_connect);
   }
 
 private:
   template<typename M>
-  result<void> gut_async_send(message_type id, const ptr<M> msg,
-                              bool non_connect = false) {
+  result<void>
+  gut_async_send(message_type id, const ptr<M> msg,
+                 const std::vector<ptr<const std::string>> &payload,
+                 bool non_connect = false) {
 #ifdef DEBUG_NETWORK_SEND_RECV
+    if (not payload.empty()) {
+      // the tailer follows the body, merge the payload into the message
+      std::string body = msg->SerializeAsString();
+      for (const auto &p : payload) {
+        body.append(*p);
+      }
+      auto merged = cs_new<M>();
+      if (not merged->ParseFromString(body)) {
+        return outcome::failure(EC::EC_MARSHALL_ERROR);
+      }
+      return gut_async_send(id, merged, {}, non_connect);
+    }
     fn_msg_hdr fn = [this](msg_hdr &hdr) {
       hdr.set_offset(offset_);
       this->debug_hdr_send(hdr);
@@ -209,44 +276,131 @@ private:
 #else // TRACE_MESSAGE
     fn_msg_hdr fn = nullptr;
 #endif
+    if (not connected_ && not non_connect) {
+      return outcome::failure(EC::EC_NET_UNCONNECTED);
+    }
+    result<void> res = append_send_queue(id, *msg, payload, fn);
+    if (not res) {
+      LOG(fatal) << "proto_to_buf error";
+      return outcome::failure(EC::EC_MARSHALL_ERROR);
+    }
     if (not connected_) {
-      if (non_connect) {
-        ptr<byte_buffer> buf(cs_new<byte_buffer>());
-        result<void> res = proto_to_buf(*buf, id, *msg, fn);
-        if (not res) {
-          return res;
-        }
-        send_msg_pending_.push_back(buf);
-        return outcome::failure(EC::EC_NET_UNCONNECTED);
-      } else {
-        return outcome::failure(EC::EC_NET_UNCONNECTED);
-      }
+      // sent after connected
+      return outcome::failure(EC::EC_NET_UNCONNECTED);
+    }
+    if (not writing_in_action_ && not write_held_) {
+      // no message sending in action ...
+      async_write();
+    }
+    return outcome::success();
+  }
+
+  template<typename M>
+  result<void>
+  append_send_queue(message_type id, const M &msg,
+                    const std::vector<ptr<const std::string>> &payload,
+                    fn_msg_hdr fn) {
+    uint64_t payload_size = 0;
+    for (const auto &p : payload) {
+      payload_size += p->size();
     }
-    if (not writing_in_action_) { // no message sending in action ...
-      send_buf_.reset();
-      result<void> res = proto_to_buf(send_buf_, id, *msg, fn);
-      if (not res) {
-        return res;
+#ifndef DEBUG_NETWORK_SEND_RECV
+    if (compress_ != COMPRESS_NONE &&
+        msg.ByteSizeLong() + payload_size >= compress_min_bytes_) {
+      return append_compressed(id, msg, payload, payload_size);
+    }
+#endif
+    size_t size = msg.ByteSizeLong() + msg_hdr::size() * 2;
+    reserve_send_tail(size);
+    uint64_t begin = send_tail_->get_write_pos();
+    result<void> res = proto_to_buf(*send_tail_, id, msg, payload_size, fn);
+    if (not res) {
+      return res;
+    }
+    append_send_tail(begin, send_tail_->get_write_pos());
+    for (const auto &p : payload) {
+      if (not p->empty()) {
+        send_queue_.push_back(send_segment{nullptr, 0, p->size(), p});
       }
-      writing_in_action_ = true;
-      async_write(send_buf_);
-      return outcome::success();
+    }
+    return outcome::success();
+  }
+
+  // serialize msg and the payload, and queue them compressed, the payload is
+  // copied
+  template<typename M>
+  result<void>
+  append_compressed(message_type id, const M &msg,
+                    const std::vector<ptr<const std::string>> &payload,
+                    uint64_t payload_size) {
+    size_t msg_size = msg.ByteSizeLong();
+    size_t body_size = msg_size + payload_size;
+    compress_buf_.reset();
+    compress_buf_.resize_write_available_size(body_size);
+    if (not msg.SerializeToArray(compress_buf_.data(), int(msg_size))) {
+      return outcome::failure(EC::EC_MARSHALL_ERROR);
+    }
+    size_t pos = msg_size;
+    for (const auto &p : payload) {
+      std::memcpy(compress_buf_.data() + pos, p->data(), p->size());
+      pos += p->size();
+    }
+
+    size_t bound = frame_compress_bound(compress_, body_size);
+    reserve_send_tail(msg_hdr::size() + std::max(bound, body_size));
+    uint64_t begin = send_tail_->get_write_pos();
+    int8_t *out = send_tail_->write_begin() + msg_hdr::size();
+    msg_hdr header;
+    header.set_type(id);
+    size_t n = frame_compress(compress_, id, compress_buf_.data(), body_size,
+                              out, bound);
+    if (n > 0 && n < body_size) {
+      header.set_compressed();
     } else {
-      if (send_msg_pending_.empty() ||
-          (not send_msg_pending_.empty() &&
-              (*send_msg_pending_.rbegin())->size() > MESSAGE_BUFFER_SIZE)) {
-        // create a new buffer
-        send_msg_pending_.push_back(ptr<byte_buffer>(new byte_buffer()));
-      }
+      // incompressible
+      std::memcpy(out, compress_buf_.data(), body_size);
+      n = body_size;
+    }
+    header.set_length(msg_hdr::size() + n);
+    std::memcpy(send_tail_->write_begin(), &header, msg_hdr::size());
+    send_tail_->set_write_pos(begin + msg_hdr::size() + n);
+    append_send_tail(begin, send_tail_->get_write_pos());
+    return outcome::success();
+  }
 
-      ptr<byte_buffer> &last = *send_msg_pending_.rbegin();
-      result<void> res = proto_to_buf(*last, id, *msg, fn);
-      if (not res) {
-        LOG(fatal) << "proto_to_buf error";
-        return outcome::failure(EC::EC_MARSHALL_ERROR);
-      } else {
-        return outcome::success();
-      }
+  // serialize into the tail buffer when it has enough space, a buffer being
+  // written is never resized, so its segments stay valid
+  void reserve_send_tail(size_t size) {
+    if (not send_tail_ || send_tail_->write_available_size() < size) {
+      send_tail_ = size > MESSAGE_BUFFER_SIZE ? cs_new<byte_buffer>(size)
+                                              : alloc_send_buffer();
+    }
+  }
+
+  void append_send_tail(uint64_t begin, uint64_t end) {
+    if (not send_queue_.empty() && send_queue_.back().buffer_ == send_tail_ &&
+        send_queue_.back().end_ == begin) {
+      send_queue_.back().end_ = end;
+    } else {
+      send_queue_.push_back(send_segment{send_tail_, begin, end, nullptr});
+    }
+  }
+
+  ptr<byte_buffer> alloc_send_buffer() {
+    if (send_buf_pool_.empty()) {
+      return cs_new<byte_buffer>();
+    }
+    ptr<byte_buffer> buffer = send_buf_pool_.back();
+    send_buf_pool_.pop_back();
+    return buffer;
+  }
+
+  void free_send_buffer(const ptr<byte_buffer> &buffer) {
+    // only the fixed size buffers no segment refers to are pooled
+    if (buffer.use_count() == 1 && buffer->size() == MESSAGE_BUFFER_SIZE &&
+        send_buf_pool_.size() < SEND_BUFFER_POOL_SIZE) {
+      buffer->reset();
+      send_buf_pool_.push_back(buffer);
     }
   }
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// the lock-free queues between the cores of thread-per-core mode,
+// queue [from][to] is pushed by the thread of core from only, and consumed by
+// the thread of core to only
+class core_mailbox {
+public:
+  typedef std::function<void()> fn_task;
+
+private:
+  typedef boost::lockfree::spsc_queue<fn_task> queue_t;
+  size_t num_cores_;
+  std::vector<std::unique_ptr<queue_t>> queue_;
+  std::unique_ptr<std::atomic<bool>[]> drain_scheduled_;
+  // the tasks of queue [from][to] posted around it after it was full, and
+  // not run yet
+  std::unique_ptr<std::atomic<uint64_t>[]> overflow_;
+
+public:
+  core_mailbox(size_t num_cores, size_t capacity)
+      : num_cores_(num_cores),
+        drain_scheduled_(new std::atomic<bool>[num_cores]),
+        overflow_(new std::atomic<uint64_t>[num_cores * num_cores]) {
+    for (size_t i = 0; i < num_cores * num_cores; i++) {
+      queue_.emplace_back(new queue_t(capacity));
+      overflow_[i].store(0);
+    }
+    for (size_t i = 0; i < num_cores; i++) {
+      drain_scheduled_[i].store(false);
+    }
+  }
+
+  // return false when the queue is full
+  bool push(uint32_t from, uint32_t to, const fn_task &task) {
+    return queue_[from * num_cores_ + to]->push(task);
+  }
+
+  // while the tasks posted around queue [from][to] have not all run, the
+  // later ones are posted too, or they would overtake them
+  bool overflowed(uint32_t from, uint32_t to) const {
+    return overflow_[from * num_cores_ + to].load() != 0;
+  }
+
+  void begin_overflow(uint32_t from, uint32_t to) {
+    overflow_[from * num_cores_ + to].fetch_add(1);
+  }
+
+  void end_overflow(uint32_t from, uint32_t to) {
+    overflow_[from * num_cores_ + to].fetch_sub(1);
+  }
+
+  // return true if the caller must schedule a drain on core to
+  bool schedule_drain(uint32_t to) {
+    return not drain_scheduled_[to].exchange(true);
+  }
+
+  // run the tasks sent to core to
+  size_t drain(uint32_t to) {
+    drain_scheduled_[to].store(false);
+    size_t n = 0;
+    for (size_t from = 0; from < num_cores_; from++) {
+      n += queue_[from * num_cores_ + to]->consume_all(
+          [](const fn_task &task) { task(); });
+    }
+    return n;
+  }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "common/byte_buffer.h"
+#include "common/message.h"
+#include "common/result.hpp"
+#include <ostream>
+#include <string>
+
+// compression of the message bodies sent over the WAN links;
+// a compressed body is the codec (1 byte), the size of the raw body (8 bytes,
+// little endian) and the compressed bytes, and msg_hdr is flagged compressed
+enum compress_codec {
+  COMPRESS_NONE = 0,
+  COMPRESS_LZ4 = 1,
+  COMPRESS_ZSTD = 2,
+};
+
+// "none", "lz4" or "zstd"
+compress_codec str_to_compress_codec(const std::string &str);
+
+const size_t FRAME_COMPRESS_HEADER_SIZE = 9;
+
+size_t frame_compress_bound(compress_codec codec, size_t size);
+
+// compress [data, data + size) to out, return the bytes written, 0 on error
+size_t frame_compress(compress_codec codec, message_type id, const int8_t *data,
+                      size_t size, int8_t *out, size_t out_size);
+
+// decompress a compressed body to [read_pos, write_pos) of out
+result<void> frame_decompress(message_type id, const int8_t *data, size_t size,
+                              byte_buffer &out);
+
+// compression ratio and CPU time of each message type
+void frame_compress_stats(std::ostream &os);
@@ -48,14 +48,13 @@ public:
 
   result<void> process(ptr<connection> conn, message_type id,
                        byte_buffer &buffer, msg_hdr *hdr) override {
-    ptr<T> message(new T());
     if (hdr!=nullptr) {
     }
-    auto r1 = buf_to_proto(buffer, *message);
+    auto r1 = buf_to_arena_proto<T>(buffer);
     if (not r1) {
-      return r1;
+      return r1.error();
     }
-    auto r2 = this->process_msg(conn, id, message);
+    auto r2 = this->process_msg(conn, id, r1.value());
     return r2;
   }
 
@@ -172,11 +171,13 @@ std::map<message_block, std::map<message_type, processor *>>
          {R2C_REGISTER_RESP, NP(rlb_register_ccb_response)},
          {COMMIT_LOG_ENTRIES, NP(rlb_commit_entries)},
          {D2C_READ_DATA_RESP, NP(dsb_read_response)},
+         {R2C_READ_INDEX_RESP, NP(rlb_read_index_response)},
 
          {CLIENT_TX_REQ, NP(tx_request)},
          {CLIENT_CCB_STATE_REQ, NP(ccb_state_req)},
          {CCB_HANDLE_WARM_UP_REQ, NP(warm_up_req)},
          {CCB_HANDLE_WARM_UP_RESP, NP(warm_up_resp)},
+         {D2C_WARM_UP_CHUNK, NP(warm_up_chunk)},
          {TX_TM_COMMIT, NP(tx_tm_commit)},
          {TX_TM_ABORT, NP(tx_tm_abort)},
          {TX_TM_END, NP(tx_tm_end)},
@@ -197,10 +198,14 @@ std::map<message_block, std::map<message_type, processor *>>
     {MESSAGE_BLOCK_DSB,
      {
          {DSB_HANDLE_WARM_UP_REQ, NP(warm_up_req)},
+         {C2D_WARM_UP_ACK, NP(warm_up_ack)},
          {C2D_READ_DATA_REQ, NP(ccb_read_request)},
          {R2D_REGISTER_RESP, NP(rlb_register_dsb_response)},
          {CLIENT_LOAD_DATA_REQ, NP(client_load_data_request)},
          {R2D_REPLAY_TO_DSB_REQ, NP(replay_to_dsb_request)},
+         {R2D_SNAPSHOT_REQ, NP(rlb_snapshot_request)},
+         {D2D_SNAPSHOT_CHUNK, NP(dsb_snapshot_chunk)},
+         {D2D_SNAPSHOT_ACK, NP(dsb_snapshot_ack)},
          {DSB_ERROR_CONSISTENCY, NP(error_consistency)},
      }},
     {MESSAGE_BLOCK_RLB,
@@ -213,11 +218,15 @@ std::map<message_block, std::map<message_type, processor *>>
          {RAFT_PRE_VOTE_RESP, NP(pre_vote_response)},
          {RAFT_TRANSFER_LEADER, NP(transfer_leader)},
          {RAFT_TRANSFER_NOTIFY, NP(transfer_notify)},
+         {RAFT_READ_INDEX_REQ, NP(read_index_request)},
+         {RAFT_READ_INDEX_RESP, NP(read_index_response)},
          {C2R_APPEND_LOG_REQ, NP(ccb_append_log_request)},
          {D2R_WRITE_BATCH_RESP, NP(replay_to_dsb_response)},
          {C2R_REGISTER_REQ, NP(ccb_register_ccb_request)},
          {D2R_REGISTER_REQ, NP(dsb_register_dsb_request)},
          {C2R_REPORT_STATUS_RESP, NP(ccb_report_status_response)},
+         {C2R_READ_INDEX_REQ, NP(ccb_read_index_request)},
+         {D2R_SNAPSHOT_INSTALLED, NP(dsb_snapshot_installed)},
      }},
     {MESSAGE_BLOCK_CLI,
      {
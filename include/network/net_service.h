@@ -4,16 +4,20 @@
 #include "common/define.h"
 #include "common/id.h"
 #include "common/message.h"
+#include "common/metrics.h"
 #include "common/ptr.hpp"
 #include "common/result.hpp"
-#include "common/scoped_time.h"
 #include "common/set_thread_name.h"
 #include "common/variable.h"
 #include "network/client.h"
 #include "network/connection.h"
+#include "network/core_mailbox.h"
 #include "network/future.hpp"
 #include "network/message_handler.h"
+#include "network/net_shaper.h"
 #include "network/sender.h"
+#include "network/shm_ring.h"
+#include "network/timing_wheel.h"
 #include <atomic>
 #include <boost/asio.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -42,8 +46,57 @@ enum service_type {
 template<>
 enum_strings<service_type>::e2s_t enum_strings<service_type>::enum2str;
 
+// the messages sent, received and the time to handle a received message, by
+// message type
+extern metric_family<metric_counter, message_type, MESSAGE_END> messages_sent;
+extern metric_family<metric_counter, message_type, MESSAGE_END>
+    messages_received;
+extern metric_family<metric_histogram, message_type, MESSAGE_END>
+    message_handle_us;
+
 class net_service : public sender,
                     public std::enable_shared_from_this<net_service> {
+private:
+  typedef std::function<result<void>(const ptr<client> &)> fn_client_send;
+
+  // the messages to a peer buffered by async_send_remote, and flushed together
+  // on the strand of the connections to the peer
+  struct peer_send_queue {
+    peer_send_queue() : flush_scheduled_(false) {}
+
+    std::mutex mutex_;
+    std::vector<fn_client_send> pending_;
+    bool flush_scheduled_;
+  };
+
+  // a message to a peer on the same host waiting for its ring to be freed,
+  // and how it is sent by TCP if the ring is given up
+  struct shm_pending {
+    std::string data_;
+    std::function<void()> send_tcp_;
+  };
+
+  // the ring of the messages to a peer on the same host, the ring is opened
+  // after the peer creates it, and opened again after the peer restarts
+  struct shm_peer {
+    shm_peer()
+        : open_after_ms_(0), check_after_ms_(0), offset_(0), progress_ms_(0),
+          drain_scheduled_(false) {}
+
+    std::mutex mutex_;
+    std::string name_;
+    ptr<shm_ring> ring_;
+    uint64_t open_after_ms_;
+    uint64_t check_after_ms_;
+    // the messages sent while the ring is full, written in order as the
+    // reader frees the ring, the first one is written up to offset_
+    std::deque<shm_pending> backlog_;
+    uint64_t offset_;
+    // the last time the backlog was written to the ring
+    uint64_t progress_ms_;
+    bool drain_scheduled_;
+  };
+
 public:
   config conf_;
   std::atomic<bool> started_;
@@ -53,6 +106,27 @@ public:
   std::unordered_map<uint32_t, node_config> peers_;
 
   std::unordered_map<uint32_t, std::vector<ptr<client>>> out_coming_conn_;
+  std::unordered_map<uint32_t, ptr<peer_send_queue>> peer_send_queue_;
+  bool send_coalesce_;
+  uint64_t send_coalesce_delay_us_;
+  // thread-per-core mode, io_context_ are the single-threaded contexts of the
+  // cores, each run by a pinned thread
+  bool thread_per_core_;
+  uint32_t num_cores_;
+  std::atomic<uint64_t> next_core_;
+  std::unordered_map<boost::asio::io_context *, uint32_t> core_index_;
+  std::unique_ptr<core_mailbox> core_mailbox_;
+  bool shm_transport_;
+  std::unordered_map<uint32_t, ptr<shm_peer>> shm_out_;
+  // the rings read by this node, replaced by their reader threads when they
+  // are closed
+  std::mutex shm_in_mutex_;
+  std::vector<std::pair<std::string, ptr<shm_ring>>> shm_in_;
+  // the messages to the shaped zones are delayed by the timing wheel of the
+  // async context of the link, whichever context they are sent on
+  std::unique_ptr<net_shaper> shaper_;
+  std::unordered_map<boost::asio::io_context *, ptr<timing_wheel>>
+      timing_wheel_;
   boost::ptr_vector<boost::asio::io_context> io_context_;
   std::vector<std::pair<service_type, uint32_t>> io_context_threads_;
   typedef boost::asio::executor_work_guard<
@@ -87,6 +161,24 @@ public:
 
   boost::asio::io_context &get_service(service_type type);
 
+  // in thread-per-core mode, the context of the core which key is mapped to,
+  // otherwise, the same as get_service(type)
+  boost::asio::io_context &get_service(service_type type, uint64_t key);
+
+  // the timing wheel of a context of get_service
+  timing_wheel &get_timing_wheel(boost::asio::io_context &context);
+
+  bool thread_per_core() const { return thread_per_core_; }
+
+  uint32_t num_cores() const { return num_cores_; }
+
+  // the core of the calling thread, CORE_NONE if it is not a core thread
+  static uint32_t current_core();
+
+  // post fn to a core context, through the mailbox of the cores when the
+  // caller is the thread of another core
+  void core_post(boost::asio::io_context &context, std::function<void()> fn);
+
   void async_client_connect(const ptr<client> &client);
 
   void resolve_connect(ptr<client> client);
@@ -99,23 +191,28 @@ public:
 
   virtual result<ptr<client>> get_connection(uint32_t id);
 
+  // send the messages buffered to a peer without waiting the delay
+  void flush(node_id_t node_id);
+
   template<typename PB_MSG>
   void conn_async_send(ptr<connection> c, message_type mt,
-                       const ptr<PB_MSG> m) {
-    auto id = conf_.node_id();
-    boost::asio::post(c->get_strand(), [c, mt, m, id]() {
-      scoped_time _t((boost::format("net_service::conn_async_send message %s")%
-          enum2str(mt))
-                         .str());
-      result<void> r = c->template async_send(mt, m, false);
-      if (not r) {
-        if (r.error().code()!=EC::EC_NET_UNCONNECTED) {
-          LOG(error) << id_2_name(id) << " async send message error, "
-                     << r.error().message() << " " << enum2str(mt);
-        }
+                       const ptr<PB_MSG> m,
+                       std::vector<ptr<const std::string>> payload = {}) {
+    if (shaper_) {
+      uint64_t bytes = msg_hdr::size() + m->ByteSizeLong();
+      for (const ptr<const std::string> &p : payload) {
+        bytes += p->size();
       }
-    });
+      auto s = shared_from_this();
+      if (shaper_->shape(c->peer_id(), bytes, [s, c, mt, m, payload] {
+            s->conn_post_send(c, mt, m, payload);
+          })) {
+        return;
+      }
+    }
+    conn_post_send(c, mt, m, std::move(payload));
   }
+
   template<typename PB_MSG>
   result<void> async_send(uint32_t node_id, message_type mt,
                           const ptr<PB_MSG> m, bool non_connect_send = false) {
@@ -129,11 +226,30 @@ public:
 
 private:
   void service_thread(service_type st, size_t n);
+
+  void core_thread(uint32_t core);
+
+  template<typename PB_MSG>
+  void conn_post_send(const ptr<connection> &c, message_type mt,
+                      const ptr<PB_MSG> &m,
+                      std::vector<ptr<const std::string>> payload) {
+    auto id = conf_.node_id();
+    boost::asio::post(c->get_strand(), [c, mt, m, id, payload]() {
+      messages_sent[mt].inc();
+      result<void> r = c->template async_send(mt, m, payload, false);
+      if (not r) {
+        if (r.error().code()!=EC::EC_NET_UNCONNECTED) {
+          LOG(error) << id_2_name(id) << " async send message error, "
+                     << r.error().message() << " " << enum2str(mt);
+        }
+      }
+    });
+  }
+
   template<typename PB_MSG>
   result<void> async_send_local(message_type mt, const ptr<PB_MSG> m) {
     auto s = shared_from_this();
     auto fn = [s, mt, m]() {
-      scoped_time _t("net_service::async_send_local");
       auto rh = s->local_handler_(nullptr, mt, m);
       if (not rh) {
       }
@@ -147,14 +263,51 @@ private:
   template<typename PB_MSG>
   void async_send_remote(uint32_t node_id, message_type mt, const ptr<PB_MSG> m,
                          bool non_connect_send = false) {
+    if (shaper_) {
+      auto s = shared_from_this();
+      if (shaper_->shape(node_id, msg_hdr::size() + m->ByteSizeLong(),
+                         [s, node_id, mt, m, non_connect_send] {
+                           s->async_send_transport(node_id, mt, m,
+                                                   non_connect_send);
+                         })) {
+        return;
+      }
+    }
+    async_send_transport(node_id, mt, m, non_connect_send);
+  }
+
+  template<typename PB_MSG>
+  void async_send_transport(uint32_t node_id, message_type mt,
+                            const ptr<PB_MSG> &m, bool non_connect_send) {
+    messages_sent[mt].inc();
+    if (shm_transport_) {
+      auto iter = shm_out_.find(node_id);
+      if (iter != shm_out_.end() &&
+          shm_send(node_id, iter->second, mt, m, non_connect_send)) {
+        return;
+      }
+    }
+    async_send_tcp(node_id, mt, m, non_connect_send);
+  }
+
+  template<typename PB_MSG>
+  void async_send_tcp(uint32_t node_id, message_type mt, const ptr<PB_MSG> &m,
+                      bool non_connect_send) {
+    if (send_coalesce_) {
+      auto iter = peer_send_queue_.find(node_id);
+      if (iter != peer_send_queue_.end()) {
+        coalesce_send(node_id, iter->second,
+                      [mt, m, non_connect_send](const ptr<client> &c) {
+                        return c->async_send(mt, m, non_connect_send);
+                      });
+        return;
+      }
+    }
     result<ptr<client>> r = get_connection(node_id);
     if (r) {
       ptr<client> c = r.value();
       auto service = shared_from_this();
       boost::asio::post(c->get_strand(), [service, c, mt, m, non_connect_send] {
-        scoped_time _t(
-            (boost::format("net_service::async_send_remote %s")%enum2str(mt))
-                .str());
         result<void> sr = c->async_send(mt, m, non_connect_send);
         if (sr.has_failure() && sr.error().code()==EC_NET_UNCONNECTED) {
           service->async_client_connect(c);
@@ -166,6 +319,77 @@ private:
     }
   }
 
+  // write the message to the shared memory ring of the peer, false if the
+  // ring is not available and the message must be sent by TCP;
+  // the messages to a peer with an open ring all go through the ring, of any
+  // size, so they are handled in order; the sender never waits, a message
+  // which does not fit is queued in the backlog of the peer, written by
+  // shm_drain as the reader frees the ring
+  template<typename PB_MSG>
+  bool shm_send(uint32_t node_id, const ptr<shm_peer> &peer, message_type mt,
+                const ptr<PB_MSG> &m, bool non_connect_send) {
+    std::scoped_lock l(peer->mutex_);
+    if (peer->backlog_.empty()) {
+      if (not shm_open_peer(peer)) {
+        return false;
+      }
+      if (msg_hdr::size() + m->ByteSizeLong() <=
+          peer->ring_->max_record_size()) {
+        result<void> r = peer->ring_->write(mt, *m, false);
+        if (r) {
+          return true;
+        }
+        if (r.error().code() != EC_INSUFFICIENT_SPACE) {
+          // the peer has stopped, or the ring is closed, it is opened again
+          // after the peer creates it again
+          peer->ring_.reset();
+          peer->open_after_ms_ =
+              steady_clock_ms_since_epoch() + SHM_RING_RETRY_MILLIS;
+          return false;
+        }
+      }
+      peer->progress_ms_ = steady_clock_ms_since_epoch();
+    }
+    shm_pending pending;
+    result<void> rs = shm_ring::serialize(mt, *m, pending.data_);
+    if (not rs) {
+      LOG(error) << "serialize message " << enum2str(mt) << " error "
+                 << rs.error().message();
+      return true;
+    }
+    auto s = shared_from_this();
+    pending.send_tcp_ = [s, node_id, mt, m, non_connect_send] {
+      s->async_send_tcp(node_id, mt, m, non_connect_send);
+    };
+    peer->backlog_.push_back(std::move(pending));
+    shm_drain(peer);
+    return true;
+  }
+
+  // called with the mutex of peer held, write the backlog of peer to its
+  // ring, and schedule another drain if the ring is still full; the backlog
+  // is sent by TCP when the reader has not read it for
+  // SHM_RING_STALL_MILLIS, or the ring is closed
+  void shm_drain(const ptr<shm_peer> &peer);
+
+  void shm_schedule_drain(const ptr<shm_peer> &peer);
+
+  bool shm_open_peer(const ptr<shm_peer> &peer);
+
+  void shm_start();
+
+  // read the i-th ring of shm_in_, the messages read are handled on a strand
+  void shm_receive(size_t i);
+
+  void coalesce_send(node_id_t node_id, const ptr<peer_send_queue> &queue,
+                     fn_client_send fn);
+
+  void schedule_flush(node_id_t node_id, const ptr<peer_send_queue> &queue,
+                      uint64_t delay_us);
+
+  // called on the strand of c
+  void flush_peer(const ptr<client> &c, const ptr<peer_send_queue> &queue);
+
   void handle_connect_done(ptr<client> client, ptr<tcp::socket> sock,
                            berror err);
 
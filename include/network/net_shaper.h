@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common/config.h"
+#include "common/id.h"
+#include "common/ptr.hpp"
+#include "network/timing_wheel.h"
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+// simulates the WAN links from the zone of this node to the other zones,
+// a message is delivered after it is transmitted at the bandwidth of the link
+// and then propagated with the latency and jitter of the link; the messages
+// on a link are delivered in the order they are sent, as by TCP, they are
+// delayed on the one timing wheel of the link
+class net_shaper {
+private:
+  struct link {
+    link()
+        : latency_us_(0), jitter_us_(0), bandwidth_mbps_(0), wheel_(nullptr),
+          busy_until_us_(0), last_deliver_us_(0) {}
+
+    uint64_t latency_us_;
+    uint64_t jitter_us_;
+    uint64_t bandwidth_mbps_;
+    timing_wheel *wheel_;
+    std::mutex mutex_;
+    // the link transmits the messages sent before until this time
+    uint64_t busy_until_us_;
+    uint64_t last_deliver_us_;
+  };
+
+  // the links to the zones, by the AZ id of the receivers
+  std::unordered_map<az_id_t, ptr<link>> links_;
+
+public:
+  // wheel_of returns the timing wheel of the link to a zone
+  net_shaper(const config &conf,
+             const std::function<timing_wheel &(az_id_t)> &wheel_of);
+
+  bool empty() const { return links_.empty(); }
+
+  // delay fn to the time a message of bytes sent to node_id is delivered,
+  // false if the link to node_id is not shaped; the time is taken and fn is
+  // armed under the lock of the link, the messages sent one after another
+  // fire in the order they are sent
+  bool shape(node_id_t node_id, uint64_t bytes, std::function<void()> fn);
+};
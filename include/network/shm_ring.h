@@ -0,0 +1,155 @@
+#pragma once
+
+#include "common/byte_buffer.h"
+#include "common/ptr.hpp"
+#include "common/read_write_pb.hpp"
+#include "common/result.hpp"
+#include <atomic>
+#include <cstring>
+#include <string>
+
+// a single-producer single-consumer ring of messages in a POSIX shared memory
+// segment, the transport of the blocks on the same host;
+// a record is an 8 bytes length followed by msg_hdr and message body, records
+// are contiguous, a record which would wrap is placed at the ring begin after
+// a skip record; a message larger than max_record_size() is split into
+// records flagged in their length, so a message of any size is sent in order
+// with the others;
+// the reader and the writer sleep on futex only when the ring is empty or
+// full, and are woken only when the other side sleeps; a writer which does
+// not wait fails when the ring is full, a writer which waits fails when the
+// reader has not read for SHM_RING_STALL_MILLIS; write_from writes a message
+// in parts as the reader frees the ring, and never waits
+class shm_ring {
+private:
+  struct alignas(64) ring_header {
+    uint64_t magic_;
+    // a reader restarted creates the segment of the same name again, with
+    // another generation
+    uint64_t generation_;
+    uint64_t capacity_;
+    std::atomic<uint32_t> closed_;
+
+    alignas(64) std::atomic<uint64_t> write_pos_;
+    // futex word of the reader
+    std::atomic<uint32_t> write_seq_;
+    std::atomic<uint32_t> reader_waiting_;
+
+    alignas(64) std::atomic<uint64_t> read_pos_;
+    // futex word of the writer
+    std::atomic<uint32_t> read_seq_;
+    std::atomic<uint32_t> writer_waiting_;
+  };
+
+  std::string name_;
+  bool owner_;
+  size_t map_size_;
+  ring_header *header_;
+  int8_t *data_;
+  uint64_t generation_;
+  uint64_t capacity_;
+  uint64_t spin_;
+  // the records of a split message read so far
+  std::string fragment_;
+
+public:
+  // create the ring read by this process, the segment is removed when it is
+  // destroyed
+  static result<ptr<shm_ring>> create(const std::string &name,
+                                      uint64_t capacity);
+
+  // open the ring created by the reader
+  static result<ptr<shm_ring>> open(const std::string &name);
+
+  ~shm_ring();
+
+  const std::string &name() const { return name_; }
+
+  bool is_closed() const { return header_->closed_.load() != 0; }
+
+  // false if the segment of the name is not the one mapped, the reader has
+  // crashed and created it again, or has removed it
+  bool is_current() const;
+
+  // wake and stop the reader and the writer, the messages not read yet are
+  // dropped
+  void close();
+
+  // the largest record, a record and the skipped bytes ahead of it always
+  // fit in the ring
+  uint64_t max_record_size() const { return capacity_ / 2 - 16; }
+
+  // write a message, when the ring is full, wait while the reader reads if
+  // wait is true, otherwise fail with EC_INSUFFICIENT_SPACE; a message split
+  // into records is never left partially written, the ring is closed if the
+  // reader stalls in the middle of it
+  template<typename PROTOBUF>
+  result<void> write(message_type id, const PROTOBUF &msg, bool wait = true) {
+    size_t body_size = msg.ByteSizeLong();
+    uint64_t length = msg_hdr::size() + body_size;
+    if (length > max_record_size()) {
+      std::string data;
+      result<void> rs = serialize(id, msg, data);
+      if (not rs) {
+        return rs;
+      }
+      return write_split(data, wait);
+    }
+    msg_hdr header;
+    header.set_type(id);
+    header.set_length(length);
+    int8_t *p = nullptr;
+    result<void> r = reserve(length, false, &p, wait);
+    if (not r) {
+      return r;
+    }
+    std::memcpy(p, &header, msg_hdr::size());
+    if (not msg.SerializeToArray(p + msg_hdr::size(), int(body_size))) {
+      return outcome::failure(EC::EC_MARSHALL_ERROR);
+    }
+    commit(length);
+    return outcome::success();
+  }
+
+  // the header and body of a message, as written by write_from
+  template<typename PROTOBUF>
+  static result<void> serialize(message_type id, const PROTOBUF &msg,
+                                std::string &data) {
+    size_t body_size = msg.ByteSizeLong();
+    uint64_t length = msg_hdr::size() + body_size;
+    msg_hdr header;
+    header.set_type(id);
+    header.set_length(length);
+    data.assign(length, '\0');
+    std::memcpy(data.data(), &header, msg_hdr::size());
+    if (not msg.SerializeToArray(data.data() + msg_hdr::size(),
+                                 int(body_size))) {
+      return outcome::failure(EC::EC_MARSHALL_ERROR);
+    }
+    return outcome::success();
+  }
+
+  // write the records of a serialized message from offset without waiting,
+  // offset is advanced past the bytes written; fail with
+  // EC_INSUFFICIENT_SPACE when the ring is full before the end, the caller
+  // writes the rest later, before any other message
+  result<void> write_from(const std::string &data, uint64_t &offset);
+
+  // read a message to buffer, [read_pos, write_pos) of buffer is the body,
+  // wait until there is a message or the ring is closed
+  result<void> read(byte_buffer &buffer, msg_hdr &hdr);
+
+private:
+  shm_ring(const std::string &name, bool owner, size_t map_size,
+           ring_header *header);
+
+  // a contiguous space of a record with length bytes, followed by the other
+  // records of its message if more is true; wait while the ring is full and
+  // the reader reads if wait is true
+  result<void> reserve(uint64_t length, bool more, int8_t **p, bool wait);
+
+  // write the records of a message larger than a record
+  result<void> write_split(const std::string &data, bool wait);
+
+  void commit(uint64_t length);
+};
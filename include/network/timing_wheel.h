@@ -0,0 +1,128 @@
+#pragma once
+
+#include "common/ptr.hpp"
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class timing_wheel;
+
+// a timer node embedded in the object it times, armed on a timing_wheel;
+// the node must not be armed on two wheels at a time
+class wheel_timer {
+  friend class timing_wheel;
+
+private:
+  wheel_timer *prev_;
+  wheel_timer *next_;
+  uint64_t tick_;
+  uint32_t level_;
+  uint32_t slot_;
+  // the wheel the node is armed on, nullptr if not armed
+  std::atomic<timing_wheel *> wheel_;
+  std::function<void()> fn_;
+  // the nodes allocated by timing_wheel::schedule_at, freed after fired
+  bool owned_;
+
+public:
+  wheel_timer();
+
+  wheel_timer(const wheel_timer &) = delete;
+
+  wheel_timer &operator=(const wheel_timer &) = delete;
+
+  ~wheel_timer();
+
+  bool armed() const { return wheel_.load() != nullptr; }
+
+  // false if the timer is not armed, or has fired
+  bool cancel();
+};
+
+// a hierarchical timing wheel driven by a single steady_timer of an
+// io_context, arm and cancel are O(1);
+// level l has WHEEL_SLOTS slots of WHEEL_SLOTS^l ticks, a node far from the
+// current tick is placed on a higher level and cascades down when the wheel
+// reaches its slot; the steady_timer is armed only to the next tick which
+// expires or cascades nodes, and not armed when the wheel is empty;
+// the callbacks run on the context, in the order of their deadline ticks
+// and then the order they are armed
+class timing_wheel : public std::enable_shared_from_this<timing_wheel> {
+  friend class wheel_timer;
+
+public:
+  static const uint32_t WHEEL_LEVELS = 4;
+  static const uint32_t WHEEL_SLOT_BITS = 8;
+  static const uint32_t WHEEL_SLOTS = 1u << WHEEL_SLOT_BITS;
+
+private:
+  struct slot_list {
+    slot_list() : head_(nullptr), tail_(nullptr) {}
+
+    wheel_timer *head_;
+    wheel_timer *tail_;
+  };
+
+  struct wheel_level {
+    std::array<slot_list, WHEEL_SLOTS> slots_;
+    // the non-empty slots
+    std::array<uint64_t, WHEEL_SLOTS / 64> occupied_;
+  };
+
+  boost::asio::io_context &context_;
+  boost::asio::steady_timer timer_;
+  uint64_t tick_us_;
+  std::mutex mutex_;
+  std::array<wheel_level, WHEEL_LEVELS> levels_;
+  // the next tick to process, the ticks before it are expired
+  uint64_t current_tick_;
+  // the tick steady_timer is armed to, UINT64_MAX if not armed
+  uint64_t armed_tick_;
+  uint64_t size_;
+  bool stopped_;
+
+public:
+  timing_wheel(boost::asio::io_context &context, uint64_t tick_us);
+
+  boost::asio::io_context &context() { return context_; }
+
+  uint64_t tick_us() const { return tick_us_; }
+
+  // arm node to run fn at deadline_us, microseconds of steady clock since
+  // epoch, the node is re-armed if it is armed; false if the wheel is stopped
+  // and the node is not armed, once true the node may have fired, and an
+  // owned node freed, by another thread
+  bool arm_at(wheel_timer &node, uint64_t deadline_us, std::function<void()> fn);
+
+  void arm_after(wheel_timer &node, uint64_t delay_us, std::function<void()> fn);
+
+  // run fn at deadline_us with a node owned by the wheel
+  void schedule_at(uint64_t deadline_us, std::function<void()> fn);
+
+  void schedule_after(uint64_t delay_us, std::function<void()> fn);
+
+  // the callbacks not run are dropped
+  void stop();
+
+  uint64_t size();
+
+private:
+  // must hold mutex_ for the following functions
+  void link(wheel_timer *node, uint64_t tick);
+
+  void unlink(wheel_timer *node);
+
+  // the next tick which expires or cascades nodes, UINT64_MAX if empty
+  uint64_t next_event_tick() const;
+
+  void cascade(uint32_t level, uint32_t slot);
+
+  void arm_timer(uint64_t tick);
+
+  bool cancel(wheel_timer *node);
+
+  void handle_tick();
+};
@@ -2,15 +2,19 @@
 
 #include "common/bench_result.h"
 #include "common/config.h"
+#include "common/hdr_histogram.h"
 #include "common/id.h"
 #include "common/panic.h"
 #include "common/tuple.h"
 #include "common/tuple_gen.h"
 #include "common/uniform_generator.hpp"
+#include "network/async_db_client.h"
 #include "network/client.h"
 #include "network/db_client.h"
 #include "network/net_service.h"
+#include "portal/ycsb.h"
 #include "proto/proto.h"
+#include <array>
 #include <atomic>
 #include <boost/date_time.hpp>
 #include <boost/format.hpp>
@@ -26,9 +30,68 @@ using std::vector;
 
 const static uint32_t PERCENT_BASE = 10000;
 
+enum bench_tx_type {
+  TPCC_TX_NEW_ORDER = 0,
+  TPCC_TX_PAYMENT = 1,
+  TPCC_TX_ORDER_STATUS = 2,
+  TPCC_TX_DELIVERY = 3,
+  TPCC_TX_STOCK_LEVEL = 4,
+  // the read only transactions out of the TPC-C mix, percent_read_only
+  TPCC_TX_READ_ONLY = 5,
+  YCSB_TX_READ_ONLY = 6,
+  YCSB_TX_READ_WRITE = 7,
+  BENCH_TX_TYPES = 8,
+};
+
+inline const char *bench_tx_type_name(uint32_t type) {
+  static const char *names[BENCH_TX_TYPES] = {
+      "new_order", "payment", "order_status", "delivery",
+      "stock_level", "read_only", "ycsb_read_only", "ycsb_read_write"};
+  return type < BENCH_TX_TYPES ? names[type] : "unknown";
+}
+
+struct tx_type_statistic {
+  // the latency of the committed transactions
+  std::chrono::nanoseconds commit_duration{0};
+  uint32_t num_tx{0};
+  uint32_t num_commit{0};
+  uint32_t num_abort{0};
+
+  void add(const tx_type_statistic &r) {
+    commit_duration += r.commit_duration;
+    num_tx += r.num_tx;
+    num_commit += r.num_commit;
+    num_abort += r.num_abort;
+  }
+};
+
+typedef std::array<tx_type_statistic, BENCH_TX_TYPES> tx_type_statistics;
+
+// the latency histograms of the committed transactions, in microseconds
+enum latency_phase {
+  LATENCY_TOTAL = 0,
+  LATENCY_LOCK_WAIT = 1,
+  LATENCY_APPEND = 2,
+  LATENCY_REPLICATE = 3,
+  LATENCY_READ_DSB = 4,
+  LATENCY_PART = 5,
+  LATENCY_PHASES = 6,
+};
+
+// the keys of bench_result
+inline const char *latency_phase_name(uint32_t phase) {
+  static const char *names[LATENCY_PHASES] = {
+      "lt", "lt_lock", "lt_app", "lt_app_rlb", "lt_read_dsb", "lt_part"};
+  return phase < LATENCY_PHASES ? names[phase] : "unknown";
+}
+
+typedef std::array<hdr_histogram, LATENCY_PHASES> latency_histograms;
+
 struct tpm_statistic {
   tpm_statistic() { reset(); }
 
+  // the wall clock time the statistics are collected in, summed over the
+  // terminals
   std::chrono::nanoseconds duration;
   std::chrono::nanoseconds commit_duration;
   std::chrono::nanoseconds duration_append_log;
@@ -44,6 +107,8 @@ struct tpm_statistic {
   uint32_t num_lock;
   uint32_t num_read_violate;
   uint32_t num_write_violate;
+  tx_type_statistics tx_type;
+  latency_histograms latency;
 
   void reset() {
     duration_part = duration_lock_wait = duration_replicate_log =
@@ -52,6 +117,10 @@ struct tpm_statistic {
 
     num_part = num_tx = num_commit = num_abort = num_lock = num_read_violate =
         num_write_violate = 0;
+    tx_type.fill(tx_type_statistic());
+    for (hdr_histogram &h : latency) {
+      h.reset();
+    }
   }
 
   void add(const tpm_statistic &r) {
@@ -70,6 +139,12 @@ struct tpm_statistic {
     num_lock += r.num_lock;
     num_read_violate += r.num_read_violate;
     num_write_violate += r.num_write_violate;
+    for (uint32_t i = 0; i < BENCH_TX_TYPES; i++) {
+      tx_type[i].add(r.tx_type[i]);
+    }
+    for (uint32_t i = 0; i < LATENCY_PHASES; i++) {
+      latency[i].add(r.latency[i]);
+    }
   }
 
   void to_proto(tpm_stat & proto) {
@@ -87,6 +162,20 @@ struct tpm_statistic {
     proto.set_num_abort( num_abort);
     proto.set_num_part( num_part);
     proto.set_num_lock( num_lock);
+    for (const tx_type_statistic &t : tx_type) {
+      tpm_tx_type_stat *s = proto.add_tx_type();
+      s->set_commit_duration(t.commit_duration.count());
+      s->set_num_tx(t.num_tx);
+      s->set_num_commit(t.num_commit);
+      s->set_num_abort(t.num_abort);
+    }
+    for (const hdr_histogram &h : latency) {
+      tpm_histogram *hp = proto.add_latency();
+      h.for_each([hp](size_t index, uint64_t count) {
+        hp->add_index(uint32_t(index));
+        hp->add_count(count);
+      });
+    }
   }
 
   void from_proto(const tpm_stat &proto) {
@@ -103,9 +192,27 @@ struct tpm_statistic {
     num_abort = proto.num_abort();
     num_part = proto.num_part();
     num_lock = proto.num_lock();
+    tx_type.fill(tx_type_statistic());
+    for (int i = 0; i < proto.tx_type_size() && i < BENCH_TX_TYPES; i++) {
+      const tpm_tx_type_stat &s = proto.tx_type(i);
+      tx_type[i].commit_duration = std::chrono::nanoseconds(s.commit_duration());
+      tx_type[i].num_tx = s.num_tx();
+      tx_type[i].num_commit = s.num_commit();
+      tx_type[i].num_abort = s.num_abort();
+    }
+    for (hdr_histogram &h : latency) {
+      h.reset();
+    }
+    for (int i = 0; i < proto.latency_size() && i < LATENCY_PHASES; i++) {
+      const tpm_histogram &hp = proto.latency(i);
+      for (int j = 0; j < hp.index_size() && j < hp.count_size(); j++) {
+        latency[i].add_at(hp.index(j), hp.count(j));
+      }
+    }
   }
 
-  bench_result compute_bench_result(uint32_t num_term, const std::string & name);
+  bench_result compute_bench_result(uint32_t num_term, const std::string & name,
+                                    double offered_tps);
 };
 
 struct per_terminal {
@@ -117,8 +224,18 @@ struct per_terminal {
   uint32_t num_dist_;
   node_id_t node_id_;
   ptr<db_client> client_conn_;
+  // the replica in the same AZ serves read only transactions
+  ptr<db_client> replica_conn_;
   std::vector<tx_request> requests_;
+  // the transaction type of each request
+  std::vector<bench_tx_type> tx_types_;
+  // the next order to deliver of a district, by district key
+  std::map<uint64_t, uint32_t> delivery_oid_;
+  uint32_t num_history_{0};
   tpm_statistic result_;
+  // the wall clock time of the last update, the throughput is computed from
+  // the elapsed time, as the latencies overlap in a pipelined terminal
+  std::chrono::steady_clock::time_point update_ts_;
   std::map<node_id_t, ptr<db_client>> client_set_;
   std::vector<node_id_t> nodes_id_set_;
 
@@ -127,6 +244,8 @@ struct per_terminal {
 
   void reset_database_connection();
 
+  void start_clock();
+
   void update(uint32_t commit, uint32_t abort, uint32_t total,
               uint32_t num_part, std::chrono::nanoseconds commit_duration,
               std::chrono::nanoseconds duration_append_log,
@@ -135,7 +254,9 @@ struct per_terminal {
               std::chrono::nanoseconds duration_read_dsb,
               std::chrono::nanoseconds duration_lock_wait,
               std::chrono::nanoseconds duration_part, uint32_t num_lock,
-              uint32_t num_read_violate, uint32_t num_write_violate);
+              uint32_t num_read_violate, uint32_t num_write_violate,
+              const tx_type_statistics &tx_type,
+              const latency_histograms &latency);
 
   tpm_statistic get_result();
 };
@@ -169,6 +290,15 @@ struct id_generator {
         distributed_gen_(1, PERCENT_BASE), hot_row_gen_(1, PERCENT_BASE),
         rg_gen_(1, (uint32_t)rg2b.size()),
         read_only_gen_(1, PERCENT_BASE),
+        tx_mix_gen_(1, std::max<uint32_t>(1, conf.weight_new_order() +
+                                                 conf.weight_payment() +
+                                                 conf.weight_order_status() +
+                                                 conf.weight_delivery() +
+                                                 conf.weight_stock_level())),
+        percent_gen_(1, PERCENT_BASE),
+        last_name_gen_(1, std::min<uint32_t>(conf.num_customer_per_district(),
+                                             NUM_CUSTOMER_LAST_NAME)),
+        loaded_oid_gen_(1, conf.num_order_initialize_per_district()),
         control_dist_(conf.control_percent_dist_tx())
         {
     for (auto iter = rg2b.begin(); iter != rg2b.end(); ++iter) {
@@ -243,6 +373,10 @@ struct id_generator {
   uniform_generator<uint32_t> hot_row_gen_;
   uniform_generator<uint32_t> rg_gen_;
   uniform_generator<uint32_t> read_only_gen_;
+  uniform_generator<uint32_t> tx_mix_gen_;
+  uniform_generator<uint32_t> percent_gen_;
+  uniform_generator<uint32_t> last_name_gen_;
+  uniform_generator<uint32_t> loaded_oid_gen_;
   bool control_dist_;
   std::map<uint32_t, uniform_generator<uint32_t>> rg2_wid_gen_;
   wid2rg_map_t wid2rg_;
@@ -257,6 +391,8 @@ private:
   uint32_t num_term_;
   bool oneshot_;
   std::map<shard_id_t, boundary> rg2wid_boundary_;
+  // the YCSB key distribution shared by the terminals
+  std::shared_ptr<const zipf_distribution<uint64_t>> ycsb_zipf_;
   std::atomic<bool> stopped_;
   std::atomic<bool> ended_;
   tuple_gen tuple_gen_;
@@ -278,8 +414,20 @@ public:
 
 
   void warm_up_cached1(shard_id_t sd_id, uint32_t term_id);
+
+  void warm_up_scan(shard_id_t sd_id);
   void warm_up_cached2(shard_id_t sd_id, uint32_t term_id);
 
+  // sample the keys of the operations of a terminal to warm up requests, by
+  // the shard of the keys
+  void warm_up_sample(
+      per_terminal *td,
+      std::unordered_map<shard_id_t, std::vector<ptr<warm_up_req>>>
+          &warm_up_requests);
+
+  void warm_up_sample_shard(shard_id_t sd_id,
+                            std::vector<ptr<warm_up_req>> &vec);
+
   void run_new_order(shard_id_t sd_id, uint32_t term_id);
 
   void load_data(node_id_t node_id);
@@ -313,6 +461,19 @@ private:
       id_generator & gen,
       std::default_random_engine &rng);
 
+  void payment(shard_id_t sd_id, per_terminal *td, id_generator &gen);
+
+  void order_status(shard_id_t sd_id, per_terminal *td, id_generator &gen);
+
+  bool delivery(shard_id_t sd_id, per_terminal *td, id_generator &gen);
+
+  void stock_level(shard_id_t sd_id, per_terminal *td, id_generator &gen);
+
+  void ycsb(shard_id_t sd_id, per_terminal *td, ycsb_generator &gen);
+
+  uint32_t gen_customer_id(shard_id_t sd_id, uint32_t wid, uint32_t did,
+                           per_terminal *td, id_generator &gen);
+
   bool on_same_node(shard_id_t shard_id, shard_id_t remote_shard_id);
 
   per_terminal *get_terminal_data(shard_id_t sd_id, uint32_t term_id);
@@ -329,7 +490,11 @@ private:
   void make_read_for_write_operation(shard_id_t sd_id, table_id_t table,
                                      uint64_t key, per_terminal *td);
 
-  void make_begin_tx_request(per_terminal *td, bool read_only);
+  void make_delete_operation(shard_id_t sd_id, table_id_t table, uint64_t key,
+                             per_terminal *td);
+
+  void make_begin_tx_request(per_terminal *td, bool read_only,
+                             bench_tx_type type);
 
   void make_end_tx_request(per_terminal *td);
 
@@ -337,9 +502,18 @@ private:
 
   void random_get_replica_client(shard_id_t sd_id, per_terminal *td);
 
+  void nearest_replica_client(shard_id_t sd_id, per_terminal *td);
+
+  // run_new_order with client_window transactions in flight
+  void run_pipelined(shard_id_t sd_id, uint32_t term_id);
+
+  ptr<async_db_client> connect_async_client(boost::asio::io_context &context,
+                                            node_id_t node_id);
+
   tx_request &mutable_request(per_terminal *td);
 
-  void create_tx_request(per_terminal *td, bool read_only);
+  void create_tx_request(per_terminal *td, bool read_only,
+                         bench_tx_type type);
 
   std::vector<tx_request> &get_tx_request(per_terminal *td);
 
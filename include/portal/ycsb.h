@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common/config.h"
+#include "common/id.h"
+#include "common/uniform_generator.hpp"
+#include "common/zipf_generator.hpp"
+#include "proto/proto.h"
+#include <memory>
+#include <set>
+#include <vector>
+
+// the records of a shard, [lower, upper], the YCSB table is split evenly
+// among the shards
+struct ycsb_key_range {
+  uint64_t lower;
+  uint64_t upper;
+};
+
+ycsb_key_range ycsb_shard_key_range(const config &conf, shard_id_t sd_id);
+
+// the zipfian distribution of the keys of a shard, shared by the generators of
+// all the terminals, nullptr if the keys are uniform
+std::shared_ptr<const zipf_distribution<uint64_t>>
+ycsb_zipf_distribution(const config &conf);
+
+// the records inserted by a terminal are out of the loaded key range
+inline uint64_t make_ycsb_insert_key(uint64_t terminal_id, uint64_t seq) {
+  return (terminal_id << 32) | seq;
+}
+
+struct ycsb_op {
+  tx_op_type op_type;
+  shard_id_t sd_id;
+  uint64_t key;
+};
+
+// the mix of a YCSB core workload, in percent of the operations
+struct ycsb_mix {
+  uint32_t read;
+  uint32_t update;
+  uint32_t insert;
+  uint32_t scan;
+  uint32_t read_modify_write;
+};
+
+// A update heavy, B read mostly, C read only, D read latest, E short ranges,
+// F read-modify-write
+ycsb_mix ycsb_workload_mix(const std::string &workload);
+
+// generates the transactions of a terminal, the scans are expanded into the
+// keyed reads of a key range, all of them go through the CCB
+class ycsb_generator {
+private:
+  enum key_distribution {
+    KEY_UNIFORM,
+    KEY_ZIPFIAN,
+    KEY_LATEST,
+  };
+
+  ycsb_config conf_;
+  ycsb_mix mix_;
+  key_distribution distribution_;
+  shard_id_t sd_id_;
+  uint32_t terminal_id_;
+  uint32_t num_shard_;
+  uint64_t num_record_per_shard_;
+  uint32_t num_insert_;
+  // the keys inserted by this terminal, the latest at the end
+  std::vector<uint64_t> inserted_;
+  uniform_generator<uint32_t> op_gen_;
+  uniform_generator<uint32_t> percent_gen_;
+  uniform_generator<uint32_t> shard_gen_;
+  uniform_generator<uint32_t> scan_length_gen_;
+  uniform_generator<uint64_t> uniform_gen_;
+  std::unique_ptr<zipf_generator<uint64_t>> zipf_gen_;
+
+public:
+  // the generators of a terminal are seeded from the YCSB seed, the shard and
+  // the terminal id
+  ycsb_generator(const config &conf, shard_id_t sd_id, uint32_t terminal_id,
+                 std::shared_ptr<const zipf_distribution<uint64_t>> zipf);
+
+  // the operations of the next transaction, returns whether it is read only
+  bool next_tx(std::vector<ycsb_op> &ops);
+
+private:
+  uint64_t next_key(shard_id_t sd_id);
+
+  uint64_t stream_seed(uint32_t stream) const;
+
+  shard_id_t gen_remote_shard();
+};
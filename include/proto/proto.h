@@ -13,6 +13,7 @@
 #include "proto/raft_log_entry.pb.h"
 #include "proto/raft_test.pb.h"
 #include "proto/replay.pb.h"
+#include "proto/snapshot.pb.h"
 #include "proto/tuple.pb.h"
 #include "proto/tx_log.pb.h"
 #include "proto/tx_op_type.h"
@@ -8,11 +8,13 @@
 #include "common/panic.h"
 #include "common/ptr.hpp"
 #include "common/random.h"
+#include "common/scoped_time.h"
 #include "common/tx_log.h"
 #include "network/net_service.h"
 #include "network/sender.h"
 #include "proto/proto.h"
 #include "replog/log_service.h"
+#include <array>
 #include <atomic>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
@@ -22,6 +24,7 @@
 #include <boost/asio/write.hpp>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -44,6 +47,14 @@ template <> enum_strings<raft_state>::e2s_t enum_strings<raft_state>::enum2str;
 
 typedef std::function<void(uint64_t term)> fn_on_become_leader;
 typedef std::function<void(uint64_t term)> fn_on_become_follower;
+// send a snapshot at no less than min_index to a lagging node, return the
+// index the snapshot is taken at
+typedef std::function<std::optional<log_index_t>(
+    node_id_t node_id, uint64_t term, log_index_t min_index)>
+    fn_send_snapshot;
+// the index a read only transaction is served at, or the error when the read
+// index cannot be confirmed
+typedef std::function<void(EC ec, log_index_t read_index)> fn_read_index;
 
 struct sm_status {
   raft_state state;
@@ -63,7 +74,8 @@ private:
 
     progress(uint32_t max)
         : node_id_(0), match_index_(0), next_index_(1), append_log_num_(max),
-          send_next_index_(1), last_reject_(false) {}
+          send_next_index_(1), last_reject_(false), snapshot_index_(0),
+          snapshot_tick_(0), read_seq_(0) {}
 
     node_id_t node_id_;
     log_index_t match_index_;
@@ -72,6 +84,29 @@ private:
     log_index_t send_next_index_;
     uint64_t last_two_log_index_i_;
     bool last_reject_;
+    // index of the snapshot being installed at this node, 0 if none
+    log_index_t snapshot_index_;
+    uint64_t snapshot_tick_;
+    // the last read index round this node has responded to
+    uint64_t read_seq_;
+  };
+
+  // statistic of the batches appended by send_append_log
+  struct batch_stat {
+    batch_stat()
+        : num_batch_(0), num_entries_(0), num_bytes_(0), num_flush_full_(0),
+          num_flush_deadline_(0), num_flush_idle_(0), num_window_full_(0),
+          entries_hist_{} {}
+
+    uint64_t num_batch_;
+    uint64_t num_entries_;
+    uint64_t num_bytes_;
+    uint64_t num_flush_full_;
+    uint64_t num_flush_deadline_;
+    uint64_t num_flush_idle_;
+    uint64_t num_window_full_;
+    // entries_hist_[i] counts batches of [2^i, 2^(i+1)) entries
+    std::array<uint64_t, 16> entries_hist_;
   };
 
   typedef std::unordered_set<uint32_t> node_set;
@@ -100,6 +135,10 @@ private:
   std::map<uint64_t, node_id_t> priority_;
   node_id_t priority_replica_node_;
   std::vector<ptr<raft_log_entry>> log_;
+  // serialized entries field of append_entries_request, keyed by log index,
+  // shared by the append entries to all followers
+  std::map<log_index_t, std::pair<uint64_t, ptr<const std::string>>>
+      entry_payload_;
   std::unordered_map<uint64_t, ptr<scoped_time>> log_debug_;
   ptr<raft_log_state> log_state_;
   // log index in [1, consistent_log_index_] are written to snapshot
@@ -120,19 +159,46 @@ private:
 
   uint32_t follower_tick_max_;
   uint32_t append_log_entries_batch_max_;
+  uint64_t append_log_entries_batch_min_;
+  uint64_t append_log_batch_bytes_max_;
+  uint64_t append_log_batch_deadline_us_;
+  uint64_t append_log_inflight_max_;
   std::recursive_mutex mutex_;
 
   fn_on_become_leader fn_on_become_leader_;
   fn_on_become_follower fn_on_become_follower_;
   fn_commit_entries fn_on_commit_entries_;
+  fn_send_snapshot fn_send_snapshot_;
+  uint64_t snapshot_timeout_tick_;
 
   ptr<log_service> log_service_;
 
   std::unordered_map<uint32_t, std::vector<ptr<client>>> clients_;
   std::atomic<bool> stopped_;
   std::deque<repeated_tx_logs> tx_logs_;
+  uint64_t tx_logs_bytes_;
+  ptr<boost::asio::steady_timer> timer_batch_;
+  bool batch_timer_armed_;
+  bool batch_deadline_expired_;
+  // smoothed follower round trip and log force time, in microseconds
+  uint64_t rtt_us_;
+  uint64_t fsync_us_;
+  batch_stat batch_stat_;
   std::chrono::steady_clock::time_point start_;
   boost::asio::io_context::strand log_strand_;
+  // read index rounds of the leader; round read_seq_ is carried by the append
+  // entries sent after it started, and is confirmed when a majority responds
+  // in this term
+  uint64_t read_seq_;
+  uint64_t read_seq_acked_;
+  // reads at the leader waiting the confirmation of a round
+  std::deque<std::pair<uint64_t, fn_read_index>> read_waiting_;
+  // the last round of the leader received by a follower, echoed by responses
+  uint64_t leader_read_seq_;
+  // reads a follower has forwarded to the leader, seq -> (tick, callback)
+  uint64_t read_forward_seq_;
+  uint64_t read_forward_tick_;
+  std::map<uint64_t, std::pair<uint64_t, fn_read_index>> read_forward_;
 
 public:
   explicit state_machine(const config &conf, ptr<net_service> sender,
@@ -148,6 +214,21 @@ public:
   result<void> ccb_append_log(const ccb_append_log_request &msg,
                               std::chrono::steady_clock::time_point ts);
 
+  // more logs are queued than a full in flight window can carry
+  bool append_log_overloaded() const {
+    return tx_logs_bytes_ >
+           append_log_batch_bytes_max_ * append_log_inflight_max_;
+  }
+
+  // the index a read only transaction is served at this node; the leader
+  // confirms it is still the leader by a round of heart beats, a follower
+  // fetches the read index from the leader
+  void read_index(fn_read_index fn);
+
+  void set_send_snapshot(fn_send_snapshot fn) {
+    fn_send_snapshot_ = std::move(fn);
+  }
+
   void on_start();
 
   void on_stop();
@@ -196,6 +277,12 @@ public:
 
   void handle_pre_vote_response(ptr<pre_vote_response> response);
 
+  void handle_install_snapshot(uint64_t term, log_index_t index);
+
+  void handle_read_index_request(const read_index_request &request);
+
+  void handle_read_index_response(const read_index_response &response);
+
 private:
   void leader_send_append_entries();
 
@@ -205,8 +292,20 @@ private:
 
   void append_entries(progress &tracer);
 
+  ptr<const std::string> entry_payload(const raft_log_entry &entry);
+
   result<void> send_append_log(bool is_heart_beat);
 
+  result<void> try_flush_append_log();
+
+  void async_wait_batch_deadline();
+
+  uint64_t batch_deadline_us() const;
+
+  uint64_t inflight_log_num();
+
+  void debug_log_batch(std::ostream &os);
+
   void tick();
 
   void pre_start();
@@ -231,6 +330,18 @@ private:
 
   void leader_advance_consistency_index();
 
+  void leader_send_snapshot(progress &p);
+
+  void leader_read_index(fn_read_index fn);
+
+  void leader_release_read_index();
+
+  bool leader_committed_in_term();
+
+  void fail_read_index(EC ec);
+
+  void timeout_read_index();
+
   void response_append_entries_response(uint32_t to_node_id,
                                         uint64_t ts_append_send, bool success,
                                         uint64_t match_index, bool heart_beat,
@@ -250,7 +361,8 @@ private:
 
   template <typename MESSAGE>
   result<void> async_send(node_id_t to_node_id, message_type mt,
-                          ptr<MESSAGE> msg) {
+                          ptr<MESSAGE> msg,
+                          std::vector<ptr<const std::string>> payload = {}) {
 
     auto i = clients_.find(to_node_id);
     if (i == clients_.end()) {
@@ -266,23 +378,8 @@ private:
     }
     ptr<client> client = i->second[n];
 
-    uint32_t ms = conf_.get_test_config().debug_add_wan_latency_ms();
-    if (ms > 0) { // only valid when debug ..
-      // delayed send
-      auto self = shared_from_this();
-      ptr<boost::asio::steady_timer> timer(new boost::asio::steady_timer(
-          sender_->get_service(SERVICE_ASYNC_CONTEXT),
-          boost::asio::chrono::milliseconds(ms)));
-      timer->async_wait([to_node_id, mt, msg, client, timer,
-                         self](const boost::system::error_code &error) {
-        timer.get();
-        if (not error.failed()) {
-          self->sender_->template conn_async_send(client, mt, msg);
-        }
-      });
-    } else {
-      sender_->template conn_async_send(client, mt, msg);
-    }
+    // the WAN latency is simulated by the net shaping of sender_
+    sender_->template conn_async_send(client, mt, msg, std::move(payload));
 
     return outcome::success();
   }
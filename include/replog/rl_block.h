@@ -3,7 +3,6 @@
 #include "common/block.h"
 #include "common/callback.h"
 #include "common/config.h"
-#include "common/msg_time.h"
 #include "common/tx_log.h"
 #include "network/net_service.h"
 #include "network/sender.h"
@@ -11,10 +10,11 @@
 #include "raft/state_machine.h"
 #include "replog/log_service_impl.h"
 #include <boost/enable_shared_from_this.hpp>
-#include <boost/format.hpp>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <utility>
 
 class rl_block : public block, public std::enable_shared_from_this<rl_block> {
@@ -37,10 +37,23 @@ private:
   ptr<state_machine> state_machine_;
   ptr<log_service_impl> log_service_;
   std::map<node_id_t, bool> ccb_responsed_;
+  // append log credits of the committed logs, not granted back to CCB yet
+  std::unordered_map<node_id_t, uint64_t> ccb_credit_owed_;
+  // log index of the replays sent to a DSB but not acknowledged yet
+  std::unordered_map<node_id_t, std::set<log_index_t>> replay_inflight_;
+  // the committed logs up to this index have been sent to the DSBs
+  log_index_t replay_index_;
+  // the first log index a DSB failed to replay, the reads at or after it
+  // fail until a snapshot beyond it is installed
+  log_index_t replay_failed_index_;
+  EC replay_failed_ec_;
+  // read index responses waiting the DSBs to apply up to the read index
+  std::multimap<log_index_t, ptr<rlb_read_index_response>> read_index_waiting_;
+  // DSBs have installed the snapshot at an index
+  std::map<log_index_t, std::set<node_id_t>> snapshot_installed_;
   ptr<boost::asio::steady_timer> timer_send_report_;
   boost::asio::io_context::strand rlb_strand_;
   std::chrono::steady_clock::time_point start_;
-  msg_time time_;
 
 public:
   rl_block(const config &conf, ptr<net_service> service,
@@ -64,8 +77,7 @@ public:
     // run routine in state_machine's strand
     auto shared = this->shared_from_this();
     auto fn = [shared, conn, t, m, ts] {
-      scoped_time _t(
-          (boost::format("rl_block handle message: %s") % enum2str(t)).str());
+      scoped_time _t("rl_block::handle_message");
       switch (t) {
       case message_type::C2R_APPEND_LOG_REQ: {
         auto msg = static_pointer_cast<ccb_append_log_request>(
@@ -133,6 +145,18 @@ private:
   result<void> rlb_handle_message(const ptr<connection>, message_type,
                                   const ptr<replay_to_dsb_response>);
 
+  result<void> rlb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<ccb_read_index_request>);
+
+  result<void> rlb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<read_index_request>);
+
+  result<void> rlb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<read_index_response>);
+
+  result<void> rlb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<dsb_snapshot_installed>);
+
   void handle_append_entries_response(const append_entries_response &response);
 
   void handle_transfer_leader(const transfer_leader &msg);
@@ -159,7 +183,34 @@ private:
   void on_commit_entries(EC ec, bool is_lead,
                          const std::vector<ptr<raft_log_entry>> &logs);
 
-  void response_commit_log(EC ec, const std::vector<ptr<raft_log_entry>> &logs);
+  void response_commit_log(EC ec, bool is_lead,
+                           const std::vector<ptr<raft_log_entry>> &logs);
+
+  void handle_replay_to_dsb_response(const replay_to_dsb_response &res);
+
+  void handle_read_index_request(const ccb_read_index_request &req);
+
+  void response_read_index(ptr<rlb_read_index_response> res, EC ec,
+                           log_index_t read_index);
+
+  // all DSBs of this node have applied the logs up to this index
+  log_index_t applied_index() const;
+
+  void release_read_index(EC ec);
+
+  typedef std::multimap<log_index_t, ptr<rlb_read_index_response>>::iterator
+      read_index_iter;
+
+  void send_read_index(read_index_iter begin, read_index_iter end, EC ec);
+
+  std::optional<log_index_t> send_snapshot(node_id_t node_id, uint64_t term,
+                                           log_index_t min_index);
+
+  void handle_snapshot_installed(const dsb_snapshot_installed &msg);
+
+  void grant_append_log_credit(
+      uint64_t cno,
+      std::unordered_map<node_id_t, ptr<rlb_commit_entries>> &commit_msg_map);
 
   // when recovery/rester, retrieve all logs
   void response_ccb_register_with_logs(node_id_t) {};
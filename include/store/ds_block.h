@@ -4,19 +4,55 @@
 #include "common/callback.h"
 #include "common/config.h"
 #include "common/define.h"
-#include "common/msg_time.h"
 #include "common/ptr.hpp"
+#include "common/tx_log.h"
 #include "common/tuple_gen.h"
 #include "network/net_service.h"
 #include "proto/proto.h"
 #include "store/store.h"
 #include <boost/asio.hpp>
 #include <boost/date_time.hpp>
+#include <map>
+#include <random>
 
 using boost::asio::steady_timer;
 
 class ds_block : public block, public std::enable_shared_from_this<ds_block> {
 private:
+  // a snapshot being sent to the DSB of a lagging replica
+  struct snapshot_send {
+    rlb_snapshot_request request_;
+    ptr<store_snapshot> snapshot_;
+    uint64_t stream_;
+    uint64_t seq_;
+    uint64_t acked_;
+    bool done_;
+  };
+
+  // a snapshot being received from the DSB of the leader; the chunks may
+  // arrive out of order on the connections to a peer, they are buffered and
+  // installed by seq
+  struct snapshot_recv {
+    uint64_t stream_;
+    uint64_t next_seq_;
+    // installed or failed, the late chunks of the stream are dropped
+    bool done_;
+    std::map<uint64_t, ptr<dsb_snapshot_chunk>> pending_;
+  };
+
+  // the rows of a shard being streamed to CCB to warm up its cache
+  struct warm_up_send {
+    warm_up_req request_;
+    std::vector<table_id_t> tables_;
+    // the table being scanned
+    size_t table_index_;
+    ptr<store_snapshot> scan_;
+    std::mt19937 rand_;
+    uint64_t seq_;
+    uint64_t acked_;
+    bool done_;
+  };
+
   config conf_;
   net_service *service_;
   uint32_t node_id_;
@@ -28,10 +64,26 @@ private:
   uint32_t cno_;
   ptr<store> store_;
   std::vector<uint32_t> wid_;
+  std::unordered_set<shard_id_t> shard_ids_;
+  shard_map_t shard_map_;
   std::recursive_mutex mutex_;
-  msg_time time_;
   tuple_gen tuple_gen_;
   std::vector<ptr<std::thread>> load_threads_;
+  uint64_t snapshot_chunk_bytes_;
+  uint64_t snapshot_chunk_inflight_;
+  // sends and installs snapshot chunks in order
+  boost::asio::io_context::strand snapshot_strand_;
+  std::unordered_map<node_id_t, ptr<snapshot_send>> snapshot_send_;
+  std::unordered_map<node_id_t, ptr<snapshot_recv>> snapshot_recv_;
+  // the last snapshot stream sent, starts at the clock so that the streams
+  // of a restarted DSB are newer
+  uint64_t snapshot_stream_;
+  uint64_t warm_up_chunk_bytes_;
+  uint64_t warm_up_chunk_inflight_;
+  // scans and sends warm up chunks in order
+  boost::asio::io_context::strand warm_up_strand_;
+  // by CCB node and term
+  std::map<std::pair<node_id_t, uint64_t>, ptr<warm_up_send>> warm_up_send_;
 
 public:
   ds_block(const config &conf, net_service *service);
@@ -63,6 +115,9 @@ private:
   result<void> dsb_handle_message(const ptr<connection>, message_type,
                                   const ptr<warm_up_req> m);
 
+  result<void> dsb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<warm_up_ack> m);
+
   result<void> dsb_handle_message(const ptr<connection>, message_type,
                                   const ptr<client_load_data_request>);
 
@@ -75,6 +130,15 @@ private:
   result<void> dsb_handle_message(const ptr<connection>, message_type,
                                   const ptr<replay_to_dsb_request>);
 
+  result<void> dsb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<rlb_snapshot_request>);
+
+  result<void> dsb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<dsb_snapshot_chunk>);
+
+  result<void> dsb_handle_message(const ptr<connection>, message_type,
+                                  const ptr<dsb_snapshot_ack>);
+
   void handle_load_data_request(const client_load_data_request &,
                                 ptr<connection> conn);
   void response_load_data_done(ptr<connection> conn);
@@ -85,6 +149,25 @@ private:
 
   void handle_replay_to_dsb(const ptr<replay_to_dsb_request> msg);
 
+  void handle_snapshot_request(const rlb_snapshot_request &request);
+
+  void send_snapshot_chunks(ptr<snapshot_send> send);
+
+  void handle_snapshot_chunk(const ptr<dsb_snapshot_chunk> chunk);
+
+  void handle_snapshot_ack(const dsb_snapshot_ack &ack);
+
+  // install a chunk, return false when the stream ends, by error or done
+  bool install_snapshot_chunk(const dsb_snapshot_chunk &chunk);
+
+  void handle_warm_up_scan(const ptr<warm_up_req> request);
+
+  void send_warm_up_chunks(ptr<warm_up_send> send);
+
+  result<bool> next_warm_up_chunk(warm_up_send &send, warm_up_chunk &chunk);
+
+  void handle_warm_up_ack(const warm_up_ack &ack);
+
   tuple_pb gen_tuple(table_id_t table_id);
 
   void send_register();
@@ -95,6 +178,8 @@ private:
 
   void load_customer();
 
+  void load_customer_last_index();
+
   void load_stock();
 
   void load_warehouse();
@@ -103,6 +188,8 @@ private:
 
   void load_order();
 
+  void load_ycsb(uint64_t key_lower, uint64_t key_upper);
+
   void read_request();
 
   void send_error_consistency(node_id_t node_id, message_type mt);
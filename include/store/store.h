@@ -5,6 +5,18 @@
 #include "common/tuple.h"
 #include "proto/proto.h"
 
+// a view of the rows in a store, read chunk by chunk when sending a snapshot
+// to a lagging replica or warming up the cache of CCB
+class store_snapshot {
+public:
+  // add rows to the chunk until it exceeds max_bytes, returns true when all
+  // rows have been read
+  virtual result<bool> next_chunk(uint64_t max_bytes,
+                                  dsb_snapshot_chunk &chunk) = 0;
+
+  virtual ~store_snapshot() {}
+};
+
 class store {
 public:
   virtual result<void> replay(ptr<std::vector<ptr<tx_operation>>> ops) = 0;
@@ -15,6 +27,16 @@ public:
   virtual result<ptr<tuple_pb>> get(table_id_t table_id,
                                     tuple_id_t tuple_id) = 0;
 
+  virtual result<ptr<store_snapshot>> create_snapshot() = 0;
+
+  // the rows of table_id whose tuple ids are in [lower, upper), no upper
+  // bound when upper is 0
+  virtual result<ptr<store_snapshot>>
+  create_scan(table_id_t table_id, tuple_id_t lower, tuple_id_t upper) = 0;
+
+  // write the rows of a snapshot chunk, the first chunk clears the store
+  virtual result<void> install_snapshot(const dsb_snapshot_chunk &chunk) = 0;
+
   virtual result<void> sync() = 0;
 
   virtual void close() = 0;
@@ -9,6 +9,7 @@ import shutil
 import stat
 import subprocess
 import time
+import urllib.request
 
 import paramiko
 
@@ -27,9 +28,27 @@ HOT_ITEM_NUM = 10
 
 NUM_READ_ONLY_ROWS = 500
 ADDITIONAL_READ_ONLY = False
+REPLICA_READ = False
 
 APPEND_LOG_ENTRIES_BATCH_MIN = 1
 APPEND_LOG_ENTRIES_BATCH_MAX = 32
+APPEND_LOG_BATCH_BYTES_MAX = 256 * 1024
+APPEND_LOG_BATCH_DEADLINE_US = 2000
+APPEND_LOG_INFLIGHT_MAX = 4
+APPEND_LOG_CREDIT_BYTES = 4 * 1024 * 1024
+APPEND_LOG_PENDING_BYTES_MAX = 1024 * 1024
+SNAPSHOT_CHUNK_BYTES = 1024 * 1024
+SNAPSHOT_CHUNK_INFLIGHT = 4
+WARM_UP_CHUNK_BYTES = 256 * 1024
+WARM_UP_CHUNK_INFLIGHT = 8
+SEND_COALESCE = True
+SEND_COALESCE_DELAY_US = 0
+THREAD_PER_CORE = False
+NUM_CORES = 0
+NUM_CORES_ARRAY = [1, 2, 4, 8]
+SHM_TRANSPORT = True
+WAN_COMPRESS = 'none'
+WAN_COMPRESS_MIN_BYTES = 1024
 
 THREADS_ASYNC_CONTEXT = 4
 THREADS_CC = 4
@@ -42,7 +61,13 @@ MYSQL_MAX_CONNECTIONS = 2500
 SSH_SERVER_PORT = 22
 RETRY_AFTER_EXCEPTION = 500
 WAN_LATENCY_DELAY_WAIT_MS = 0
+# the WAN links simulated by net_service, see net_shaping_matrix
+NET_SHAPING = []
 CACHED_TUPLE_PERCENTAGE = 0.2
+# warm up CCB with a percent_cached_tuple sample of the rows of a shard
+# scanned by DSB, instead of a sample of the keys accessed by the
+# transactions; the results of the two are not comparable
+WARM_UP_SCAN = False
 DIST_PERCENTAGE = False
 RAFT_FOLLOWER_TICK_MAX_REQUEST_VOTE = 40
 RAFT_LEADER_ELECTION_TICK_MS = 200
@@ -51,6 +76,8 @@ AZ_RTT_LATENCY_MS = 40
 DEADLOCK_DETECTION = False
 DEADLOCK_DETECTION_MS = 1000
 LOCK_TIMEOUT_MS = 500
+# the runtime log level of the blocks
+LOG_LEVEL = 'info'
 CALVIN_EPOCH_MS = 40
 NUM_OUTPUT_RESULT = 80
 
@@ -86,6 +113,26 @@ DEFAULT_PERCENT_REMOTE_WH = 0.01
 PERCENT_REMOTE_WH_ARRAY = [0.01, 0.25, 0.5]
 CCB_CACHED_PERCENTAGE_ARRAY = [0.0, 0.25, 0.5, 0.75, 1.0]
 PERCENT_READ_ONLY = [0.0, 0.25, 0.5, 0.75, 1.0]
+# the weights of new-order, payment, order-status, delivery and stock-level
+TPCC_TX_MIX = [45, 43, 4, 4, 4]
+# the arrival rate of the transactions of a shard, 0 for closed loop
+OPEN_LOOP_TPS = 0.0
+# the transactions a terminal keeps in flight on a connection
+CLIENT_WINDOW = 1
+# the fraction of the transactions traced as spans, served by /trace
+TRACE_SAMPLE_RATE = 0.01
+# "tpcc" or "ycsb"
+BENCHMARK = 'tpcc'
+YCSB_NUM_RECORD = 100000
+# the YCSB core workload, "A" to "F"
+YCSB_WORKLOAD = 'A'
+# "zipfian", "latest" or "uniform"
+YCSB_DISTRIBUTION = 'zipfian'
+YCSB_ZIPF_THETA = 0.99
+YCSB_OPS_PER_TX = 10
+YCSB_PERCENT_CROSS_SHARD = 0.1
+YCSB_MAX_SCAN_LENGTH = 100
+YCSB_SEED = 1
 
 NUM_WAREHOUSE = 160
 WAREHOUSES = [160]
@@ -94,6 +141,8 @@ TEST_CACHE = 'cache'
 TEST_DISTRIBUTE = 'distribute'
 TEST_TERMINAL = 'terminal'
 TEST_READ_ONLY = 'readonly'
+TEST_CORE = 'core'
+TEST_LOG = 'log'
 
 DB_CONFIG_SLB = 'lb'
 DB_CONFIG_STB = 'tb'
@@ -263,6 +312,9 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
               tight_binding=True,
               percent_cached_tuple=CACHED_TUPLE_PERCENTAGE,
               control_percent_dist_tx=DIST_PERCENTAGE,
+              thread_per_core=THREAD_PER_CORE,
+              num_cores=NUM_CORES,
+              log_level=LOG_LEVEL,
               ):
     path_node_configure_file = os.path.join(CONF_PATH, conf_file)
     conf_map = load_json_file(path_node_configure_file)
@@ -279,6 +331,7 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
             node['priority'] = az_priority[az]
     num_transactions = NUM_TRANSACTIONS[db_type]
     tpcc_config = {
+        'benchmark': BENCHMARK,
         'num_warehouse': num_warehouse,
         'num_item': num_item,
         'num_order_initialize_per_district': ORD_PER_DIST,
@@ -292,6 +345,7 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
         'percent_read_only': percent_read_only,
         'num_read_only_rows': NUM_READ_ONLY_ROWS,
         'additional_read_only_terminal': ADDITIONAL_READ_ONLY,
+        'replica_read': REPLICA_READ,
         'hot_item_num': HOT_ITEM_NUM,
         # remove warehouse or shard
         'percent_remote': percent_remote,
@@ -304,14 +358,25 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
         "num_output_result": NUM_OUTPUT_RESULT,
         "az_rtt_ms": AZ_RTT_LATENCY_MS,
         "flow_control_rtt_count": 4,
+        "weight_new_order": TPCC_TX_MIX[0],
+        "weight_payment": TPCC_TX_MIX[1],
+        "weight_order_status": TPCC_TX_MIX[2],
+        "weight_delivery": TPCC_TX_MIX[3],
+        "weight_stock_level": TPCC_TX_MIX[4],
+        "open_loop_tps": OPEN_LOOP_TPS,
+        "client_window": CLIENT_WINDOW,
+        "trace_sample_rate": TRACE_SAMPLE_RATE,
     }
 
     test_conf = {
         'wan_latency_delay_wait_ms': WAN_LATENCY_DELAY_WAIT_MS,
         'percent_cached_tuple': percent_cached_tuple,
+        'warm_up_scan': WARM_UP_SCAN,
         'deadlock_detection_ms': DEADLOCK_DETECTION_MS,
         'deadlock_detection': DEADLOCK_DETECTION,
         'lock_timeout_ms': LOCK_TIMEOUT_MS,
+        'log_level': log_level,
+        'net_shaping': NET_SHAPING,
         'label': label,
         'parameter': ''
     }
@@ -336,6 +401,8 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
                 not is_client,
                 label,
                 az_priority,
+                thread_per_core,
+                num_cores,
             )
         )
         receivers.append(receiver)
@@ -359,8 +426,12 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
         'percent_remote': percent_remote,
         'percent_hot_item': percent_hot_item,
         'percent_cached_tuple': percent_cached_tuple,
+        'warm_up_scan': WARM_UP_SCAN,
         'percent_read_only': percent_read_only,
         'control_dist_tx':control_percent_dist_tx,
+        'thread_per_core': thread_per_core,
+        'num_cores': num_cores,
+        'log_level': log_level,
     }
 
     # process server
@@ -394,7 +465,7 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
             result_json = output_result
         p = multiprocessing.Process(
             target=process_run_client,
-            args=(address, node_path, False, result_json, node_name)
+            args=(address, node_path, False, result_json, node_name, servers)
         )
         processors.append(p)
     for p in processors:
@@ -403,16 +474,32 @@ def run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
         p.join()
 
 
-def process_run_client(address, run_dir, backend, output_result, name):
+def process_run_client(address, run_dir, backend, output_result, name, servers):
     process_run_block(address, run_dir, backend, output_result)
     output = 'output_{}.txt'.format(name)
     if output_result is not None:
+        output_result['hot_key'] = fetch_hot_keys(servers)
         json_file = os.path.join(run_dir, output)
         with open(json_file, 'w') as file:
             file.write(json.dumps(output_result) + '\n')
         file.close()
 
 
+def fetch_hot_keys(servers):
+    # the keys of the most lock waits of every table, by CCB node
+    hot_keys = {}
+    for node in servers:
+        if 'CCB' not in node['block_type']:
+            continue
+        url = 'http://{}:{}/json/hot_key'.format(node['private_address'], node['port'] + 1000)
+        try:
+            with urllib.request.urlopen(url, timeout=5) as response:
+                hot_keys[node['node_name']] = json.loads(response.read())
+        except (OSError, ValueError) as e:
+            print('fetch hot keys from {} error: {}'.format(url, e))
+    return hot_keys
+
+
 def process_run_block(address, run_dir, backend, output_result):
     run_block(address, run_dir, backend, output_result)
 
@@ -443,6 +530,9 @@ def run_block(address, run_dir, backend, output_result=None):
 
         output_result['abort'] = result['abort']
         output_result['tpm'] = result['tpm']
+        output_result['tpm_total'] = result['tpm_total']
+        output_result['offered_tps'] = result['offered_tps']
+        output_result['tps'] = result['tps']
         output_result['lt'] = result['lt']
         output_result['lt_read'] = result['lt_read']
         output_result['lt_read_dsb'] = result['lt_read_dsb']
@@ -450,6 +540,9 @@ def run_block(address, run_dir, backend, output_result=None):
         output_result['lt_app_rlb'] = result['lt_app_rlb']
         output_result['lt_lock'] = result['lt_lock']
         output_result['lt_part'] = result['lt_part']
+        for k in result:
+            if k.startswith('lt') and k.endswith(('_p50', '_p99', '_p999')):
+                output_result[k] = result[k]
 
 
 def process_configure_node(
@@ -464,7 +557,9 @@ def process_configure_node(
         db_type,
         is_backend,
         label,
-        az_priority
+        az_priority,
+        thread_per_core=THREAD_PER_CORE,
+        num_cores=NUM_CORES,
 ):
     (name, path) = configure_node(
         server_node_conf_list,
@@ -477,13 +572,28 @@ def process_configure_node(
         db_type,
         is_backend,
         label,
-        az_priority
+        az_priority,
+        thread_per_core,
+        num_cores,
     )
     pipe.send((name, path))
     pipe.close()
     print("send to PIPE, name:{}, path:{}".format(name, path))
 
 
+def gen_ycsb_conf():
+    return {
+        'num_record': YCSB_NUM_RECORD,
+        'workload': YCSB_WORKLOAD,
+        'distribution': YCSB_DISTRIBUTION,
+        'zipf_theta': YCSB_ZIPF_THETA,
+        'ops_per_tx': YCSB_OPS_PER_TX,
+        'percent_cross_shard': YCSB_PERCENT_CROSS_SHARD,
+        'max_scan_length': YCSB_MAX_SCAN_LENGTH,
+        'seed': YCSB_SEED,
+    }
+
+
 def configure_node(
         server_node_conf_list,
         client_node_conf,
@@ -495,7 +605,9 @@ def configure_node(
         db_type,
         is_backend,
         label,
-        az_priority
+        az_priority,
+        thread_per_core=THREAD_PER_CORE,
+        num_cores=NUM_CORES,
 ):
     ts = time.strftime('%a_%d_%b_%Y_%H_%M_%S', time.gmtime())
     name = '{}_{}_{}__{}'.format(label, db_type, node_name, ts)
@@ -524,11 +636,28 @@ def configure_node(
         'connections_per_peer': CONNECTIONS_PER_PEER,
         'append_log_entries_batch_min': APPEND_LOG_ENTRIES_BATCH_MIN,
         'append_log_entries_batch_max': APPEND_LOG_ENTRIES_BATCH_MAX,
+        'append_log_batch_bytes_max': APPEND_LOG_BATCH_BYTES_MAX,
+        'append_log_batch_deadline_us': APPEND_LOG_BATCH_DEADLINE_US,
+        'append_log_inflight_max': APPEND_LOG_INFLIGHT_MAX,
+        'append_log_credit_bytes': APPEND_LOG_CREDIT_BYTES,
+        'append_log_pending_bytes_max': APPEND_LOG_PENDING_BYTES_MAX,
+        'snapshot_chunk_bytes': SNAPSHOT_CHUNK_BYTES,
+        'snapshot_chunk_inflight': SNAPSHOT_CHUNK_INFLIGHT,
+        'warm_up_chunk_bytes': WARM_UP_CHUNK_BYTES,
+        'warm_up_chunk_inflight': WARM_UP_CHUNK_INFLIGHT,
+        'send_coalesce': SEND_COALESCE,
+        'send_coalesce_delay_us': SEND_COALESCE_DELAY_US,
+        'thread_per_core': thread_per_core,
+        'num_cores': num_cores,
+        'shm_transport': SHM_TRANSPORT,
+        'wan_compress': WAN_COMPRESS,
+        'wan_compress_min_bytes': WAN_COMPRESS_MIN_BYTES,
     }
 
     configure = {
         'block': block_config,
         'param': tpcc_config,
+        'ycsb': gen_ycsb_conf(),
         'test': test_conf,
         'node_server_list': server_node_conf_list,
         'node_client_list': client_node_conf,
@@ -724,6 +853,50 @@ def evaluation_block_binding(
                           percent_cached_tuple=percentage)
 
 
+def evaluation_core_scaling(
+        conf_path,
+        db_type=DB_S,
+        num_cores_array=None,
+):
+    # TPC-C throughput of thread-per-core mode as the cores of a node grow
+    if num_cores_array is None:
+        num_cores_array = NUM_CORES_ARRAY
+    for num_cores in num_cores_array:
+        clean_all(conf_path)
+        label = 'core_' + str(num_cores)
+        run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
+                  num_warehouse=NUM_WAREHOUSE,
+                  percent_remote=DEFAULT_PERCENT_REMOTE_WH,
+                  db_type=db_type,
+                  label=label,
+                  conf_file=conf_path,
+                  tight_binding=True,
+                  thread_per_core=True,
+                  num_cores=num_cores)
+
+
+def evaluation_log_level(
+        conf_path,
+        db_type=DB_S,
+        log_levels=None,
+):
+    # TPC-C throughput of the runtime log levels, the trace records are
+    # compiled out unless the blocks are built with -DBLOG_MIN_LEVEL=0
+    if log_levels is None:
+        log_levels = ['info', 'trace']
+    for log_level in log_levels:
+        clean_all(conf_path)
+        label = 'log_' + log_level
+        run_bench(num_terminal=DEFAULT_NUM_TERMINAL,
+                  num_warehouse=NUM_WAREHOUSE,
+                  percent_remote=DEFAULT_PERCENT_REMOTE_WH,
+                  db_type=db_type,
+                  label=label,
+                  conf_file=conf_path,
+                  tight_binding=True,
+                  log_level=log_level)
+
+
 def tc_set_command(ip, delay=None, rate=None):
     if delay is None:
         delay_s = ''
@@ -770,6 +943,23 @@ def get_nodes(conf_file, all_node=True):
     return node
 
 
+# the net shaping of every pair of zones, to run a geo-distributed
+# deployment on one host
+def net_shaping_matrix(zones, latency_ms, jitter_ms=0, bandwidth_mbps=0):
+    matrix = []
+    for from_zone in zones:
+        for to_zone in zones:
+            if from_zone != to_zone:
+                matrix.append({
+                    'from_zone': from_zone,
+                    'to_zone': to_zone,
+                    'latency_ms': latency_ms,
+                    'jitter_ms': jitter_ms,
+                    'bandwidth_mbps': bandwidth_mbps,
+                })
+    return matrix
+
+
 def config_latency(conf_file, wan_latency, lan_latency, bandwidth_wan, use_private_address=False):
     node = get_nodes(conf_file, all_node=True)
     user, password = get_user_password(user_name='root')
@@ -1260,7 +1450,7 @@ def main():
     parser.add_argument('-t', '--db-config-type', type=str, help='db config type:lb/tb/sn/scr')
     parser.add_argument('-r', '--run-command', type=str, help='run command on all site')
     parser.add_argument('-c', '--clean', action='store_true', help='clean all')
-    parser.add_argument('-tp', '--test-parameter', type=str, help='test parameter:cache/readonly/terminal/distribute')
+    parser.add_argument('-tp', '--test-parameter', type=str, help='test parameter:cache/readonly/terminal/distribute/core/log')
     parser.add_argument('-dt', '--distributed-tx', action='store_true', help='control remote distributed transaction')
     parser.add_argument('-dg', '--debug-url', type=str, help='debug url')
 
@@ -1313,7 +1503,11 @@ def main():
         return
 
     if db_config_type == DB_CONFIG_STB:
-        if test_parameter == TEST_CACHE:
+        if test_parameter == TEST_CORE:
+            evaluation_core_scaling(conf)
+        elif test_parameter == TEST_LOG:
+            evaluation_log_level(conf)
+        elif test_parameter == TEST_CACHE:
             arr_percent_ccb_cache = [0.0, 0.25, 0.5, 0.75, 1.0]
             evaluation_block_binding(
                 conf,
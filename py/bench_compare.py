@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+import argparse
+import json
+import os
+import sys
+
+# compare the bench_*.json written by the micro benchmarks (make bench) with a
+# baseline, a case is (bench, name, threads) and is compared by its ns_per_op
+
+DEFAULT_THRESHOLD = 0.10
+
+
+def load_results(path):
+    results = {}
+    for file in sorted(os.listdir(path)):
+        if not (file.startswith('bench_') and file.endswith('.json')):
+            continue
+        with open(os.path.join(path, file)) as f:
+            j = json.load(f)
+        if 'cases' not in j:
+            continue
+        for c in j['cases']:
+            key = '{}/{}/threads:{}'.format(j['bench'], c['name'], c['threads'])
+            results[key] = c['ns_per_op']
+    return results
+
+
+def save_baseline(results, baseline):
+    with open(baseline, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print('baseline {} saved, {} cases'.format(baseline, len(results)))
+
+
+def compare(results, baseline, threshold):
+    with open(baseline) as f:
+        base = json.load(f)
+    regressions = []
+    for key in sorted(results.keys()):
+        if key not in base:
+            print('{:<64} {:>12.1f} ns/op  (new)'.format(key, results[key]))
+            continue
+        ratio = results[key] / base[key] - 1.0 if base[key] > 0 else 0.0
+        mark = ''
+        if ratio > threshold:
+            mark = 'REGRESSION'
+            regressions.append(key)
+        elif ratio < -threshold:
+            mark = 'improved'
+        print('{:<64} {:>12.1f} ns/op {:>+8.1%} {}'.format(key, results[key], ratio, mark))
+    for key in sorted(base.keys()):
+        if key not in results:
+            print('{:<64} missing'.format(key))
+    print('{} cases, {} regressions over {:.0%}'.format(len(results), len(regressions), threshold))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description='compare micro benchmarks with a baseline')
+    parser.add_argument('-p', '--path', type=str, default='.', help='directory of bench_*.json')
+    parser.add_argument('-b', '--baseline', type=str, default='baseline.json', help='baseline file')
+    parser.add_argument('-t', '--threshold', type=float, default=DEFAULT_THRESHOLD,
+                        help='slow down ratio flagged as a regression')
+    parser.add_argument('-s', '--save', action='store_true', help='save the results as the baseline')
+    args = parser.parse_args()
+
+    results = load_results(args.path)
+    if not results:
+        print('no bench_*.json in {}'.format(args.path))
+        sys.exit(1)
+    if args.save:
+        save_baseline(results, args.baseline)
+        return
+    if not os.path.exists(args.baseline):
+        print('no baseline {}, save one by --save'.format(args.baseline))
+        sys.exit(1)
+    if compare(results, args.baseline, args.threshold):
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
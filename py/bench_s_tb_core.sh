@@ -0,0 +1,2 @@
+#!/bin/bash
+nohup python3 bench.py -t tb -tp core > fe.out 2>&1 &
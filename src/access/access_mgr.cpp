@@ -1,7 +1,13 @@
 #include "access/access_mgr.h"
+#include "common/metrics.h"
 
 #include <utility>
 
+static metric<metric_counter> cache_hits("tddb_cache_hits_total",
+                                         "tuples read from the CCB cache");
+static metric<metric_counter> cache_misses(
+    "tddb_cache_misses_total", "tuples not in the CCB cache, read from DSB");
+
 access_mgr::access_mgr(
     const std::vector<shard_id_t> &shards,
     uint64_t max_table_id
@@ -29,7 +35,13 @@ void access_mgr::put(uint32_t table_id, shard_id_t shard_id, tuple_id_t key, tup
 std::pair<tuple_pb, bool> access_mgr::get(uint32_t table_id, shard_id_t shard_id, tuple_id_t key) {
   ptr<data_mgr> dm = data_table_[table_id][shard_id];
   if (dm) {
-    return dm->get(key);
+    std::pair<tuple_pb, bool> r = dm->get(key);
+    if (r.second) {
+      cache_hits->inc();
+    } else {
+      cache_misses->inc();
+    }
+    return r;
   } else {
     LOG(fatal) << "data manager get error";
     return std::make_pair(tuple_pb(), false);
@@ -5,7 +5,21 @@ block_config::block_config()
     : threads_cc_(0), threads_io_(0), threads_replication_(0),
       threads_async_context_(0), connections_per_peer_(CONNECTIONS_PER_PEER),
       append_log_entries_batch_min_(APPEND_LOG_ENTRIES_BATCH_MIN),
-      append_log_entries_batch_max_(APPEND_LOG_ENTRIES_BATCH_MAX) {};
+      append_log_entries_batch_max_(APPEND_LOG_ENTRIES_BATCH_MAX),
+      append_log_batch_bytes_max_(APPEND_LOG_BATCH_BYTES_MAX),
+      append_log_batch_deadline_us_(APPEND_LOG_BATCH_DEADLINE_MICROS),
+      append_log_inflight_max_(APPEND_LOG_INFLIGHT_MAX),
+      append_log_credit_bytes_(APPEND_LOG_CREDIT_BYTES),
+      append_log_pending_bytes_max_(APPEND_LOG_PENDING_BYTES_MAX),
+      snapshot_chunk_bytes_(SNAPSHOT_CHUNK_BYTES),
+      snapshot_chunk_inflight_(SNAPSHOT_CHUNK_INFLIGHT),
+      warm_up_chunk_bytes_(WARM_UP_CHUNK_BYTES),
+      warm_up_chunk_inflight_(WARM_UP_CHUNK_INFLIGHT),
+      send_coalesce_(SEND_COALESCE),
+      send_coalesce_delay_us_(SEND_COALESCE_DELAY_MICROS),
+      thread_per_core_(THREAD_PER_CORE), num_cores_(NUM_CORES),
+      shm_transport_(SHM_TRANSPORT), wan_compress_(WAN_COMPRESS),
+      wan_compress_min_bytes_(WAN_COMPRESS_MIN_BYTES) {};
 
 boost::json::object block_config::to_json() const {
   boost::json::object obj;
@@ -20,6 +34,22 @@ boost::json::object block_config::to_json() const {
   obj["connections_per_peer"] = connections_per_peer_;
   obj["append_log_entries_batch_min"] = append_log_entries_batch_min_;
   obj["append_log_entries_batch_max"] = append_log_entries_batch_max_;
+  obj["append_log_batch_bytes_max"] = append_log_batch_bytes_max_;
+  obj["append_log_batch_deadline_us"] = append_log_batch_deadline_us_;
+  obj["append_log_inflight_max"] = append_log_inflight_max_;
+  obj["append_log_credit_bytes"] = append_log_credit_bytes_;
+  obj["append_log_pending_bytes_max"] = append_log_pending_bytes_max_;
+  obj["snapshot_chunk_bytes"] = snapshot_chunk_bytes_;
+  obj["snapshot_chunk_inflight"] = snapshot_chunk_inflight_;
+  obj["warm_up_chunk_bytes"] = warm_up_chunk_bytes_;
+  obj["warm_up_chunk_inflight"] = warm_up_chunk_inflight_;
+  obj["send_coalesce"] = send_coalesce_;
+  obj["send_coalesce_delay_us"] = send_coalesce_delay_us_;
+  obj["thread_per_core"] = thread_per_core_;
+  obj["num_cores"] = num_cores_;
+  obj["shm_transport"] = shm_transport_;
+  obj["wan_compress"] = wan_compress_;
+  obj["wan_compress_min_bytes"] = wan_compress_min_bytes_;
   return obj;
 }
 
@@ -41,4 +71,31 @@ void block_config::from_json(boost::json::object &obj) {
       boost::json::value_to<uint64_t>(obj["append_log_entries_batch_min"]);
   append_log_entries_batch_max_ =
       boost::json::value_to<uint64_t>(obj["append_log_entries_batch_max"]);
+  append_log_batch_bytes_max_ =
+      boost::json::value_to<uint64_t>(obj["append_log_batch_bytes_max"]);
+  append_log_batch_deadline_us_ =
+      boost::json::value_to<uint64_t>(obj["append_log_batch_deadline_us"]);
+  append_log_inflight_max_ =
+      boost::json::value_to<uint64_t>(obj["append_log_inflight_max"]);
+  append_log_credit_bytes_ =
+      boost::json::value_to<uint64_t>(obj["append_log_credit_bytes"]);
+  append_log_pending_bytes_max_ =
+      boost::json::value_to<uint64_t>(obj["append_log_pending_bytes_max"]);
+  snapshot_chunk_bytes_ =
+      boost::json::value_to<uint64_t>(obj["snapshot_chunk_bytes"]);
+  snapshot_chunk_inflight_ =
+      boost::json::value_to<uint64_t>(obj["snapshot_chunk_inflight"]);
+  warm_up_chunk_bytes_ =
+      boost::json::value_to<uint64_t>(obj["warm_up_chunk_bytes"]);
+  warm_up_chunk_inflight_ =
+      boost::json::value_to<uint64_t>(obj["warm_up_chunk_inflight"]);
+  send_coalesce_ = boost::json::value_to<bool>(obj["send_coalesce"]);
+  send_coalesce_delay_us_ =
+      boost::json::value_to<uint64_t>(obj["send_coalesce_delay_us"]);
+  thread_per_core_ = boost::json::value_to<bool>(obj["thread_per_core"]);
+  num_cores_ = boost::json::value_to<uint64_t>(obj["num_cores"]);
+  shm_transport_ = boost::json::value_to<bool>(obj["shm_transport"]);
+  wan_compress_ = boost::json::value_to<std::string>(obj["wan_compress"]);
+  wan_compress_min_bytes_ =
+      boost::json::value_to<uint64_t>(obj["wan_compress_min_bytes"]);
 }
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "common/blog.h"
+#include "common/logger.hpp"
+#include "common/panic.h"
+#include "common/variable.h"
+#include <algorithm>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/log/attributes/attribute_set.hpp>
+#include <boost/log/attributes/constant.hpp>
+#include <boost/log/detail/thread_id.hpp>
+#include <boost/log/sources/record_ostream.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static_assert((BLOG_RING_BYTES & (BLOG_RING_BYTES - 1)) == 0,
+              "BLOG_RING_BYTES must be a power of 2");
+
+std::atomic<int> blog_runtime_level(BLOG_LEVEL_info);
+
+// a single producer, the thread of the ring, and a single consumer, the
+// background thread; head_ and tail_ only increase
+struct blog_ring {
+  std::unique_ptr<char[]> buf_;
+  alignas(64) std::atomic<uint64_t> head_;
+  uint64_t cached_tail_;
+  alignas(64) std::atomic<uint64_t> tail_;
+  std::atomic<uint64_t> dropped_;
+  // the thread writing the ring, set before its first record
+  boost::log::aux::thread::id thread_id_;
+
+  blog_ring()
+      : buf_(new char[BLOG_RING_BYTES]), head_(0), cached_tail_(0), tail_(0),
+        dropped_(0) {}
+};
+
+struct blog_line {
+  uint64_t ts_ns_;
+  int level_;
+  boost::log::aux::thread::id thread_id_;
+  std::string text_;
+};
+
+// the rings outlive their threads, the records of an ended thread are
+// written; the ring of an ended thread is free, and taken by a new thread
+// once its records are written, so there are at most as many rings as the
+// threads alive, and the ended ones not drained yet
+static std::mutex blog_rings_mutex;
+static std::vector<std::unique_ptr<blog_ring>> blog_rings;
+static std::vector<blog_ring *> blog_free_rings;
+
+// frees the ring of the thread when it ends
+struct blog_ring_holder {
+  blog_ring *ring_ = nullptr;
+
+  ~blog_ring_holder() {
+    if (ring_ != nullptr) {
+      std::scoped_lock l(blog_rings_mutex);
+      blog_free_rings.push_back(ring_);
+    }
+  }
+};
+
+static thread_local blog_ring_holder blog_this_ring;
+
+// serializes the writers of the records, the background thread and
+// blog_flush
+static std::mutex blog_drain_mutex;
+static std::once_flag blog_start_once;
+static std::atomic<bool> blog_stopped(false);
+static std::thread blog_thread;
+static uint64_t blog_dropped_reported = 0;
+
+static void blog_run();
+
+static void blog_start() {
+  // Boost.Log is created before, and destroyed after, blog_stop at exit
+  boost::log::core::get();
+  blog_thread = std::thread(blog_run);
+  std::atexit(blog_stop);
+}
+
+static blog_ring *blog_get_ring() {
+  if (blog_this_ring.ring_ == nullptr) {
+    std::call_once(blog_start_once, blog_start);
+    blog_ring *ring = nullptr;
+    {
+      std::scoped_lock l(blog_rings_mutex);
+      // a free ring whose records are all written, the records not written
+      // yet keep the thread id of the ended thread
+      auto i = std::find_if(
+          blog_free_rings.begin(), blog_free_rings.end(), [](blog_ring *r) {
+            return r->tail_.load(std::memory_order_acquire) ==
+                   r->head_.load(std::memory_order_relaxed);
+          });
+      if (i != blog_free_rings.end()) {
+        ring = *i;
+        blog_free_rings.erase(i);
+      } else {
+        blog_rings.emplace_back(new blog_ring());
+        ring = blog_rings.back().get();
+      }
+    }
+    ring->thread_id_ = boost::log::aux::this_thread::get_id();
+    blog_this_ring.ring_ = ring;
+  }
+  return blog_this_ring.ring_;
+}
+
+uint64_t blog_now_ns() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count());
+}
+
+int blog_level_of(const std::string &name) {
+  static const char *const names[] = {"trace",   "debug", "info",
+                                      "warning", "error", "fatal"};
+  for (int i = BLOG_LEVEL_trace; i <= BLOG_LEVEL_fatal; i++) {
+    if (name == names[i]) {
+      return i;
+    }
+  }
+  PANIC("unknown log level " + name);
+  return BLOG_LEVEL_info;
+}
+
+void blog_set_level(int level) {
+  blog_runtime_level.store(level, std::memory_order_relaxed);
+  boost::log::core::get()->set_filter(
+      boost::log::trivial::severity >=
+      boost::log::trivial::severity_level(level));
+}
+
+char *blog_reserve(uint32_t size) {
+  blog_ring *ring = blog_get_ring();
+  if (size > BLOG_RING_BYTES / 2) {
+    ring->dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  uint64_t head = ring->head_.load(std::memory_order_relaxed);
+  uint64_t offset = head & (BLOG_RING_BYTES - 1);
+  // a record never wraps, the end of the ring is padded
+  uint64_t pad = offset + size > BLOG_RING_BYTES ? BLOG_RING_BYTES - offset : 0;
+  if (head + pad + size - ring->cached_tail_ > BLOG_RING_BYTES) {
+    ring->cached_tail_ = ring->tail_.load(std::memory_order_acquire);
+    if (head + pad + size - ring->cached_tail_ > BLOG_RING_BYTES) {
+      ring->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+  if (pad != 0) {
+    // the padding may be 8 bytes, only its size and marker are written
+    uint32_t marker[2] = {uint32_t(pad), BLOG_PAD_MARKER};
+    std::memcpy(ring->buf_.get() + offset, marker, sizeof(marker));
+    ring->head_.store(head + pad, std::memory_order_release);
+    offset = 0;
+  }
+  return ring->buf_.get() + offset;
+}
+
+void blog_commit(uint32_t size) {
+  blog_ring *ring = blog_this_ring.ring_;
+  ring->head_.store(ring->head_.load(std::memory_order_relaxed) + size,
+                    std::memory_order_release);
+}
+
+template<class T> static T blog_get(const char *&p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  p += sizeof(T);
+  return v;
+}
+
+std::string blog_format(const char *format, const char *args, size_t size) {
+  std::string text;
+  const char *p = args;
+  const char *end = args + size;
+  auto append_arg = [&text, &p, end]() {
+    if (p >= end) {
+      return false;
+    }
+    blog_tag tag = blog_tag(*p++);
+    switch (tag) {
+    case BLOG_TAG_I64:text += std::to_string(blog_get<int64_t>(p));
+      break;
+    case BLOG_TAG_U64:text += std::to_string(blog_get<uint64_t>(p));
+      break;
+    case BLOG_TAG_F64:text += std::to_string(blog_get<double>(p));
+      break;
+    case BLOG_TAG_BOOL:text += (*p++ != 0) ? "true" : "false";
+      break;
+    case BLOG_TAG_STR: {
+      uint32_t n = blog_get<uint32_t>(p);
+      text.append(p, n);
+      p += n;
+      break;
+    }
+    case BLOG_TAG_ENUM: {
+      int64_t v = blog_get<int64_t>(p);
+      blog_enum_fn fn = blog_get<blog_enum_fn>(p);
+      text += fn(v);
+      break;
+    }
+    case BLOG_TAG_NODE:text += id_2_name(blog_get<node_id_t>(p));
+      break;
+    default:p = end;
+      return false;
+    }
+    return true;
+  };
+  for (const char *f = format; *f != 0; f++) {
+    if (f[0] == '{' && f[1] == '}') {
+      if (not append_arg()) {
+        text += "{}";
+      }
+      f++;
+    } else {
+      text += *f;
+    }
+  }
+  // the arguments more than the placeholders
+  while (p < end) {
+    text += " ";
+    if (not append_arg()) {
+      break;
+    }
+  }
+  return text;
+}
+
+// the record has the time it is made, and the thread which made it, as the
+// TimeStamp and ThreadID attributes of Boost.Log, not those of the drain
+static void blog_write(const blog_line &line) {
+  boost::posix_time::ptime utc =
+      boost::posix_time::from_time_t(time_t(line.ts_ns_ / 1000000000)) +
+      boost::posix_time::microseconds(int64_t(line.ts_ns_ % 1000000000 / 1000));
+  boost::log::attribute_set attrs;
+  attrs.insert("Severity",
+               boost::log::attributes::make_constant(
+                   boost::log::trivial::severity_level(line.level_)));
+  attrs.insert(
+      "TimeStamp",
+      boost::log::attributes::make_constant(
+          boost::date_time::c_local_adjustor<boost::posix_time::ptime>::
+              utc_to_local(utc)));
+  attrs.insert("ThreadID",
+               boost::log::attributes::make_constant(line.thread_id_));
+  boost::shared_ptr<boost::log::core> core = boost::log::core::get();
+  boost::log::record rec = core->open_record(attrs);
+  if (rec) {
+    boost::log::record_ostream strm(rec);
+    strm << line.text_;
+    strm.flush();
+    core->push_record(boost::move(rec));
+  }
+}
+
+// write the records in the rings, false if there is none
+static bool blog_drain() {
+  std::scoped_lock l(blog_drain_mutex);
+  std::vector<blog_ring *> rings;
+  {
+    std::scoped_lock lr(blog_rings_mutex);
+    for (const auto &r : blog_rings) {
+      rings.push_back(r.get());
+    }
+  }
+  std::vector<blog_line> lines;
+  uint64_t dropped = 0;
+  for (blog_ring *ring : rings) {
+    dropped += ring->dropped_.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail_.load(std::memory_order_relaxed);
+    uint64_t head = ring->head_.load(std::memory_order_acquire);
+    while (tail < head) {
+      const char *p = ring->buf_.get() + (tail & (BLOG_RING_BYTES - 1));
+      uint32_t marker[2];
+      std::memcpy(marker, p, sizeof(marker));
+      if (marker[1] == BLOG_PAD_MARKER) {
+        tail += marker[0];
+        continue;
+      }
+      blog_header header;
+      std::memcpy(&header, p, sizeof(header));
+      lines.push_back(blog_line{
+          header.ts_ns_, header.site_->level_, ring->thread_id_,
+          blog_format(header.site_->format_, p + sizeof(header),
+                      header.args_)});
+      tail += header.size_;
+    }
+    ring->tail_.store(tail, std::memory_order_release);
+  }
+  // the records of the threads in the order they are made
+  std::stable_sort(lines.begin(), lines.end(),
+                   [](const blog_line &x, const blog_line &y) {
+                     return x.ts_ns_ < y.ts_ns_;
+                   });
+  for (const blog_line &line : lines) {
+    blog_write(line);
+  }
+  if (dropped != blog_dropped_reported) {
+    LOG(warning) << "binary log dropped " << dropped - blog_dropped_reported
+                 << " records, the rings are full";
+    blog_dropped_reported = dropped;
+  }
+  return not lines.empty();
+}
+
+static void blog_run() {
+  while (not blog_stopped.load(std::memory_order_acquire)) {
+    if (not blog_drain()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(BLOG_FLUSH_MICROS));
+    }
+  }
+}
+
+void blog_flush() { blog_drain(); }
+
+void blog_stop() {
+  if (blog_stopped.exchange(true)) {
+    return;
+  }
+  if (blog_thread.joinable()) {
+    blog_thread.join();
+  }
+  blog_drain();
+}
+
+uint64_t blog_dropped() {
+  uint64_t dropped = 0;
+  std::scoped_lock l(blog_rings_mutex);
+  for (const auto &r : blog_rings) {
+    dropped += r->dropped_.load(std::memory_order_relaxed);
+  }
+  return dropped;
+}
+
+size_t blog_num_rings() {
+  std::scoped_lock l(blog_rings_mutex);
+  return blog_rings.size();
+}
@@ -1,6 +1,7 @@
 #include "common/config.h"
 #include "common/logger.hpp"
 #include "common/panic.h"
+#include "common/tx_log.h"
 
 config::config()
     : num_rep_group_(0), num_replica_(0),
@@ -270,6 +271,7 @@ void config::re_generate_id() {
 boost::json::object config::to_json() {
   boost::json::object j;
   j["param"] = tpcc_config_.to_json();
+  j["ycsb"] = ycsb_config_.to_json();
   j["block"] = block_config_.to_json();
   j["test"] = test_config_.to_json();
 
@@ -289,6 +291,7 @@ boost::json::object config::to_json() {
 
 void config::from_json(boost::json::object j) {
   tpcc_config_.from_json(j["param"].as_object());
+  ycsb_config_.from_json(j["ycsb"].as_object());
 
   boost::json::object &jblock = j["block"].as_object();
   block_config_.from_json(jblock);
@@ -352,6 +355,13 @@ bool config::valid_check() {
     LOG(error) << "order id overflow";
     return false;
   }
+  for (shard_id_t shard_id : all_shard_ids()) {
+    if (shard_id >= SHARD_MAP_BITS) {
+      LOG(error) << "shard id " << shard_id << " overflows the shard map, at most "
+                 << SHARD_MAP_BITS - 1 << " shards";
+      return false;
+    }
+  }
   return true;
 }
 
@@ -19,12 +19,16 @@ enum_strings<message_type>::e2s_t enum_strings<message_type>::enum2str = {
 
     {RAFT_TRANSFER_LEADER, "RAFT_TRANSFER_LEADER"},
     {RAFT_TRANSFER_NOTIFY, "RAFT_TRANSFER_NOTIFY"},
+    {RAFT_READ_INDEX_REQ, "RAFT_READ_INDEX_REQ"},
+    {RAFT_READ_INDEX_RESP, "RAFT_READ_INDEX_RESP"},
     {C2R_APPEND_LOG_REQ, "C2R_APPEND_LOG_REQ"},
     {C2R_REPLAY_LOG_RESP, "C2R_REPLAY_LOG_RESP"},
     {D2R_WRITE_BATCH_RESP, "D2R_WRITE_BATCH_RESP"},
     {C2R_REGISTER_REQ, "C2R_REGISTER_REQ"},
     {D2R_REGISTER_REQ, "D2R_REGISTER_REQ"},
     {C2R_REPORT_STATUS_RESP, "C2R_REPORT_STATUS_RESP"},
+    {C2R_READ_INDEX_REQ, "C2R_READ_INDEX_REQ"},
+    {D2R_SNAPSHOT_INSTALLED, "D2R_SNAPSHOT_INSTALLED"},
     {RLB_MESSAGE_END, "RLB_MESSAGE_END"},
 
     // the following message are processed by CCB
@@ -32,6 +36,7 @@ enum_strings<message_type>::e2s_t enum_strings<message_type>::enum2str = {
     {R2C_REGISTER_RESP, "R2C_REGISTER_RESP"},
     {COMMIT_LOG_ENTRIES, "COMMIT_LOG_ENTRIES"},
     {D2C_READ_DATA_RESP, "D2C_READ_DATA_RESP"},
+    {R2C_READ_INDEX_RESP, "R2C_READ_INDEX_RESP"},
 
     {R2C_REPORT_STATUS_REQ, "R2C_REPORT_STATUS_REQ"},
 
@@ -42,6 +47,7 @@ enum_strings<message_type>::e2s_t enum_strings<message_type>::enum2str = {
     {CLIENT_CCB_STATE_RESP, "CLIENT_CCB_STATE_RESP"},
     {CCB_HANDLE_WARM_UP_REQ, "DSB_HANDLE_WARM_UP_REQ"},
     {CCB_HANDLE_WARM_UP_RESP, "CCB_HANDLE_WARM_UP_RESP"},
+    {D2C_WARM_UP_CHUNK, "D2C_WARM_UP_CHUNK"},
     {TX_TM_COMMIT, "TX_TM_COMMIT"},
     {TX_TM_ABORT, "TX_TM_ABORT"},
     {TX_TM_END, "TX_TM_END"},
@@ -68,8 +74,12 @@ enum_strings<message_type>::e2s_t enum_strings<message_type>::enum2str = {
 
     {R2D_REGISTER_RESP, "R2D_REGISTER_RESP"},
     {R2D_REPLAY_TO_DSB_REQ, "R2D_REPLAY_TO_DSB_REQ"},
+    {R2D_SNAPSHOT_REQ, "R2D_SNAPSHOT_REQ"},
+    {D2D_SNAPSHOT_CHUNK, "D2D_SNAPSHOT_CHUNK"},
+    {D2D_SNAPSHOT_ACK, "D2D_SNAPSHOT_ACK"},
     {CLIENT_LOAD_DATA_REQ, "CLIENT_LOAD_DATA_REQ"},
     {DSB_HANDLE_WARM_UP_REQ, "DSB_HANDLE_WARM_UP_REQ"},
+    {C2D_WARM_UP_ACK, "C2D_WARM_UP_ACK"},
     {DSB_MESSAGE_END, "DSB_MESSAGE_END"},
 
     {CLI_MESSAGE_BEGIN, "CLI_MESSAGE_BEGIN"},
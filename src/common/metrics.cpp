@@ -0,0 +1,161 @@
+#include "common/metrics.h"
+#include "common/panic.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// the cells of a thread, a chunk is allocated by the thread on its first
+// update of a cell of the chunk
+struct metrics_shard {
+  std::array<std::atomic<std::atomic<uint64_t> *>, METRICS_MAX_CHUNKS> chunk_;
+
+  metrics_shard() {
+    for (auto &c : chunk_) {
+      c.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+};
+
+// constant initialized, the metrics defined as static objects of the other
+// translation units allocate their cells before main
+static std::atomic<uint32_t> metrics_next_cell(0);
+
+static thread_local metrics_shard *metrics_this_shard = nullptr;
+
+static std::mutex &metrics_shards_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+static std::vector<std::unique_ptr<metrics_shard>> &metrics_shards() {
+  static std::vector<std::unique_ptr<metrics_shard>> shards;
+  return shards;
+}
+
+static std::mutex &metrics_entries_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+static std::vector<const metric_entry *> &metrics_entries() {
+  static std::vector<const metric_entry *> entries;
+  return entries;
+}
+
+static std::atomic<uint64_t> *metrics_alloc_chunk(metrics_shard *shard,
+                                                  uint32_t chunk) {
+  auto *cells = new std::atomic<uint64_t>[METRICS_CHUNK_CELLS]();
+  shard->chunk_[chunk].store(cells, std::memory_order_release);
+  return cells;
+}
+
+std::atomic<uint64_t> &metrics_cell(uint32_t cell) {
+  metrics_shard *shard = metrics_this_shard;
+  if (shard == nullptr) {
+    std::scoped_lock l(metrics_shards_mutex());
+    metrics_shards().emplace_back(new metrics_shard());
+    shard = metrics_shards().back().get();
+    metrics_this_shard = shard;
+  }
+  uint32_t chunk = cell / METRICS_CHUNK_CELLS;
+  std::atomic<uint64_t> *cells =
+      shard->chunk_[chunk].load(std::memory_order_relaxed);
+  if (cells == nullptr) {
+    cells = metrics_alloc_chunk(shard, chunk);
+  }
+  return cells[cell % METRICS_CHUNK_CELLS];
+}
+
+uint64_t metrics_cell_sum(uint32_t cell) {
+  uint32_t chunk = cell / METRICS_CHUNK_CELLS;
+  uint64_t sum = 0;
+  std::scoped_lock l(metrics_shards_mutex());
+  for (const auto &shard : metrics_shards()) {
+    std::atomic<uint64_t> *cells =
+        shard->chunk_[chunk].load(std::memory_order_acquire);
+    if (cells != nullptr) {
+      sum += cells[cell % METRICS_CHUNK_CELLS].load(std::memory_order_relaxed);
+    }
+  }
+  return sum;
+}
+
+uint32_t metrics_alloc_cells(uint32_t num) {
+  uint32_t cell = metrics_next_cell.fetch_add(num);
+  if (cell + num > METRICS_CHUNK_CELLS * METRICS_MAX_CHUNKS) {
+    PANIC("too many metric cells");
+  }
+  return cell;
+}
+
+static std::string metrics_labels(const std::string &labels) {
+  return labels.empty() ? std::string() : "{" + labels + "}";
+}
+
+void metric_counter::write(std::ostream &os, const std::string &name,
+                           const std::string &labels) const {
+  os << name << metrics_labels(labels) << " " << value() << "\n";
+}
+
+void metric_gauge::write(std::ostream &os, const std::string &name,
+                         const std::string &labels) const {
+  os << name << metrics_labels(labels) << " " << value() << "\n";
+}
+
+uint64_t metric_histogram::count() const {
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+    count += metrics_cell_sum(cell_ + i);
+  }
+  return count;
+}
+
+void metric_histogram::write(std::ostream &os, const std::string &name,
+                             const std::string &labels) const {
+  std::array<uint64_t, METRICS_HISTOGRAM_BUCKETS> buckets{};
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+    buckets[i] = metrics_cell_sum(cell_ + i);
+    if (buckets[i] != 0) {
+      last = i;
+    }
+  }
+  std::string sep = labels.empty() ? "" : labels + ",";
+  // the buckets up to the largest non-empty one, the last bucket has no
+  // upper bound and is only in +Inf
+  uint64_t cumulative = 0;
+  for (uint32_t i = 0; i <= last && i + 1 < METRICS_HISTOGRAM_BUCKETS; i++) {
+    cumulative += buckets[i];
+    os << name << "_bucket{" << sep << "le=\"" << bucket_upper(i) << "\"} "
+       << cumulative << "\n";
+  }
+  uint64_t count = 0;
+  for (uint64_t b : buckets) {
+    count += b;
+  }
+  os << name << "_bucket{" << sep << "le=\"+Inf\"} " << count << "\n";
+  os << name << "_sum" << metrics_labels(labels) << " " << sum() << "\n";
+  os << name << "_count" << metrics_labels(labels) << " " << count << "\n";
+}
+
+metric_entry::metric_entry(const char *name, const char *help)
+    : name_(name), help_(help) {
+  std::scoped_lock l(metrics_entries_mutex());
+  metrics_entries().push_back(this);
+}
+
+void metric_entry::write_header(std::ostream &os, const char *type) const {
+  os << "# HELP " << name_ << " " << help_ << "\n";
+  os << "# TYPE " << name_ << " " << type << "\n";
+}
+
+void metrics_prometheus(std::ostream &os) {
+  std::vector<const metric_entry *> entries;
+  {
+    std::scoped_lock l(metrics_entries_mutex());
+    entries = metrics_entries();
+  }
+  for (const metric_entry *e : entries) {
+    e->write(os);
+  }
+}
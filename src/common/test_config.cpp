@@ -2,18 +2,43 @@
 #include "common/variable.h"
 
 test_config::test_config()
-    : wan_latency_ms_(0), cached_tuple_percentage_(0.0),
+    : wan_latency_ms_(0), cached_tuple_percentage_(0.0), warm_up_scan_(false),
       deadlock_detection_ms_(DEADLOCK_DETECTION_TIMEOUT_MILLIS),
       deadlock_detection_(DEADLOCK_DETECTION),
-      lock_timeout_ms_(LOCK_WAIT_TIMEOUT_MILLIS) {}
+      lock_timeout_ms_(LOCK_WAIT_TIMEOUT_MILLIS), log_level_(LOG_LEVEL) {}
+
+boost::json::object net_link_shaping::to_json() const {
+  boost::json::object obj;
+  obj["from_zone"] = from_zone_;
+  obj["to_zone"] = to_zone_;
+  obj["latency_ms"] = latency_ms_;
+  obj["jitter_ms"] = jitter_ms_;
+  obj["bandwidth_mbps"] = bandwidth_mbps_;
+  return obj;
+}
+
+void net_link_shaping::from_json(boost::json::object &obj) {
+  from_zone_ = boost::json::value_to<std::string>(obj["from_zone"]);
+  to_zone_ = boost::json::value_to<std::string>(obj["to_zone"]);
+  latency_ms_ = boost::json::value_to<uint32_t>(obj["latency_ms"]);
+  jitter_ms_ = boost::json::value_to<uint32_t>(obj["jitter_ms"]);
+  bandwidth_mbps_ = boost::json::value_to<uint64_t>(obj["bandwidth_mbps"]);
+}
 
 boost::json::object test_config::to_json() const {
   boost::json::object obj;
   obj["wan_latency_delay_wait_ms"] = wan_latency_ms_;
   obj["percent_cached_tuple"] = cached_tuple_percentage_;
+  obj["warm_up_scan"] = warm_up_scan_;
   obj["deadlock_detection_ms"] = deadlock_detection_ms_;
   obj["deadlock_detection"] = deadlock_detection_;
   obj["lock_timeout_ms"] = lock_timeout_ms_;
+  obj["log_level"] = log_level_;
+  boost::json::array net_shaping;
+  for (const net_link_shaping &link : net_shaping_) {
+    net_shaping.push_back(link.to_json());
+  }
+  obj["net_shaping"] = net_shaping;
   return obj;
 }
 
@@ -22,8 +47,16 @@ void test_config::from_json(boost::json::object &obj) {
       boost::json::value_to<int32_t>(obj["wan_latency_delay_wait_ms"]);
   cached_tuple_percentage_ =
       boost::json::value_to<float_t>(obj["percent_cached_tuple"]);
+  warm_up_scan_ = boost::json::value_to<bool>(obj["warm_up_scan"]);
   deadlock_detection_ms_ =
       boost::json::value_to<int32_t>(obj["deadlock_detection_ms"]);
   deadlock_detection_ = boost::json::value_to<bool>(obj["deadlock_detection"]);
   lock_timeout_ms_ = boost::json::value_to<int64_t>(obj["lock_timeout_ms"]);
+  log_level_ = boost::json::value_to<std::string>(obj["log_level"]);
+  net_shaping_.clear();
+  for (boost::json::value &v : obj["net_shaping"].as_array()) {
+    net_link_shaping link;
+    link.from_json(v.as_object());
+    net_shaping_.push_back(link);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "common/tx_span.h"
+#include "common/variable.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+static_assert((TX_SPAN_RING_SIZE & (TX_SPAN_RING_SIZE - 1)) == 0,
+              "TX_SPAN_RING_SIZE must be a power of 2");
+
+// a slot is written by the thread of its ring only; seq_ is odd while the
+// slot is written, a reader drops a slot whose seq_ changed while read
+struct span_slot {
+  std::atomic<uint64_t> seq_;
+  std::atomic<uint64_t> id_;
+  std::atomic<uint64_t> begin_ns_;
+  std::atomic<uint64_t> end_ns_;
+  std::atomic<uint32_t> kind_;
+  std::atomic<uint32_t> terminal_id_;
+  // the thread which wrote the span, a ring is reused by the threads
+  std::atomic<uint32_t> tid_;
+
+  span_slot()
+      : seq_(0), id_(0), begin_ns_(0), end_ns_(0), kind_(0), terminal_id_(0),
+        tid_(0) {}
+};
+
+struct span_ring {
+  uint32_t tid_;
+  uint64_t next_;
+  std::array<span_slot, TX_SPAN_RING_SIZE> slot_;
+
+  span_ring() : tid_(0), next_(0) {}
+};
+
+// the rings outlive their threads, the ring of an ended thread goes to the
+// free list and the next new thread overwrites its spans, so the rings are
+// bounded by the threads alive at once
+static std::mutex span_rings_mutex;
+static std::vector<std::unique_ptr<span_ring>> span_rings;
+static std::vector<span_ring *> span_free_rings;
+static uint32_t span_next_tid = 0;
+
+struct span_ring_holder {
+  span_ring *ring_;
+
+  span_ring_holder() : ring_(nullptr) {}
+
+  ~span_ring_holder() {
+    if (ring_ != nullptr) {
+      std::scoped_lock l(span_rings_mutex);
+      span_free_rings.push_back(ring_);
+    }
+  }
+};
+
+static thread_local span_ring_holder this_span_ring;
+
+static std::atomic<uint64_t> span_sample_threshold(
+    uint64_t(TX_SPAN_SAMPLE_RATE * double(1ull << 32)));
+
+static span_ring *get_span_ring() {
+  if (this_span_ring.ring_ == nullptr) {
+    std::scoped_lock l(span_rings_mutex);
+    if (span_free_rings.empty()) {
+      span_rings.emplace_back(new span_ring());
+      this_span_ring.ring_ = span_rings.back().get();
+    } else {
+      this_span_ring.ring_ = span_free_rings.back();
+      span_free_rings.pop_back();
+    }
+    this_span_ring.ring_->tid_ = ++span_next_tid;
+  }
+  return this_span_ring.ring_;
+}
+
+size_t tx_span_num_rings() {
+  std::scoped_lock l(span_rings_mutex);
+  return span_rings.size();
+}
+
+const char *tx_span_name(tx_span_kind kind) {
+  switch (kind) {
+  case SPAN_CLIENT_SEND:return "client_send";
+  case SPAN_CCB_DISPATCH:return "ccb_dispatch";
+  case SPAN_LOCK_WAIT:return "lock_wait";
+  case SPAN_DSB_READ:return "dsb_read";
+  case SPAN_WAL_APPEND:return "wal_append";
+  case SPAN_RAFT_REPLICATE:return "raft_replicate";
+  case SPAN_COMMIT_NOTIFY:return "commit_notify";
+  case SPAN_TM_COMMIT:return "tm_commit";
+  case SPAN_RESPONSE:return "response";
+  default:return "unknown";
+  }
+}
+
+void tx_span_set_sample_rate(double rate) {
+  rate = std::min(1.0, std::max(0.0, rate));
+  span_sample_threshold.store(uint64_t(rate * double(1ull << 32)),
+                              std::memory_order_relaxed);
+}
+
+double tx_span_sample_rate() {
+  return double(span_sample_threshold.load(std::memory_order_relaxed)) /
+         double(1ull << 32);
+}
+
+bool tx_span_sample() {
+  uint64_t threshold = span_sample_threshold.load(std::memory_order_relaxed);
+  if (threshold == 0) {
+    return false;
+  }
+  // xorshift64*, seeded by the address of the state of the thread
+  static thread_local uint64_t state = 0;
+  if (state == 0) {
+    state = uint64_t(reinterpret_cast<uintptr_t>(&state)) ^ tx_span_now_ns();
+    state |= 1;
+  }
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return ((state * 2685821657736338717ull) >> 32) < threshold;
+}
+
+void tx_span_record(tx_span_kind kind, uint64_t id, uint32_t terminal_id,
+                    uint64_t begin_ns, uint64_t end_ns) {
+  span_ring *ring = get_span_ring();
+  span_slot &slot = ring->slot_[ring->next_ & (TX_SPAN_RING_SIZE - 1)];
+  ring->next_++;
+  uint64_t seq = slot.seq_.load(std::memory_order_relaxed);
+  slot.seq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.id_.store(id, std::memory_order_relaxed);
+  slot.begin_ns_.store(begin_ns, std::memory_order_relaxed);
+  slot.end_ns_.store(end_ns, std::memory_order_relaxed);
+  slot.kind_.store(uint32_t(kind), std::memory_order_relaxed);
+  slot.terminal_id_.store(terminal_id, std::memory_order_relaxed);
+  slot.tid_.store(ring->tid_, std::memory_order_relaxed);
+  slot.seq_.store(seq + 2, std::memory_order_release);
+}
+
+void tx_span_chrome_trace(std::ostream &os, uint64_t window_ms) {
+  std::vector<span_ring *> rings;
+  {
+    std::scoped_lock l(span_rings_mutex);
+    for (const auto &r : span_rings) {
+      rings.push_back(r.get());
+    }
+  }
+  uint64_t now = tx_span_now_ns();
+  uint64_t since = 0;
+  if (window_ms != 0 && now > window_ms * 1000000) {
+    since = now - window_ms * 1000000;
+  }
+  int pid = int(getpid());
+  bool first = true;
+  os << "{\"traceEvents\":[";
+  for (span_ring *ring : rings) {
+    for (span_slot &slot : ring->slot_) {
+      uint64_t seq = slot.seq_.load(std::memory_order_acquire);
+      if (seq == 0 || (seq & 1) != 0) {
+        continue;
+      }
+      uint64_t id = slot.id_.load(std::memory_order_relaxed);
+      uint64_t begin_ns = slot.begin_ns_.load(std::memory_order_relaxed);
+      uint64_t end_ns = slot.end_ns_.load(std::memory_order_relaxed);
+      uint32_t kind = slot.kind_.load(std::memory_order_relaxed);
+      uint32_t terminal_id = slot.terminal_id_.load(std::memory_order_relaxed);
+      uint32_t tid = slot.tid_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq_.load(std::memory_order_relaxed) != seq) {
+        continue;
+      }
+      if (end_ns < since) {
+        continue;
+      }
+      if (not first) {
+        os << ",";
+      }
+      first = false;
+      uint64_t dur_ns = end_ns > begin_ns ? end_ns - begin_ns : 0;
+      os << "{\"name\":\"" << tx_span_name(tx_span_kind(kind))
+         << "\",\"cat\":\"tx\",\"ph\":\"X\",\"ts\":" << begin_ns / 1000
+         << "." << (begin_ns % 1000) / 100 << ",\"dur\":" << dur_ns / 1000
+         << "." << (dur_ns % 1000) / 100 << ",\"pid\":" << pid
+         << ",\"tid\":" << tid << ",\"args\":{\"id\":" << id
+         << ",\"terminal\":" << terminal_id << "}}";
+    }
+  }
+  os << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
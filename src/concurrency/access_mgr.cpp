@@ -15,7 +15,7 @@ access_mgr::access_mgr(
   data_table_.resize(max_table_id + 1);
   for (table_id_t id = 0; id <= max_table_id; id++) {
     for (auto shard_id : shards) {
-      ptr<lock_mgr> l(new lock_mgr(id, shard_id, service_->get_service(SERVICE_CC), dl_,
+      ptr<lock_mgr> l(new lock_mgr(id, shard_id, service_->get_service(SERVICE_CC, id), dl_,
                                    fn_before_, fn_after_));
       lock_table_[id].insert(std::make_pair(shard_id, l));
 
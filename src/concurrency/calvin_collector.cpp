@@ -53,6 +53,7 @@ void calvin_collector::respond() {
     }
   }
   response->set_error_code(EC::EC_OK);
+  response->set_client_seq(request_->client_seq());
   service_->conn_async_send(conn_, CLIENT_TX_RESP, response);
 }
 
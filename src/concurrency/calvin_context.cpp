@@ -1,5 +1,6 @@
 #include "concurrency/calvin_context.h"
 #include "common/berror.h"
+#include "common/scoped_time.h"
 #include "common/tx_log.h"
 #include "common/utils.h"
 #include "common/shard2node.h"
@@ -46,35 +47,48 @@ void calvin_context::async_lock_acquire(EC ec, oid_t oid) {
 
 void calvin_context::begin() {
 #ifdef TX_TRACE
-  auto rm = shared_from_this();
-  auto fn_timeout = [rm] {
-    if (rm->timeout_invoked_) {
+  async_tick_timeout();
+#endif
+}
+
+#ifdef TX_TRACE
+void calvin_context::async_tick_timeout() {
+  std::weak_ptr<calvin_context> ctx = shared_from_this();
+  auto fn_timeout = [ctx] {
+    ptr<calvin_context> rm = ctx.lock();
+    if (not rm) {
       return;
     }
+    boost::asio::post(rm->get_strand(), [rm] { rm->handle_tick_timeout(); });
+  };
+  service_->get_timing_wheel(get_strand().context())
+      .arm_after(timer_ticker_, TX_TIMEOUT_MILLIS * 1000, fn_timeout);
+}
 
-    auto ms = steady_clock_ms_since_epoch();
+void calvin_context::handle_tick_timeout() {
+  if (timeout_invoked_) {
+    async_tick_timeout();
+    return;
+  }
 
-    if (ms < rm->start_ms_ + TX_TIMEOUT_MILLIS) {
-      std::string trace = rm->trace_message_.str();
-      if (rm->commit_) {
-        rm->timer_ticker_->cancel();
-        return;
-      }
+  auto ms = steady_clock_ms_since_epoch();
 
-      rm->timeout_invoked_ = true;
-      LOG(warning) <<
-          " tx: " << ms - rm->start_ms_ <<
-          " wait ms, " << rm->xid_ <<
-          " trace" << trace;
+  if (ms < start_ms_ + TX_TIMEOUT_MILLIS) {
+    std::string trace = trace_message_.str();
+    if (commit_) {
+      return;
     }
-  };
-  ptr<timer> t(new timer(
-      get_strand(), boost::asio::chrono::milliseconds(TX_TIMEOUT_MILLIS),
-      fn_timeout));
-  timer_ticker_ = t;
-  t->async_tick();
-#endif
+
+    timeout_invoked_ = true;
+    LOG(warning) <<
+        " tx: " << ms - start_ms_ <<
+        " wait ms, " << xid_ <<
+        " trace" << trace;
+  }
+  async_tick_timeout();
 }
+#endif
+
 bool calvin_context::on_operation_done(const tx_operation &op,
                                        const tuple_pb &tp) {
   ptr<tx_operation> o(new tx_operation(op));
@@ -1,5 +1,6 @@
 #include "concurrency/calvin_scheduler.h"
 
+#include <map>
 #include <utility>
 #ifdef DB_TYPE_CALVIN
 
@@ -28,8 +29,10 @@ void calvin_scheduler::schedule(const ptr<calvin_epoch_ops> &e) {
     return;
   }
   std::vector<tx_log_binary> entry;
+  std::vector<shard_map_t> shard_map;
   std::unordered_map<xid_t, ptr<calvin_context>> ctx_set;
   entry.resize(e->reqs_.size());
+  shard_map.resize(e->reqs_.size(), 0);
   uint64_t ops = 0;
   for (size_t i = 0; i < e->reqs_.size(); i++) {
     ptr<tx_request> req = e->reqs_[i];
@@ -40,6 +43,7 @@ void calvin_scheduler::schedule(const ptr<calvin_epoch_ops> &e) {
     for (const tx_operation &op : req->operations()) {
       if (is_write_operation(op.op_type())) {
         *proto.add_operations() = op;
+        shard_map[i] |= shard_id_to_map(op.tuple_row().shard_id());
         if (op.op_type() == tx_op_type::TX_OP_INSERT ||
             op.op_type() == tx_op_type::TX_OP_UPDATE) {
           BOOST_ASSERT(op.has_tuple_row() &&
@@ -62,13 +66,17 @@ void calvin_scheduler::schedule(const ptr<calvin_epoch_ops> &e) {
   }
   // LOG(trace) << id_2_name(conf_.node_id()) << " write operations " <<
   // entry.operation().size();
-  wal_->async_append(entry);
+  wal_->async_append(entry, shard_map);
   /*
   for (auto & c : ctx_set) {
     LOG(info) << "calvin async append log " << c.second->xid();
     c.second->trace_message_ += "app logs;";
   }*/
   ptr<std::atomic<uint64_t>> num_op(new std::atomic(ops));
+  // the row locks of the epoch by table and shard, each batch looks up its
+  // lock slots at a time
+  std::map<std::pair<uint32_t, uint32_t>, std::vector<row_lock_request>>
+      lock_requests;
   for (const ptr<tx_request> &req : e->reqs_) {
     auto tx = ctx_set[req->xid()];
     for (const tx_operation &op : req->operations()) {
@@ -100,12 +108,18 @@ void calvin_scheduler::schedule(const ptr<calvin_epoch_ops> &e) {
         tx_op_done(tx, op);
       };
       tx->add_lock_acquire_callback(op.operation_id(), fn);
-      access_mgr_->lock_row(op.xid(), op.operation_id(), lt,
-                            op.tuple_row().table_id(),
-                            op.tuple_row().shard_id(),
-                            predicate(op.tuple_row().tuple_id()), tx);
+      auto key = std::make_pair(op.tuple_row().table_id(),
+                                op.tuple_row().shard_id());
+      lock_requests[key].push_back(row_lock_request{
+          op.operation_id(), lt, op.tuple_row().tuple_id(), tx});
     }
   }
+  // the locks of a row are acquired in the order of the epoch, as the
+  // requests of a row are in the same batch
+  for (auto &kv : lock_requests) {
+    access_mgr_->lock_rows(kv.first.first, kv.first.second,
+                           std::move(kv.second));
+  }
 }
 
 void calvin_scheduler::tx_op_done(const ptr<calvin_context> &tx,
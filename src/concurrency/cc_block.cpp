@@ -1,15 +1,22 @@
 #include "concurrency/cc_block.h"
+#include "common/blog.h"
 #include "common/db_type.h"
 #include "common/debug_url.h"
 #include "common/json_pretty.h"
 #include "common/make_int.h"
+#include "common/metrics.h"
 #include "common/result.hpp"
+#include "common/scoped_time.h"
 #include "common/timer.h"
 #include "common/shard2node.h"
 #include <charconv>
 #include <memory>
 #include <utility>
 
+static metric<metric_gauge> strand_queue_depth(
+    "tddb_ccb_strand_queue_depth",
+    "transaction routines posted to the strands and not yet run");
+
 cc_block::cc_block(const config &conf, net_service *service,
                    fn_schedule_before fn_before, fn_schedule_after fn_after)
     : conf_(conf), cno_(0), leader_(false), node_id_(conf.node_id()),
@@ -17,12 +24,18 @@ cc_block::cc_block(const config &conf, net_service *service,
       rlb_node_id_(conf.register_to_node_id()), cc_opt_dsb_node_id_(std::nullopt),
       neighbour_shard_(0), registered_(false), mgr_(nullptr), service_(service),
       sequence_(0), wal_(new write_ahead_log(
-        conf.node_id(), conf.register_to_node_id(), service)),
+        conf.node_id(), conf.register_to_node_id(),
+        conf.get_block_config().append_log_credit_bytes(),
+        conf.get_block_config().append_log_pending_bytes_max(), service)),
 #ifdef DB_TYPE_CALVIN
       strand_calvin_(service->get_service(SERVICE_ASYNC_CONTEXT)),
 #endif
-      fn_schedule_after_(fn_after), time_("CCB h msg"),
-      strand_ccb_tick_(service->get_service(SERVICE_ASYNC_CONTEXT)) {
+      fn_schedule_after_(fn_after),
+      strand_ccb_tick_(service->get_service(SERVICE_ASYNC_CONTEXT)),
+      warm_up_stream_(uint64_t(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count())) {
   auto fn = [this](xid_t xid) { abort_tx(xid, EC::EC_VICTIM); };
   rg_lead_ = conf_.priority_lead_nodes();
   deadlock_ = cs_new<deadlock>(
@@ -72,8 +85,8 @@ void cc_block::on_start() {
   for (auto p : rg_lead_) {
     if (p.first == neighbour_shard_) {
       if (deadlock_) {
-        LOG(trace) << "neighbour " << id_2_name(node_id_) << " "
-                   << id_2_name(p.second);
+        BLOG(trace, "neighbour {} {}", blog_node(node_id_),
+             blog_node(p.second));
         deadlock_->set_next_node(p.second);
       }
     }
@@ -89,12 +102,12 @@ void cc_block::on_start() {
     auto fn_find = [ccb](const tx_request &req) {
       xid_t xid = req.xid();
       uint32_t terminal_id = ccb->xid_to_terminal_id(xid);
-      auto pair = ccb->calvin_context_[terminal_id].find(xid);
+      auto pair = ccb->calvin_context_.find(terminal_id, xid);
       if (pair.second) {
         return pair.first;
       } else {
         auto ctx = ccb->create_calvin_context(req);
-        ccb->calvin_context_[terminal_id].insert(xid, ctx);
+        ccb->calvin_context_.insert(terminal_id, xid, ctx);
         return ctx;
       }
     };
@@ -130,7 +143,6 @@ void cc_block::on_stop() {
   }
   // todo elegant exit
   sleep(5);
-  // time_.print();
   LOG(info) << "stop CCB " << node_name_ << " ...";
 }
 
@@ -162,6 +174,10 @@ void cc_block::handle_debug(const std::string &path, std::ostream &os) {
     }
   } else if (boost::regex_match(path, url_lock)) {
     debug_lock(os);
+  } else if (boost::regex_match(path, url_hot_key)) {
+    mgr_->debug_hot_key(os, false);
+  } else if (boost::regex_match(path, url_json_hot_key)) {
+    mgr_->debug_hot_key(os, true);
   } else if (boost::regex_match(path, url_dep)) {
     debug_dependency(os);
   } else if (boost::regex_match(path, url_deadlock)) {
@@ -260,16 +276,27 @@ void cc_block::strand_ccb_handle_register_ccb_response(
 void cc_block::handle_client_tx_request(const ptr<connection> conn,
                                         const ptr<tx_request> request) {
   EC ec = EC::EC_OK;
-  LOG(trace) << node_name_ << " handle tx request "
-             << " leader"
-             << id_2_name(conf_.get_largest_priority_node_of_shard(
-                 TO_RG_ID(node_id_)));
+  BLOG(trace, "{} handle tx request leader {}", blog_node(node_id_),
+       blog_node(conf_.get_largest_priority_node_of_shard(TO_RG_ID(node_id_))));
 
   BOOST_ASSERT(request->client_request());
   BOOST_ASSERT(conn != nullptr);
   BOOST_ASSERT(mgr_);
   BOOST_ASSERT(service_);
-  if (request->operations_size() > 0) {
+#ifdef DB_TYPE_NON_DETERMINISTIC
+  if (is_non_deterministic() && !leader_ && request->read_only() &&
+      !request->distributed() && request->operations_size() > 0) {
+    // a follower serves a read only transaction when its DSBs have applied
+    // the logs up to the read index
+    handle_replica_read_request(conn, request);
+    return;
+  }
+#endif // DB_TYPE_NON_DETERMINISTIC
+  if (wal_->overloaded()) {
+    // admission control, RLB has not granted enough append log credits
+    ec = EC::EC_FLOW_CONTROL;
+  }
+  if (request->operations_size() > 0 && ec == EC::EC_OK) {
     if (request->oneshot()) {
 #ifdef DB_TYPE_CALVIN
       if (is_deterministic()) {
@@ -285,11 +312,12 @@ void cc_block::handle_client_tx_request(const ptr<connection> conn,
       BOOST_ASSERT_MSG(false, "not implement");
     }
   } else {
-    tx_response response;
-    response.set_error_code(uint32_t(ec));
-    auto r2 = conn->send_message(CLIENT_TX_RESP, response);
-    if (!r2) {
-    }
+    // sent on the strand of the connection, a pipelined client may have
+    // other responses being written
+    auto response = std::make_shared<tx_response>();
+    response->set_error_code(uint32_t(ec));
+    response->set_client_seq(request->client_seq());
+    service_->conn_async_send(conn, CLIENT_TX_RESP, response);
   }
 }
 
@@ -320,7 +348,8 @@ cc_block::ccb_handle_message(const ptr<connection>, message_type,
 result<void> cc_block::ccb_handle_message(const ptr<connection> c, message_type,
                                           const ptr<warm_up_req> req) {
   BOOST_ASSERT(req->term_id() != 0);
-  LOG(trace) << id_2_name(conf_.node_id()) << " CCB handle warm up, term_id: " << req->term_id();
+  BLOG(trace, "{} CCB handle warm up, term_id: {}", blog_node(conf_.node_id()),
+       req->term_id());
   std::pair<ptr<connection>, bool> pair =
       term_connection_table_.find(req->term_id());
   ptr<connection> conn;
@@ -339,17 +368,26 @@ result<void> cc_block::ccb_handle_message(const ptr<connection> c, message_type,
                               warm_up_resp_to_client);
     return outcome::success();
   } else {
-    if (req->tuple_key().empty()) {
-      PANIC("cannot find this shard id");
-      return outcome::failure(EC::EC_NOT_FOUND_ERROR);
-    }
-    shard_id_t shard_id = req->tuple_key().begin()->shard_id();
+    // the keys given are read one by one, otherwise DSB streams the rows of
+    // the shard scanned in chunks
+    shard_id_t shard_id = req->tuple_key().empty()
+                              ? req->shard_id()
+                              : req->tuple_key().begin()->shard_id();
     auto iter = dsb_shard2node_.find(shard_id);
     if (iter == dsb_shard2node_.end()) {
       PANIC("cannot find this shard id");
       return outcome::failure(EC::EC_NOT_FOUND_ERROR);
     }
     node_id_t dest_node_id = iter->second;
+    if (req->tuple_key().empty()) {
+      // a retry of the same term starts over with a new stream, the chunks
+      // of the previous one are ignored
+      uint64_t stream = ++warm_up_stream_;
+      const_cast<warm_up_req &>(*req).set_stream(stream);
+      warm_up_recv_.remove(req->term_id());
+      warm_up_recv_.insert(req->term_id(),
+                           [stream] { return cs_new<warm_up_recv>(stream); });
+    }
     const_cast<warm_up_req &>(*req).set_source(node_id_);
     const_cast<warm_up_req &>(*req).set_dest(dest_node_id);
     auto result = service_->async_send(dest_node_id,
@@ -366,7 +404,8 @@ result<void> cc_block::ccb_handle_message(const ptr<connection> c, message_type,
 
 result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
                                           const ptr<warm_up_resp> resp) {
-  LOG(trace) << id_2_name(conf_.node_id()) << " CCB handle warm up resp, " << "DSB:" << id_2_name(resp->source()) << ", term id: " << resp->term_id();
+  BLOG(trace, "{} CCB handle warm up resp, DSB:{}, term id: {}",
+       blog_node(conf_.node_id()), blog_node(resp->source()), resp->term_id());
 
   for (const tuple_row &row : resp->tuple_row()) {
     tuple_pb t;
@@ -390,6 +429,74 @@ result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
   return outcome::success();
 }
 
+result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<warm_up_chunk> chunk) {
+  BLOG(trace, "{} CCB handle warm up chunk {}, DSB:{}, term id: {}, rows: {}",
+       blog_node(conf_.node_id()), chunk->seq(), blog_node(chunk->source()),
+       chunk->term_id(), uint64_t(chunk->rows_size()));
+  auto s = shared_from_this();
+  // the chunks are cached in parallel
+  auto fn = [s, chunk]() {
+    // a chunk is acked even if its stream is stale or unknown, or DSB would
+    // wait for the ack with the stream open
+    auto ack = cs_new<warm_up_ack>();
+    ack->set_source(s->node_id_);
+    ack->set_dest(chunk->source());
+    ack->set_term_id(chunk->term_id());
+    ack->set_seq(chunk->seq());
+    ack->set_stream(chunk->stream());
+    std::pair<ptr<warm_up_recv>, bool> pair =
+        s->warm_up_recv_.find(chunk->term_id());
+    if (!pair.second || pair.first->stream_ != chunk->stream()) {
+      s->send_warm_up_ack(ack);
+      return;
+    }
+    ptr<warm_up_recv> recv = pair.first;
+    if (chunk->done()) {
+      recv->total_.store(chunk->seq() + 1);
+    }
+    if (chunk->error_code() != EC::EC_OK) {
+      LOG(error) << s->node_name_ << " warm up from "
+                 << id_2_name(chunk->source()) << " error "
+                 << enum2str(EC(chunk->error_code()));
+      recv->failed_.store(true);
+    }
+    for (tuple_row &row : *chunk->mutable_rows()) {
+      tuple_pb t;
+      swap(t, *row.mutable_tuple());
+      s->access_->put(row.table_id(), row.shard_id(), row.tuple_id(),
+                      std::move(t));
+    }
+    s->send_warm_up_ack(ack);
+    // the last chunk cached responds to the client
+    if (recv->cached_.fetch_add(1) + 1 != recv->total_.load()) {
+      return;
+    }
+    s->warm_up_recv_.remove_if(
+        chunk->term_id(),
+        [recv](const ptr<warm_up_recv> &r) { return r == recv; });
+    std::pair<ptr<connection>, bool> conn =
+        s->term_connection_table_.find(chunk->term_id());
+    if (!conn.second) {
+      return;
+    }
+    ptr<warm_up_resp> resp(cs_new<warm_up_resp>());
+    resp->set_term_id(chunk->term_id());
+    resp->set_ok(!recv->failed_.load());
+    s->service_->conn_async_send(conn.first, CLIENT_HANDLE_WARM_UP_RESP, resp);
+  };
+  boost::asio::post(service_->get_service(SERVICE_ASYNC_CONTEXT, chunk->seq()),
+                    fn);
+  return outcome::success();
+}
+
+void cc_block::send_warm_up_ack(const ptr<warm_up_ack> ack) {
+  auto rs = service_->async_send(ack->dest(), C2D_WARM_UP_ACK, ack);
+  if (!rs) {
+    LOG(error) << node_name_ << " send warm up ack error";
+  }
+}
+
 result<void> cc_block::ccb_handle_message(const ptr<connection> c,
                                           message_type t,
                                           const ptr<tx_request> m) {
@@ -439,6 +546,16 @@ result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
   return outcome::success();
 }
 
+result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<rlb_read_index_response> m) {
+#ifdef DB_TYPE_NON_DETERMINISTIC
+  if (is_non_deterministic()) {
+    handle_read_index_response(*m);
+  }
+#endif
+  return outcome::success();
+}
+
 result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
                                           const ptr<tx_rm_prepare> m) {
   handle_tx_rm_prepare(*m);
@@ -544,6 +661,13 @@ void cc_block::handle_log_entries_commit(const rlb_commit_entries &msg) {
               << ms - conf_.get_test_config().debug_add_wan_latency_ms();
   }
 #endif
+  if (msg.cno() == cno_) {
+    if (EC(msg.error_code()) != EC::EC_OK) {
+      wal_->reset_credit();
+    } else {
+      wal_->add_credit(msg.credit_bytes());
+    }
+  }
 #ifdef DB_TYPE_CALVIN
   if (is_deterministic()) {
     handle_calvin_log_commit(msg);
@@ -574,15 +698,16 @@ void cc_block::handle_lead_status_request(const ptr<connection> conn,
 
 ptr<tx_context> cc_block::create_tx_context_gut(xid_t xid, bool distributed,
                                                 ptr<connection> conn) {
-  boost::asio::io_context::strand strand_tx_context(
-      service_->get_service(SERVICE_ASYNC_CONTEXT));
+  // the transactions of a terminal run on the same core
+  boost::asio::io_context::strand strand_tx_context(service_->get_service(
+      SERVICE_ASYNC_CONTEXT, xid_to_terminal_id(xid)));
   BOOST_ASSERT(!cc_opt_dsb_node_id_.has_value() || cc_opt_dsb_node_id_.value() != 0);
   auto ccb = shared_from_this();
   auto fn_remove = [ccb, xid](uint64_t, rm_state state) {
     if (state == rm_state::RM_ABORTING || state == rm_state::RM_COMMITTING ||
         state == rm_state::RM_ENDED) {
       uint32_t terminal_id = ccb->xid_to_terminal_id(xid);
-      bool remove_ok = ccb->tx_context_[terminal_id].remove(xid, nullptr);
+      bool remove_ok = ccb->tx_context_.remove(terminal_id, xid);
       if (!remove_ok) {
         LOG(warning) << "remove " << xid << " no such transaction";
       }
@@ -601,13 +726,19 @@ ptr<tx_context> cc_block::create_tx_context_gut(xid_t xid, bool distributed,
   return ctx;
 }
 void cc_block::create_tx_context(const ptr<connection> conn,
-                                 const tx_request &req) {
+                                 const tx_request &req, bool replica_read) {
   uint64_t xid = req.xid();
   // LOG(debug) << node_name_ << " transaction " << xid
   //                          << " request";
   ptr<tx_context> ctx = create_tx_context_gut(xid, req.distributed(), conn);
+  if (req.trace()) {
+    ctx->begin_dispatch_span();
+  }
+  if (replica_read) {
+    ctx->set_replica_read();
+  }
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  bool ok = tx_context_[terminal_id].insert(xid, ctx);
+  bool ok = tx_context_.insert(terminal_id, xid, ctx);
   if (ok) {
     async_run_tx_routine(ctx->get_strand(), [req, ctx] {
       scoped_time _t("tx_context::process_tx_request");
@@ -666,7 +797,7 @@ void cc_block::handle_append_log_response(const rlb_commit_entries &response) {
     case TX_CMD_TM_END: {
       uint32_t terminal_id = xid_to_terminal_id(xid);
       std::pair<ptr<tx_coordinator>, bool> rc =
-          tx_coordinator_[terminal_id].find(xid);
+          tx_coordinator_.find(terminal_id, xid);
       if (rc.second) {
         auto tm = rc.first;
         async_run_tx_routine(
@@ -689,7 +820,7 @@ void cc_block::handle_append_log_response(const rlb_commit_entries &response) {
     case TX_CMD_RM_COMMIT:
     case TX_CMD_RM_BEGIN: {
       uint32_t terminal_id = xid_to_terminal_id(xid);
-      std::pair<ptr<tx_context>, bool> p = tx_context_[terminal_id].find(xid);
+      std::pair<ptr<tx_context>, bool> p = tx_context_.find(terminal_id, xid);
       if (p.second) {
         auto ctx = p.first;
         async_run_tx_routine(ctx->get_strand(), [repl_latency, t, ctx, ts] {
@@ -715,7 +846,7 @@ void cc_block::handle_read_data_response(ptr<dsb_read_response> response) {
 
   auto ts = std::chrono::steady_clock::now();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_context>, bool> p = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> p = tx_context_.find(terminal_id, xid);
   if (p.second) {
     auto ctx = p.first;
     async_run_tx_routine(ctx->get_strand(), [ts, ctx, response] {
@@ -730,8 +861,8 @@ void cc_block::handle_read_data_response(ptr<dsb_read_response> response) {
 void cc_block::handle_non_deterministic_tx_request(
     const ptr<connection> conn, const ptr<tx_request> request) {
   uint64_t xid = gen_xid(request->terminal_id());
-  LOG(trace) << node_name_ << " handle dist=" << request->distributed()
-             << " tx_rm " << xid;
+  BLOG(trace, "{} handle dist={} tx_rm {}", blog_node(node_id_),
+       request->distributed(), xid);
   const_cast<tx_request &>(*request).set_xid(xid);
   if (request->distributed()) {
 #ifdef DB_TYPE_SHARE_NOTHING
@@ -740,14 +871,78 @@ void cc_block::handle_non_deterministic_tx_request(
     }
 #endif
   } else {
-    create_tx_context(conn, *request);
+    create_tx_context(conn, *request, false);
+  }
+}
+
+void cc_block::handle_replica_read_request(const ptr<connection> conn,
+                                           const ptr<tx_request> request) {
+  uint64_t xid = gen_xid(request->terminal_id());
+  request->set_xid(xid);
+  auto pair = std::make_pair(conn, request);
+  if (!replica_read_waiting_.insert(xid, pair)) {
+    LOG(error) << node_name_ << " existing transaction " << xid;
+    return;
+  }
+  auto req = cs_new<ccb_read_index_request>();
+  req->set_source(node_id_);
+  req->set_dest(rlb_node_id_);
+  req->set_cno(cno_);
+  req->set_xid(xid);
+  auto r = service_->async_send(rlb_node_id_, C2R_READ_INDEX_REQ, req);
+  if (!r) {
+    LOG(error) << node_name_ << " send read index request error";
+    response_replica_read(xid, EC::EC_NOT_LEADER);
+    return;
+  }
+  // RLB may never answer, e.g. it has crashed
+  auto s = shared_from_this();
+  service_->get_timing_wheel(strand_ccb_tick_.context())
+      .schedule_after(REPLICA_READ_TIMEOUT_MILLIS * 1000, [s, xid] {
+        s->response_replica_read(xid, EC::EC_NOT_LEADER);
+      });
+}
+
+void cc_block::response_replica_read(xid_t xid, EC ec) {
+  std::pair<ptr<connection>, ptr<tx_request>> pair;
+  bool found = replica_read_waiting_.remove(
+      xid, [&pair](std::pair<ptr<connection>, ptr<tx_request>> value) {
+        pair = value;
+      });
+  if (!found) {
+    // answered already
+    return;
   }
+  auto res = std::make_shared<tx_response>();
+  res->set_error_code(uint32_t(ec));
+  res->set_client_seq(pair.second->client_seq());
+  service_->conn_async_send(pair.first, CLIENT_TX_RESP, res);
+}
+
+void cc_block::handle_read_index_response(
+    const rlb_read_index_response &response) {
+  EC ec = EC(response.error_code());
+  if (ec != EC::EC_OK) {
+    response_replica_read(response.xid(), ec);
+    return;
+  }
+  std::pair<ptr<connection>, ptr<tx_request>> pair;
+  bool found = replica_read_waiting_.remove(
+      response.xid(),
+      [&pair](std::pair<ptr<connection>, ptr<tx_request>> value) {
+        pair = value;
+      });
+  if (!found) {
+    // timed out
+    return;
+  }
+  create_tx_context(pair.first, *pair.second, true);
 }
 
 #ifdef DB_TYPE_SHARE_NOTHING
 
 void cc_block::handle_tx_tm_request(const tx_request &request) {
-  LOG(trace) << node_name_ << "handle RM request " << request.xid();
+  BLOG(trace, "{} handle RM request {}", blog_node(node_id_), request.xid());
   BOOST_ASSERT(request.operations_size() > 0);
   BOOST_ASSERT(request.distributed());
   BOOST_ASSERT(mgr_);
@@ -755,7 +950,7 @@ void cc_block::handle_tx_tm_request(const tx_request &request) {
   BOOST_ASSERT(!request.client_request());
   if (request.oneshot()) {
     BOOST_ASSERT(request.xid() != 0);
-    create_tx_context(nullptr, request);
+    create_tx_context(nullptr, request, false);
   } else {
     BOOST_ASSERT_MSG(false, "not implement");
     // non one_shot tx_rm
@@ -770,11 +965,11 @@ cc_block::create_tx_coordinator_gut(const ptr<connection> conn,
   auto fn_remove = [this](uint64_t xid, tm_state state) {
     if (state == tm_state::TM_DONE) {
       uint32_t terminal_id = xid_to_terminal_id(xid);
-      tx_coordinator_[terminal_id].remove(xid, nullptr);
+      tx_coordinator_.remove(terminal_id, xid);
     }
   };
-  boost::asio::io_context::strand strand(
-      service_->get_service(SERVICE_ASYNC_CONTEXT));
+  boost::asio::io_context::strand strand(service_->get_service(
+      SERVICE_ASYNC_CONTEXT, xid_to_terminal_id(xid)));
   ptr<tx_coordinator> c = std::make_shared<tx_coordinator>(
       strand, xid, node_id_, rg_lead_, service_, conn, wal_.get(), fn_remove);
   return c;
@@ -783,11 +978,14 @@ cc_block::create_tx_coordinator_gut(const ptr<connection> conn,
 void cc_block::create_tx_coordinator(const ptr<connection> conn,
                                      const tx_request &req) {
   uint64_t xid = req.xid();
-  LOG(trace) << "transaction " << xid << " request";
+  BLOG(trace, "transaction {} request", xid);
 
   uint32_t terminal_id = xid_to_terminal_id(xid);
   ptr<tx_coordinator> coordinator = create_tx_coordinator_gut(conn, req);
-  bool ok = tx_coordinator_[terminal_id].insert(xid, coordinator);
+  if (req.trace()) {
+    coordinator->begin_dispatch_span();
+  }
+  bool ok = tx_coordinator_.insert(terminal_id, xid, coordinator);
   if (ok) {
     result<void> r = coordinator->handle_tx_request(req);
     if (not r) {
@@ -804,7 +1002,7 @@ void cc_block::handle_tx_rm_prepare(const tx_rm_prepare &msg) {
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
   std::pair<ptr<tx_coordinator>, bool> p =
-      tx_coordinator_[terminal_id].find(xid);
+      tx_coordinator_.find(terminal_id, xid);
   if (p.second) {
     auto tm = p.first;
     async_run_tx_routine(
@@ -825,7 +1023,7 @@ void cc_block::handle_tx_rm_ack(const tx_rm_ack &msg) {
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
   std::pair<ptr<tx_coordinator>, bool> p =
-      tx_coordinator_[terminal_id].find(xid);
+      tx_coordinator_.find(terminal_id, xid);
   if (p.second) {
     auto tm = p.first;
     async_run_tx_routine(tm->get_strand(),
@@ -844,7 +1042,7 @@ void cc_block::handle_tx_rm_ack(const tx_rm_ack &msg) {
 void cc_block::handle_tx_tm_commit(const tx_tm_commit &msg) {
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_context>, bool> p = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> p = tx_context_.find(terminal_id, xid);
   if (p.second) {
     auto ctx = p.first;
     async_run_tx_routine(ctx->get_strand(), [ctx, msg] {
@@ -859,7 +1057,7 @@ void cc_block::handle_tx_tm_commit(const tx_tm_commit &msg) {
 void cc_block::handle_tx_tm_abort(const tx_tm_abort &msg) {
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_context>, bool> p = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> p = tx_context_.find(terminal_id, xid);
   if (p.second) {
     auto ctx = p.first;
     async_run_tx_routine(ctx->get_strand(), [ctx, msg] {
@@ -880,7 +1078,7 @@ void cc_block::handle_dependency_set(const ptr<dependency_set> msg) {
 void cc_block::handle_tx_tm_end(const tx_tm_end &msg) {
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_context>, bool> p = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> p = tx_context_.find(terminal_id, xid);
   if (p.second) {
     auto ctx = p.first;
     async_run_tx_routine(ctx->get_strand(), [ctx] {
@@ -898,7 +1096,7 @@ void cc_block::handle_tx_tm_enable_violate(const tx_enable_violate &msg) {
   BOOST_ASSERT(msg.dest() == node_id_);
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_context>, bool> r = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> r = tx_context_.find(terminal_id, xid);
   if (r.second) {
     ptr<tx_context> ctx = r.first;
     ctx->handle_tx_enable_violate();
@@ -908,7 +1106,7 @@ void cc_block::handle_tx_rm_enable_violate(const tx_enable_violate &msg) {
   BOOST_ASSERT(msg.dest() == node_id_);
   xid_t xid = msg.xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  std::pair<ptr<tx_coordinator>, bool> r = tx_coordinator_[terminal_id].find(xid);
+  std::pair<ptr<tx_coordinator>, bool> r = tx_coordinator_.find(terminal_id, xid);
   if (r.second) {
     auto tm = r.first;
     async_run_tx_routine(
@@ -931,7 +1129,7 @@ void cc_block::handle_tx_rm_enable_violate(const tx_enable_violate &msg) {
 void cc_block::abort_tx(xid_t xid, EC ec) {
   uint32_t terminal_id = xid_to_terminal_id(xid);
 
-  std::pair<ptr<tx_context>, bool> r = tx_context_[terminal_id].find(xid);
+  std::pair<ptr<tx_context>, bool> r = tx_context_.find(terminal_id, xid);
   if (r.second) {
     auto ctx = r.first;
     async_run_tx_routine(ctx->get_strand(), [ctx, ec] {
@@ -944,7 +1142,7 @@ void cc_block::abort_tx(xid_t xid, EC ec) {
   if (is_shared_nothing()) {
 
     std::pair<ptr<tx_coordinator>, bool> rc =
-        tx_coordinator_[terminal_id].find(xid);
+        tx_coordinator_.find(terminal_id, xid);
     if (rc.second) {
       auto tm = rc.first;
       async_run_tx_routine(tm->get_strand(),
@@ -971,9 +1169,7 @@ void cc_block::debug_tx(std::ostream &os, xid_t xid) {
       rm->debug_tx(os);
     }
   };
-  for (size_t i = 0; i < tx_context_.size(); i++) {
-    tx_context_[i].traverse(fn_kv_ctx);
-  }
+  tx_context_.traverse(fn_kv_ctx);
 #ifdef DB_TYPE_SHARE_NOTHING
   if (is_shared_nothing()) {
     auto fn_kv_coord = [&os, xid](uint64_t k, const ptr<tx_coordinator> &tm) {
@@ -981,9 +1177,7 @@ void cc_block::debug_tx(std::ostream &os, xid_t xid) {
         tm->debug_tx(os);
       }
     };
-    for (size_t i = 0; i < tx_coordinator_.size(); i++) {
-      tx_coordinator_[i].traverse(fn_kv_coord);
-    }
+    tx_coordinator_.traverse(fn_kv_coord);
   }
 #endif
 #endif // #ifdef DB_TYPE_NON_DETERMINISTIC
@@ -997,9 +1191,7 @@ void cc_block::debug_tx(std::ostream &os, xid_t xid) {
         t->debug_tx(os);
       }
     };
-    for (size_t i = 0; i < calvin_context_.size(); i++) {
-      calvin_context_[i].traverse(f1);
-    }
+    calvin_context_.traverse(f1);
 
     os << "calvin collector:" << std::endl;
     auto f2 = [&os, xid](xid_t k, const ptr<calvin_collector> &t) {
@@ -1008,9 +1200,7 @@ void cc_block::debug_tx(std::ostream &os, xid_t xid) {
       }
     };
 
-    for (size_t i = 0; i < calvin_context_.size(); i++) {
-      calvin_collector_[i].traverse(f2);
-    }
+    calvin_collector_.traverse(f2);
   }
 #endif // DB_TYPE_CALVIN
 }
@@ -1053,14 +1243,14 @@ ptr<calvin_context> cc_block::create_calvin_context(const tx_request &req) {
       mgr_, fn_remove);
   calvin_ctx->begin();
   uint32_t terminal_id = xid_to_terminal_id(req.xid());
-  calvin_context_[terminal_id].insert(req.xid(), calvin_ctx);
+  calvin_context_.insert(terminal_id, req.xid(), calvin_ctx);
   BOOST_ASSERT(calvin_ctx);
   return calvin_ctx;
 }
 
 void cc_block::remove_calvin_context(xid_t xid) {
   uint32_t terminal_id = xid_to_terminal_id(xid);
-  calvin_context_[terminal_id].remove(xid, nullptr);
+  calvin_context_.remove(terminal_id, xid);
 }
 
 void cc_block::handle_calvin_tx_request(ptr<connection> conn,
@@ -1071,9 +1261,9 @@ void cc_block::handle_calvin_tx_request(ptr<connection> conn,
   ptr<calvin_collector> collector(new calvin_collector(
       strand_calvin, xid, std::move(conn), service_, request));
 
-  LOG(trace) << node_name_ << " handle dist=" << request->distributed()
-             << " calvin " << xid;
-  bool ok = calvin_collector_[terminal_id].insert(xid, collector);
+  BLOG(trace, "{} handle dist={} calvin {}", blog_node(node_id_),
+       request->distributed(), xid);
+  bool ok = calvin_collector_.insert(terminal_id, xid, collector);
   if (!ok) {
     LOG(error) << "existing xid " << xid;
   }
@@ -1092,11 +1282,12 @@ void cc_block::handle_calvin_log_commit(const rlb_commit_entries &msg) {
     tx_log_proto &log_proto = *pair.first;
     xid_t xid = log_proto.xid();
 
-    LOG(trace) << node_name_ << " calvin log commit " << xid << ",log type" << log_proto.log_type() << ", ptr:" << &msg;
+    BLOG(trace, "{} calvin log commit {}, log type {}", blog_node(node_id_),
+         xid, int32_t(log_proto.log_type()));
 
     uint32_t terminal_id = xid_to_terminal_id(xid);
     std::pair<ptr<calvin_context>, bool> r =
-        calvin_context_[terminal_id].find(xid);
+        calvin_context_.find(terminal_id, xid);
     if (r.second) {
       auto ctx = r.first;
       auto ccb = shared_from_this();
@@ -1105,7 +1296,7 @@ void cc_block::handle_calvin_log_commit(const rlb_commit_entries &msg) {
             bool committed = ctx->on_operation_committed(log_proto);
             if (committed) {
               scoped_time _t("remove calvin context");
-              ccb->calvin_context_[terminal_id].remove(xid, nullptr);
+              ccb->calvin_context_.remove(terminal_id, xid);
             }
           });
     } else {
@@ -1118,7 +1309,7 @@ void cc_block::handle_calvin_part_commit(const ptr<calvin_part_commit> msg) {
   xid_t xid = msg->xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
   std::pair<ptr<calvin_collector>, bool> r =
-      calvin_collector_[terminal_id].find(xid);
+      calvin_collector_.find(terminal_id, xid);
   if (r.second) {
     ptr<calvin_collector> collector = r.first;
     auto ccb = shared_from_this();
@@ -1126,7 +1317,7 @@ void cc_block::handle_calvin_part_commit(const ptr<calvin_part_commit> msg) {
         collector->get_strand(), [ccb, collector, terminal_id, xid, msg] {
           bool all_committed = collector->part_commit(msg);
           if (all_committed) {
-            ccb->calvin_collector_[terminal_id].remove(xid, nullptr);
+            ccb->calvin_collector_.remove(terminal_id, xid);
           }
         });
   } else {
@@ -1138,7 +1329,7 @@ void cc_block::handle_calvin_read_response(const ptr<dsb_read_response> msg) {
   uint64_t xid = msg->xid();
   uint32_t terminal_id = xid_to_terminal_id(xid);
   std::pair<ptr<calvin_context>, bool> p =
-      calvin_context_[terminal_id].find(xid);
+      calvin_context_.find(terminal_id, xid);
   if (p.second) {
     auto ctx = p.first;
     async_run_tx_routine(ctx->get_strand(), [ctx, msg] {
@@ -1155,7 +1346,21 @@ void cc_block::handle_calvin_read_response(const ptr<dsb_read_response> msg) {
 
 void cc_block::async_run_tx_routine(boost::asio::io_context::strand strand,
                                     std::function<void()> routine) {
-  boost::asio::post(strand, routine);
+  strand_queue_depth->add(1);
+  if (service_->thread_per_core()) {
+    service_->core_post(
+        strand.context(), [strand, routine = std::move(routine)]() mutable {
+          boost::asio::dispatch(strand, [routine = std::move(routine)]() {
+            strand_queue_depth->sub(1);
+            routine();
+          });
+        });
+  } else {
+    boost::asio::post(strand, [routine = std::move(routine)]() {
+      strand_queue_depth->sub(1);
+      routine();
+    });
+  }
 }
 
 void cc_block::strand_ccb_handle_state(ptr<connection> conn, ptr<ccb_state_req> req) {
@@ -1178,7 +1383,8 @@ void cc_block::strand_ccb_handle_state(ptr<connection> conn, ptr<ccb_state_req>
     LOG(error) << " send ccb state resp error";
     return;
   }
-  LOG(trace) << " send response CCB state " << id_2_name(node_id_) << "s" << req->shard_id() << "t" << req->term_id();
+  BLOG(trace, "send response CCB state {} s{} t{}", blog_node(node_id_),
+       req->shard_id(), req->term_id());
 }
 
 result<void> cc_block::ccb_handle_message(const ptr<connection>, message_type,
@@ -221,33 +221,32 @@ void deadlock::async_victim(xid_t x) {
 void deadlock::debug_deadlock(std::ostream &os) { wait_path_.handle_debug(os); }
 
 void deadlock::async_wait_lock(fn_wait_lock fn_wait) {
+  arm_wait_lock(cs_new<lock_wait>(std::move(fn_wait)));
+}
+
+void deadlock::arm_wait_lock(const ptr<lock_wait> &wait) {
   // issue another wait to avoid lost this message
-  ptr<boost::asio::steady_timer> timer(new boost::asio::steady_timer(
-      get_strand().context(),
-      boost::asio::chrono::milliseconds(lock_wait_timeout_ms_)));
   auto dl = shared_from_this();
-  auto fn_timeout = boost::asio::bind_executor(
-      get_strand(),
-      [dl, timer, fn_wait](const boost::system::error_code &error) {
-        if (not error.failed()) {
-          fn_handle_wait_set fn = [dl](ptr<tx_wait> wait) {
-            boost::asio::post(dl->get_strand(), [dl, wait] {
-              scoped_time _t("deadlock::add_wait_set");
-              dl->add_wait_set(wait);
-            });
-          };
-          auto r = fn_wait(fn);
-          if (r) {
-            // existing such tx_rm
-            dl->async_wait_lock(fn_wait);
-            timer.get();
-          } else { // no such tx_rm, maybe this tx_rm have removed, we need not
-            // wait it any longer
-            return;
-          }
-        } else {
-          LOG(error) << "wait lock timeout error";
-        }
+  service_->get_timing_wheel(get_strand().context())
+      .arm_after(wait->timer_, lock_wait_timeout_ms_ * 1000, [dl, wait] {
+        boost::asio::post(dl->get_strand(),
+                          [dl, wait] { dl->handle_wait_lock(wait); });
       });
-  timer->async_wait(fn_timeout);
+}
+
+void deadlock::handle_wait_lock(const ptr<lock_wait> &wait) {
+  auto dl = shared_from_this();
+  fn_handle_wait_set fn = [dl](ptr<tx_wait> wait) {
+    boost::asio::post(dl->get_strand(), [dl, wait] {
+      scoped_time _t("deadlock::add_wait_set");
+      dl->add_wait_set(wait);
+    });
+  };
+  auto r = wait->fn_wait_(fn);
+  if (r) {
+    // existing such tx_rm
+    arm_wait_lock(wait);
+  }
+  // otherwise, no such tx_rm, maybe this tx_rm have removed, we need not
+  // wait it any longer
 }
\ No newline at end of file
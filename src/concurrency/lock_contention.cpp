@@ -0,0 +1,116 @@
+#include "concurrency/lock_contention.h"
+#include "common/variable.h"
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+namespace {
+struct contention_event {
+  lock_contention *contention_;
+  tuple_id_t key_;
+  // conflict of a wait, or wait time of a grant
+  uint64_t value_;
+  bool granted_;
+};
+
+std::atomic<uint64_t> next_contention_id(1);
+
+// the events recorded while a lock slot mutex is held
+thread_local std::vector<contention_event> pending_events;
+} // namespace
+
+lock_contention::thread_sketch::thread_sketch()
+    : wait_(LOCK_HOT_KEY_CAPACITY), granted_(LOCK_HOT_KEY_CAPACITY) {}
+
+lock_contention::lock_contention() : id_(next_contention_id.fetch_add(1)) {}
+
+void lock_contention::on_wait(tuple_id_t key, uint64_t conflict) {
+  pending_events.push_back(contention_event{this, key, conflict, false});
+}
+
+void lock_contention::on_granted(tuple_id_t key, uint64_t wait_us) {
+  pending_events.push_back(contention_event{this, key, wait_us, true});
+}
+
+void lock_contention::flush() {
+  if (pending_events.empty()) {
+    return;
+  }
+  std::vector<contention_event> events;
+  events.swap(pending_events);
+  for (const contention_event &e : events) {
+    thread_sketch &sketch = e.contention_->local();
+    std::scoped_lock l(sketch.mutex_);
+    if (e.granted_) {
+      lock_contention_stat &stat = sketch.granted_.add(e.key_);
+      stat.granted_++;
+      stat.wait_us_ += e.value_;
+    } else {
+      sketch.wait_.add(e.key_).conflict_ += e.value_;
+    }
+  }
+}
+
+lock_contention::thread_sketch &lock_contention::local() {
+  // by the id of the lock_contention, an address may be reused
+  thread_local std::unordered_map<uint64_t, ptr<thread_sketch>> sketches;
+  auto i = sketches.find(id_);
+  if (i != sketches.end()) {
+    return *i->second;
+  }
+  ptr<thread_sketch> sketch(new thread_sketch());
+  {
+    std::scoped_lock l(mutex_);
+    sketches_.push_back(sketch);
+  }
+  sketches.insert(std::make_pair(id_, sketch));
+  return *sketch;
+}
+
+std::vector<lock_hot_key> lock_contention::top(table_id_t table_id,
+                                               shard_id_t shard_id, size_t k) {
+  std::vector<ptr<thread_sketch>> sketches;
+  {
+    std::scoped_lock l(mutex_);
+    sketches = sketches_;
+  }
+  // the counts and errors of a key are summed over the sketches of the
+  // threads, the sum of the errors bounds the over-estimation
+  std::unordered_map<tuple_id_t, lock_hot_key> merged;
+  for (const ptr<thread_sketch> &sketch : sketches) {
+    std::scoped_lock l(sketch->mutex_);
+    for (const auto &e : sketch->wait_.top(sketch->wait_.size())) {
+      auto i = merged.find(e.key_);
+      if (i == merged.end()) {
+        merged.insert(std::make_pair(
+            e.key_, lock_hot_key{table_id, shard_id, e.key_, e.count_,
+                                 e.error_, e.stat_}));
+      } else {
+        i->second.wait_ += e.count_;
+        i->second.error_ += e.error_;
+        i->second.stat_.conflict_ += e.stat_.conflict_;
+      }
+    }
+  }
+  std::vector<lock_hot_key> keys;
+  for (const auto &kv : merged) {
+    keys.push_back(kv.second);
+  }
+  k = std::min(k, keys.size());
+  std::partial_sort(keys.begin(), keys.begin() + ptrdiff_t(k), keys.end(),
+                    [](const lock_hot_key &x, const lock_hot_key &y) {
+                      return x.wait_ > y.wait_;
+                    });
+  keys.resize(k);
+  for (const ptr<thread_sketch> &sketch : sketches) {
+    std::scoped_lock l(sketch->mutex_);
+    for (lock_hot_key &key : keys) {
+      const lock_contention_stat *stat = sketch->granted_.find(key.key_);
+      if (stat) {
+        key.stat_.granted_ += stat->granted_;
+        key.stat_.wait_us_ += stat->wait_us_;
+      }
+    }
+  }
+  return keys;
+}
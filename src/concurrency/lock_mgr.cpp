@@ -23,6 +23,14 @@ void lock_mgr::lock(xid_t xid, oid_t oid, lock_mode lt, predicate pred,
   boost::asio::post(strand_, fn);
 }
 
+void lock_mgr::lock_rows(std::vector<row_lock_request> requests) {
+  auto fn = [this, requests = std::move(requests)] {
+    scoped_time _t("lock_mgr::lock_rows_gut");
+    this->lock_rows_gut(requests);
+  };
+  boost::asio::post(strand_, std::move(fn));
+}
+
 void lock_mgr::unlock(uint64_t xid, lock_mode mode, predicate pred) {
 
   auto fn = [this, xid, mode, pred] {
@@ -84,6 +92,10 @@ void lock_mgr::debug_dependency(tx_wait_set &dep) {
   }
 }
 
+std::vector<lock_hot_key> lock_mgr::hot_keys(size_t k) {
+  return contention_.top(table_id_, shard_id_, k);
+}
+
 void lock_mgr::row_lock(
 
     oid_t oid, lock_mode lt, tuple_id_t key, const ptr<tx_rm> &tx) {
@@ -91,6 +103,25 @@ void lock_mgr::row_lock(
   pair.first->lock(lt, tx, oid);
 }
 
+void lock_mgr::lock_rows_gut(const std::vector<row_lock_request> &requests) {
+  std::vector<tuple_id_t> keys;
+  keys.reserve(requests.size());
+  for (const row_lock_request &r : requests) {
+    keys.push_back(r.key_);
+  }
+  std::vector<ptr<lock_slot>> slots(requests.size());
+  key_row_locks_.find_many(keys, [&slots](size_t i, const ptr<lock_slot> &slot) {
+    slots[i] = slot;
+  });
+  for (size_t i = 0; i < requests.size(); i++) {
+    const row_lock_request &r = requests[i];
+    if (!slots[i]) {
+      slots[i] = get_lock_slot(r.key_).first;
+    }
+    slots[i]->lock(r.lt_, r.tx_, r.oid_);
+  }
+}
+
 std::pair<ptr<lock_slot>, bool> lock_mgr::find_slot(tuple_id_t key) {
   return key_row_locks_.find(key);
 }
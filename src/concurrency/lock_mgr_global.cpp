@@ -1,5 +1,7 @@
 #include "concurrency/lock_mgr_global.h"
-
+#include "common/json_pretty.h"
+#include "common/variable.h"
+#include <algorithm>
 #include <utility>
 
 lock_mgr_global::lock_mgr_global(
@@ -15,7 +17,7 @@ lock_mgr_global::lock_mgr_global(
 
   for (table_id_t id = 0; id <= max_table_id; id++) {
     for (auto shard_id : shards) {
-      ptr<lock_mgr> l(new lock_mgr(id, shard_id, service_->get_service(SERVICE_CC), dl_,
+      ptr<lock_mgr> l(new lock_mgr(id, shard_id, service_->get_service(SERVICE_CC, id), dl_,
                                    fn_before_, fn_after_));
       lock_table_[id].insert(std::make_pair(shard_id, l));
     }
@@ -33,6 +35,16 @@ void lock_mgr_global::lock_row(xid_t xid, oid_t oid, lock_mode lt, uint32_t tabl
   }
 }
 
+void lock_mgr_global::lock_rows(uint32_t table_id, uint32_t shard_id,
+                                std::vector<row_lock_request> requests) {
+  ptr<lock_mgr> lm = lock_table_[table_id][shard_id];
+  if (lm) {
+    lm->lock_rows(std::move(requests));
+  } else {
+    LOG(fatal) << "lock rows error";
+  }
+}
+
 void lock_mgr_global::unlock(xid_t xid, lock_mode mode, uint32_t table_id, uint32_t shard_id,
                              const predicate &key) {
   ptr<lock_mgr> lm = lock_table_[table_id][shard_id];
@@ -75,3 +87,66 @@ void lock_mgr_global::debug_dependency(tx_wait_set &dep) {
     }
   }
 }
+
+std::map<table_id_t, std::vector<lock_hot_key>>
+lock_mgr_global::hot_keys(size_t k) {
+  std::map<table_id_t, std::vector<lock_hot_key>> tables;
+  for (table_id_t i = 0; i < lock_table_.size(); i++) {
+    std::vector<lock_hot_key> keys;
+    for (const auto &kv : lock_table_[i]) {
+      std::vector<lock_hot_key> shard_keys = kv.second->hot_keys(k);
+      keys.insert(keys.end(), shard_keys.begin(), shard_keys.end());
+    }
+    if (keys.empty()) {
+      continue;
+    }
+    // the keys of the shards are disjoint, the top k of a table are in the
+    // top k of its shards
+    std::sort(keys.begin(), keys.end(),
+              [](const lock_hot_key &x, const lock_hot_key &y) {
+                return x.wait_ > y.wait_;
+              });
+    if (keys.size() > k) {
+      keys.resize(k);
+    }
+    tables[i] = std::move(keys);
+  }
+  return tables;
+}
+
+void lock_mgr_global::debug_hot_key(std::ostream &os, bool as_json) {
+  std::map<table_id_t, std::vector<lock_hot_key>> tables =
+      hot_keys(LOCK_HOT_KEY_TOP);
+  if (not as_json) {
+    for (const auto &kv : tables) {
+      os << "table " << kv.first << std::endl;
+      for (const lock_hot_key &k : kv.second) {
+        os << "  shard " << k.shard_id_ << " key " << k.key_ << " wait "
+           << k.wait_ << " error " << k.error_ << " conflict "
+           << k.stat_.conflict_ << " granted " << k.stat_.granted_
+           << " wait_us " << k.stat_.wait_us_ << std::endl;
+      }
+    }
+    return;
+  }
+  boost::json::array array;
+  for (const auto &kv : tables) {
+    boost::json::array keys;
+    for (const lock_hot_key &k : kv.second) {
+      boost::json::object o;
+      o["shard_id"] = k.shard_id_;
+      o["key"] = k.key_;
+      o["wait"] = k.wait_;
+      o["error"] = k.error_;
+      o["conflict"] = k.stat_.conflict_;
+      o["granted"] = k.stat_.granted_;
+      o["wait_us"] = k.stat_.wait_us_;
+      keys.push_back(o);
+    }
+    boost::json::object t;
+    t["table_id"] = kv.first;
+    t["keys"] = keys;
+    array.push_back(t);
+  }
+  pretty_print(os, array);
+}
@@ -1,13 +1,18 @@
 #include "concurrency/lock_slot.h"
 #include "common/db_type.h"
 #include "common/define.h"
+#include "common/metrics.h"
 #include "common/result.hpp"
+#include "common/utils.h"
 #include "concurrency/tx_context.h"
 #include "proto/proto.h"
 #include <utility>
 
 #include "concurrency/lock_mgr.h"
 
+static metric<metric_counter> lock_waits(
+    "tddb_lock_waits_total", "lock requests which wait for a conflicting lock");
+
 lock_slot::lock_slot(lock_mgr *mgr, table_id_t table_id, shard_id_t shard_id, tuple_id_t tuple_id,
                      fn_schedule_before fn_before, fn_schedule_after fn_after)
     : mgr_(mgr), table_id_(table_id), shard_id_(shard_id), tuple_id_(tuple_id),
@@ -32,6 +37,9 @@ bool lock_slot::lock(lock_mode type, const ptr<tx_rm> &tx, oid_t oid) {
     BOOST_ASSERT(false);
   }
   assert_check();
+  l.unlock();
+  // the contention is counted out of the slot mutex
+  lock_contention::flush();
   return ok;
 }
 
@@ -39,12 +47,22 @@ void lock_slot::unlock(xid_t tx) {
   std::unique_lock l(mutex_);
   unlock_gut(tx);
   assert_check();
+  l.unlock();
+  lock_contention::flush();
 }
 
 void lock_slot::add_wait(ptr<tx_lock_ctx> info, oid_t oid) {
+  lock_waits->inc();
 #ifdef TEST_TRACE_LOCK
   trace_ << "wait " << info->ctx_->xid() << ":" << oid << "@@";
 #endif
+  if (info->wait_ts_ == std::chrono::steady_clock::time_point()) {
+    info->wait_ts_ = std::chrono::steady_clock::now();
+    if (mgr_) {
+      mgr_->contention().on_wait(tuple_id_,
+                                 read_count_ + write_count_ + wait_.size());
+    }
+  }
   wait_.push_back(xid_oid_t(info->ctx_->xid(), oid));
   // after insert tx_info, build dependency
 #ifdef DB_TYPE_NON_DETERMINISTIC
@@ -244,10 +262,19 @@ void lock_slot::notify_lock_acquire() {
     }
   }
 
+  std::chrono::steady_clock::time_point now;
   for (xid_t x : notify_tx) {
     auto i = info_.find(x);
     if (i != info_.end()) {
       i->second->acquired_ = true;
+      if (mgr_ &&
+          i->second->wait_ts_ != std::chrono::steady_clock::time_point()) {
+        if (now == std::chrono::steady_clock::time_point()) {
+          now = std::chrono::steady_clock::now();
+        }
+        mgr_->contention().on_granted(
+            tuple_id_, uint64_t(to_microseconds(now - i->second->wait_ts_)));
+      }
       if (i->second->type_ == LOCK_READ_ROW ||
           i->second->type_ == LOCK_READ_PREDICATE) {
         if (!read_.contains(x)) {
@@ -1,5 +1,8 @@
 #include "concurrency/tx_context.h"
 #include "concurrency/violate.h"
+#include "common/blog.h"
+#include "common/metrics.h"
+#include "common/scoped_time.h"
 #include "common/shard2node.h"
 #ifdef DB_TYPE_NON_DETERMINISTIC
 #include "common/define.h"
@@ -8,6 +11,10 @@
 #include <boost/assert.hpp>
 #include <utility>
 
+static metric<metric_histogram> lock_wait_us(
+    "tddb_tx_lock_wait_microseconds",
+    "time a transaction waits for its locks, by the transaction");
+
 template<>
 enum_strings<rm_state>::e2s_t enum_strings<rm_state>::enum2str = {
     {RM_IDLE, "RM_IDLE"},
@@ -38,52 +45,65 @@ tx_context::tx_context(boost::asio::io_context::strand s, uint64_t xid,
       prepare_commit_log_synced_(false), commit_log_synced_(false), dl_(dl),
       victim_(false), log_rep_delay_(0), latency_read_dsb_(0),
       num_read_violate_(0), num_write_violate_(0), num_lock_(0), timeout_invoked_(false),
-      read_only_(false)
+      read_only_(false), replica_read_(false), client_seq_(0), traced_(false),
+      trace_id_(0), terminal_id_(0), construct_ns_(0)
       {
   BOOST_ASSERT(node_id != 0);
   BOOST_ASSERT(dsb_node_id != 0);
   start_ = steady_clock_ms_since_epoch();
   part_time_tracer_.begin();
-  LOG(trace) << node_name_ << " transaction RM " << xid_ << " construct";
+  BLOG(trace, "{} transaction RM {} construct", blog_node(node_id_), xid_);
 }
 
 void tx_context::begin() {
 #ifdef TX_TRACE
-  auto rm = shared_from_this();
-  auto fn_timeout = [rm] {
-    if (rm->timeout_invoked_) {
+  async_tick_timeout();
+#endif
+}
+
+#ifdef TX_TRACE
+void tx_context::async_tick_timeout() {
+  std::weak_ptr<tx_context> ctx = shared_from_this();
+  auto fn_timeout = [ctx] {
+    ptr<tx_context> rm = ctx.lock();
+    if (not rm) {
       return;
     }
+    boost::asio::post(rm->get_strand(), [rm] { rm->handle_tick_timeout(); });
+  };
+  service_->get_timing_wheel(get_strand().context())
+      .arm_after(timer_tick_, TX_TIMEOUT_MILLIS * 1000, fn_timeout);
+}
 
-    auto ms = steady_clock_ms_since_epoch();
+void tx_context::handle_tick_timeout() {
+  if (timeout_invoked_) {
+    async_tick_timeout();
+    return;
+  }
 
-    if (ms < rm->start_ + TX_TIMEOUT_MILLIS) {
-      std::string trace = rm->trace_message_.str();
-      if (trace.find("RESP;") == std::string::npos) {
-        LOG(warning) << "no RESP" << trace;
-      }
+  auto ms = steady_clock_ms_since_epoch();
 
-      if (rm->state_ == RM_ENDED ||
-           rm->state_ == RM_ABORTING ||
-           rm->state_ == RM_COMMITTING) {
-        rm->timer_tick_->cancel();
-        return;
-      }
+  if (ms < start_ + TX_TIMEOUT_MILLIS) {
+    std::string trace = trace_message_.str();
+    if (trace.find("RESP;") == std::string::npos) {
+      LOG(warning) << "no RESP" << trace;
+    }
 
-      rm->timeout_invoked_ = true;
-      LOG(warning) << rm->node_name_ <<
-          " tx: " << ms - rm->start_ <<
-          " wait ms, " << rm->xid_ <<
-          " trace" << trace;
+    if (state_ == RM_ENDED ||
+        state_ == RM_ABORTING ||
+        state_ == RM_COMMITTING) {
+      return;
     }
-  };
-  ptr<timer> t(new timer(
-      get_strand(), boost::asio::chrono::milliseconds(TX_TIMEOUT_MILLIS),
-      fn_timeout));
-  timer_tick_ = t;
-  t->async_tick();
-#endif
+
+    timeout_invoked_ = true;
+    LOG(warning) << node_name_ <<
+        " tx: " << ms - start_ <<
+        " wait ms, " << xid_ <<
+        " trace" << trace;
+  }
+  async_tick_timeout();
 }
+#endif
 
 void tx_context::notify_lock_acquire(
     EC ec, const ptr<std::vector<ptr<tx_context>>> &in) {
@@ -124,9 +144,13 @@ void tx_context::async_read(uint32_t table_id, shard_id_t shard_id, tuple_id_t k
   }
   lock_acquire_ = [table_id, shard_id, key, oid, s, fn_read_done](EC ec) {
     s->lock_wait_time_tracer_.end();
+    s->lock_wait_span_.end(s->traced_, SPAN_LOCK_WAIT, s->trace_id_, s->terminal_id_);
 
     if (ec == EC::EC_OK) {
-      std::pair<tuple_pb, bool> r = s->access_->get(table_id, shard_id, key);
+      std::pair<tuple_pb, bool> r;
+      if (!s->replica_read_) {
+        r = s->access_->get(table_id, shard_id, key);
+      }
 
       if (r.second) {
         BOOST_ASSERT(not(ec == EC::EC_OK && is_tuple_nil(r.first)));
@@ -140,8 +164,8 @@ void tx_context::async_read(uint32_t table_id, shard_id_t shard_id, tuple_id_t k
         s->read_data_from_dsb(table_id, shard_id, key, oid, fn_read_from_dsb);
       }
     } else { // error
-      LOG(trace) << "cannot find tuple, table id:" << table_id
-                 << " tuple id:" << (key);
+      BLOG(trace, "cannot find tuple, table id:{} tuple id:{}", table_id,
+           key);
       fn_read_done(ec, tuple_pb());
     }
   };
@@ -152,6 +176,7 @@ void tx_context::async_read(uint32_t table_id, shard_id_t shard_id, tuple_id_t k
                     key << " : " << oid <<";";
 #endif
   lock_wait_time_tracer_.begin();
+  lock_wait_span_.begin(traced_);
   if (read_only_) {
     lock_acquire_(EC::EC_OK);
     lock_acquire_ = nullptr;
@@ -174,6 +199,7 @@ void tx_context::async_update(uint32_t table_id, shard_id_t shard_id, tuple_id_t
   lock_acquire_ = [table_id, shard_id, key, oid, s, fn_update_done,
       tuple = std::move(tuple)](EC ec) {
     s->lock_wait_time_tracer_.end();
+    s->lock_wait_span_.end(s->traced_, SPAN_LOCK_WAIT, s->trace_id_, s->terminal_id_);
 
     if (ec == EC::EC_OK) {
       std::pair<tuple_pb, bool> r = s->access_->get(table_id, shard_id, key);
@@ -187,8 +213,8 @@ void tx_context::async_update(uint32_t table_id, shard_id_t shard_id, tuple_id_t
         s->read_data_from_dsb(table_id, shard_id, key, oid, fn_read_done);
       }
     } else {
-      LOG(trace) << "cannot find tuple, table id:" << table_id
-                 << " tuple id:" << (key);
+      BLOG(trace, "cannot find tuple, table id:{} tuple id:{}", table_id,
+           key);
       fn_update_done(ec);
     }
   };
@@ -198,6 +224,7 @@ void tx_context::async_update(uint32_t table_id, shard_id_t shard_id, tuple_id_t
                     key << ":" << oid << ";";
 #endif
   lock_wait_time_tracer_.begin();
+  lock_wait_span_.begin(traced_);
   mgr_->lock_row(xid_, oid, LOCK_WRITE_ROW, table_id, shard_id, predicate(key),
                  shared_from_this());
 }
@@ -216,6 +243,7 @@ void tx_context::async_insert(uint32_t table_id, shard_id_t shard_id, tuple_id_t
   lock_acquire_ = [table_id, shard_id, key, oid, s, tuple = std::move(tuple),
       fn_write_done](EC ec) {
     s->lock_wait_time_tracer_.end();
+    s->lock_wait_span_.end(s->traced_, SPAN_LOCK_WAIT, s->trace_id_, s->terminal_id_);
 
     if (ec == EC::EC_OK) {
       std::pair<tuple_pb, bool> r = s->access_->get(table_id, shard_id, key);
@@ -249,6 +277,7 @@ void tx_context::async_insert(uint32_t table_id, shard_id_t shard_id, tuple_id_t
                     key << ":" << oid << ";";
 #endif
   lock_wait_time_tracer_.begin();
+  lock_wait_span_.begin(traced_);
   mgr_->lock_row(xid_, oid, LOCK_WRITE_ROW,
                  table_id,
                  shard_id,
@@ -267,14 +296,19 @@ void tx_context::async_remove(uint32_t table_id, shard_id_t shard_id, tuple_id_t
     num_lock_++;
   }
   BOOST_ASSERT(lock_acquire_ == nullptr);
-  lock_acquire_ = [s, table_id, shard_id, key, fn_removed](EC ec) {
+  lock_acquire_ = [s, table_id, shard_id, key, oid, fn_removed](EC ec) {
     s->lock_wait_time_tracer_.end();
+    s->lock_wait_span_.end(s->traced_, SPAN_LOCK_WAIT, s->trace_id_, s->terminal_id_);
 
-    std::pair<tuple_pb, bool> r = s->access_->get(table_id, shard_id, key);
-    if (r.second) {
-      fn_removed(ec, std::move(r.first));
+    if (ec == EC::EC_OK) {
+      std::pair<tuple_pb, bool> r = s->access_->get(table_id, shard_id, key);
+      if (r.second) {
+        fn_removed(EC::EC_OK, std::move(r.first));
+      } else {
+        s->read_data_from_dsb(table_id, shard_id, key, oid, fn_removed);
+      }
     } else {
-      fn_removed(EC::EC_NOT_FOUND_ERROR, tuple_pb());
+      fn_removed(ec, tuple_pb());
     }
   };
 
@@ -283,6 +317,7 @@ void tx_context::async_remove(uint32_t table_id, shard_id_t shard_id, tuple_id_t
                     key << ":" << oid << ";";
 #endif
   lock_wait_time_tracer_.begin();
+  lock_wait_span_.begin(traced_);
   mgr_->lock_row(xid_, oid, LOCK_WRITE_ROW,
                  table_id,
                  shard_id,
@@ -295,8 +330,8 @@ void tx_context::read_data_from_dsb(uint32_t table_id, shard_id_t shard_id, tupl
 #ifdef TX_TRACE
   trace_message_ << "rd dsb;";
 #endif
-  LOG(trace) << node_name_ << " tx " << xid_ << " read key from DSB, table id:" << table_id
-             << " tuple id:" << key;
+  BLOG(trace, "{} tx {} read key from DSB, table id:{} tuple id:{}",
+       blog_node(node_id_), xid_, table_id, key);
   node_id_t dest_node_id = shard2node(shard_id);
   auto req = std::make_shared<ccb_read_request>();
   req->set_source(node_id_);
@@ -312,6 +347,7 @@ void tx_context::read_data_from_dsb(uint32_t table_id, shard_id_t shard_id, tupl
   req->set_tuple_id(key);
   BOOST_ASSERT(dest_node_id != 0);
   read_time_tracer_.begin();
+  read_span_.begin(traced_);
 
   result<void> r = service_->async_send(dest_node_id, C2D_READ_DATA_REQ, req, true);
   if (!r) {
@@ -332,9 +368,8 @@ void tx_context::read_data_from_dsb_response(
   EC ec = EC(response->error_code());
   tuple_pb tuple;
   auto table_id = response->tuple_row().table_id();
-  LOG(trace) << node_name_ << " tx " << xid_
-             << " read key from DSB response, table_id:" << table_id
-             << " tuple id:" << (key);
+  BLOG(trace, "{} tx {} read key from DSB response, table_id:{} tuple id:{}",
+       blog_node(node_id_), xid_, table_id, key);
 
   auto oid = response->oid();
   auto latency = response->latency_read_dsb();
@@ -347,6 +382,7 @@ void tx_context::read_data_from_dsb_response(
 
   latency_read_dsb_ += latency;
   read_time_tracer_.end_ts(ts);
+  read_span_.end_ts(traced_, SPAN_DSB_READ, trace_id_, terminal_id_, tx_span_ns(ts));
 
   BOOST_ASSERT(oid != 0);
   auto i = ds_read_handler_.find(oid);
@@ -362,22 +398,34 @@ void tx_context::read_data_from_dsb_response(
   }
 
   if (ec == EC::EC_OK) {
-    if (has_tuple) {
+    if (replica_read_) {
+      // a follower does not cache, its cache is not updated by the commits
+    } else if (has_tuple) {
       BOOST_ASSERT(!is_tuple_nil(tuple));
       access_->put(table_id, shard_id, key, std::move(tuple));
       // auto pair = mgr_->get(table_id, key);
       // BOOST_ASSERT(pair.second);
-      LOG(trace) << node_name_ << " cached table:" << table_id << " key:" << key;
+      BLOG(trace, "{} cached table:{} key:{}", blog_node(node_id_), table_id,
+           key);
     } else {
-      LOG(trace) << node_name_ << " no tuple:" << table_id << " key:" << key;
+      BLOG(trace, "{} no tuple:{} key:{}", blog_node(node_id_), table_id, key);
     }
   } else {
-    LOG(trace) << node_name_ << " read error:" << ec << "" << table_id << " key:" << key;
+    BLOG(trace, "{} read error:{} {} key:{}", blog_node(node_id_), ec, table_id,
+         key);
   }
 }
 
 void tx_context::process_tx_request(const tx_request &req) {
   read_only_ = req.read_only();
+  client_seq_ = req.client_seq();
+  traced_ = req.trace();
+  trace_id_ = req.trace_id();
+  terminal_id_ = req.terminal_id();
+  if (traced_ && construct_ns_ != 0) {
+    tx_span_record(SPAN_CCB_DISPATCH, trace_id_, terminal_id_, construct_ns_,
+                   tx_span_now_ns());
+  }
   begin();
 
 #ifdef TX_TRACE
@@ -434,7 +482,7 @@ void tx_context::handle_next_operation() {
     }
   } else {
 
-    LOG(trace) << xid_ << " abort , " << enum2str(error_code_);
+    BLOG(trace, "{} abort , {}", xid_, error_code_);
     if (distributed_) {
 #ifdef DB_TYPE_SHARE_NOTHING
       if (is_shared_nothing()) {
@@ -463,13 +511,13 @@ void tx_context::handle_operation(tx_operation &op, const fn_ec op_done) {
       if (ec == EC::EC_NOT_FOUND_ERROR) {
         tuple_id_t tid = (key);
 
-        LOG(trace) << s->node_name_ << " cannot find, table_id=" << table_id
-                   << ", tuple_id=" << tid;
+        BLOG(trace, "{} cannot find, table_id={}, tuple_id={}",
+             blog_node(s->node_id_), table_id, tid);
       }
       BOOST_ASSERT(not(ec == EC::EC_OK && is_tuple_nil(tuple)));
       tx_operation *op_response = s->response_.add_operations();
       tuple.swap(*op_response->mutable_tuple_row()->mutable_tuple());
-      LOG(trace) << s->node_name_ << " handle read table " << table_id << "  ";
+      BLOG(trace, "{} handle read table {}", blog_node(s->node_id_), table_id);
       s->invoke_done(op_done, ec);
     };
     bool read_for_write = op.op_type() == TX_OP_READ_FOR_WRITE;
@@ -484,8 +532,8 @@ void tx_context::handle_operation(tx_operation &op, const fn_ec op_done) {
     auto s = shared_from_this();
     auto update_done = [s, op, table_id, shard_id, key, tuple, op_done](EC ec) {
       if (ec == EC::EC_NOT_FOUND_ERROR) {
-        LOG(debug) << s->node_name_ << " cannot find, table_id=" << table_id
-                   << ", tuple_id=" << (key);
+        BLOG(debug, "{} cannot find, table_id={}, tuple_id={}",
+             blog_node(s->node_id_), table_id, key);
       }
       // LOG(debug)
       //   << "handle update table " << table_id << " tuple: ";
@@ -506,8 +554,8 @@ void tx_context::handle_operation(tx_operation &op, const fn_ec op_done) {
     auto s = shared_from_this();
     auto insert_done = [s, op, table_id, shard_id, key, tuple, op_done](EC ec) {
       if (ec == EC::EC_DUPLICATION_ERROR) {
-        LOG(debug) << s->node_name_ << " find, table_id=" << table_id
-                   << ", tuple=" << (key);
+        BLOG(debug, "{} find, table_id={}, tuple={}", blog_node(s->node_id_),
+             table_id, key);
       }
       // LOG(debug)
       //   << "handle insert table " << table_id << " tuple ";
@@ -519,6 +567,22 @@ void tx_context::handle_operation(tx_operation &op, const fn_ec op_done) {
     async_insert(table_id, shard_id, key, std::move(tp), insert_done);
     return;
   }
+  case TX_OP_DELETE: {
+    table_id_t table_id = op.tuple_row().table_id();
+    tuple_id_t key = op.tuple_row().tuple_id();
+    shard_id_t shard_id = op.tuple_row().shard_id();
+    auto s = shared_from_this();
+    auto remove_done = [s, op, table_id, key, op_done](EC ec, tuple_pb &&) {
+      if (ec == EC::EC_NOT_FOUND_ERROR) {
+        BLOG(debug, "{} cannot find, table_id={}, tuple_id={}",
+             blog_node(s->node_id_), table_id, key);
+      }
+      s->append_operation(op);
+      s->invoke_done(op_done, ec);
+    };
+    async_remove(table_id, shard_id, key, remove_done);
+    return;
+  }
   default:BOOST_ASSERT(false);
   }
 }
@@ -539,7 +603,10 @@ void tx_context::send_tx_response() {
   }
   trace_message_ << "RESP;";
   has_respond_ = true;
-  LOG(trace) << node_name_ << " tx " << xid_ << " send response: " << enum2str(error_code_);
+  tx_span response_span;
+  response_span.begin(traced_);
+  BLOG(trace, "{} tx {} send response: {}", blog_node(node_id_), xid_,
+       error_code_);
 
   part_time_tracer_.end();
 
@@ -551,12 +618,14 @@ void tx_context::send_tx_response() {
   response->set_latency_read_dsb(latency_read_dsb_);
   response->set_latency_read(read_time_tracer_.microseconds());
   response->set_latency_lock_wait(lock_wait_time_tracer_.microseconds());
+  lock_wait_us->record(lock_wait_time_tracer_.microseconds());
   response->set_latency_replicate(log_rep_delay_);
   response->set_latency_part(part_time_tracer_.microseconds());
   response->set_access_part(1);
   response->set_num_lock(num_lock_);
   response->set_num_read_violate(num_read_violate_);
   response->set_num_write_violate(num_write_violate_);
+  response->set_client_seq(client_seq_);
   if (response->latency_read_dsb() > response->latency_read()) {
     LOG(error) << "read DSB" << response->latency_read_dsb() << "ms";
     LOG(error) << "read" << response->latency_read() << "ms";
@@ -564,6 +633,7 @@ void tx_context::send_tx_response() {
   }
 
   service_->conn_async_send(cli_conn_, CLIENT_TX_RESP, response);
+  response_span.end(traced_, SPAN_RESPONSE, trace_id_, terminal_id_);
 }
 
 void tx_context::abort_tx_1p() {
@@ -573,7 +643,8 @@ void tx_context::abort_tx_1p() {
   if (state_ == rm_state::RM_IDLE) {
     state_ = rm_state::RM_ABORTING;
     set_tx_cmd_type(TX_CMD_RM_ABORT);
-    LOG(trace) << node_name_ << " transaction RM " << xid_ << "phase1 aborted";
+    BLOG(trace, "{} transaction RM {} phase1 aborted", blog_node(node_id_),
+         xid_);
     async_force_log();
   } else if (state_ == rm_state::RM_ABORTING) {
     send_tx_response();
@@ -597,6 +668,17 @@ void tx_context::on_log_entry_commit(
   trace_message_ << "lg cmt " << type << ";";
 #endif
   log_entry_.clear();
+  if (traced_) {
+    // the log is replicated in the last log_rep_delay_ us of the append
+    uint64_t end_ns = tx_span_ns(end_ts);
+    append_span_.end_ts(traced_, SPAN_WAL_APPEND, trace_id_, terminal_id_, end_ns);
+    if (log_rep_delay_ != 0 && end_ns > log_rep_delay_ * 1000) {
+      tx_span_record(SPAN_RAFT_REPLICATE, trace_id_, terminal_id_,
+                     end_ns - log_rep_delay_ * 1000, end_ns);
+    }
+    tx_span_record(SPAN_COMMIT_NOTIFY, trace_id_, terminal_id_, end_ns,
+                   tx_span_now_ns());
+  }
   switch (type) {
   case TX_CMD_RM_COMMIT: {
     append_time_tracer_.end_ts(end_ts);
@@ -630,7 +712,7 @@ void tx_context::tx_committed() {
     trace_message_ << "tx_rm C;";
 #endif
 
-    LOG(trace) << "tx_rm: " << xid_ << ", commit ";
+    BLOG(trace, "tx_rm: {}, commit", xid_);
     send_tx_response();
     release_lock();
   } else {
@@ -640,7 +722,7 @@ void tx_context::tx_committed() {
 #ifdef TX_TRACE
       trace_message_ << "tx_rm C;";
 #endif
-      LOG(trace) << "tx_rm TM : " << xid_ << ", phase 2 commit: ";
+      BLOG(trace, "tx_rm TM : {}, phase 2 commit", xid_);
       send_ack_message(true);
       release_lock();
     }
@@ -654,7 +736,7 @@ void tx_context::tx_aborted() {
     trace_message_ << "tx_rm A;";
 #endif
 
-    LOG(trace) << "tx_rm RM : " << xid_ << ", phase 1 abort: ";
+    BLOG(trace, "tx_rm RM : {}, phase 1 abort", xid_);
     if (error_code_ == EC::EC_OK) {
       error_code_ = EC::EC_TX_ABORT;
     }
@@ -664,7 +746,7 @@ void tx_context::tx_aborted() {
 #ifdef DB_TYPE_SHARE_NOTHING
     if (is_shared_nothing()) {
 
-      LOG(trace) << "tx_rm TM : " << xid_ << ", phase 2 abort: ";
+      BLOG(trace, "tx_rm TM : {}, phase 2 abort", xid_);
       send_ack_message(false);
       release_lock();
     }
@@ -677,7 +759,7 @@ rm_state tx_context::state() const { return state_; }
 
 void tx_context::tx_ended() {
   state_ = RM_ENDED;
-  LOG(trace) << node_name_ << " xid " << xid_ << " end";
+  BLOG(trace, "{} xid {} end", blog_node(node_id_), xid_);
   if (fn_tx_state_) {
     fn_tx_state_(xid_, state_);
   }
@@ -706,15 +788,18 @@ void tx_context::async_force_log() {
 #ifdef TX_TRACE
   trace_message_ << "fc lg;";
 #endif
-  LOG(trace) << node_name_ << " xid:" << xid_ << ", force log";
+  BLOG(trace, "{} xid:{}, force log", blog_node(node_id_), xid_);
   std::vector<tx_log_binary> entries;
+  std::vector<shard_map_t> shard_map;
   for (tx_log_proto &log : log_entry_) {
     tx_log_binary log_binary = tx_log_proto_to_binary(log);
     entries.emplace_back(log_binary);
+    shard_map.push_back(tx_log_proto_shard_map(log));
   }
-  wal_->async_append(entries);
+  wal_->async_append(entries, shard_map);
   log_entry_.clear();
   append_time_tracer_.begin();
+  append_span_.begin(traced_);
 }
 
 void tx_context::append_operation(const tx_operation &op) {
@@ -751,7 +836,7 @@ void tx_context::handle_finish_tx_phase1_commit() {
 
     set_tx_cmd_type(TX_CMD_RM_COMMIT);
 
-    LOG(trace) << node_name_ << " transaction RM " << xid_ << " commit";
+    BLOG(trace, "{} transaction RM {} commit", blog_node(node_id_), xid_);
     if (read_only_) {
       on_committed_log_commit();
     } else {
@@ -808,7 +893,7 @@ void tx_context::tx_prepare_committed() {
 #ifdef TX_TRACE
   trace_message_ << "tx_rm PC;";
 #endif
-  LOG(trace) << node_name_ << " tx_rm: " << xid_ << ", prepare commit: ";
+  BLOG(trace, "{} tx_rm: {}, prepare commit", blog_node(node_id_), xid_);
 
   send_prepare_message(true);
 }
@@ -817,7 +902,7 @@ void tx_context::tx_prepare_aborted() {
 #ifdef TX_TRACE
   trace_message_ << "tx_rm PA;";
 #endif
-  LOG(trace) << "tx_rm: " << xid_ << ", prepare abort: ";
+  BLOG(trace, "tx_rm: {}, prepare abort", xid_);
   send_prepare_message(false);
 }
 
@@ -830,7 +915,8 @@ void tx_context::abort_tx_2p() {
     trace_message_ << "a2p;";
 #endif
     set_tx_cmd_type(TX_CMD_RM_ABORT);
-    LOG(trace) << node_name_ << " transaction RM " << xid_ << "phase2 aborted";
+    BLOG(trace, "{} transaction RM {} phase2 aborted", blog_node(node_id_),
+         xid_);
     async_force_log();
   } else if (state_ == RM_ABORTING || state_ == RM_ENDED) {
     send_ack_message(false);
@@ -863,7 +949,8 @@ void tx_context::prepare_commit_tx() {
     tx_operation prepare_commit_op;
 
     set_tx_cmd_type(TX_CMD_RM_PREPARE_COMMIT);
-    LOG(trace) << node_name_ << " transaction RM " << xid_ << " prepare commit";
+    BLOG(trace, "{} transaction RM {} prepare commit", blog_node(node_id_),
+         xid_);
   }
 }
 
@@ -873,7 +960,7 @@ void tx_context::prepare_abort_tx() {
   tx_operation prepare_commit_op;
 
   set_tx_cmd_type(TX_CMD_RM_PREPARE_ABORT);
-  LOG(trace) << node_name_ << " transaction RM " << xid_ << " prepare commit";
+  BLOG(trace, "{} transaction RM {} prepare commit", blog_node(node_id_), xid_);
 }
 
 void tx_context::send_prepare_message(bool commit) {
@@ -939,7 +1026,7 @@ void tx_context::handle_finish_tx_phase2_commit() {
   if (state_ == rm_state::RM_PREPARE_COMMITTING) {
     state_ = rm_state::RM_COMMITTING;
     set_tx_cmd_type(TX_CMD_RM_COMMIT);
-    LOG(trace) << node_name_ << " transaction RM " << xid_ << " commit";
+    BLOG(trace, "{} transaction RM {} commit", blog_node(node_id_), xid_);
     async_force_log();
   } else if (state_ == rm_state::RM_COMMITTING) {
     send_ack_message(true);
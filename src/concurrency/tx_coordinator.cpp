@@ -34,7 +34,8 @@ tx_coordinator::tx_coordinator(
       fn_tm_state_(std::move(fn)), latency_read_(0), latency_read_dsb_(0),
       latency_replicate_(0), latency_append_(0), latency_lock_wait_(0),
       latency_part_(0), num_lock_(0), num_read_violate_(0),
-      num_write_violate_(0) {
+      num_write_violate_(0), client_seq_(0), traced_(false), trace_id_(0),
+      terminal_id_(0), construct_ns_(0) {
   start_ = std::chrono::steady_clock::now();
 }
 
@@ -76,6 +77,7 @@ void tx_coordinator::on_committed() {
   trace_message_ += "C;";
 #endif
   tm_state_ = TM_COMMITTED;
+  commit_span_.end(traced_, SPAN_TM_COMMIT, trace_id_, terminal_id_);
   send_commit();
 }
 
@@ -105,6 +107,14 @@ result<void> tx_coordinator::handle_tx_request(const tx_request &req) {
   trace_message_ += "tx req;";
 #endif
   BOOST_ASSERT(req.distributed());
+  client_seq_ = req.client_seq();
+  traced_ = req.trace();
+  trace_id_ = req.trace_id();
+  terminal_id_ = req.terminal_id();
+  if (traced_ && construct_ns_ != 0) {
+    tx_span_record(SPAN_CCB_DISPATCH, trace_id_, terminal_id_, construct_ns_,
+                   tx_span_now_ns());
+  }
   for (auto iter = req.operations().begin(); iter != req.operations().end();
        ++iter) {
     shard_id_t sd_id = iter->sd_id();
@@ -121,6 +131,10 @@ result<void> tx_coordinator::handle_tx_request(const tx_request &req) {
     tracer.message_.set_distributed(true);
     tracer.message_.set_source(node_id_);
     tracer.message_.set_oneshot(req.oneshot());
+    // the participants record the spans of a sampled transaction too
+    tracer.message_.set_trace(traced_);
+    tracer.message_.set_trace_id(trace_id_);
+    tracer.message_.set_terminal_id(terminal_id_);
 
     auto i = lead_node_.find(sd_id);
     if (lead_node_.end() != i) {
@@ -356,6 +370,7 @@ void tx_coordinator::write_commit_log() {
     trace_message_ += "C log;";
 #endif
     tx_log_binary log_binary = tx_log_proto_to_binary(log);
+    commit_span_.begin(traced_);
     wal_->async_append(log_binary);
     write_commit_log_ = true;
   }
@@ -397,6 +412,8 @@ void tx_coordinator::send_tx_response() {
   }
 
   responsed_ = true;
+  tx_span response_span;
+  response_span.begin(traced_);
   auto response = std::make_shared<tx_response>();
   response->set_error_code(uint32_t(error_code_));
   response->set_latency_part(latency_part_);
@@ -409,8 +426,10 @@ void tx_coordinator::send_tx_response() {
   response->set_num_lock(num_lock_);
   response->set_num_read_violate(num_read_violate_);
   response->set_num_write_violate(num_write_violate_);
+  response->set_client_seq(client_seq_);
 
   service_->conn_async_send(connection_, CLIENT_TX_RESP, response);
+  response_span.end(traced_, SPAN_RESPONSE, trace_id_, terminal_id_);
 }
 
 void tx_coordinator::abort(EC ec) {
@@ -5,20 +5,73 @@
 #include <mutex>
 
 write_ahead_log::write_ahead_log(node_id_t node_id, node_id_t rlb_node,
+                                 uint64_t credit_bytes,
+                                 uint64_t pending_bytes_max,
                                  net_service *service)
     : node_id_(node_id), node_name_(id_2_name(node_id)), rlb_node_id_(rlb_node),
-      cno_(0), service_(service) {}
+      cno_(0), service_(service), credit_bytes_max_(credit_bytes),
+      credit_bytes_(credit_bytes), pending_bytes_max_(pending_bytes_max),
+      pending_bytes_(0) {}
 
-void write_ahead_log::set_cno(uint64_t cno) { cno_ = cno; }
+void write_ahead_log::set_cno(uint64_t cno) {
+  std::scoped_lock l(mutex_);
+  if (cno_ == cno) {
+    return;
+  }
+  cno_ = cno;
+  // requests wait for credits of the previous RLB term, send them and let the
+  // RLB reject them
+  while (not pending_.empty()) {
+    send_append_log_request(pending_.front());
+    pending_.pop_front();
+  }
+  pending_bytes_.store(0);
+  credit_bytes_ = credit_bytes_max_;
+}
+
+void write_ahead_log::add_credit(uint64_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  std::scoped_lock l(mutex_);
+  credit_bytes_ = std::min(credit_bytes_ + bytes, credit_bytes_max_);
+  send_pending();
+}
+
+void write_ahead_log::reset_credit() {
+  std::scoped_lock l(mutex_);
+  credit_bytes_ = credit_bytes_max_;
+  send_pending();
+}
+
+void write_ahead_log::send_pending() {
+  while (not pending_.empty()) {
+    const ptr<ccb_append_log_request> &req = pending_.front();
+    uint64_t size = req->repeated_tx_logs().size();
+    // a request larger than the whole window is sent when nothing is
+    // outstanding
+    if (size > credit_bytes_ && credit_bytes_ != credit_bytes_max_) {
+      break;
+    }
+    credit_bytes_ = size > credit_bytes_ ? 0 : credit_bytes_ - size;
+    pending_bytes_.fetch_sub(size);
+    send_append_log_request(req);
+    pending_.pop_front();
+  }
+}
 
 void write_ahead_log::async_append(tx_log_binary &entry) {
   std::vector<tx_log_binary> log;
   log.push_back(tx_log_binary());
   log.rbegin()->swap(entry);
-  async_append(log);
+  // no write operations
+  std::vector<shard_map_t> shard_map(1, 0);
+  async_append(log, shard_map);
 }
 
-void write_ahead_log::async_append(std::vector<tx_log_binary> &entry) {
+void write_ahead_log::async_append(std::vector<tx_log_binary> &entry,
+                                   const std::vector<shard_map_t> &shard_map) {
+  BOOST_ASSERT(entry.size() == shard_map.size());
   auto req = cs_new<ccb_append_log_request>();
   req->set_source(node_id_);
   req->set_dest(rlb_node_id_);
@@ -31,13 +84,22 @@ void write_ahead_log::async_append(std::vector<tx_log_binary> &entry) {
   std::string *repeated_tx_logs = req->mutable_repeated_tx_logs();
   repeated_tx_logs->resize(total_size);
   size_t offset = 0;
-  for (tx_log_binary &log : entry) {
+  for (size_t i = 0; i < entry.size(); i++) {
+    tx_log_binary &log = entry[i];
     log_buffer::format(const_cast<char *>(repeated_tx_logs->data()) + offset,
                        repeated_tx_logs->size() - offset, log.data(),
-                       log.size(), 0, node_id_);
+                       log.size(), 0, node_id_, shard_map[i]);
     offset += log_buffer::add_header_size(log.size());
   }
 
+  std::scoped_lock l(mutex_);
+  pending_bytes_.fetch_add(total_size);
+  pending_.push_back(req);
+  send_pending();
+}
+
+void write_ahead_log::send_append_log_request(
+    const ptr<ccb_append_log_request> &req) {
 #ifdef TEST_APPEND_TIME
   req->set_debug_send_ts(steady_clock_ms_since_epoch());
 #endif
@@ -0,0 +1,148 @@
+#include "network/async_db_client.h"
+#include "common/logger.hpp"
+#include <utility>
+
+async_db_client::async_db_client(boost::asio::io_context &context,
+                                 az_id_t az_id, node_config conf,
+                                 uint32_t window)
+    : az_id_(az_id), conf_(std::move(conf)), strand_(context),
+      window_(std::max<uint32_t>(1, window)), next_seq_(0),
+      num_outstanding_(0) {}
+
+bool async_db_client::connect() {
+  ptr<tcp::socket> s(new tcp::socket(strand_.context()));
+  tcp::resolver resolver(strand_.context());
+  boost::system::error_code ec;
+  std::string address = conf_.address_public_or_private(az_id_);
+  boost::asio::connect(
+      *s, resolver.resolve(address, std::to_string(conf_.port())), ec);
+  if (ec.failed()) {
+    LOG(error) << "connect ip:" << address << " port:" << conf_.port()
+               << " failed";
+    return false;
+  }
+  // the handlers refer to this client weakly, the connection does not keep
+  // it alive
+  std::weak_ptr<async_db_client> weak = shared_from_this();
+  message_handler handler = [weak](ptr<connection>, message_type id,
+                                   byte_buffer &buffer,
+                                   msg_hdr *) -> result<void> {
+    ptr<async_db_client> c = weak.lock();
+    if (not c) {
+      return outcome::success();
+    }
+    return c->handle_message(id, buffer);
+  };
+  node_peer peer(conf_.node_id(), address, conf_.port());
+  ptr<client> cli(new client(strand_, s, handler, peer));
+  cli->set_error_handler([weak](berror) {
+    ptr<async_db_client> c = weak.lock();
+    if (c) {
+      c->fail_all(EC::EC_NET_UNCONNECTED);
+    }
+  });
+  auto self = shared_from_this();
+  boost::asio::post(strand_, [self, cli] {
+    self->cli_ = cli;
+    cli->async_read();
+    self->send_waiting();
+  });
+  return true;
+}
+
+void async_db_client::async_submit(const ptr<tx_request> &request,
+                                   fn_tx_response fn) {
+  num_outstanding_.fetch_add(1);
+  auto self = shared_from_this();
+  boost::asio::post(strand_, [self, request, fn = std::move(fn)]() mutable {
+    if (self->cli_ && self->in_flight_.size() < self->window_ &&
+        self->waiting_.empty()) {
+      self->send(waiting_tx{request, std::move(fn)});
+    } else {
+      self->waiting_.push_back(waiting_tx{request, std::move(fn)});
+    }
+  });
+}
+
+void async_db_client::close() {
+  auto self = shared_from_this();
+  boost::asio::post(strand_, [self] {
+    if (self->cli_) {
+      self->cli_->close();
+    }
+    self->fail_all(EC::EC_NET_UNCONNECTED);
+  });
+}
+
+void async_db_client::send(waiting_tx tx) {
+  uint64_t seq = ++next_seq_;
+  tx.request_->set_client_seq(seq);
+  // the response may arrive before async_send returns, but it is handled on
+  // this strand after it
+  in_flight_[seq] = std::move(tx.fn_);
+  result<void> r = cli_->async_send(CLIENT_TX_REQ, tx.request_);
+  if (not r) {
+    auto i = in_flight_.find(seq);
+    if (i != in_flight_.end()) {
+      fn_tx_response fn = std::move(i->second);
+      in_flight_.erase(i);
+      num_outstanding_.fetch_sub(1);
+      tx_response response;
+      response.set_error_code(uint32_t(r.error().code()));
+      fn(r.error().code(), response);
+    }
+  }
+}
+
+void async_db_client::send_waiting() {
+  while (cli_ && in_flight_.size() < window_ && not waiting_.empty()) {
+    waiting_tx tx = std::move(waiting_.front());
+    waiting_.pop_front();
+    send(std::move(tx));
+  }
+}
+
+result<void> async_db_client::handle_message(message_type id,
+                                             byte_buffer &buffer) {
+  if (id != CLIENT_TX_RESP) {
+    LOG(error) << "async client, unexpected message " << enum2str(id);
+    return outcome::success();
+  }
+  tx_response response;
+  result<void> r = buf_to_proto(buffer, response);
+  if (not r) {
+    return r;
+  }
+  handle_response(EC::EC_OK, response);
+  return outcome::success();
+}
+
+void async_db_client::handle_response(EC ec, const tx_response &response) {
+  auto i = in_flight_.find(response.client_seq());
+  if (i == in_flight_.end()) {
+    LOG(warning) << "async client, no transaction of client_seq "
+                 << response.client_seq();
+    return;
+  }
+  fn_tx_response fn = std::move(i->second);
+  in_flight_.erase(i);
+  num_outstanding_.fetch_sub(1);
+  send_waiting();
+  fn(ec, response);
+}
+
+void async_db_client::fail_all(EC ec) {
+  std::unordered_map<uint64_t, fn_tx_response> in_flight;
+  std::deque<waiting_tx> waiting;
+  in_flight.swap(in_flight_);
+  waiting.swap(waiting_);
+  num_outstanding_.fetch_sub(in_flight.size() + waiting.size());
+  tx_response response;
+  response.set_error_code(uint32_t(ec));
+  for (auto &kv : in_flight) {
+    kv.second(ec, response);
+  }
+  for (waiting_tx &tx : waiting) {
+    tx.fn_(ec, response);
+  }
+}
@@ -23,6 +23,9 @@ void connection::async_read() {
       strand_, [t](const boost_ec &ec, size_t bytes_read) {
         scoped_time _t_read("read call back", 10);
         if (ec == boost::asio::error::eof) {
+          if (t->error_handler_) {
+            t->error_handler_(berror(ec));
+          }
           return;
         }
         t->read_start_ = steady_clock_ms_since_epoch();
@@ -135,7 +138,6 @@ result<void> connection::process_message_buffer() {
                      << "ms, message:" << enum2str(id);
       }
       start_ms = millis - start_ms;
-      time1_.add(id, boost::posix_time::milliseconds(start_ms));
     } else {
       LOG(error) << "error test network time";
     }
@@ -169,14 +171,21 @@ result<void> connection::process_message_buffer() {
 #endif
   }
 
-  if (wpos > recv_buf_.get_read_pos()) {
+  size_t left_begin = recv_buf_.get_read_pos();
+  // length of the message received partially, header included
+  size_t partial_length =
+      prev_message_length > 0 ? prev_message_length + msg_hdr::size() : 0;
+  if (wpos > left_begin) {
 #ifdef DEBUG_NETWORK_SEND_RECV
     ssm_ << __LINE__ << " wpos > rpos, recv_buf_" << recv_buf_.info_str()
          << std::endl;
 #endif
-    size_t left_begin = recv_buf_.get_read_pos();
-    if (left_begin > 0) {
-      size_t unprocessed = wpos - recv_buf_.get_read_pos();
+    // the unprocessed bytes are moved to the front only when the free space
+    // is low, or the partial message would not fit in the rest of buffer
+    if (left_begin > 0 &&
+        (recv_buf_.write_available_size() < RECV_BUFFER_LOW_WATER ||
+         left_begin + partial_length > recv_buf_.size())) {
+      size_t unprocessed = wpos - left_begin;
       if (unprocessed <= left_begin) { // non-overlapping
         BOOST_ASSERT(recv_buf_.size() >= left_begin + unprocessed);
         std::memcpy(recv_buf_.data(), recv_buf_.data() + left_begin,
@@ -195,35 +204,43 @@ result<void> connection::process_message_buffer() {
          << std::endl;
 #endif
     recv_buf_.reset();
+    if (recv_buf_.size() > RECV_BUFFER_SHRINK_SIZE) {
+      // a large message has been processed
+      recv_buf_.resize_capacity(MESSAGE_BUFFER_SIZE);
+    }
   } else {
     LOG(fatal) << "handle message buffer size error";
   }
-  if (recv_buf_.get_write_pos() + prev_message_length > MESSAGE_BUFFER_SIZE) {
+  if (recv_buf_.get_read_pos() + partial_length > recv_buf_.size()) {
 #ifdef DEBUG_NETWORK_SEND_RECV
-    ssm_ << __LINE__ << " wpos + prev > recv_buf_:" << recv_buf_.info_str()
+    ssm_ << __LINE__ << " rpos + prev > recv_buf_:" << recv_buf_.info_str()
          << std::endl;
 #endif
-    recv_buf_.resize_write_available_size(recv_buf_.get_write_pos() +
-        prev_message_length);
-  } else if (recv_buf_.get_write_pos() <= MESSAGE_BUFFER_SIZE &&
-      recv_buf_.size() > MESSAGE_BUFFER_SIZE) {
-#ifdef DEBUG_NETWORK_SEND_RECV
-    ssm_ << __LINE__ << " wpos <= buf_size && size > buf_size, recv_buf_:"
-         << recv_buf_.info_str() << std::endl;
-#endif
-    recv_buf_.resize_capacity(MESSAGE_BUFFER_SIZE);
+    // grow, and keep the capacity for the following large messages
+    recv_buf_.resize_capacity(recv_buf_.get_read_pos() + partial_length);
+  }
+  if (recv_buf_.write_available_size() == 0) {
+    recv_buf_.resize_write_available_size(MESSAGE_BUFFER_SIZE);
   }
   return outcome::success();
 }
 
 result<void> connection::process_message_body(message_type msg_id,
                                               msg_hdr *hdr) {
-  scoped_time _t(
-      (boost::format("process message %s") % enum2str(msg_id)).str());
+  scoped_time _t("connection::process_message_body");
   if (handler_ == nullptr) {
     return outcome::success();
   }
   auto t = shared_from_this();
+  if (hdr != nullptr && hdr->compressed()) {
+    result<void> rd = frame_decompress(msg_id, recv_buf_.read_begin(),
+                                       recv_buf_.read_available_size(),
+                                       decompress_buf_);
+    if (not rd) {
+      return rd;
+    }
+    return handler_(t, msg_id, decompress_buf_, hdr);
+  }
   result<void> r = handler_(t, msg_id, recv_buf_, hdr);
   return r;
 }
@@ -235,56 +252,78 @@ void connection::process_error(berror ec) {
       socket_->close();
     }
     connected_ = false;
+    if (error_handler_) {
+      error_handler_(ec);
+    }
   }
 }
 
-void connection::async_write(const byte_buffer &buffer) {
+void connection::async_write() {
+  writing_in_action_ = true;
+  BOOST_ASSERT(send_writing_.empty());
+  send_writing_.swap(send_queue_);
+  send_iov_.clear();
+  size_t size = 0;
+  // write all queued segments by one gather write
+  for (const send_segment &segment : send_writing_) {
+    if (segment.buffer_) {
+      send_iov_.emplace_back(segment.buffer_->data() + segment.begin_,
+                             segment.end_ - segment.begin_);
+    } else {
+      send_iov_.emplace_back(segment.payload_->data(),
+                             segment.payload_->size());
+    }
+    size += send_iov_.back().size();
+  }
   auto t = shared_from_this();
-  size_t size = buffer.read_available_size();
   auto write_handler = boost::asio::bind_executor(
       get_strand(), [size, t](boost_ec ec, size_t _b) {
         if (not ec.failed()) {
           if (size != _b) {
             LOG(fatal) << "async_write size error" << _b;
           }
-          t->async_write_done();
           t->offset_ += size;
+          t->async_write_done();
         } else {
           LOG(error) << "async write error send bytes: " << ec.message();
           t->process_error(berror(ec));
         }
       });
 
-  boost::asio::async_write(
-      *socket_,
-      boost::asio::buffer(buffer.read_begin(), buffer.read_available_size()),
-      write_handler);
+  boost::asio::async_write(*socket_, send_iov_, write_handler);
 }
 
 void connection::async_write_done() {
-  send_buf_.reset();
-  connected_ = true;
-  if (!send_msg_pending_.empty()) {
-    size_t size = 0;
-    for (const auto &message : send_msg_pending_) {
-      size += message->read_available_size();
+  std::vector<ptr<byte_buffer>> written;
+  for (const send_segment &segment : send_writing_) {
+    if (segment.buffer_ && segment.buffer_ != send_tail_ &&
+        (written.empty() || written.back() != segment.buffer_)) {
+      written.push_back(segment.buffer_);
     }
-    if (send_buf_.size() < size) {
-      send_buf_.resize_capacity(size);
-    }
-
-    for (const auto &message : send_msg_pending_) {
-      send_buf_.append(*message);
-    }
-    BOOST_ASSERT(send_buf_.read_available_size() == size);
-
-    send_msg_pending_.clear();
-    async_write(send_buf_);
+  }
+  send_writing_.clear();
+  for (const ptr<byte_buffer> &buffer : written) {
+    free_send_buffer(buffer);
+  }
+  if (send_queue_.empty() && send_tail_ && send_tail_.use_count() == 1) {
+    // all written, reuse the tail buffer from its beginning
+    send_tail_->reset();
+  }
+  connected_ = true;
+  if (!send_queue_.empty()) {
+    async_write();
   } else {
     writing_in_action_ = false;
   }
 }
 
+void connection::release_write() {
+  write_held_ = false;
+  if (connected_ && not writing_in_action_ && not send_queue_.empty()) {
+    async_write();
+  }
+}
+
 void connection::connected() { connected_ = true; }
 
 void connection::connected(ptr<tcp::socket> sock, message_handler handler) {
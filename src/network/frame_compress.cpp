@@ -0,0 +1,166 @@
+#include "network/frame_compress.h"
+#include "common/logger.hpp"
+#include "common/variable.h"
+#include <array>
+#include <atomic>
+#include <boost/endian/conversion.hpp>
+#include <chrono>
+#include <cstring>
+#include <lz4.h>
+#include <zstd.h>
+
+struct compress_stat {
+  std::atomic<uint64_t> compress_count_;
+  std::atomic<uint64_t> raw_bytes_;
+  std::atomic<uint64_t> compressed_bytes_;
+  std::atomic<uint64_t> compress_ns_;
+  std::atomic<uint64_t> decompress_count_;
+  std::atomic<uint64_t> decompress_ns_;
+};
+
+static std::array<compress_stat, MESSAGE_END> compress_stats;
+
+static uint64_t ns_since(std::chrono::steady_clock::time_point begin) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count());
+}
+
+compress_codec str_to_compress_codec(const std::string &str) {
+  if (str == "lz4") {
+    return COMPRESS_LZ4;
+  } else if (str == "zstd") {
+    return COMPRESS_ZSTD;
+  } else {
+    return COMPRESS_NONE;
+  }
+}
+
+size_t frame_compress_bound(compress_codec codec, size_t size) {
+  switch (codec) {
+  case COMPRESS_LZ4:
+    return FRAME_COMPRESS_HEADER_SIZE + size_t(LZ4_compressBound(int(size)));
+  case COMPRESS_ZSTD:
+    return FRAME_COMPRESS_HEADER_SIZE + ZSTD_compressBound(size);
+  default:
+    return FRAME_COMPRESS_HEADER_SIZE + size;
+  }
+}
+
+size_t frame_compress(compress_codec codec, message_type id, const int8_t *data,
+                      size_t size, int8_t *out, size_t out_size) {
+  if (out_size < FRAME_COMPRESS_HEADER_SIZE) {
+    return 0;
+  }
+  auto begin = std::chrono::steady_clock::now();
+  char *dst = reinterpret_cast<char *>(out) + FRAME_COMPRESS_HEADER_SIZE;
+  size_t dst_size = out_size - FRAME_COMPRESS_HEADER_SIZE;
+  size_t n = 0;
+  switch (codec) {
+  case COMPRESS_LZ4: {
+    int r = LZ4_compress_default(reinterpret_cast<const char *>(data), dst,
+                                 int(size), int(dst_size));
+    n = r > 0 ? size_t(r) : 0;
+    break;
+  }
+  case COMPRESS_ZSTD: {
+    size_t r = ZSTD_compress(dst, dst_size, data, size, WAN_COMPRESS_ZSTD_LEVEL);
+    n = ZSTD_isError(r) ? 0 : r;
+    break;
+  }
+  default:
+    break;
+  }
+  if (n == 0) {
+    return 0;
+  }
+  out[0] = int8_t(codec);
+  uint64_t raw_size = boost::endian::native_to_little(uint64_t(size));
+  std::memcpy(out + 1, &raw_size, sizeof(raw_size));
+
+  compress_stat &stat = compress_stats[id];
+  stat.compress_count_.fetch_add(1, std::memory_order_relaxed);
+  stat.raw_bytes_.fetch_add(size, std::memory_order_relaxed);
+  stat.compressed_bytes_.fetch_add(FRAME_COMPRESS_HEADER_SIZE + n,
+                                   std::memory_order_relaxed);
+  stat.compress_ns_.fetch_add(ns_since(begin), std::memory_order_relaxed);
+  return FRAME_COMPRESS_HEADER_SIZE + n;
+}
+
+result<void> frame_decompress(message_type id, const int8_t *data, size_t size,
+                              byte_buffer &out) {
+  if (size_t(id) >= MESSAGE_END) {
+    return outcome::failure(EC::EC_MESSAGE_ID_ERROR);
+  }
+  if (size < FRAME_COMPRESS_HEADER_SIZE) {
+    return outcome::failure(EC::EC_MESSAGE_LENGTH_ERROR);
+  }
+  auto begin = std::chrono::steady_clock::now();
+  auto codec = compress_codec(data[0]);
+  uint64_t raw_size = 0;
+  std::memcpy(&raw_size, data + 1, sizeof(raw_size));
+  raw_size = boost::endian::little_to_native(raw_size);
+  if (raw_size > WAN_DECOMPRESS_MAX_BYTES) {
+    LOG(error) << "decompress message " << enum2str(id) << " raw size "
+               << raw_size << " exceeds the limit";
+    return outcome::failure(EC::EC_MESSAGE_LENGTH_ERROR);
+  }
+  const char *src =
+      reinterpret_cast<const char *>(data) + FRAME_COMPRESS_HEADER_SIZE;
+  size_t src_size = size - FRAME_COMPRESS_HEADER_SIZE;
+
+  out.reset();
+  out.resize_write_available_size(raw_size);
+  char *dst = reinterpret_cast<char *>(out.write_begin());
+  bool ok = false;
+  switch (codec) {
+  case COMPRESS_LZ4: {
+    int r = LZ4_decompress_safe(src, dst, int(src_size), int(raw_size));
+    ok = r >= 0 && uint64_t(r) == raw_size;
+    break;
+  }
+  case COMPRESS_ZSTD: {
+    size_t r = ZSTD_decompress(dst, raw_size, src, src_size);
+    ok = not ZSTD_isError(r) && r == raw_size;
+    break;
+  }
+  default:
+    break;
+  }
+  if (not ok) {
+    LOG(error) << "decompress message " << enum2str(id) << " error";
+    return outcome::failure(EC::EC_UNMARSHALL_ERROR);
+  }
+  out.set_write_pos(raw_size);
+
+  compress_stat &stat = compress_stats[id];
+  stat.decompress_count_.fetch_add(1, std::memory_order_relaxed);
+  stat.decompress_ns_.fetch_add(ns_since(begin), std::memory_order_relaxed);
+  return outcome::success();
+}
+
+void frame_compress_stats(std::ostream &os) {
+  for (size_t i = 0; i < compress_stats.size(); i++) {
+    const compress_stat &stat = compress_stats[i];
+    uint64_t count = stat.compress_count_.load();
+    uint64_t decompress_count = stat.decompress_count_.load();
+    if (count == 0 && decompress_count == 0) {
+      continue;
+    }
+    os << enum2str(message_type(i)) << ": compressed " << count;
+    if (count > 0) {
+      os << ", ratio "
+         << double(stat.raw_bytes_.load()) /
+                double(stat.compressed_bytes_.load())
+         << ", compress us/message "
+         << double(stat.compress_ns_.load()) / 1000.0 / double(count);
+    }
+    os << ", decompressed " << decompress_count;
+    if (decompress_count > 0) {
+      os << ", decompress us/message "
+         << double(stat.decompress_ns_.load()) / 1000.0 /
+                double(decompress_count);
+    }
+    os << std::endl;
+  }
+}
@@ -1,7 +1,9 @@
 #include "network/net_service.h"
 #include "common/logger.hpp"
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <pthread.h>
 #include <utility>
 
 template<>
@@ -11,22 +13,65 @@ enum_strings<service_type>::e2s_t enum_strings<service_type>::enum2str = {
     {SERVICE_CC, "CC"},
     {SERVICE_REPLICATION, "REPLICATION"}};
 
+metric_family<metric_counter, message_type, MESSAGE_END> messages_sent(
+    "tddb_messages_sent_total", "messages sent", "type");
+metric_family<metric_counter, message_type, MESSAGE_END> messages_received(
+    "tddb_messages_received_total", "messages received", "type");
+metric_family<metric_histogram, message_type, MESSAGE_END> message_handle_us(
+    "tddb_message_handle_microseconds",
+    "time to dispatch a received message to its block", "type");
+
 std::unordered_map<service_type, uint32_t> service_thread_num = {
     {SERVICE_ASYNC_CONTEXT, THREADS_ASYNC_CONTEXT},
     {SERVICE_IO, THREADS_IO},
     {SERVICE_CC, THREADS_CC},
     {SERVICE_REPLICATION, THREADS_REPLICATION}};
 
+static thread_local uint32_t this_core = CORE_NONE;
+
+static void set_thread_affinity(uint32_t cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (ret != 0) {
+    LOG(warning) << "set thread affinity to cpu " << cpu << " error " << ret;
+  }
+#endif
+}
+
 net_service::net_service(const config &conf)
-    : conf_(conf), started_(false), stopped_(false), thread_running_(0),
-      handler_(nullptr), local_handler_(nullptr) {
+    : conf_(conf), started_(false), stopped_(false),
+      send_coalesce_(conf_.get_block_config().send_coalesce()),
+      send_coalesce_delay_us_(
+          conf_.get_block_config().send_coalesce_delay_us()),
+      thread_per_core_(conf_.get_block_config().thread_per_core()),
+      num_cores_(0), next_core_(0),
+      shm_transport_(conf_.get_block_config().shm_transport()),
+      thread_running_(0), handler_(nullptr), local_handler_(nullptr) {
   for (const auto &c : conf.node_server_list()) {
     if (!c.is_client()) {
       peers_.insert(std::make_pair(c.node_id(), c));
     }
   }
 
+  if (thread_per_core_) {
+    num_cores_ = uint32_t(conf_.get_block_config().num_cores());
+    if (num_cores_ == 0) {
+      num_cores_ = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (uint32_t i = 0; i < num_cores_; i++) {
+      io_context_.push_back(std::make_unique<boost::asio::io_context>(1));
+      core_index_.insert(std::make_pair(&io_context_[i], i));
+    }
+    core_mailbox_.reset(new core_mailbox(num_cores_, CORE_MAILBOX_CAPACITY));
+  }
+
   for (auto &i : service_thread_num) {
+    if (thread_per_core_) {
+      break;
+    }
     uint32_t thread_num = 0;
     service_type service = i.first;
     switch (service) {
@@ -62,6 +107,18 @@ net_service::net_service(const config &conf)
     io_context_work_.push_back(boost::asio::make_work_guard(c));
     // make work guard must come ahead io_context::run()
   }
+
+  for (boost::asio::io_context &c : io_context_) {
+    timing_wheel_.insert(
+        std::make_pair(&c, cs_new<timing_wheel>(c, TIMING_WHEEL_TICK_US)));
+  }
+  // a link is delayed on one wheel, by the zone of the link
+  shaper_.reset(new net_shaper(conf_, [this](az_id_t az_id) -> timing_wheel & {
+    return get_timing_wheel(get_service(SERVICE_ASYNC_CONTEXT, az_id));
+  }));
+  if (shaper_->empty()) {
+    shaper_.reset();
+  }
 }
 
 net_service::~net_service() = default;
@@ -74,7 +131,12 @@ void net_service::start() {
     return;
   }
 
-  for (size_t i = 0; i < io_context_.size(); i++) {
+  for (uint32_t i = 0; i < num_cores_; i++) {
+    boost::thread *thd =
+        thread_group_.create_thread([this, i] { core_thread(i); });
+    threads_.push_back(thd);
+  }
+  for (size_t i = 0; i < io_context_threads_.size(); i++) {
     service_type service = io_context_threads_[i].first;
     uint32_t thread_num = io_context_threads_[i].second;
     for (size_t j = 0; j < thread_num; j++) {
@@ -92,6 +154,8 @@ void net_service::start() {
         l, [this] { return this->thread_running_ == thread_group_.size(); });
   }
   uint64_t connections = conf_.get_block_config().connections_per_peer();
+  compress_codec wan_compress =
+      str_to_compress_codec(conf_.get_block_config().wan_compress());
 
   for (const auto &kv : peers_) {
     boost::asio::io_context::strand s(get_service(SERVICE_ASYNC_CONTEXT));
@@ -100,17 +164,29 @@ void net_service::start() {
     std::vector<ptr<client>> clients;
     std::string address = p.address_public_or_private(conf_.az_id());
     node_peer peer(p.node_id(), address, p.port());
+    // the peers in other AZs are reached by WAN links
+    bool wan =
+        p.az_id() != 0 && conf_.az_id() != 0 && p.az_id() != conf_.az_id();
     for (size_t i = 0; i < connections; i++) {
       ptr<client> cli = std::make_shared<client>(s, peer);
+      if (wan) {
+        cli->set_compress(wan_compress,
+                          conf_.get_block_config().wan_compress_min_bytes());
+      }
       clients.push_back(cli);
     }
 
     out_coming_conn_.insert(std::make_pair(id, clients));
+    peer_send_queue_.insert(std::make_pair(id, cs_new<peer_send_queue>()));
     for (auto cli : clients) {
       async_client_connect(cli);
     }
   }
 
+  if (shm_transport_) {
+    shm_start();
+  }
+
   // call on_start callback of all blocks
   for (auto b : blocks_) {
     b->on_start();
@@ -129,6 +205,17 @@ void net_service::join() {
       c->close();
     }
   }
+  {
+    std::scoped_lock l(shm_in_mutex_);
+    for (const auto &in : shm_in_) {
+      if (in.second) {
+        in.second->close();
+      }
+    }
+  }
+  for (const auto &kv : timing_wheel_) {
+    kv.second->stop();
+  }
 
   // io_service::cancel_and_join must be called in from another thread
   // (not io_context::run thread)
@@ -150,6 +237,10 @@ void net_service::join() {
 
   threads_.clear();
   out_coming_conn_.clear();
+  {
+    std::scoped_lock l(shm_in_mutex_);
+    shm_in_.clear();
+  }
   LOG(info) << id_2_name(conf_.node_id()) << " stopped ...";
 }
 
@@ -165,15 +256,349 @@ result<ptr<client>> net_service::get_connection(uint32_t id) {
   }
 }
 
+void net_service::flush(node_id_t node_id) {
+  auto iter = peer_send_queue_.find(node_id);
+  if (iter != peer_send_queue_.end()) {
+    schedule_flush(node_id, iter->second, 0);
+  }
+}
+
+timing_wheel &net_service::get_timing_wheel(boost::asio::io_context &context) {
+  auto iter = timing_wheel_.find(&context);
+  if (iter == timing_wheel_.end()) {
+    PANIC("not a context of net_service");
+  }
+  return *iter->second;
+}
+
+// the name of the ring read by the node listening on port, and written by
+// node_id
+static std::string shm_ring_name(uint32_t port, node_id_t node_id) {
+  return "/tddb_" + std::to_string(port) + "_" + std::to_string(node_id);
+}
+
+void net_service::shm_start() {
+  const node_config &self = conf_.this_node_config();
+  const std::string &address = self.address_public_or_private(conf_.az_id());
+  for (const auto &kv : peers_) {
+    const node_config &p = kv.second;
+    if (p.node_id() == conf_.node_id() ||
+        p.address_public_or_private(conf_.az_id()) != address) {
+      continue;
+    }
+    auto peer = cs_new<shm_peer>();
+    peer->name_ = shm_ring_name(p.port(), conf_.node_id());
+    shm_out_.insert(std::make_pair(p.node_id(), peer));
+
+    std::string name = shm_ring_name(self.port(), p.node_id());
+    auto r = shm_ring::create(name, SHM_RING_BYTES);
+    if (not r) {
+      LOG(error) << "cannot create shared memory ring from "
+                 << id_2_name(p.node_id());
+      continue;
+    }
+    size_t i = shm_in_.size();
+    shm_in_.push_back(std::make_pair(name, r.value()));
+    boost::thread *thd =
+        thread_group_.create_thread([this, i] { shm_receive(i); });
+    threads_.push_back(thd);
+  }
+}
+
+bool net_service::shm_open_peer(const ptr<shm_peer> &peer) {
+  uint64_t now_ms = steady_clock_ms_since_epoch();
+  if (peer->ring_) {
+    if (now_ms < peer->check_after_ms_) {
+      return true;
+    }
+    peer->check_after_ms_ = now_ms + SHM_RING_CHECK_MILLIS;
+    if (peer->ring_->is_current()) {
+      return true;
+    }
+    // the peer has crashed without closing the ring, the messages written
+    // to it are lost
+    LOG(warning) << "shared memory ring " << peer->name_
+                 << " is orphaned, open it again";
+    peer->ring_.reset();
+    peer->open_after_ms_ = 0;
+  }
+  if (now_ms < peer->open_after_ms_) {
+    return false;
+  }
+  auto r = shm_ring::open(peer->name_);
+  if (not r) {
+    peer->open_after_ms_ = now_ms + SHM_RING_RETRY_MILLIS;
+    return false;
+  }
+  peer->ring_ = r.value();
+  peer->check_after_ms_ = now_ms + SHM_RING_CHECK_MILLIS;
+  return true;
+}
+
+void net_service::shm_drain(const ptr<shm_peer> &peer) {
+  uint64_t now_ms = steady_clock_ms_since_epoch();
+  while (not peer->backlog_.empty()) {
+    uint64_t offset = peer->offset_;
+    result<void> r =
+        peer->ring_->write_from(peer->backlog_.front().data_, peer->offset_);
+    if (peer->offset_ != offset) {
+      peer->progress_ms_ = now_ms;
+    }
+    if (r) {
+      peer->backlog_.pop_front();
+      peer->offset_ = 0;
+      continue;
+    }
+    if (r.error().code() == EC_INSUFFICIENT_SPACE) {
+      if (now_ms < peer->progress_ms_ + SHM_RING_STALL_MILLIS) {
+        shm_schedule_drain(peer);
+        return;
+      }
+      LOG(warning) << "shared memory ring " << peer->name_
+                   << " is stalled, send " << peer->backlog_.size()
+                   << " messages by TCP";
+      if (peer->offset_ > 0) {
+        // the records written of a message must not be followed by another
+        // message, the peer creates the ring again
+        peer->ring_->close();
+      }
+    } else {
+      LOG(warning) << "shared memory ring " << peer->name_
+                   << " is closed, send " << peer->backlog_.size()
+                   << " messages by TCP";
+    }
+    // the messages after the backlog are sent by TCP until the ring is
+    // opened again
+    for (const shm_pending &pending : peer->backlog_) {
+      pending.send_tcp_();
+    }
+    peer->backlog_.clear();
+    peer->offset_ = 0;
+    peer->ring_.reset();
+    peer->open_after_ms_ = now_ms + SHM_RING_RETRY_MILLIS;
+    return;
+  }
+}
+
+void net_service::shm_schedule_drain(const ptr<shm_peer> &peer) {
+  if (peer->drain_scheduled_) {
+    return;
+  }
+  peer->drain_scheduled_ = true;
+  auto s = shared_from_this();
+  ptr<boost::asio::steady_timer> timer(
+      new boost::asio::steady_timer(get_service(SERVICE_ASYNC_CONTEXT)));
+  timer->expires_after(std::chrono::microseconds(SHM_RING_DRAIN_MICROS));
+  timer->async_wait([s, timer, peer](const boost::system::error_code &ec) {
+    std::scoped_lock l(peer->mutex_);
+    peer->drain_scheduled_ = false;
+    if (not ec.failed() && not s->stopped_.load()) {
+      s->shm_drain(peer);
+    }
+  });
+}
+
+void net_service::shm_receive(size_t i) {
+  set_thread_name(conf_.node_debug_name() + "S");
+  ptr<shm_ring> ring;
+  std::string name;
+  {
+    std::scoped_lock l(shm_in_mutex_);
+    name = shm_in_[i].first;
+    ring = shm_in_[i].second;
+  }
+  // the messages of the ring are handled in order, as those of a connection
+  auto strand = std::make_shared<boost::asio::io_context::strand>(
+      get_service(SERVICE_IO));
+  auto s = shared_from_this();
+  while (not stopped_.load()) {
+    if (not ring) {
+      // the ring was closed, the writer opens the one created again
+      {
+        std::scoped_lock l(shm_in_mutex_);
+        if (stopped_.load()) {
+          break;
+        }
+        auto r = shm_ring::create(name, SHM_RING_BYTES);
+        if (r) {
+          ring = r.value();
+          shm_in_[i].second = ring;
+        }
+      }
+      if (not ring) {
+        LOG(error) << "cannot create shared memory ring " << name;
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(SHM_RING_RETRY_MILLIS));
+      }
+      continue;
+    }
+    auto buffer = std::make_shared<byte_buffer>(size_t(0));
+    msg_hdr hdr;
+    result<void> r = ring->read(*buffer, hdr);
+    if (not r) {
+      if (stopped_.load()) {
+        break;
+      }
+      LOG(warning) << "read shared memory ring " << name << " error "
+                   << r.error().message() << ", create it again";
+      // the old segment is removed before the new one is created
+      {
+        std::scoped_lock l(shm_in_mutex_);
+        shm_in_[i].second.reset();
+      }
+      ring.reset();
+      continue;
+    }
+    if (handler_) {
+      // the messages between blocks are handled without a connection, as
+      // the messages sent locally
+      boost::asio::post(*strand, [s, buffer, hdr]() mutable {
+        auto rh = s->handler_(nullptr, hdr.type(), *buffer, &hdr);
+        if (not rh) {
+          LOG(error) << "handle message " << enum2str(hdr.type()) << " error "
+                     << rh.error().message();
+        }
+      });
+    }
+  }
+}
+
+void net_service::coalesce_send(node_id_t node_id,
+                                const ptr<peer_send_queue> &queue,
+                                fn_client_send fn) {
+  bool schedule = false;
+  {
+    std::scoped_lock l(queue->mutex_);
+    queue->pending_.push_back(std::move(fn));
+    if (not queue->flush_scheduled_) {
+      queue->flush_scheduled_ = true;
+      schedule = true;
+    }
+  }
+  if (schedule) {
+    schedule_flush(node_id, queue, send_coalesce_delay_us_);
+  }
+}
+
+void net_service::schedule_flush(node_id_t node_id,
+                                 const ptr<peer_send_queue> &queue,
+                                 uint64_t delay_us) {
+  result<ptr<client>> r = get_connection(node_id);
+  if (not r) {
+    // no flush would run, the buffered messages are dropped as a message
+    // sent without a connection, and the next message schedules a flush
+    size_t dropped = 0;
+    {
+      std::scoped_lock l(queue->mutex_);
+      dropped = queue->pending_.size();
+      queue->pending_.clear();
+      queue->flush_scheduled_ = false;
+    }
+    LOG(error) << " cannot find connection to " << id_2_name(node_id) << " "
+               << r.error() << ", drop " << dropped << " messages";
+    return;
+  }
+  auto s = shared_from_this();
+  // the client is written on its own strand only
+  ptr<client> c = r.value();
+  const boost::asio::io_context::strand &strand = c->get_strand();
+  auto fn = [s, c, queue]() { s->flush_peer(c, queue); };
+  if (delay_us == 0) {
+    // flushed after the handlers posted to the strand ahead of it
+    boost::asio::post(strand, fn);
+  } else {
+    ptr<boost::asio::steady_timer> timer(
+        new boost::asio::steady_timer(strand.context()));
+    timer->expires_after(std::chrono::microseconds(delay_us));
+    timer->async_wait(boost::asio::bind_executor(
+        strand, [timer, fn](const boost::system::error_code &ec) {
+          if (not ec.failed()) {
+            fn();
+          }
+        }));
+  }
+}
+
+void net_service::flush_peer(const ptr<client> &c,
+                             const ptr<peer_send_queue> &queue) {
+  std::vector<fn_client_send> pending;
+  {
+    std::scoped_lock l(queue->mutex_);
+    pending.swap(queue->pending_);
+    queue->flush_scheduled_ = false;
+  }
+  if (pending.empty()) {
+    return;
+  }
+  bool unconnected = false;
+  // one frame per message, the frames are written by one gather write
+  c->hold_write();
+  for (const fn_client_send &fn : pending) {
+    result<void> sr = fn(c);
+    if (sr.has_failure() && sr.error().code() == EC_NET_UNCONNECTED) {
+      unconnected = true;
+    }
+  }
+  c->release_write();
+  if (unconnected) {
+    async_client_connect(c);
+  }
+}
+
 void net_service::async_client_connect(const ptr<client> &client) {
   auto s = shared_from_this();
   this->resolve_connect(client);
 }
 
 boost::asio::io_context &net_service::get_service(service_type type) {
+  if (thread_per_core_) {
+    // spread the strands, timers and connections over the cores
+    return io_context_[next_core_.fetch_add(1) % num_cores_];
+  }
   return io_context_[uint64_t(type)];
 }
 
+boost::asio::io_context &net_service::get_service(service_type type,
+                                                  uint64_t key) {
+  if (thread_per_core_) {
+    return io_context_[key % num_cores_];
+  }
+  return get_service(type);
+}
+
+uint32_t net_service::current_core() { return this_core; }
+
+void net_service::core_post(boost::asio::io_context &context,
+                            std::function<void()> fn) {
+  auto iter = core_index_.find(&context);
+  uint32_t from = current_core();
+  if (iter == core_index_.end() || from == CORE_NONE || from == iter->second) {
+    boost::asio::post(context, std::move(fn));
+    return;
+  }
+  uint32_t to = iter->second;
+  core_mailbox *mailbox = core_mailbox_.get();
+  if (not mailbox->overflowed(from, to)) {
+    if (mailbox->push(from, to, fn)) {
+      if (mailbox->schedule_drain(to)) {
+        boost::asio::post(context, [mailbox, to] { mailbox->drain(to); });
+      }
+      return;
+    }
+    // the queue is full, a drain is posted ahead of fn if none is pending,
+    // the tasks queued before fn run first
+    if (mailbox->schedule_drain(to)) {
+      boost::asio::post(context, [mailbox, to] { mailbox->drain(to); });
+    }
+  }
+  // fn and the tasks after it are posted in order, until they all run
+  mailbox->begin_overflow(from, to);
+  boost::asio::post(context, [mailbox, from, to, fn = std::move(fn)] {
+    mailbox->end_overflow(from, to);
+    fn();
+  });
+}
+
 void net_service::register_block(block *block) { blocks_.push_back(block); }
 
 void net_service::service_thread(service_type st, size_t n) {
@@ -193,6 +618,25 @@ void net_service::service_thread(service_type st, size_t n) {
   io_context_[uint32_t(st)].run();
 }
 
+void net_service::core_thread(uint32_t core) {
+  std::string name = conf_.node_debug_name();
+  name += "C";
+  name += std::to_string(core);
+
+  {
+    std::lock_guard<std::mutex> l(condition_mutex_);
+    ++thread_running_;
+    if (thread_running_ == thread_group_.size()) {
+      condition_variable_.notify_all();
+    }
+  }
+  LOG(trace) << "thread running " << name;
+  set_thread_name(name);
+  set_thread_affinity(core % std::max(std::thread::hardware_concurrency(), 1u));
+  this_core = core;
+  io_context_[core].run();
+}
+
 void net_service::register_handler(message_handler handler) {
   handler_ = handler;
 }
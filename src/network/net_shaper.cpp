@@ -0,0 +1,75 @@
+#include "network/net_shaper.h"
+#include "common/logger.hpp"
+#include "common/utils.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+net_shaper::net_shaper(
+    const config &conf,
+    const std::function<timing_wheel &(az_id_t)> &wheel_of) {
+  std::map<std::string, az_id_t> zones;
+  for (const node_config &c : conf.node_server_list()) {
+    zones.insert(std::make_pair(c.az_name(), c.az_id()));
+  }
+  for (const node_config &c : conf.node_client_list()) {
+    zones.insert(std::make_pair(c.az_name(), c.az_id()));
+  }
+  const std::string &zone = conf.this_node_config().az_name();
+  const test_config &test = conf.get_test_config();
+  for (const net_link_shaping &s : test.net_shaping()) {
+    if (s.from_zone_ != zone) {
+      continue;
+    }
+    auto iter = zones.find(s.to_zone_);
+    if (iter == zones.end()) {
+      LOG(warning) << "net shaping to unknown zone " << s.to_zone_;
+      continue;
+    }
+    auto l = cs_new<link>();
+    l->latency_us_ = uint64_t(s.latency_ms_) * 1000;
+    l->jitter_us_ = uint64_t(std::min(s.jitter_ms_, s.latency_ms_)) * 1000;
+    l->bandwidth_mbps_ = s.bandwidth_mbps_;
+    l->wheel_ = &wheel_of(iter->second);
+    links_[iter->second] = l;
+  }
+  // the zone pairs not in the matrix have the WAN latency of test config
+  if (test.debug_add_wan_latency_ms() > 0) {
+    for (const auto &kv : zones) {
+      if (kv.first == zone || links_.contains(kv.second)) {
+        continue;
+      }
+      auto l = cs_new<link>();
+      l->latency_us_ = uint64_t(test.debug_add_wan_latency_ms()) * 1000;
+      l->wheel_ = &wheel_of(kv.second);
+      links_[kv.second] = l;
+    }
+  }
+}
+
+bool net_shaper::shape(node_id_t node_id, uint64_t bytes,
+                       std::function<void()> fn) {
+  auto iter = links_.find(TO_AZ_ID(node_id));
+  if (iter == links_.end()) {
+    return false;
+  }
+  link &l = *iter->second;
+  uint64_t latency_us = l.latency_us_;
+  if (l.jitter_us_ > 0) {
+    static thread_local std::mt19937_64 generator(std::random_device{}());
+    std::uniform_int_distribution<uint64_t> distribution(0, l.jitter_us_ * 2);
+    latency_us = latency_us - l.jitter_us_ + distribution(generator);
+  }
+  uint64_t now_us = steady_clock_us_since_epoch();
+  std::scoped_lock lock(l.mutex_);
+  uint64_t sent_us = now_us;
+  if (l.bandwidth_mbps_ > 0) {
+    // one megabit per second transmits one bit per microsecond
+    sent_us = std::max(now_us, l.busy_until_us_) + bytes * 8 / l.bandwidth_mbps_;
+    l.busy_until_us_ = sent_us;
+  }
+  uint64_t deliver_us = std::max(sent_us + latency_us, l.last_deliver_us_);
+  l.last_deliver_us_ = deliver_us;
+  l.wheel_->schedule_at(deliver_us, std::move(fn));
+  return true;
+}
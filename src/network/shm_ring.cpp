@@ -0,0 +1,330 @@
+#include "network/shm_ring.h"
+#include "common/logger.hpp"
+#include "common/variable.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+const uint64_t SHM_RING_MAGIC = 0x74646462726e6731;
+const uint64_t SHM_RECORD_SKIP = UINT64_MAX;
+// flagged in the length of a record followed by the other records of its
+// message
+const uint64_t SHM_RECORD_MORE = uint64_t(1) << 62;
+const uint64_t SHM_RECORD_LENGTH_SIZE = sizeof(uint64_t);
+
+static uint64_t record_size(uint64_t length) {
+  return (SHM_RECORD_LENGTH_SIZE + length + 7) & ~uint64_t(7);
+}
+
+// the segment is shared by processes, FUTEX_PRIVATE_FLAG must not be set
+static void futex_wait(std::atomic<uint32_t> *addr, uint32_t value,
+                       uint64_t timeout_ms) {
+  struct timespec ts;
+  ts.tv_sec = time_t(timeout_ms / 1000);
+  ts.tv_nsec = long(timeout_ms % 1000) * 1000000;
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT, value,
+          &ts, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t> *addr) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+shm_ring::shm_ring(const std::string &name, bool owner, size_t map_size,
+                   ring_header *header)
+    : name_(name), owner_(owner), map_size_(map_size), header_(header),
+      data_(reinterpret_cast<int8_t *>(header) + sizeof(ring_header)),
+      generation_(header->generation_), capacity_(header->capacity_),
+      spin_(std::thread::hardware_concurrency() > 1 ? SHM_RING_SPIN : 0) {}
+
+shm_ring::~shm_ring() {
+  if (owner_) {
+    close();
+    shm_unlink(name_.c_str());
+  }
+  munmap(header_, map_size_);
+}
+
+result<ptr<shm_ring>> shm_ring::create(const std::string &name,
+                                       uint64_t capacity) {
+  capacity = (capacity + 7) & ~uint64_t(7);
+  // a segment left by a crashed process
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    LOG(error) << "create shared memory " << name << " error "
+               << strerror(errno);
+    return outcome::failure(EC::EC_SYSTEM_ERROR);
+  }
+  size_t map_size = sizeof(ring_header) + capacity;
+  if (ftruncate(fd, off_t(map_size)) != 0) {
+    LOG(error) << "truncate shared memory " << name << " error "
+               << strerror(errno);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return outcome::failure(EC::EC_SYSTEM_ERROR);
+  }
+  void *p = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return outcome::failure(EC::EC_SYSTEM_ERROR);
+  }
+  auto header = new (p) ring_header();
+  header->generation_ = uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  header->capacity_ = capacity;
+  header->closed_.store(0);
+  header->write_pos_.store(0);
+  header->write_seq_.store(0);
+  header->reader_waiting_.store(0);
+  header->read_pos_.store(0);
+  header->read_seq_.store(0);
+  header->writer_waiting_.store(0);
+  // the writer opens the segment only after magic is set
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic_ = SHM_RING_MAGIC;
+  return outcome::success(
+      ptr<shm_ring>(new shm_ring(name, true, map_size, header)));
+}
+
+result<ptr<shm_ring>> shm_ring::open(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return outcome::failure(EC::EC_NET_UNCONNECTED);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) <= sizeof(ring_header)) {
+    ::close(fd);
+    return outcome::failure(EC::EC_NET_UNCONNECTED);
+  }
+  size_t map_size = size_t(st.st_size);
+  void *p = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    return outcome::failure(EC::EC_SYSTEM_ERROR);
+  }
+  auto header = reinterpret_cast<ring_header *>(p);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic_ != SHM_RING_MAGIC || header->closed_.load() != 0 ||
+      header->capacity_ + sizeof(ring_header) != map_size) {
+    munmap(p, map_size);
+    return outcome::failure(EC::EC_NET_UNCONNECTED);
+  }
+  return outcome::success(
+      ptr<shm_ring>(new shm_ring(name, false, map_size, header)));
+}
+
+bool shm_ring::is_current() const {
+  int fd = shm_open(name_.c_str(), O_RDONLY, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  uint64_t generation = 0;
+  ssize_t n = pread(fd, &generation, sizeof(generation),
+                    off_t(offsetof(ring_header, generation_)));
+  ::close(fd);
+  return n == ssize_t(sizeof(generation)) && generation == generation_;
+}
+
+void shm_ring::close() {
+  header_->closed_.store(1);
+  header_->write_seq_.fetch_add(1);
+  futex_wake(&header_->write_seq_);
+  header_->read_seq_.fetch_add(1);
+  futex_wake(&header_->read_seq_);
+}
+
+result<void> shm_ring::reserve(uint64_t length, bool more, int8_t **p,
+                               bool wait) {
+  uint64_t write_pos = header_->write_pos_.load(std::memory_order_relaxed);
+  uint64_t offset = write_pos % capacity_;
+  uint64_t size = record_size(length);
+  // the bytes to the ring end are skipped when the record does not fit
+  uint64_t skip = capacity_ - offset < size ? capacity_ - offset : 0;
+  uint64_t spin = 0;
+  uint64_t progress_pos = UINT64_MAX;
+  auto progress_time = std::chrono::steady_clock::now();
+  while (true) {
+    if (header_->closed_.load() != 0) {
+      return outcome::failure(EC::EC_NET_UNCONNECTED);
+    }
+    uint64_t read_pos = header_->read_pos_.load(std::memory_order_acquire);
+    if (capacity_ - (write_pos - read_pos) >= skip + size) {
+      break;
+    }
+    if (spin < spin_) {
+      spin++;
+      continue;
+    }
+    if (not wait) {
+      return outcome::failure(EC::EC_INSUFFICIENT_SPACE);
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (read_pos != progress_pos) {
+      progress_pos = read_pos;
+      progress_time = now;
+    } else if (now - progress_time >=
+               std::chrono::milliseconds(SHM_RING_STALL_MILLIS)) {
+      return outcome::failure(EC::EC_INSUFFICIENT_SPACE);
+    }
+    uint32_t seq = header_->read_seq_.load();
+    header_->writer_waiting_.store(1);
+    if (header_->read_pos_.load() == read_pos) {
+      futex_wait(&header_->read_seq_, seq, SHM_RING_WAIT_MILLIS);
+    }
+    header_->writer_waiting_.store(0);
+  }
+  if (skip > 0) {
+    std::memcpy(data_ + offset, &SHM_RECORD_SKIP, SHM_RECORD_LENGTH_SIZE);
+    header_->write_pos_.store(write_pos + skip, std::memory_order_release);
+    offset = 0;
+  }
+  uint64_t flagged = more ? length | SHM_RECORD_MORE : length;
+  std::memcpy(data_ + offset, &flagged, SHM_RECORD_LENGTH_SIZE);
+  *p = data_ + offset + SHM_RECORD_LENGTH_SIZE;
+  return outcome::success();
+}
+
+result<void> shm_ring::write_split(const std::string &data, bool wait) {
+  uint64_t max = max_record_size();
+  for (uint64_t offset = 0; offset < data.size(); offset += max) {
+    uint64_t length = std::min<uint64_t>(max, data.size() - offset);
+    bool more = offset + length < data.size();
+    int8_t *p = nullptr;
+    // the records after the first are always waited for
+    result<void> r = reserve(length, more, &p, wait || offset > 0);
+    if (not r) {
+      if (offset > 0 && r.error().code() != EC::EC_NET_UNCONNECTED) {
+        // the reader stalls in the middle of the message, the records
+        // written must not be followed by another message
+        LOG(warning) << "shared memory ring " << name_
+                     << " stalls in a split message, close it";
+        close();
+        return outcome::failure(EC::EC_NET_UNCONNECTED);
+      }
+      return r;
+    }
+    std::memcpy(p, data.data() + offset, length);
+    commit(length);
+  }
+  return outcome::success();
+}
+
+result<void> shm_ring::write_from(const std::string &data, uint64_t &offset) {
+  uint64_t max = max_record_size();
+  while (offset < data.size()) {
+    uint64_t length = std::min<uint64_t>(max, data.size() - offset);
+    bool more = offset + length < data.size();
+    int8_t *p = nullptr;
+    result<void> r = reserve(length, more, &p, false);
+    if (not r) {
+      return r;
+    }
+    std::memcpy(p, data.data() + offset, length);
+    commit(length);
+    offset += length;
+  }
+  return outcome::success();
+}
+
+void shm_ring::commit(uint64_t length) {
+  uint64_t write_pos = header_->write_pos_.load(std::memory_order_relaxed);
+  header_->write_pos_.store(write_pos + record_size(length));
+  if (header_->reader_waiting_.load() != 0) {
+    header_->write_seq_.fetch_add(1);
+    futex_wake(&header_->write_seq_);
+  }
+}
+
+result<void> shm_ring::read(byte_buffer &buffer, msg_hdr &hdr) {
+  uint64_t read_pos = header_->read_pos_.load(std::memory_order_relaxed);
+  uint64_t spin = 0;
+  auto consume = [this, &read_pos](uint64_t length) {
+    read_pos += record_size(length);
+    header_->read_pos_.store(read_pos);
+    if (header_->writer_waiting_.load() != 0) {
+      header_->read_seq_.fetch_add(1);
+      futex_wake(&header_->read_seq_);
+    }
+  };
+  auto set_message = [&buffer, &hdr](const int8_t *p, uint64_t length) {
+    std::memcpy(static_cast<void *>(&hdr), p, msg_hdr::size());
+    uint64_t body_size = length - msg_hdr::size();
+    buffer.reset();
+    buffer.resize_write_available_size(body_size);
+    std::memcpy(buffer.write_begin(), p + msg_hdr::size(), body_size);
+    buffer.set_write_pos(body_size);
+  };
+  while (true) {
+    // the messages not read are dropped after the ring is closed
+    if (header_->closed_.load() != 0) {
+      fragment_.clear();
+      return outcome::failure(EC::EC_NET_UNCONNECTED);
+    }
+    uint64_t write_pos = header_->write_pos_.load(std::memory_order_acquire);
+    if (write_pos != read_pos) {
+      uint64_t offset = read_pos % capacity_;
+      uint64_t length = 0;
+      std::memcpy(&length, data_ + offset, SHM_RECORD_LENGTH_SIZE);
+      if (length == SHM_RECORD_SKIP) {
+        read_pos += capacity_ - offset;
+        header_->read_pos_.store(read_pos);
+        continue;
+      }
+      bool more = (length & SHM_RECORD_MORE) != 0;
+      length &= ~SHM_RECORD_MORE;
+      if (length == 0 || length > max_record_size()) {
+        return outcome::failure(EC::EC_MESSAGE_LENGTH_ERROR);
+      }
+      const int8_t *p = data_ + offset + SHM_RECORD_LENGTH_SIZE;
+      if (not more && fragment_.empty()) {
+        if (length < msg_hdr::size()) {
+          return outcome::failure(EC::EC_MESSAGE_LENGTH_ERROR);
+        }
+        set_message(p, length);
+        consume(length);
+        break;
+      }
+      // a record of a split message
+      fragment_.append(reinterpret_cast<const char *>(p), length);
+      consume(length);
+      if (more) {
+        spin = 0;
+        continue;
+      }
+      if (fragment_.size() < msg_hdr::size()) {
+        fragment_.clear();
+        return outcome::failure(EC::EC_MESSAGE_LENGTH_ERROR);
+      }
+      set_message(reinterpret_cast<const int8_t *>(fragment_.data()),
+                  fragment_.size());
+      fragment_.clear();
+      break;
+    }
+    if (spin < spin_) {
+      spin++;
+      continue;
+    }
+    uint32_t seq = header_->write_seq_.load();
+    header_->reader_waiting_.store(1);
+    if (header_->write_pos_.load() == read_pos) {
+      futex_wait(&header_->write_seq_, seq, SHM_RING_WAIT_MILLIS);
+    }
+    header_->reader_waiting_.store(0);
+  }
+  return outcome::success();
+}
@@ -0,0 +1,292 @@
+#include "network/timing_wheel.h"
+#include "common/utils.h"
+#include <algorithm>
+#include <bit>
+
+wheel_timer::wheel_timer()
+    : prev_(nullptr), next_(nullptr), tick_(0), level_(0), slot_(0),
+      wheel_(nullptr), owned_(false) {}
+
+wheel_timer::~wheel_timer() { cancel(); }
+
+bool wheel_timer::cancel() {
+  timing_wheel *wheel = wheel_.load();
+  if (wheel == nullptr) {
+    return false;
+  }
+  return wheel->cancel(this);
+}
+
+// the first set bit of bitmap at or after from, cyclically
+static uint32_t find_next_set(const std::array<uint64_t, 4> &bitmap,
+                              uint32_t from) {
+  for (uint32_t n = 0; n <= bitmap.size(); n++) {
+    uint32_t word = (from / 64 + n) % bitmap.size();
+    uint64_t bits = bitmap[word];
+    if (n == 0) {
+      bits &= ~uint64_t(0) << (from % 64);
+    } else if (n == bitmap.size()) {
+      // back to the word of from, the bits before from
+      bits &= (uint64_t(1) << (from % 64)) - 1;
+    }
+    if (bits != 0) {
+      return word * 64 + uint32_t(std::countr_zero(bits));
+    }
+  }
+  return UINT32_MAX;
+}
+
+timing_wheel::timing_wheel(boost::asio::io_context &context, uint64_t tick_us)
+    : context_(context), timer_(context), tick_us_(std::max(tick_us, 1ul)),
+      levels_(), current_tick_(0), armed_tick_(UINT64_MAX), size_(0),
+      stopped_(false) {
+  static_assert(WHEEL_SLOTS / 64 == 4);
+}
+
+bool timing_wheel::arm_at(wheel_timer &node, uint64_t deadline_us,
+                          std::function<void()> fn) {
+  timing_wheel *other = node.wheel_.load();
+  if (other != nullptr && other != this) {
+    node.cancel();
+  }
+  uint64_t tick = (deadline_us + tick_us_ - 1) / tick_us_;
+  std::function<void()> old_fn;
+  std::unique_lock l(mutex_);
+  if (stopped_) {
+    return false;
+  }
+  if (node.wheel_.load() == this) {
+    unlink(&node);
+    size_--;
+    old_fn = std::move(node.fn_);
+  }
+  if (size_ == 0) {
+    // the ticks passed while the wheel is empty have nothing to expire
+    current_tick_ =
+        std::max(current_tick_, steady_clock_us_since_epoch() / tick_us_);
+  }
+  node.fn_ = std::move(fn);
+  node.wheel_.store(this);
+  link(&node, tick);
+  size_++;
+  arm_timer(next_event_tick());
+  l.unlock();
+  return true;
+}
+
+void timing_wheel::arm_after(wheel_timer &node, uint64_t delay_us,
+                             std::function<void()> fn) {
+  arm_at(node, steady_clock_us_since_epoch() + delay_us, std::move(fn));
+}
+
+void timing_wheel::schedule_at(uint64_t deadline_us, std::function<void()> fn) {
+  auto node = new wheel_timer();
+  node->owned_ = true;
+  // once linked, the node is freed by the thread firing it, it must not be
+  // touched here
+  if (not arm_at(*node, deadline_us, std::move(fn))) {
+    // stopped
+    delete node;
+  }
+}
+
+void timing_wheel::schedule_after(uint64_t delay_us, std::function<void()> fn) {
+  schedule_at(steady_clock_us_since_epoch() + delay_us, std::move(fn));
+}
+
+void timing_wheel::stop() {
+  std::vector<std::function<void()>> dropped;
+  std::vector<wheel_timer *> owned;
+  {
+    std::scoped_lock l(mutex_);
+    stopped_ = true;
+    for (wheel_level &level : levels_) {
+      for (slot_list &list : level.slots_) {
+        while (list.head_ != nullptr) {
+          wheel_timer *node = list.head_;
+          unlink(node);
+          node->wheel_.store(nullptr);
+          dropped.push_back(std::move(node->fn_));
+          if (node->owned_) {
+            owned.push_back(node);
+          }
+        }
+      }
+    }
+    size_ = 0;
+    armed_tick_ = UINT64_MAX;
+    timer_.cancel();
+  }
+  for (wheel_timer *node : owned) {
+    delete node;
+  }
+}
+
+uint64_t timing_wheel::size() {
+  std::scoped_lock l(mutex_);
+  return size_;
+}
+
+void timing_wheel::link(wheel_timer *node, uint64_t tick) {
+  tick = std::max(tick, current_tick_);
+  // the lowest level on which tick and the current tick share the higher
+  // bits, the ticks beyond the top level wait in the top level slots
+  uint32_t level = 0;
+  while (level + 1 < WHEEL_LEVELS &&
+         ((tick ^ current_tick_) >> (WHEEL_SLOT_BITS * (level + 1))) != 0) {
+    level++;
+  }
+  uint32_t slot =
+      uint32_t(tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+  node->tick_ = tick;
+  node->level_ = level;
+  node->slot_ = slot;
+  slot_list &list = levels_[level].slots_[slot];
+  node->prev_ = list.tail_;
+  node->next_ = nullptr;
+  if (list.tail_ != nullptr) {
+    list.tail_->next_ = node;
+  } else {
+    list.head_ = node;
+    levels_[level].occupied_[slot / 64] |= uint64_t(1) << (slot % 64);
+  }
+  list.tail_ = node;
+}
+
+void timing_wheel::unlink(wheel_timer *node) {
+  wheel_level &level = levels_[node->level_];
+  slot_list &list = level.slots_[node->slot_];
+  if (node->prev_ != nullptr) {
+    node->prev_->next_ = node->next_;
+  } else {
+    list.head_ = node->next_;
+  }
+  if (node->next_ != nullptr) {
+    node->next_->prev_ = node->prev_;
+  } else {
+    list.tail_ = node->prev_;
+  }
+  node->prev_ = nullptr;
+  node->next_ = nullptr;
+  if (list.head_ == nullptr) {
+    level.occupied_[node->slot_ / 64] &= ~(uint64_t(1) << (node->slot_ % 64));
+  }
+}
+
+uint64_t timing_wheel::next_event_tick() const {
+  uint64_t event = UINT64_MAX;
+  for (uint32_t l = 0; l < WHEEL_LEVELS; l++) {
+    uint32_t shift = WHEEL_SLOT_BITS * l;
+    // the slots of level l are processed at the multiples of 2^shift ticks
+    uint64_t unit = (current_tick_ + (uint64_t(1) << shift) - 1) >> shift;
+    uint32_t from = uint32_t(unit) & (WHEEL_SLOTS - 1);
+    uint32_t slot = find_next_set(levels_[l].occupied_, from);
+    if (slot == UINT32_MAX) {
+      continue;
+    }
+    uint64_t u = (unit & ~uint64_t(WHEEL_SLOTS - 1)) | slot;
+    if (u < unit) {
+      u += WHEEL_SLOTS;
+    }
+    event = std::min(event, u << shift);
+  }
+  return event;
+}
+
+void timing_wheel::cascade(uint32_t level, uint32_t slot) {
+  slot_list &list = levels_[level].slots_[slot];
+  wheel_timer *node = list.head_;
+  list.head_ = nullptr;
+  list.tail_ = nullptr;
+  levels_[level].occupied_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+  while (node != nullptr) {
+    wheel_timer *next = node->next_;
+    link(node, node->tick_);
+    node = next;
+  }
+}
+
+void timing_wheel::arm_timer(uint64_t tick) {
+  if (tick >= armed_tick_) {
+    return;
+  }
+  armed_tick_ = tick;
+  timer_.expires_at(EPOCH_TIME_STEADY_CLOCK +
+                    std::chrono::microseconds(tick * tick_us_));
+  auto s = shared_from_this();
+  timer_.async_wait([s](const boost::system::error_code &ec) {
+    // aborted when the timer is re-armed to an earlier tick
+    if (not ec.failed()) {
+      s->handle_tick();
+    }
+  });
+}
+
+bool timing_wheel::cancel(wheel_timer *node) {
+  std::function<void()> fn;
+  std::unique_lock l(mutex_);
+  if (node->wheel_.load() != this) {
+    return false;
+  }
+  unlink(node);
+  node->wheel_.store(nullptr);
+  size_--;
+  fn = std::move(node->fn_);
+  if (size_ == 0 && armed_tick_ != UINT64_MAX) {
+    // no wake up of the empty wheel
+    armed_tick_ = UINT64_MAX;
+    timer_.cancel();
+  }
+  l.unlock();
+  // fn may hold the object of node, and is destroyed without the lock
+  return true;
+}
+
+void timing_wheel::handle_tick() {
+  std::vector<std::function<void()>> expired;
+  std::vector<wheel_timer *> owned;
+  {
+    std::scoped_lock l(mutex_);
+    armed_tick_ = UINT64_MAX;
+    if (stopped_) {
+      return;
+    }
+    uint64_t now_tick = steady_clock_us_since_epoch() / tick_us_;
+    while (true) {
+      uint64_t tick = next_event_tick();
+      if (tick > now_tick) {
+        break;
+      }
+      current_tick_ = tick;
+      for (uint32_t level = WHEEL_LEVELS - 1; level > 0; level--) {
+        uint32_t shift = WHEEL_SLOT_BITS * level;
+        if ((tick & ((uint64_t(1) << shift) - 1)) == 0) {
+          cascade(level, uint32_t(tick >> shift) & (WHEEL_SLOTS - 1));
+        }
+      }
+      slot_list &list = levels_[0].slots_[tick & (WHEEL_SLOTS - 1)];
+      while (list.head_ != nullptr) {
+        wheel_timer *node = list.head_;
+        unlink(node);
+        node->wheel_.store(nullptr);
+        size_--;
+        expired.push_back(std::move(node->fn_));
+        if (node->owned_) {
+          owned.push_back(node);
+        }
+      }
+      current_tick_ = tick + 1;
+    }
+    // no node expires or cascades up to now_tick
+    current_tick_ = std::max(current_tick_, now_tick + 1);
+    if (size_ > 0) {
+      arm_timer(next_event_tick());
+    }
+  }
+  for (std::function<void()> &fn : expired) {
+    fn();
+  }
+  for (wheel_timer *node : owned) {
+    delete node;
+  }
+}
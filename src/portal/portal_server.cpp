@@ -9,8 +9,12 @@
 #include "replog/rl_block.h"
 #include "store/ds_block.h"
 
+#include "common/blog.h"
 #include "common/debug_url.h"
+#include "common/metrics.h"
+#include "common/tx_span.h"
 #include "network/debug_server.h"
+#include "network/frame_compress.h"
 #include <boost/program_options.hpp>
 #include <boost/regex.hpp>
 #include <iostream>
@@ -83,6 +87,7 @@ void block_run(const config &conf, const callback &fn) {
   std::string name =
       "BE_" + n + std::to_string(conf.shard_ids()[0]) + std::to_string(conf.az_id());
   set_thread_name(name);
+  blog_set_level(blog_level_of(conf.get_test_config().log_level()));
 
   BOOST_ASSERT(!conf.node_name().empty());
   BOOST_ASSERT(conf.this_node_config().port() != 0);
@@ -144,9 +149,12 @@ void block_run(const config &conf, const callback &fn) {
              byte_buffer &buffer,
              msg_hdr *hdr) -> result<void> {
     try {
-#ifdef TEST_HANDLE_TIME
       auto b = std::chrono::steady_clock::now();
-#endif // TEST_HANDLE_TIME
+      messages_received[id].inc();
+      if (size_t(id) >= MESSAGE_END) {
+        LOG(error) << "receive unknown message id " << uint32_t(id);
+        return outcome::failure(EC::EC_MESSAGE_ID_ERROR);
+      }
 
       message_block bt = s.get_message_block_type(id);
       auto p = processors[bt];
@@ -161,8 +169,9 @@ void block_run(const config &conf, const callback &fn) {
           }
         }
       }
-#ifdef TEST_HANDLE_TIME
       auto e = std::chrono::steady_clock::now();
+      message_handle_us[id].record(uint64_t(to_microseconds(e - b)));
+#ifdef TEST_HANDLE_TIME
       uint64_t ms = to_milliseconds(e - b);
       if (ms > TEST_HANDLE_MAX_MS) {
         LOG(info) << " process message " << ms << "ms, " << enum2holder(id);
@@ -182,9 +191,12 @@ void block_run(const config &conf, const callback &fn) {
           &conf](ptr<connection> conn, message_type id,
                  ptr<google::protobuf::Message> msg) -> result<void> {
         try {
-#ifdef TEST_HANDLE_TIME
           auto b = std::chrono::steady_clock::now();
-#endif // TEST_HANDLE_TIME
+          messages_received[id].inc();
+          if (size_t(id) >= MESSAGE_END) {
+            LOG(error) << "receive unknown message id " << uint32_t(id);
+            return outcome::failure(EC::EC_MESSAGE_ID_ERROR);
+          }
           message_block bt = s.get_message_block_type(id);
           auto p = processors[bt];
           if (id == CLOSE_REQ) {
@@ -198,8 +210,9 @@ void block_run(const config &conf, const callback &fn) {
               }
             }
           }
-#ifdef TEST_HANDLE_TIME
           auto e = std::chrono::steady_clock::now();
+          message_handle_us[id].record(uint64_t(to_microseconds(e - b)));
+#ifdef TEST_HANDLE_TIME
           uint64_t ms = to_milliseconds(e - b);
           if (ms > TEST_HANDLE_MAX_MS) {
             LOG(info) << " process message " << ms << "ms, " << enum2holder(id);
@@ -220,6 +233,23 @@ void block_run(const config &conf, const callback &fn) {
 
   http_handler debug_handler = [blocks](const std::string &path,
                                         std::ostream &os) {
+    if (boost::regex_match(path, url_metrics)) {
+      metrics_prometheus(os);
+      return;
+    }
+    if (boost::regex_match(path, url_compress)) {
+      frame_compress_stats(os);
+      return;
+    }
+    if (boost::regex_match(path, url_trace)) {
+      uint64_t window_ms = TX_SPAN_WINDOW_MILLIS;
+      boost::smatch what;
+      if (boost::regex_match(path, what, url_trace_ms)) {
+        window_ms = std::stoull(what[1].str());
+      }
+      tx_span_chrome_trace(os, window_ms);
+      return;
+    }
     for (const auto &b : blocks) {
       b->handle_debug(path, os);
     }
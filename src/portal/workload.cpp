@@ -1,5 +1,6 @@
 #include "portal/workload.h"
 #include "common/bench_result.h"
+#include "common/block_type.h"
 #include "common/db_type.h"
 #include "common/logger.hpp"
 #include "common/make_key.h"
@@ -7,15 +8,25 @@
 #include "common/table_id.h"
 #include "common/time_tracer.h"
 #include "common/tuple.h"
+#include "common/tx_span.h"
 #include "network/client.h"
 #include "network/db_client.h"
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <iostream>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 void per_terminal::reset_database_connection() {
   node_id_ = 0;
   client_conn_.reset();
+  replica_conn_.reset();
+}
+
+void per_terminal::start_clock() {
+  std::scoped_lock l(mutex_);
+  update_ts_ = std::chrono::steady_clock::now();
 }
 
 void per_terminal::update(uint32_t commit, uint32_t abort, uint32_t total,
@@ -28,10 +39,14 @@ void per_terminal::update(uint32_t commit, uint32_t abort, uint32_t total,
                           std::chrono::nanoseconds duration_lock_wait,
                           std::chrono::nanoseconds duration_part,
                           uint32_t num_lock, uint32_t num_read_violate,
-                          uint32_t num_write_violate
-
+                          uint32_t num_write_violate,
+                          const tx_type_statistics &tx_type,
+                          const latency_histograms &latency
 ) {
   std::scoped_lock l(mutex_);
+  auto now = std::chrono::steady_clock::now();
+  result_.duration += now - update_ts_;
+  update_ts_ = now;
   result_.num_commit += commit;
   result_.num_abort += abort;
   result_.num_tx += total;
@@ -46,6 +61,12 @@ void per_terminal::update(uint32_t commit, uint32_t abort, uint32_t total,
   result_.num_lock += num_lock;
   result_.num_write_violate += num_write_violate;
   result_.num_read_violate += num_read_violate;
+  for (uint32_t i = 0; i < BENCH_TX_TYPES; i++) {
+    result_.tx_type[i].add(tx_type[i]);
+  }
+  for (uint32_t i = 0; i < LATENCY_PHASES; i++) {
+    result_.latency[i].add(latency[i]);
+  }
 }
 
 tpm_statistic per_terminal::get_result() {
@@ -57,12 +78,21 @@ tpm_statistic per_terminal::get_result() {
 
 bench_result tpm_statistic::compute_bench_result(
     uint32_t num_term,
-    const std::string &node_name
+    const std::string &node_name,
+    double offered_tps
 ) {
   bench_result res;
+  res.set_offered_tps(float_t(offered_tps));
   if (uint64_t(to_milliseconds(duration)) != 0 && num_tx != 0) {
     double tps = double(num_commit) / (to_seconds(duration)) * num_term;
     double ar = double(num_abort) / double(num_tx);
+    // tpm counts the New-Order transactions only, as tpmC
+    double tpm = tps * 60.0;
+    const tx_type_statistic &new_order = tx_type[TPCC_TX_NEW_ORDER];
+    if (new_order.num_tx != 0) {
+      tpm = double(new_order.num_commit) / (to_seconds(duration)) * num_term *
+            60.0;
+    }
 
     if (num_commit != 0) {
       double latency = to_milliseconds(commit_duration) / num_commit;
@@ -92,8 +122,8 @@ bench_result tpm_statistic::compute_bench_result(
       res.set_latency_replicate(latency_replicate);
       res.set_latency_lock_wait(latency_lock_wait);
       res.set_latency_part(latency_part);
-      res.set_tpm(tps * 60.0);
-      LOG(info) << node_name << " TPS : " << tps << ", ABORT RATE : " << ar
+      LOG(info) << node_name << " TPS : " << tps << ", TPM : " << tpm
+                << ", ABORT RATE : " << ar
                 << ", latency: " << latency << "ms"
                                             // #ifdef TEST_APPEND_TIME
                 << ", read: " << latency_read
@@ -105,11 +135,47 @@ bench_result tpm_statistic::compute_bench_result(
 
 // #endif
             ;
+      std::stringstream ssm;
+      for (uint32_t i = 0; i < BENCH_TX_TYPES; i++) {
+        const tx_type_statistic &t = tx_type[i];
+        if (t.num_tx == 0) {
+          continue;
+        }
+        double type_tps =
+            double(t.num_commit) / (to_seconds(duration)) * num_term;
+        double type_ar = double(t.num_abort) / double(t.num_tx);
+        double type_latency = t.num_commit == 0 ? 0.0 :
+            to_milliseconds(t.commit_duration) / t.num_commit;
+        ssm << " " << bench_tx_type_name(i) << ": " << type_tps << "/"
+            << type_ar << "/" << type_latency << "ms";
+      }
+      LOG(info) << node_name << " TPS/ABORT RATE/latency," << ssm.str();
+
+      // p50/p99/p999 of each phase, the histograms are in microseconds
+      std::stringstream ssp;
+      const std::pair<const char *, double> percentiles[] = {
+          {"p50", 50.0}, {"p99", 99.0}, {"p999", 99.9}};
+      for (uint32_t i = 0; i < LATENCY_PHASES; i++) {
+        ssp << " " << latency_phase_name(i) << ":";
+        for (const auto &p : percentiles) {
+          float_t v =
+              float_t(this->latency[i].value_at_percentile(p.second)) / 1000;
+          res.add_latency_percentile(
+              std::string(latency_phase_name(i)) + "_" + p.first, v);
+          ssp << " " << p.first << "=" << v;
+        }
+      }
+      LOG(info) << node_name << " latency percentile(ms)," << ssp.str();
     } else {
       LOG(info) << node_name << " TPS : " << tps;
     }
 
-    res.set_tpm(tps * 60);
+    res.set_tpm(float_t(tpm));
+    res.set_tpm_total(float_t(tps * 60.0));
+    if (offered_tps > 0.0) {
+      LOG(info) << node_name << " offered TPS : " << offered_tps
+                << ", achieved TPS : " << tps;
+    }
   } else {
     LOG(info) << node_name << " TPS : 0";
   }
@@ -122,6 +188,7 @@ workload::workload(const config &conf)
       tuple_gen_(conf.schema_manager().id2table()),
       output_result_(conf.get_tpcc_config().num_output_result()),
       output_windows_size_(conf.get_tpcc_config().num_output_result() / 4) {
+  tx_span_set_sample_rate(conf.get_tpcc_config().trace_sample_rate());
   uint32_t num_rg = conf.num_rg();
   uint32_t num_wh = conf.get_tpcc_config().num_warehouse();
   BOOST_ASSERT(num_rg < num_wh);
@@ -141,6 +208,9 @@ workload::workload(const config &conf)
     LOG(info) << "SHARD: " << sd_id << " [" << b.lower << "," << b.upper << ']';
     rg2wid_boundary_.insert(std::make_pair(sd_id, b));
   }
+  if (conf.get_tpcc_config().benchmark() == "ycsb") {
+    ycsb_zipf_ = ycsb_zipf_distribution(conf);
+  }
 }
 
 result<void> workload::connect_to_lead(per_terminal *t, bool wait_all) {
@@ -216,6 +286,27 @@ void workload::random_get_replica_client(shard_id_t sd_id, per_terminal *td) {
   }
 }
 
+void workload::nearest_replica_client(shard_id_t sd_id, per_terminal *td) {
+  per_terminal &t = *td;
+  t.replica_conn_.reset();
+  for (node_id_t id : conf_.get_rg_block_nodes(sd_id, BLOCK_TYPE_ID_CCB)) {
+    if (id == t.node_id_) {
+      continue;
+    }
+    if (conf_.get_node_conf(id).az_id() != conf_.az_id()) {
+      continue;
+    }
+    auto i = t.client_set_.find(id);
+    if (i != t.client_set_.end()) {
+      t.replica_conn_ = i->second;
+      LOG(trace) << "shard_ids:" << sd_id << " read only tx to replica "
+                 << id_2_name(id);
+      break;
+    }
+  }
+  // no follower in this AZ, read only transactions go to the leader
+}
+
 void workload::connect_database(shard_id_t shard_id, uint32_t term_id) {
 
   per_terminal *td = get_terminal_data(shard_id, term_id);
@@ -327,6 +418,9 @@ void workload::connect_database(shard_id_t shard_id, uint32_t term_id) {
     if (r) {
       LOG(trace) << "shard_ids:" << shard_id << " term_id:" << term_id
                  << " would connect leader " << id_2_name(td->node_id_);
+      if (conf_.get_tpcc_config().replica_read()) {
+        nearest_replica_client(shard_id, td);
+      }
       break;
     } else {
       sleep(1);
@@ -376,7 +470,7 @@ void workload::load_data(node_id_t node_id) {
 
   client_load_data_request request;
   client_load_data_response response;
-  request.set_workload("tpcc");
+  request.set_workload(conf_.get_tpcc_config().benchmark());
   for (auto shard_id : conf.shard_ids()) {
     auto iter = rg2wid_boundary_.find(shard_id);
     if (iter == rg2wid_boundary_.end()) {
@@ -385,6 +479,9 @@ void workload::load_data(node_id_t node_id) {
     boundary b = iter->second;
     request.set_wid_lower(b.lower);
     request.set_wid_upper(b.upper);
+    ycsb_key_range range = ycsb_shard_key_range(conf_, shard_id);
+    request.set_key_lower(range.lower);
+    request.set_key_upper(range.upper);
     result<void> rs = client.send_message(CLIENT_LOAD_DATA_REQ, request);
     if (!rs) {
       LOG(error) << "send message error";
@@ -403,17 +500,45 @@ void workload::load_data(node_id_t node_id) {
   }
 }
 
+// the store key of DSB has no shard, a DSB holding several shards cannot
+// scan the rows of one of them
+static bool dsb_hold_one_shard(const config &conf) {
+  for (const node_config &c : conf.node_server_list()) {
+    if (c.block_type_list().contains(BLOCK_DSB) && c.shard_ids().size() > 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void workload::warm_up_cached1(shard_id_t sd_id, uint32_t term_id) {
+  if (conf_.get_test_config().warm_up_scan() && dsb_hold_one_shard(conf_)) {
+    warm_up_scan(sd_id);
+    return;
+  }
+  std::unordered_map<shard_id_t, std::vector<ptr<warm_up_req>>> warm_up_requests;
+  warm_up_sample(get_terminal_data(sd_id, term_id), warm_up_requests);
+  for (auto p : warm_up_requests) {
+    std::scoped_lock<std::mutex> l(warm_up_req_mutex_);
+    auto iter = warm_up_req_.find(p.first);
+    if (iter == warm_up_req_.end()) {
+      warm_up_req_.insert(std::make_pair(p.first, p.second));
+    } else {
+      iter->second.insert(iter->second.end(), p.second.begin(), p.second.end());
+    }
+  }
+}
+
+void workload::warm_up_sample(
+    per_terminal *td,
+    std::unordered_map<shard_id_t, std::vector<ptr<warm_up_req>>>
+        &warm_up_requests) {
   float_t percent_cached_tuple =
       conf_.get_test_config().percent_cached_tuple();
   std::uniform_real_distribution<> dist(0, 1.0);
   std::random_device rd;
   std::mt19937 e(rd());
 
-  per_terminal *td = get_terminal_data(sd_id, term_id);
-  ptr<warm_up_req> req(cs_new<warm_up_req>());
-
-  std::unordered_map<shard_id_t, std::vector<ptr<warm_up_req>>> warm_up_requests;
   for (size_t i = 0; i < td->requests_.size(); i++) {
     const tx_request &t = td->requests_[i];
     for (const tx_operation &op : t.operations()) {
@@ -452,15 +577,24 @@ void workload::warm_up_cached1(shard_id_t sd_id, uint32_t term_id) {
       }
     }
   }
-  for (auto p : warm_up_requests) {
-    std::scoped_lock<std::mutex> l(warm_up_req_mutex_);
-    auto iter = warm_up_req_.find(p.first);
-    if (iter == warm_up_req_.end()) {
-      warm_up_req_.insert(std::make_pair(p.first, p.second));
-    } else {
-      iter->second.insert(iter->second.end(), p.second.begin(), p.second.end());
-    }
+}
+
+// DSB scans the rows of the shard and streams a percent_cached_tuple sample of
+// them to CCB, the first terminal of the shard sends the request
+void workload::warm_up_scan(shard_id_t sd_id) {
+  float_t percent_cached_tuple =
+      conf_.get_test_config().percent_cached_tuple();
+  if (percent_cached_tuple <= 0) {
+    return;
+  }
+  std::scoped_lock<std::mutex> l(warm_up_req_mutex_);
+  if (warm_up_req_.contains(sd_id)) {
+    return;
   }
+  ptr<warm_up_req> req(cs_new<warm_up_req>());
+  req->set_shard_id(sd_id);
+  req->set_percent(percent_cached_tuple);
+  warm_up_req_[sd_id].push_back(req);
 }
 
 void workload::warm_up_cached2(shard_id_t sd_id, uint32_t term_id) {
@@ -477,7 +611,9 @@ void workload::warm_up_cached2(shard_id_t sd_id, uint32_t term_id) {
     }
   }
   per_terminal *td = get_terminal_data(sd_id, term_id);
-  for (auto request : vec) {
+  for (size_t i = 0; i < vec.size(); i++) {
+    ptr<warm_up_req> request = vec[i];
+    uint32_t num_scan_failed = 0;
     while (true) {
       ptr<db_client> cli = td->client_conn_;
       request->set_term_id(term_id);
@@ -501,6 +637,19 @@ void workload::warm_up_cached2(shard_id_t sd_id, uint32_t term_id) {
       }
       LOG(trace) << "response warm up" << sd_id << " terminal " << term_id;
       if (!response.ok()) {
+        if (request->tuple_key().empty() &&
+            ++num_scan_failed >= WARM_UP_SCAN_RETRY) {
+          // the scan may fail for good, e.g. DSB does not hold the shard
+          // alone, and every retry opens a stream which fails the same way
+          LOG(warning) << "warm up scan of shard " << sd_id
+                       << " failed, read a sample of its keys";
+          warm_up_sample_shard(sd_id, vec);
+          break;
+        }
+        if (request->tuple_key().empty()) {
+          // CCB is not registered yet, or the scan has failed
+          sleep(1);
+        }
         continue;
       }
       break;
@@ -508,7 +657,32 @@ void workload::warm_up_cached2(shard_id_t sd_id, uint32_t term_id) {
   }
 }
 
+// the keys of shard sd_id in a sample of the operations of all terminals, as
+// warm_up_cached1 reads them without a scan
+void workload::warm_up_sample_shard(shard_id_t sd_id,
+                                    std::vector<ptr<warm_up_req>> &vec) {
+  std::vector<per_terminal *> terminals;
+  {
+    std::scoped_lock l(terminal_data_mutex_);
+    for (const auto &kv : terminal_data_) {
+      terminals.push_back(kv.second.get());
+    }
+  }
+  std::unordered_map<shard_id_t, std::vector<ptr<warm_up_req>>> sampled;
+  for (per_terminal *td : terminals) {
+    warm_up_sample(td, sampled);
+  }
+  auto iter = sampled.find(sd_id);
+  if (iter != sampled.end()) {
+    vec.insert(vec.end(), iter->second.begin(), iter->second.end());
+  }
+}
+
 void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
+  if (conf_.get_tpcc_config().client_window() > 1) {
+    run_pipelined(sd_id, term_id);
+    return;
+  }
   per_terminal *td = get_terminal_data(sd_id, term_id);
   BOOST_ASSERT(td->client_conn_);
   uint32_t commit = 0;
@@ -529,22 +703,54 @@ void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
   uint32_t num_lock = 0;
   uint32_t num_read_violate = 0;
   uint32_t num_write_violate = 0;
+  tx_type_statistics tx_type;
+  latency_histograms latency;
+  // in the open loop mode, the transactions of a terminal arrive at a fixed
+  // rate, and the latency is measured from the intended send time, so the
+  // queueing delay of a slow response is not omitted
+  double open_loop_tps = conf_.get_tpcc_config().open_loop_tps();
+  std::chrono::nanoseconds interval(0);
+  if (open_loop_tps > 0.0) {
+    interval = std::chrono::nanoseconds(uint64_t(
+        1e9 * double(std::max<uint32_t>(1, conf_.final_num_terminal())) /
+        open_loop_tps));
+  }
+  std::chrono::steady_clock::time_point intended =
+      std::chrono::steady_clock::now();
   BOOST_ASSERT(!requests.empty());
-  for (tx_request &t : requests) {
+  BOOST_ASSERT(requests.size() == pt.tx_types_.size());
+  uint64_t backoff_us = CLIENT_FLOW_CONTROL_BACKOFF_MIN_MICROS;
+  pt.start_clock();
+  for (size_t i = 0; i < requests.size(); i++) {
     if (stopped_.load()) {
       break;
     }
+    tx_request &t = requests[i];
+    tx_type_statistic &type_stat = tx_type[pt.tx_types_[i]];
+    type_stat.num_tx++;
     BOOST_ASSERT(t.client_request());
     total++;
     ptr<db_client> cli = pt.client_conn_;
+    if (t.read_only() && pt.replica_conn_) {
+      cli = pt.replica_conn_;
+    }
     BOOST_ASSERT(cli);
-    if (cli->client_ptr()->peer().node_id_ != leader_node_id) {
+    if (cli == pt.client_conn_ &&
+        cli->client_ptr()->peer().node_id_ != leader_node_id) {
       LOG(error) << "connect to node "
                  << id_2_name(cli->client_ptr()->peer().node_id_);
     }
     BOOST_ASSERT(t.ByteSizeLong() != 0);
-    tracer.begin();
+    std::chrono::nanoseconds duration_before = tracer.duration();
+    if (interval.count() != 0) {
+      std::this_thread::sleep_until(intended);
+      tracer.begin_ts(intended);
+      intended += interval;
+    } else {
+      tracer.begin();
+    }
 
+    uint64_t send_ns = t.trace() ? tx_span_now_ns() : 0;
     result<void> send_res = cli->send_message(CLIENT_TX_REQ, t);
     if (!send_res) {
       tracer.end();
@@ -559,10 +765,64 @@ void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
       LOG(error) << "client tx response receive error" << recv_res.error().message();
       continue;
     }
+    if (cli != pt.client_conn_ &&
+        EC(response.error_code()) == EC::EC_NOT_LEADER) {
+      // the replica cannot confirm a read index with the leader, the read is
+      // retried on the leader
+      cli = pt.client_conn_;
+      response.Clear();
+      send_res = cli->send_message(CLIENT_TX_REQ, t);
+      if (send_res) {
+        recv_res = cli->recv_message(CLIENT_TX_RESP, response);
+      }
+      if (!send_res || !recv_res) {
+        tracer.end();
+        LOG(error) << "retry read on the leader error, term_id, " << term_id;
+        continue;
+      }
+    }
+    while (EC(response.error_code()) == EC::EC_FLOW_CONTROL &&
+           not stopped_.load()) {
+      // the CCB is short of append log credits, the transaction is not
+      // executed and is retried after a back off
+      std::this_thread::sleep_for(std::chrono::microseconds(backoff_us));
+      backoff_us = std::min(backoff_us * 2,
+                            CLIENT_FLOW_CONTROL_BACKOFF_MAX_MICROS);
+      response.Clear();
+      send_res = cli->send_message(CLIENT_TX_REQ, t);
+      if (send_res) {
+        recv_res = cli->recv_message(CLIENT_TX_RESP, response);
+      }
+      if (!send_res || !recv_res) {
+        break;
+      }
+    }
+    if (!send_res || !recv_res) {
+      tracer.end();
+      LOG(error) << "retry flow controlled tx error, term_id, " << term_id;
+      continue;
+    }
+    if (EC(response.error_code()) != EC::EC_FLOW_CONTROL) {
+      backoff_us = CLIENT_FLOW_CONTROL_BACKOFF_MIN_MICROS;
+    }
+    if (t.trace()) {
+      tx_span_record(SPAN_CLIENT_SEND, t.trace_id(), term_id, send_ns,
+                     tx_span_now_ns());
+    }
     EC ec = EC(response.error_code());
     if (ec == EC::EC_OK) {
       tracer.end();
       commit++;
+      type_stat.num_commit++;
+      std::chrono::nanoseconds tx_duration =
+          tracer.duration() - duration_before;
+      type_stat.commit_duration += tx_duration;
+      latency[LATENCY_TOTAL].record(uint64_t(tx_duration.count() / 1000));
+      latency[LATENCY_LOCK_WAIT].record(response.latency_lock_wait());
+      latency[LATENCY_APPEND].record(response.latency_append());
+      latency[LATENCY_REPLICATE].record(response.latency_replicate());
+      latency[LATENCY_READ_DSB].record(response.latency_read_dsb());
+      latency[LATENCY_PART].record(response.latency_part());
 
       duration_append_log +=
           std::chrono::microseconds(response.latency_append());
@@ -586,12 +846,13 @@ void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
       } else {
         abort++;
       }
+      type_stat.num_abort++;
     }
     if (total >= 10 && !stopped_.load()) {
       pt.update(commit, abort, total, num_part, tracer.duration(),
                 duration_append_log, duration_replicate_log, duration_read,
                 duration_read_dsb, duration_lock_wait, duration_part, num_lock,
-                num_read_violate, num_write_violate);
+                num_read_violate, num_write_violate, tx_type, latency);
       total = 0;
       abort = 0;
       commit = 0;
@@ -599,6 +860,10 @@ void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
       duration_lock_wait = duration_part = duration_read = duration_read_dsb =
       duration_replicate_log = duration_append_log =
           std::chrono::nanoseconds(0);
+      tx_type.fill(tx_type_statistic());
+      for (hdr_histogram &h : latency) {
+        h.reset();
+      }
       tracer.reset();
     }
   }
@@ -611,6 +876,271 @@ void workload::run_new_order(shard_id_t sd_id, uint32_t term_id) {
   pt.done_.store(true);
 }
 
+// the statistics of the responses not yet added to per_terminal
+struct pipeline_stat {
+  uint32_t commit{0};
+  uint32_t abort{0};
+  uint32_t total{0};
+  uint64_t num_part{0};
+  uint32_t num_lock{0};
+  uint32_t num_read_violate{0};
+  uint32_t num_write_violate{0};
+  // the sum of the latencies, which overlap in the window, so the throughput
+  // is computed from the elapsed time of the terminal instead
+  std::chrono::nanoseconds duration{0};
+  std::chrono::nanoseconds duration_append_log{0};
+  std::chrono::nanoseconds duration_replicate_log{0};
+  std::chrono::nanoseconds duration_read{0};
+  std::chrono::nanoseconds duration_read_dsb{0};
+  std::chrono::nanoseconds duration_lock_wait{0};
+  std::chrono::nanoseconds duration_part{0};
+  tx_type_statistics tx_type;
+  latency_histograms latency;
+};
+
+ptr<async_db_client>
+workload::connect_async_client(boost::asio::io_context &context,
+                               node_id_t node_id) {
+  auto cli = cs_new<async_db_client>(context, conf_.az_id(),
+                                     conf_.get_node_conf(node_id),
+                                     conf_.get_tpcc_config().client_window());
+  while (not cli->connect()) {
+    if (stopped_.load()) {
+      return nullptr;
+    }
+    sleep(1);
+  }
+  return cli;
+}
+
+void workload::run_pipelined(shard_id_t sd_id, uint32_t term_id) {
+  per_terminal &pt = *get_terminal_data(sd_id, term_id);
+  std::vector<tx_request> &requests = pt.requests_;
+  BOOST_ASSERT(!requests.empty());
+  BOOST_ASSERT(requests.size() == pt.tx_types_.size());
+  uint32_t window = conf_.get_tpcc_config().client_window();
+  LOG(trace) << "request num:, " << requests.size() << ", term_id:" << term_id
+             << ", window: " << window;
+
+  // the IO and the response callbacks of this terminal run on this thread
+  boost::asio::io_context context;
+  ptr<async_db_client> leader = connect_async_client(context, pt.node_id_);
+  ptr<async_db_client> replica;
+  for (const auto &kv : pt.client_set_) {
+    if (pt.replica_conn_ && kv.second == pt.replica_conn_) {
+      replica = connect_async_client(context, kv.first);
+    }
+  }
+  if (not leader) {
+    pt.done_.store(true);
+    return;
+  }
+
+  pipeline_stat stat;
+  size_t num_sent = 0;
+  size_t num_done = 0;
+  double open_loop_tps = conf_.get_tpcc_config().open_loop_tps();
+  std::chrono::nanoseconds interval(0);
+  if (open_loop_tps > 0.0) {
+    interval = std::chrono::nanoseconds(uint64_t(
+        1e9 * double(std::max<uint32_t>(1, conf_.final_num_terminal())) /
+        open_loop_tps));
+  }
+  std::chrono::steady_clock::time_point intended =
+      std::chrono::steady_clock::now();
+  boost::asio::steady_timer arrival_timer(context);
+  boost::asio::steady_timer stop_timer(context);
+
+  auto finished = [&]() {
+    return (stopped_.load() || num_sent == requests.size()) &&
+        num_done == num_sent;
+  };
+
+  uint64_t backoff_us = CLIENT_FLOW_CONTROL_BACKOFF_MIN_MICROS;
+  std::function<void()> send_next;
+  std::function<void(size_t, std::chrono::steady_clock::time_point, bool)>
+      send;
+  std::function<void(size_t, std::chrono::steady_clock::time_point, bool, EC,
+                     const tx_response &)>
+      on_response;
+  on_response = [&](size_t i, std::chrono::steady_clock::time_point begin,
+                    bool on_replica, EC ec, const tx_response &response) {
+    if (on_replica && ec == EC::EC_OK &&
+        EC(response.error_code()) == EC::EC_NOT_LEADER && not stopped_.load()) {
+      // the replica cannot confirm a read index with the leader, the read is
+      // retried on the leader
+      send(i, begin, false);
+      return;
+    }
+    if (ec == EC::EC_OK &&
+        EC(response.error_code()) == EC::EC_FLOW_CONTROL &&
+        not stopped_.load()) {
+      // the CCB is short of append log credits, the transaction is not
+      // executed and is retried after a back off
+      auto timer = std::make_shared<boost::asio::steady_timer>(
+          context, std::chrono::microseconds(backoff_us));
+      backoff_us = std::min(backoff_us * 2,
+                            CLIENT_FLOW_CONTROL_BACKOFF_MAX_MICROS);
+      timer->async_wait([&, timer, i, begin](const boost::system::error_code &) {
+        if (stopped_.load()) {
+          on_response(i, begin, false, EC::EC_CANCELED_ERROR, tx_response());
+        } else {
+          send(i, begin, false);
+        }
+      });
+      return;
+    }
+    if ((ec == EC::EC_NET_UNCONNECTED || ec == EC::EC_CANCELED_ERROR) &&
+        stopped_.load()) {
+      // failed by closing the connections when stopped, not an abort
+      num_done++;
+      if (finished()) {
+        context.stop();
+      }
+      return;
+    }
+    if (ec == EC::EC_OK) {
+      backoff_us = CLIENT_FLOW_CONTROL_BACKOFF_MIN_MICROS;
+    }
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    std::chrono::nanoseconds duration = end - begin;
+    if (requests[i].trace()) {
+      tx_span_record(SPAN_CLIENT_SEND, requests[i].trace_id(), term_id,
+                     tx_span_ns(begin), tx_span_ns(end));
+    }
+    tx_type_statistic &type_stat = stat.tx_type[pt.tx_types_[i]];
+    type_stat.num_tx++;
+    stat.total++;
+    stat.duration += duration;
+    num_done++;
+    if (ec == EC::EC_OK && EC(response.error_code()) == EC::EC_OK) {
+      stat.commit++;
+      type_stat.num_commit++;
+      type_stat.commit_duration += duration;
+      stat.latency[LATENCY_TOTAL].record(uint64_t(duration.count() / 1000));
+      stat.latency[LATENCY_LOCK_WAIT].record(response.latency_lock_wait());
+      stat.latency[LATENCY_APPEND].record(response.latency_append());
+      stat.latency[LATENCY_REPLICATE].record(response.latency_replicate());
+      stat.latency[LATENCY_READ_DSB].record(response.latency_read_dsb());
+      stat.latency[LATENCY_PART].record(response.latency_part());
+      stat.duration_append_log +=
+          std::chrono::microseconds(response.latency_append());
+      stat.duration_replicate_log +=
+          std::chrono::microseconds(response.latency_replicate());
+      stat.duration_read += std::chrono::microseconds(response.latency_read());
+      stat.duration_read_dsb +=
+          std::chrono::microseconds(response.latency_read_dsb());
+      stat.duration_lock_wait +=
+          std::chrono::microseconds(response.latency_lock_wait());
+      stat.duration_part += std::chrono::microseconds(response.latency_part());
+      stat.num_part += response.access_part();
+      stat.num_write_violate += response.num_write_violate();
+      stat.num_read_violate += response.num_read_violate();
+      stat.num_lock += response.num_lock();
+    } else {
+      LOG(trace) << "tx_rm response error code :" << ec << " "
+                 << EC(response.error_code());
+      stat.abort++;
+      type_stat.num_abort++;
+    }
+    if (stat.total >= 10 && not stopped_.load()) {
+      pt.update(stat.commit, stat.abort, stat.total, stat.num_part,
+                stat.duration, stat.duration_append_log,
+                stat.duration_replicate_log, stat.duration_read,
+                stat.duration_read_dsb, stat.duration_lock_wait,
+                stat.duration_part, stat.num_lock, stat.num_read_violate,
+                stat.num_write_violate, stat.tx_type, stat.latency);
+      stat = pipeline_stat();
+    }
+    if (interval.count() == 0) {
+      // closed loop, a response makes room for the next transaction
+      send_next();
+    }
+    if (finished()) {
+      context.stop();
+    }
+  };
+
+  // begin is the intended send time in the open loop mode
+  send = [&](size_t i, std::chrono::steady_clock::time_point begin,
+             bool to_replica) {
+    auto request = cs_new<tx_request>(requests[i]);
+    bool on_replica = to_replica && request->read_only() && replica;
+    ptr<async_db_client> cli = on_replica ? replica : leader;
+    cli->async_submit(request, [&on_response, i, begin, on_replica](
+                                   EC ec, const tx_response &response) {
+      on_response(i, begin, on_replica, ec, response);
+    });
+  };
+
+  send_next = [&]() {
+    if (stopped_.load() || num_sent == requests.size()) {
+      return;
+    }
+    send(num_sent++, std::chrono::steady_clock::now(), true);
+  };
+
+  std::function<void(const boost::system::error_code &)> on_arrival =
+      [&](const boost::system::error_code &ec) {
+        if (ec.failed() || stopped_.load() || num_sent == requests.size()) {
+          return;
+        }
+        send(num_sent++, intended, true);
+        intended += interval;
+        arrival_timer.expires_at(intended);
+        arrival_timer.async_wait(on_arrival);
+      };
+
+  // the transactions in flight when stopped are failed by closing the
+  // connections, the callbacks count them as done but not as aborts
+  std::function<void(const boost::system::error_code &)> on_stop_check =
+      [&](const boost::system::error_code &ec) {
+        if (ec.failed()) {
+          return;
+        }
+        if (stopped_.load()) {
+          arrival_timer.cancel();
+          leader->close();
+          if (replica) {
+            replica->close();
+          }
+          if (num_done == num_sent) {
+            context.stop();
+          }
+          return;
+        }
+        stop_timer.expires_after(std::chrono::seconds(1));
+        stop_timer.async_wait(on_stop_check);
+      };
+
+  pt.start_clock();
+  if (interval.count() == 0) {
+    for (uint32_t i = 0; i < window; i++) {
+      send_next();
+    }
+  } else {
+    arrival_timer.expires_at(intended);
+    arrival_timer.async_wait(on_arrival);
+  }
+  stop_timer.expires_after(std::chrono::seconds(1));
+  stop_timer.async_wait(on_stop_check);
+  if (not finished()) {
+    context.run();
+  }
+  leader->close();
+  if (replica) {
+    replica->close();
+  }
+
+  LOG(info) << "terminal " << term_id << " done";
+  if (!stopped_.load()) {
+    LOG(warning) << "terminal done before stopped";
+    stopped_.store(true);
+  }
+  pt.done_.store(true);
+}
+
 per_terminal *workload::get_terminal_data(shard_id_t sd_id, uint32_t term_id) {
   std::scoped_lock l(terminal_data_mutex_);
   auto i = terminal_data_.find(term_id);
@@ -632,7 +1162,7 @@ void workload::new_order(
 
   bool is_dist = false;
   // begin transaction request
-  make_begin_tx_request(td, false);
+  make_begin_tx_request(td, false, TPCC_TX_NEW_ORDER);
 
   rg_wid rg_and_wid = gen.gen_local_wid();
   BOOST_ASSERT(rg_and_wid.rg_id_ == sd_id);
@@ -794,10 +1324,409 @@ void workload::new_order(
   // commit transaction request
   make_end_tx_request(td);
 
-  uint32_t id = 0;
-  for (tx_operation &op : *td->requests_.rbegin()->mutable_operations()) {
-    op.set_operation_id(++id);
+  mutable_request(td).set_distributed(is_dist);
+  if (is_dist) {
+    td->num_dist_ ++;
+  }
+}
+
+// the orders of a district loaded by ds_block::load_order are first,
+// first + num_warehouse, ..., returns the number of them
+static uint32_t num_loaded_order(uint32_t wid, const tpcc_config &c) {
+  uint64_t max = c.num_order_initialize_per_district();
+  uint64_t first = first_loaded_order_id(wid, max);
+  return first > max ? 0 : uint32_t((max - first) / c.num_warehouse() + 1);
+}
+
+// ds_block::load_order loads at least num_max_order_line / 3 lines of an
+// order, the lines read of a loaded order
+static uint32_t num_loaded_order_line(const tpcc_config &c) {
+  return uint32_t(c.num_max_order_line() / 3);
+}
+
+static uint32_t loaded_order_id(uint32_t wid, uint32_t index,
+                                const tpcc_config &c) {
+  return uint32_t(
+      first_loaded_order_id(wid, c.num_order_initialize_per_district()) +
+      uint64_t(index) * c.num_warehouse());
+}
+
+uint32_t workload::gen_customer_id(shard_id_t sd_id, uint32_t wid,
+                                   uint32_t did, per_terminal *td,
+                                   id_generator &gen) {
+  const tpcc_config &c = conf_.get_tpcc_config();
+  bool by_last_name = gen.percent_gen_.generate() <=
+      uint32_t(PERCENT_BY_LAST_NAME * float_t(PERCENT_BASE));
+  if (!by_last_name) {
+    return gen.cid_gen_.generate();
+  }
+  /**
+    EXEC SQL SELECT count(c_id) INTO :namecnt
+    FROM customer
+    WHERE c_last=:c_last AND c_d_id=:c_d_id AND c_w_id=:c_w_id;
+
+    EXEC SQL DECLARE c_byname CURSOR FOR
+    SELECT c_first, c_middle, c_id, c_street_1, c_street_2, c_city, c_state,
+    c_zip, c_phone, c_credit, c_credit_lim, c_discount, c_balance, c_since
+    FROM customer
+    WHERE c_w_id=:c_w_id AND c_d_id=:c_d_id AND c_last=:c_last
+    ORDER BY c_first;
+   **/
+  // the secondary index is a table of its own, read through the CCB
+  uint32_t name = gen.last_name_gen_.generate();
+  uint64_t n_key = make_customer_key(wid, did, name, c.num_warehouse(),
+                                     c.num_district_per_warehouse());
+  make_read_operation(sd_id, TPCC_CUST_LAST_INDEX, n_key, td);
+  // the customer loaded with this last name
+  return name;
+}
+
+void workload::payment(shard_id_t sd_id, per_terminal *td,
+                       id_generator &gen) {
+  const tpcc_config &c = conf_.get_tpcc_config();
+
+  bool is_dist = false;
+  // begin transaction request
+  make_begin_tx_request(td, false, TPCC_TX_PAYMENT);
+
+  rg_wid rg_and_wid = gen.gen_local_wid();
+  BOOST_ASSERT(rg_and_wid.rg_id_ == sd_id);
+  uint32_t wid = rg_and_wid.wid_;
+  uint32_t did = gen.did_gen_.generate();
+  uint32_t w_key = wid;
+  uint32_t d_key = make_district_key(wid, did, c.num_warehouse());
+
+  /**
+    EXEC SQL UPDATE warehouse SET w_ytd = w_ytd + :h_amount
+    WHERE w_id=:w_id;
+
+    EXEC SQL SELECT w_street_1, w_street_2, w_city, w_state, w_zip, w_name
+    INTO :w_street_1, :w_street_2, :w_city, :w_state, :w_zip, :w_name
+    FROM warehouse
+    WHERE w_id=:w_id;
+   **/
+  make_read_for_write_operation(sd_id, TPCC_WAREHOUSE, w_key, td);
+  tuple_pb tuple_wh = tuple_gen_.gen_tuple(TPCC_WAREHOUSE);
+  make_update_operation(sd_id, TPCC_WAREHOUSE, w_key, tuple_wh, td);
+
+  /**
+    EXEC SQL UPDATE district SET d_ytd = d_ytd + :h_amount
+    WHERE d_w_id=:w_id AND d_id=:d_id;
+
+    EXEC SQL SELECT d_street_1, d_street_2, d_city, d_state, d_zip, d_name
+    INTO :d_street_1, :d_street_2, :d_city, :d_state, :d_zip, :d_name
+    FROM district
+    WHERE d_w_id=:w_id AND d_id=:d_id;
+   **/
+  make_read_for_write_operation(sd_id, TPCC_DISTRICT, d_key, td);
+  tuple_pb tuple_dist = tuple_gen_.gen_tuple(TPCC_DISTRICT);
+  make_update_operation(sd_id, TPCC_DISTRICT, d_key, tuple_dist, td);
+
+  // the customer of a remote warehouse pays
+  uint32_t c_wid = wid;
+  uint32_t c_did = did;
+  shard_id_t c_sd_id = sd_id;
+  bool remote_warehouse =
+      (conf_.num_rg() > 1 || !c.control_percent_dist_tx()) &&
+      gen.percent_gen_.generate() <=
+          uint32_t(PERCENT_PAYMENT_REMOTE * float_t(PERCENT_BASE));
+  if (remote_warehouse) {
+    rg_wid rw = gen.gen_remote_wid(wid, true);
+    c_wid = rw.wid_;
+    c_sd_id = rw.rg_id_;
+    c_did = gen.did_gen_.generate();
+    if (c_sd_id != sd_id) {
+      is_dist = on_same_node(c_sd_id, sd_id);
+    }
   }
+  uint32_t cid = gen_customer_id(c_sd_id, c_wid, c_did, td, gen);
+  uint32_t c_key = make_customer_key(c_wid, c_did, cid, c.num_warehouse(),
+                                     c.num_district_per_warehouse());
+
+  /**
+    EXEC SQL SELECT c_first, c_middle, c_last, c_street_1, c_street_2,
+    c_city, c_state, c_zip, c_phone, c_credit, c_credit_lim,
+    c_discount, c_balance, c_since
+    INTO ...
+    FROM customer
+    WHERE c_w_id=:c_w_id AND c_d_id=:c_d_id AND c_id=:c_id;
+
+    EXEC SQL UPDATE customer SET c_balance = :c_balance, c_data = :c_new_data
+    WHERE c_w_id = :c_w_id AND c_d_id = :c_d_id AND c_id = :c_id;
+   **/
+  make_read_for_write_operation(c_sd_id, TPCC_CUSTOMER, c_key, td);
+  tuple_pb tuple_cust = tuple_gen_.gen_tuple(TPCC_CUSTOMER);
+  make_update_operation(c_sd_id, TPCC_CUSTOMER, c_key, tuple_cust, td);
+
+  /**
+    EXEC SQL INSERT INTO history (h_c_d_id, h_c_w_id, h_c_id, h_d_id,
+    h_w_id, h_date, h_amount, h_data)
+    VALUES (:c_d_id, :c_w_id, :c_id, :d_id,
+    :w_id, :datetime, :h_amount, :h_data);
+   **/
+  uint64_t h_key = make_history_key(td->terminal_id_, ++td->num_history_);
+  tuple_pb tuple_history = tuple_gen_.gen_tuple(TPCC_HISTORY);
+  make_insert_operation(sd_id, TPCC_HISTORY, h_key, tuple_history, td);
+
+  // commit transaction request
+  make_end_tx_request(td);
+
+  mutable_request(td).set_distributed(is_dist);
+  if (is_dist) {
+    td->num_dist_ ++;
+  }
+}
+
+void workload::order_status(shard_id_t sd_id, per_terminal *td,
+                            id_generator &gen) {
+  const tpcc_config &c = conf_.get_tpcc_config();
+
+  // begin transaction request
+  make_begin_tx_request(td, true, TPCC_TX_ORDER_STATUS);
+
+  rg_wid rg_and_wid = gen.gen_local_wid();
+  BOOST_ASSERT(rg_and_wid.rg_id_ == sd_id);
+  uint32_t wid = rg_and_wid.wid_;
+  uint32_t did = gen.did_gen_.generate();
+  uint32_t cid = gen_customer_id(sd_id, wid, did, td, gen);
+  uint32_t c_key = make_customer_key(wid, did, cid, c.num_warehouse(),
+                                     c.num_district_per_warehouse());
+
+  /**
+    EXEC SQL SELECT c_balance, c_first, c_middle, c_last
+    INTO :c_balance, :c_first, :c_middle, :c_last
+    FROM customer
+    WHERE c_id=:c_id AND c_d_id=:d_id AND c_w_id=:w_id;
+   **/
+  make_read_operation(sd_id, TPCC_CUSTOMER, c_key, td);
+
+  /**
+    EXEC SQL SELECT o_id, o_carrier_id, o_entry_d
+    INTO :o_id, :o_carrier_id, :entdate
+    FROM orders
+    ORDER BY o_id DESC;
+
+    EXEC SQL DECLARE c_line CURSOR FOR
+    SELECT ol_i_id, ol_supply_w_id, ol_quantity, ol_amount, ol_delivery_d
+    FROM order_line
+    WHERE ol_o_id=:o_id AND ol_d_id=:d_id AND ol_w_id=:w_id;
+   **/
+  // the orders have no index by customer, the last order of the customer is
+  // one of the loaded orders
+  uint32_t num_order = num_loaded_order(wid, c);
+  if (num_order > 0) {
+    uint32_t oid = loaded_order_id(
+        wid, gen.loaded_oid_gen_.generate() % num_order, c);
+    uint32_t o_key = make_order_key(wid, did, oid, c.num_warehouse(),
+                                    c.num_district_per_warehouse());
+    make_read_operation(sd_id, TPCC_ORDER, o_key, td);
+    uint32_t num_line = num_loaded_order_line(c);
+    for (uint32_t olid = 1; olid <= num_line; olid++) {
+      uint32_t ol_key = make_order_line_key(
+          wid, did, oid, olid, c.num_warehouse(),
+          c.num_district_per_warehouse(), NUM_ORDER_MAX);
+      make_read_operation(sd_id, TPCC_ORDER_LINE, ol_key, td);
+    }
+  }
+
+  // commit transaction request
+  make_end_tx_request(td);
+}
+
+bool workload::delivery(shard_id_t sd_id, per_terminal *td,
+                        id_generator &gen) {
+  const tpcc_config &c = conf_.get_tpcc_config();
+
+  rg_wid rg_and_wid = gen.gen_local_wid();
+  BOOST_ASSERT(rg_and_wid.rg_id_ == sd_id);
+  uint32_t wid = rg_and_wid.wid_;
+
+  // the loaded orders not delivered yet, they are partitioned among the
+  // terminals of this shard, so no two terminals delete the same new order:
+  // the districts are dealt to the terminals, and the terminals sharing a
+  // district take its orders in turn
+  uint64_t max = c.num_order_initialize_per_district();
+  uint64_t first = first_loaded_order_id(wid, max);
+  uint64_t first_new = first_undelivered_order_id(max);
+  uint32_t num_order = num_loaded_order(wid, c);
+  uint32_t skip = first_new > first ? uint32_t(
+      (first_new - first + c.num_warehouse() - 1) / c.num_warehouse()) : 0;
+  if (num_order <= skip) {
+    return false;
+  }
+  uint32_t num_terminal = std::max<uint32_t>(1, conf_.num_terminal());
+  uint32_t num_group = std::min<uint32_t>(
+      num_terminal, std::max<uint32_t>(1, c.num_district_per_warehouse()));
+  // terminal_id started from 1
+  uint32_t slot = (td->terminal_id_ - 1) % num_terminal;
+  uint32_t group = slot % num_group;
+  uint32_t num_share = (num_terminal - 1 - group) / num_group + 1;
+  uint32_t share = slot / num_group;
+  std::vector<std::pair<uint32_t, uint32_t>> did_oid;
+  for (uint32_t did = 1; did <= c.num_district_per_warehouse(); did++) {
+    if ((did - 1) % num_group != group) {
+      continue;
+    }
+    uint64_t d_key = make_district_key(wid, did, c.num_warehouse());
+    uint32_t &delivered = td->delivery_oid_[d_key];
+    uint64_t index = skip + share + uint64_t(delivered) * num_share;
+    if (index >= num_order) {
+      // no new order of this district left to this terminal
+      continue;
+    }
+    delivered++;
+    did_oid.emplace_back(did, loaded_order_id(wid, uint32_t(index), c));
+  }
+  if (did_oid.empty()) {
+    return false;
+  }
+
+  // begin transaction request
+  make_begin_tx_request(td, false, TPCC_TX_DELIVERY);
+  uint32_t num_line = num_loaded_order_line(c);
+  for (auto [did, oid] : did_oid) {
+    uint32_t o_key = make_order_key(wid, did, oid, c.num_warehouse(),
+                                    c.num_district_per_warehouse());
+    /**
+      EXEC SQL DECLARE c_no CURSOR FOR
+      SELECT no_o_id
+      FROM new_order
+      WHERE no_d_id = :d_id AND no_w_id = :w_id
+      ORDER BY no_o_id ASC;
+
+      EXEC SQL DELETE FROM new_order WHERE CURRENT OF c_no;
+     **/
+    make_delete_operation(sd_id, TPCC_NEW_ORDER, o_key, td);
+
+    /**
+      EXEC SQL SELECT o_c_id INTO :c_id FROM orders
+      WHERE o_id = :no_o_id AND o_d_id = :d_id AND o_w_id = :w_id;
+
+      EXEC SQL UPDATE orders SET o_carrier_id = :o_carrier_id
+      WHERE o_id = :no_o_id AND o_d_id = :d_id AND o_w_id = :w_id;
+     **/
+    make_read_for_write_operation(sd_id, TPCC_ORDER, o_key, td);
+    tuple_pb tuple_order = tuple_gen_.gen_tuple(TPCC_ORDER);
+    make_update_operation(sd_id, TPCC_ORDER, o_key, tuple_order, td);
+
+    /**
+      EXEC SQL UPDATE order_line SET ol_delivery_d = :datetime
+      WHERE ol_o_id = :no_o_id AND ol_d_id = :d_id AND ol_w_id = :w_id;
+
+      EXEC SQL SELECT SUM(ol_amount) INTO :ol_total
+      FROM order_line
+      WHERE ol_o_id = :no_o_id AND ol_d_id = :d_id AND ol_w_id = :w_id;
+     **/
+    for (uint32_t olid = 1; olid <= num_line; olid++) {
+      uint32_t ol_key = make_order_line_key(
+          wid, did, oid, olid, c.num_warehouse(),
+          c.num_district_per_warehouse(), NUM_ORDER_MAX);
+      make_read_for_write_operation(sd_id, TPCC_ORDER_LINE, ol_key, td);
+      tuple_pb tuple_ol = tuple_gen_.gen_tuple(TPCC_ORDER_LINE);
+      make_update_operation(sd_id, TPCC_ORDER_LINE, ol_key, tuple_ol, td);
+    }
+
+    /**
+      EXEC SQL UPDATE customer SET c_balance = c_balance + :ol_total
+      WHERE c_id = :c_id AND c_d_id = :d_id AND c_w_id = :w_id;
+     **/
+    uint32_t cid = gen.cid_gen_.generate();
+    uint32_t c_key = make_customer_key(wid, did, cid, c.num_warehouse(),
+                                       c.num_district_per_warehouse());
+    make_read_for_write_operation(sd_id, TPCC_CUSTOMER, c_key, td);
+    tuple_pb tuple_cust = tuple_gen_.gen_tuple(TPCC_CUSTOMER);
+    make_update_operation(sd_id, TPCC_CUSTOMER, c_key, tuple_cust, td);
+  }
+
+  // commit transaction request
+  make_end_tx_request(td);
+  return true;
+}
+
+void workload::stock_level(shard_id_t sd_id, per_terminal *td,
+                           id_generator &gen) {
+  const tpcc_config &c = conf_.get_tpcc_config();
+
+  // begin transaction request
+  make_begin_tx_request(td, true, TPCC_TX_STOCK_LEVEL);
+
+  rg_wid rg_and_wid = gen.gen_local_wid();
+  BOOST_ASSERT(rg_and_wid.rg_id_ == sd_id);
+  uint32_t wid = rg_and_wid.wid_;
+  uint32_t did = gen.did_gen_.generate();
+  uint32_t d_key = make_district_key(wid, did, c.num_warehouse());
+
+  /**
+    EXEC SQL SELECT d_next_o_id INTO :o_id
+    FROM district
+    WHERE d_w_id=:w_id AND d_id=:d_id;
+   **/
+  make_read_operation(sd_id, TPCC_DISTRICT, d_key, td);
+
+  /**
+    EXEC SQL SELECT COUNT(DISTINCT (s_i_id)) INTO :stock_count
+    FROM order_line, stock
+    WHERE ol_w_id=:w_id AND ol_d_id=:d_id AND ol_o_id<:o_id AND
+    ol_o_id>=:o_id-20 AND s_w_id=:w_id AND
+    s_i_id=ol_i_id AND s_quantity < :threshold;
+   **/
+  // the join is read row by row, the order lines of the last orders and the
+  // stock of their items
+  uint32_t num_order = num_loaded_order(wid, c);
+  uint32_t num_line = num_loaded_order_line(c);
+  for (uint32_t n = 0; n < STOCK_LEVEL_ORDERS && n < num_order; n++) {
+    uint32_t oid = loaded_order_id(wid, num_order - n - 1, c);
+    for (uint32_t olid = 1; olid <= num_line; olid++) {
+      uint32_t ol_key = make_order_line_key(
+          wid, did, oid, olid, c.num_warehouse(),
+          c.num_district_per_warehouse(), NUM_ORDER_MAX);
+      make_read_operation(sd_id, TPCC_ORDER_LINE, ol_key, td);
+      uint32_t s_key =
+          make_stock_key(wid, gen.iid_gen_.generate(), c.num_warehouse());
+      make_read_operation(sd_id, TPCC_STOCK, s_key, td);
+    }
+  }
+
+  // commit transaction request
+  make_end_tx_request(td);
+}
+
+void workload::ycsb(shard_id_t sd_id, per_terminal *td, ycsb_generator &gen) {
+  std::vector<ycsb_op> ops;
+  bool read_only = gen.next_tx(ops);
+  bool is_dist = false;
+  // begin transaction request
+  make_begin_tx_request(td, read_only,
+                        read_only ? YCSB_TX_READ_ONLY : YCSB_TX_READ_WRITE);
+  for (const ycsb_op &op : ops) {
+    if (op.sd_id != sd_id && !is_dist) {
+      is_dist = on_same_node(op.sd_id, sd_id);
+    }
+    switch (op.op_type) {
+    case TX_OP_READ: {
+      make_read_operation(op.sd_id, YCSB_MAIN, op.key, td);
+      break;
+    }
+    case TX_OP_READ_FOR_WRITE: {
+      make_read_for_write_operation(op.sd_id, YCSB_MAIN, op.key, td);
+      break;
+    }
+    case TX_OP_UPDATE: {
+      tuple_pb tuple = tuple_gen_.gen_tuple(YCSB_MAIN);
+      make_update_operation(op.sd_id, YCSB_MAIN, op.key, tuple, td);
+      break;
+    }
+    case TX_OP_INSERT: {
+      tuple_pb tuple = tuple_gen_.gen_tuple(YCSB_MAIN);
+      make_insert_operation(op.sd_id, YCSB_MAIN, op.key, tuple, td);
+      break;
+    }
+    default:BOOST_ASSERT(false);
+    }
+  }
+  // commit transaction request
+  make_end_tx_request(td);
+
   mutable_request(td).set_distributed(is_dist);
   if (is_dist) {
     td->num_dist_ ++;
@@ -838,6 +1767,15 @@ void workload::gen_procedure(shard_id_t sd_id, uint32_t terminal_id) {
   }
   td->rg_id_ = sd_id;
 
+  if (conf_.get_tpcc_config().benchmark() == "ycsb") {
+    ycsb_generator gen(conf_, sd_id, terminal_id, ycsb_zipf_);
+    for (uint32_t index = start_ord_id; index < end_ord_id; index++) {
+      ycsb(sd_id, td, gen);
+    }
+    // not shuffled, the reads of the latest records follow their inserts
+    return;
+  }
+
   id_generator gen(conf_.get_tpcc_config(), rg2wid_boundary_, sd_id);
 
   bool is_readonly_terminal = terminal_id > conf_.num_terminal();
@@ -846,7 +1784,19 @@ void workload::gen_procedure(shard_id_t sd_id, uint32_t terminal_id) {
     build_procedure(sd_id, td, gen, rng, is_readonly_terminal);
   }
 
-  std::shuffle(std::begin(td->requests_), std::end(td->requests_), rng);
+  std::vector<size_t> order(td->requests_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(std::begin(order), std::end(order), rng);
+  std::vector<tx_request> requests;
+  std::vector<bench_tx_type> tx_types;
+  requests.reserve(order.size());
+  tx_types.reserve(order.size());
+  for (size_t i : order) {
+    requests.emplace_back(std::move(td->requests_[i]));
+    tx_types.push_back(td->tx_types_[i]);
+  }
+  td->requests_.swap(requests);
+  td->tx_types_.swap(tx_types);
   /*
   for (auto i = td->requests_.begin(); i != td->requests_.end(); ++i) {
     tx_request &req = *i;
@@ -873,9 +1823,39 @@ void workload::build_procedure(
 
   if (is_read_only) {
     read_only(sd_id, td, gen, rng);
-  } else {
+    return;
+  }
+
+  const tpcc_config &c = conf_.get_tpcc_config();
+  uint32_t w = gen.tx_mix_gen_.generate();
+  if (w <= c.weight_new_order()) {
     new_order(sd_id, td, gen, rng);
+    return;
+  }
+  w -= c.weight_new_order();
+  if (w <= c.weight_payment()) {
+    payment(sd_id, td, gen);
+    return;
+  }
+  w -= c.weight_payment();
+  if (w <= c.weight_order_status()) {
+    order_status(sd_id, td, gen);
+    return;
   }
+  w -= c.weight_order_status();
+  if (w <= c.weight_delivery()) {
+    // no order left to deliver by this terminal
+    if (!delivery(sd_id, td, gen)) {
+      new_order(sd_id, td, gen, rng);
+    }
+    return;
+  }
+  w -= c.weight_delivery();
+  if (w <= c.weight_stock_level()) {
+    stock_level(sd_id, td, gen);
+    return;
+  }
+  new_order(sd_id, td, gen, rng);
 }
 
 void workload::read_only(
@@ -889,7 +1869,7 @@ void workload::read_only(
    **/
   auto c = conf_.get_tpcc_config();
   // begin transaction request
-  make_begin_tx_request(td, true);
+  make_begin_tx_request(td, true, TPCC_TX_READ_ONLY);
   rg_wid rg_wid = gen.gen_local_wid();
   uint32_t wid = rg_wid.wid_;
   shard_id_t sid = rg_wid.rg_id_;
@@ -977,19 +1957,35 @@ void workload::make_insert_operation(shard_id_t sd_id, table_id_t table,
   BOOST_ASSERT(!is_tuple_nil(op->tuple_row().tuple()));
 }
 
-void workload::make_begin_tx_request(per_terminal *td, bool read_only) {
-  create_tx_request(td, read_only);
+void workload::make_delete_operation(shard_id_t sd_id, table_id_t table,
+                                     uint64_t key, per_terminal *td) {
+  tx_operation *op = mutable_request(td).add_operations();
+  if (op == nullptr) {
+    return;
+  }
+  BOOST_ASSERT(sd_id != 0);
+  op->set_sd_id(sd_id);
+  op->set_op_type(TX_OP_DELETE);
+  op->mutable_tuple_row()->set_table_id(table);
+  op->mutable_tuple_row()->set_tuple_id(uint64_to_key(key));
+  op->mutable_tuple_row()->set_shard_id(sd_id);
+}
+
+void workload::make_begin_tx_request(per_terminal *td, bool read_only,
+                                     bench_tx_type type) {
+  create_tx_request(td, read_only, type);
 }
 
-void workload::make_end_tx_request(per_terminal *) {
-  if (oneshot_) {
-  } else {
+void workload::make_end_tx_request(per_terminal *td) {
+  uint32_t id = 0;
+  for (tx_operation &op : *td->requests_.rbegin()->mutable_operations()) {
+    op.set_operation_id(++id);
   }
 }
 
 tx_request &workload::mutable_request(per_terminal *td) {
   if (td->requests_.empty()) {
-    create_tx_request(td, false);
+    create_tx_request(td, false, TPCC_TX_NEW_ORDER);
   }
   return *td->requests_.rbegin();
 }
@@ -1021,13 +2017,17 @@ tpm_statistic workload::total_stat() {
   return total_result;
 }
 
-void workload::create_tx_request(per_terminal *td, bool read_only) {
+void workload::create_tx_request(per_terminal *td, bool read_only,
+                                 bench_tx_type type) {
   tx_request req;
   req.set_oneshot(oneshot_);
   req.set_client_request(true);
   req.set_read_only(read_only);
   req.set_terminal_id(td->terminal_id_);
+  req.set_trace(tx_span_sample());
+  req.set_trace_id(td->requests_.size());
   td->requests_.emplace_back(req);
+  td->tx_types_.push_back(type);
 }
 
 bool workload::output_result(std::chrono::nanoseconds duration) {
@@ -1036,8 +2036,10 @@ bool workload::output_result(std::chrono::nanoseconds duration) {
   for (auto i = terminal_data_.begin(); i != terminal_data_.end(); i++) {
     per_terminal &pt = *i->second;
     tpm_statistic r = pt.get_result();
-
-    r.duration = duration;
+    if (r.num_tx == 0) {
+      // no update in this period, the terminal waits all the period
+      r.duration = duration;
+    }
     total_result.add(r);
     if (pt.done_) {
       num_term_done++;
@@ -1056,7 +2058,9 @@ bool workload::output_result(std::chrono::nanoseconds duration) {
     return false;
   }
 
-  auto result = total_result.compute_bench_result(conf_.final_num_terminal(), conf_.node_name());
+  auto result = total_result.compute_bench_result(
+      conf_.final_num_terminal(), conf_.node_name(),
+      conf_.get_tpcc_config().open_loop_tps());
   float_t tps = result.tps();
   result_.push_back(total_result);
   moving_average(tps);
@@ -0,0 +1,201 @@
+#include "portal/ycsb.h"
+#include "common/logger.hpp"
+#include "common/panic.h"
+#include <algorithm>
+#include <boost/format.hpp>
+#include <utility>
+
+const static uint32_t YCSB_PERCENT_BASE = 10000;
+// the times to draw a key not accessed by the transaction yet
+const static uint32_t YCSB_KEY_RETRY = 8;
+
+ycsb_key_range ycsb_shard_key_range(const config &conf, shard_id_t sd_id) {
+  uint64_t num_shard = std::max<uint64_t>(1, conf.num_rg());
+  uint64_t num_record = std::max<uint64_t>(
+      1, conf.get_ycsb_config().num_record() / num_shard);
+  ycsb_key_range range{};
+  range.lower = (sd_id - 1) * num_record + 1;
+  range.upper = sd_id * num_record;
+  return range;
+}
+
+std::shared_ptr<const zipf_distribution<uint64_t>>
+ycsb_zipf_distribution(const config &conf) {
+  if (conf.get_ycsb_config().distribution() == "uniform") {
+    return nullptr;
+  }
+  // the shards have the same number of records
+  ycsb_key_range range = ycsb_shard_key_range(conf, 1);
+  return std::make_shared<const zipf_distribution<uint64_t>>(
+      range.upper - range.lower + 1, conf.get_ycsb_config().zipf_theta());
+}
+
+ycsb_mix ycsb_workload_mix(const std::string &workload) {
+  // read, update, insert, scan, read-modify-write
+  if (workload == "A") {
+    return ycsb_mix{50, 50, 0, 0, 0};
+  } else if (workload == "B") {
+    return ycsb_mix{95, 5, 0, 0, 0};
+  } else if (workload == "C") {
+    return ycsb_mix{100, 0, 0, 0, 0};
+  } else if (workload == "D") {
+    return ycsb_mix{95, 0, 5, 0, 0};
+  } else if (workload == "E") {
+    return ycsb_mix{0, 0, 5, 95, 0};
+  } else if (workload == "F") {
+    return ycsb_mix{50, 0, 0, 0, 50};
+  } else {
+    PANIC(boost::format("unknown YCSB workload %s") % workload);
+    return ycsb_mix{100, 0, 0, 0, 0};
+  }
+}
+
+ycsb_generator::ycsb_generator(
+    const config &conf, shard_id_t sd_id, uint32_t terminal_id,
+    std::shared_ptr<const zipf_distribution<uint64_t>> zipf)
+    : conf_(conf.get_ycsb_config()),
+      mix_(ycsb_workload_mix(conf.get_ycsb_config().workload())),
+      distribution_(KEY_ZIPFIAN), sd_id_(sd_id), terminal_id_(terminal_id),
+      num_shard_(std::max<uint32_t>(1, conf.num_rg())),
+      num_record_per_shard_(ycsb_shard_key_range(conf, sd_id).upper -
+                            ycsb_shard_key_range(conf, sd_id).lower + 1),
+      num_insert_(0), op_gen_(1, 100, stream_seed(1)),
+      percent_gen_(1, YCSB_PERCENT_BASE, stream_seed(2)),
+      shard_gen_(1, num_shard_, stream_seed(3)),
+      scan_length_gen_(1, std::max<uint32_t>(1, conf_.max_scan_length()),
+                       stream_seed(4)),
+      uniform_gen_(0, num_record_per_shard_ - 1, stream_seed(5)) {
+  const std::string &distribution = conf_.distribution();
+  if (distribution == "uniform") {
+    distribution_ = KEY_UNIFORM;
+  } else if (distribution == "latest") {
+    distribution_ = KEY_LATEST;
+  } else if (distribution == "zipfian") {
+    distribution_ = KEY_ZIPFIAN;
+  } else {
+    PANIC(boost::format("unknown YCSB key distribution %s") % distribution);
+  }
+  if (distribution_ != KEY_UNIFORM) {
+    BOOST_ASSERT(zipf && zipf->n() == num_record_per_shard_);
+    zipf_gen_ =
+        std::make_unique<zipf_generator<uint64_t>>(zipf, stream_seed(6));
+  }
+}
+
+uint64_t ycsb_generator::stream_seed(uint32_t stream) const {
+  // splitmix64 of the seed, the shard, the terminal and the stream
+  uint64_t z = conf_.seed() + (uint64_t(sd_id_) << 48) +
+               (uint64_t(terminal_id_) << 8) + stream;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+shard_id_t ycsb_generator::gen_remote_shard() {
+  shard_id_t sd_id = shard_gen_.generate();
+  while (sd_id == sd_id_) {
+    sd_id = shard_gen_.generate();
+  }
+  return sd_id;
+}
+
+uint64_t ycsb_generator::next_key(shard_id_t sd_id) {
+  uint64_t lower = (sd_id - 1) * num_record_per_shard_ + 1;
+  switch (distribution_) {
+  case KEY_UNIFORM: {
+    return lower + uniform_gen_.generate();
+  }
+  case KEY_ZIPFIAN: {
+    return lower + zipf_gen_->generate_scrambled();
+  }
+  case KEY_LATEST: {
+    // the latest records are those inserted by this terminal, then the last
+    // ones loaded
+    uint64_t rank = zipf_gen_->generate();
+    if (sd_id == sd_id_) {
+      if (rank < inserted_.size()) {
+        return inserted_[inserted_.size() - 1 - rank];
+      }
+      rank -= inserted_.size();
+    }
+    return lower + num_record_per_shard_ - 1 - rank % num_record_per_shard_;
+  }
+  }
+  return lower;
+}
+
+bool ycsb_generator::next_tx(std::vector<ycsb_op> &ops) {
+  ops.clear();
+  bool read_only = true;
+  bool cross_shard =
+      num_shard_ > 1 && percent_gen_.generate() <=
+          uint32_t(conf_.percent_cross_shard() * double(YCSB_PERCENT_BASE));
+  shard_id_t remote_sd_id = cross_shard ? gen_remote_shard() : sd_id_;
+
+  // a row is accessed once by a transaction
+  std::set<std::pair<shard_id_t, uint64_t>> accessed;
+  auto pick_key = [this, &accessed](shard_id_t sd_id) -> uint64_t {
+    for (uint32_t i = 0; i < YCSB_KEY_RETRY; i++) {
+      uint64_t key = next_key(sd_id);
+      if (accessed.insert(std::make_pair(sd_id, key)).second) {
+        return key;
+      }
+    }
+    return 0;
+  };
+
+  for (uint32_t i = 0; i < conf_.ops_per_tx(); i++) {
+    // a cross shard transaction accesses the remote shard every other op
+    shard_id_t sd_id = (cross_shard && i % 2 == 1) ? remote_sd_id : sd_id_;
+    uint32_t p = op_gen_.generate();
+    if (p <= mix_.read) {
+      uint64_t key = pick_key(sd_id);
+      if (key != 0) {
+        ops.push_back(ycsb_op{TX_OP_READ, sd_id, key});
+      }
+      continue;
+    }
+    p -= mix_.read;
+    if (p <= mix_.update) {
+      uint64_t key = pick_key(sd_id);
+      if (key != 0) {
+        ops.push_back(ycsb_op{TX_OP_UPDATE, sd_id, key});
+        read_only = false;
+      }
+      continue;
+    }
+    p -= mix_.update;
+    if (p <= mix_.insert) {
+      uint64_t key = make_ycsb_insert_key(terminal_id_, ++num_insert_);
+      accessed.insert(std::make_pair(sd_id_, key));
+      inserted_.push_back(key);
+      ops.push_back(ycsb_op{TX_OP_INSERT, sd_id_, key});
+      read_only = false;
+      continue;
+    }
+    p -= mix_.insert;
+    if (p <= mix_.scan) {
+      uint64_t start = pick_key(sd_id);
+      if (start == 0) {
+        continue;
+      }
+      ops.push_back(ycsb_op{TX_OP_READ, sd_id, start});
+      uint64_t upper = sd_id * num_record_per_shard_;
+      uint32_t length = scan_length_gen_.generate();
+      for (uint64_t key = start + 1; key < start + length && key <= upper;
+           key++) {
+        if (accessed.insert(std::make_pair(sd_id, key)).second) {
+          ops.push_back(ycsb_op{TX_OP_READ, sd_id, key});
+        }
+      }
+      continue;
+    }
+    uint64_t key = pick_key(sd_id);
+    if (key != 0) {
+      ops.push_back(ycsb_op{TX_OP_READ_FOR_WRITE, sd_id, key});
+      ops.push_back(ycsb_op{TX_OP_UPDATE, sd_id, key});
+      read_only = false;
+    }
+  }
+  return read_only;
+}
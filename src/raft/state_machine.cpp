@@ -1,14 +1,26 @@
 #include "raft/state_machine.h"
+#include "common/blog.h"
 #include "common/debug_url.h"
 #include "common/logger.hpp"
+#include "common/metrics.h"
 #include "common/variable.h"
 #include "network/net_service.h"
-#include <boost/format.hpp>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <memory>
 #include <random>
 #include <utility>
 
+// by the shard of the replication group, a process may run the state
+// machines of several shards
+static metric_family<metric_gauge, shard_id_t, METRICS_MAX_SHARDS>
+    raft_commit_lag("tddb_raft_commit_lag",
+                    "log entries appended and not yet committed", "shard");
+
 template<>
 enum_strings<raft_state>::e2s_t enum_strings<raft_state>::enum2str = {
     {RAFT_STATE_LEADER, "RAFT_STATE_LEADER"},
@@ -36,11 +48,27 @@ state_machine::state_machine(const config &conf, ptr<net_service> sender,
       follower_tick_max_(conf_.get_tpcc_config().raft_follow_tick_num()),
       append_log_entries_batch_max_(
           conf_.get_block_config().append_log_entries_batch_max()),
+      append_log_entries_batch_min_(
+          conf_.get_block_config().append_log_entries_batch_min()),
+      append_log_batch_bytes_max_(
+          conf_.get_block_config().append_log_batch_bytes_max()),
+      append_log_batch_deadline_us_(
+          conf_.get_block_config().append_log_batch_deadline_us()),
+      append_log_inflight_max_(
+          conf_.get_block_config().append_log_inflight_max()),
       fn_on_become_leader_(std::move(fn_on_become_leader)),
       fn_on_become_follower_(std::move(fn_on_become_follower)),
       fn_on_commit_entries_(std::move(fn_commit)),
+      snapshot_timeout_tick_(SNAPSHOT_TIMEOUT_MILLIS /
+                             std::max(raft_tick_ms_, uint32_t(1))),
       log_service_(std::move(log_service)), stopped_(false),
-      log_strand_(sender->get_service(SERVICE_IO)) {
+      tx_logs_bytes_(0),
+      timer_batch_(new boost::asio::steady_timer(
+          sender->get_service(SERVICE_REPLICATION))),
+      batch_timer_armed_(false), batch_deadline_expired_(false), rtt_us_(0),
+      fsync_us_(0), log_strand_(sender->get_service(SERVICE_IO)),
+      read_seq_(0), read_seq_acked_(0), leader_read_seq_(0),
+      read_forward_seq_(0), read_forward_tick_(0) {
   BOOST_ASSERT(node_id_ != 0);
   az_rtt_ms_ = az_rtt_ms_ == 0 ? 100 : az_rtt_ms_;
   start_ = std::chrono::steady_clock::now();
@@ -98,7 +126,7 @@ void state_machine::tick() {
     ms = raft_tick_ms_ + rnd_dist_(rnd_);
     if (priority_replica_node_ != 0 && priority_replica_node_ == node_id_) {
       // I want to be leader...
-      LOG(trace) << id_2_name(priority_replica_node_) << " want to be leader";
+      BLOG(trace, "{} want to be leader", blog_node(priority_replica_node_));
       node_transfer_leader(priority_replica_node_);
     }
   }
@@ -107,9 +135,7 @@ void state_machine::tick() {
                                     boost::asio::chrono::milliseconds(ms)));
   auto fn_timeout = [this](const boost::system::error_code &error) {
     if (not error.failed()) {
-      scoped_time t((boost::format("%s on start %s") % node_name_ %
-          (RAFT_STATE_LEADER == state_ ? "leader" : "non-leader"))
-                        .str());
+      scoped_time t("state_machine::on_tick_timeout");
       on_tick_timeout();
     } else {
       LOG(error) << " async wait error " << error.message();
@@ -262,8 +288,18 @@ void state_machine::on_tick_timeout() {
   tick_count_++;
   if (state_ == RAFT_STATE_LEADER) {
     {
-      // send heart beat
-      auto result = send_append_log(true);
+      // the queued logs are flushed as on a batch deadline, through the
+      // pipelining window; a bare heart beat is sent when the window is full
+      // or nothing is queued
+      if (tx_logs_.empty() || inflight_log_num() >= append_log_inflight_max_) {
+        heart_beat();
+      } else {
+        batch_deadline_expired_ = true;
+        auto r = try_flush_append_log();
+        if (not r) {
+          LOG(error) << "flush append log error " << r.error().message();
+        }
+      }
       if (tick_count_ > 10) {
         if (tx_logs_.size() > 100) {
           LOG(info) << " tx log queue size " << tx_logs_.size();
@@ -271,8 +307,19 @@ void state_machine::on_tick_timeout() {
         leader_advance_consistency_index();
         tick_count_ = 0;
       }
+      for (auto &kv : progress_) {
+        progress &p = kv.second;
+        if (p.snapshot_index_ != 0 &&
+            ++p.snapshot_tick_ > snapshot_timeout_tick_) {
+          // the snapshot is lost, take a new one on the next rejection
+          LOG(warning) << node_name_ << " install snapshot timeout on "
+                       << id_2_name(p.node_id_);
+          p.snapshot_index_ = 0;
+        }
+      }
     }
   } else {
+    timeout_read_index();
     if (tick_count_ >= follower_tick_max_) {
       tick_count_ = 0;
       timeout_request_vote();
@@ -365,8 +412,8 @@ result<void> state_machine::ccb_append_log(
     const ccb_append_log_request &msg, std::chrono::steady_clock::time_point ts
 
 ) {
-  LOG(trace) << id_2_name(msg.source()) << " to " << id_2_name(msg.dest())
-             << "append log";
+  BLOG(trace, "{} to {} append log", blog_node(msg.source()),
+       blog_node(msg.dest()));
 #ifdef MULTI_THREAD_EXECUTOR
   std::scoped_lock l(mutex_);
 #endif
@@ -376,17 +423,87 @@ result<void> state_machine::ccb_append_log(
   std::string *logs1 = mutable_msg.mutable_repeated_tx_logs();
   log_buffer buffer(const_cast<char *>(logs1->data()), logs1->size());
   buffer.set_timestamp(ms);
+  tx_logs_bytes_ += logs1->size();
   tx_logs_.emplace_back();
   tx_logs_.rbegin()->swap(*logs1);
 
-  // return send_append_log();
+  return try_flush_append_log();
+}
 
-  if (tx_logs_.size() >=
-      conf_.get_block_config().append_log_entries_batch_min()) {
-    return send_append_log(false);
-  } else {
+uint64_t state_machine::inflight_log_num() {
+  uint64_t last_index = last_log_index();
+  return last_index > commit_index_ ? last_index - commit_index_ : 0;
+}
+
+uint64_t state_machine::batch_deadline_us() const {
+  // wait for a fraction of a replication round trip at most, the longer a
+  // round trip is, the more logs can be merged without adding much latency
+  uint64_t us = (rtt_us_ + fsync_us_) / 4;
+  return std::min(us, append_log_batch_deadline_us_);
+}
+
+result<void> state_machine::try_flush_append_log() {
+  if (state_ != RAFT_STATE_LEADER) {
     return outcome::success();
   }
+  while (not tx_logs_.empty()) {
+    bool full = tx_logs_.size() >= append_log_entries_batch_max_ ||
+                tx_logs_bytes_ >= append_log_batch_bytes_max_;
+    uint64_t inflight = inflight_log_num();
+    if (inflight >= append_log_inflight_max_) {
+      batch_stat_.num_window_full_++;
+      break;
+    }
+    // when nothing is in flight, there is no reason to wait
+    bool idle =
+        inflight == 0 && tx_logs_.size() >= append_log_entries_batch_min_;
+    if (full) {
+      batch_stat_.num_flush_full_++;
+    } else if (batch_deadline_expired_) {
+      batch_stat_.num_flush_deadline_++;
+    } else if (idle) {
+      batch_stat_.num_flush_idle_++;
+    } else {
+      break;
+    }
+    batch_deadline_expired_ = false;
+    auto r = send_append_log(false);
+    if (not r) {
+      return r;
+    }
+  }
+  if (not tx_logs_.empty()) {
+    async_wait_batch_deadline();
+  } else {
+    batch_deadline_expired_ = false;
+  }
+  return outcome::success();
+}
+
+void state_machine::async_wait_batch_deadline() {
+  if (batch_timer_armed_ || batch_deadline_expired_) {
+    return;
+  }
+  batch_timer_armed_ = true;
+  timer_batch_->expires_after(
+      std::chrono::microseconds(batch_deadline_us()));
+  auto sm = shared_from_this();
+  auto fn_timeout = [sm](const boost::system::error_code &error) {
+#ifdef MULTI_THREAD_EXECUTOR
+    std::scoped_lock l(sm->mutex_);
+#endif
+    sm->batch_timer_armed_ = false;
+    if (error.failed()) {
+      return;
+    }
+    sm->batch_deadline_expired_ = true;
+    auto r = sm->try_flush_append_log();
+    if (not r) {
+      LOG(error) << "flush append log error " << r.error().message();
+    }
+  };
+  timer_batch_->async_wait(
+      boost::asio::bind_executor(get_strand(), fn_timeout));
 }
 
 result<void> state_machine::send_append_log(bool is_heart_beat) {
@@ -405,12 +522,12 @@ result<void> state_machine::send_append_log(bool is_heart_beat) {
   size_t total_size = 0;
   ptr<raft_log_entry> entry(new raft_log_entry());
   for (auto i = tx_logs_.begin(); i != tx_logs_.end(); i++) {
-    count++;
-    total_size += i->size();
-    if (count > append_log_entries_batch_max_) {
-      LOG(info) << "raft append log size: " << tx_logs_.size();
+    if (count > 0 && (count >= append_log_entries_batch_max_ ||
+                      total_size + i->size() > append_log_batch_bytes_max_)) {
       break;
     }
+    count++;
+    total_size += i->size();
   }
   repeated_tx_logs *to_send = entry->mutable_repeated_tx_logs();
   to_send->reserve(total_size);
@@ -418,6 +535,17 @@ result<void> state_machine::send_append_log(bool is_heart_beat) {
     to_send->append(tx_logs_.front());
     tx_logs_.pop_front();
   }
+  tx_logs_bytes_ -= total_size;
+
+  batch_stat_.num_batch_++;
+  batch_stat_.num_entries_ += count;
+  batch_stat_.num_bytes_ += total_size;
+  size_t slot = 0;
+  while ((count >> (slot + 1)) != 0 &&
+         slot + 1 < batch_stat_.entries_hist_.size()) {
+    slot++;
+  }
+  batch_stat_.entries_hist_[slot]++;
   auto r = leader_append_entry(entry);
   if (not r) {
     LOG(error) << "send_append_log append entry error " << r.error().message();
@@ -454,6 +582,7 @@ result<void> state_machine::leader_append_entry(ptr<raft_log_entry> entries) {
     log_debug_.insert(std::make_pair(entries->index(), st_append_log));
 #endif
     log_.push_back(entries);
+    raft_commit_lag[TO_RG_ID(node_id_)].set(int64_t(inflight_log_num()));
 
     check_log_index();
     std::vector<ptr<raft_log_entry>> vec;
@@ -578,15 +707,20 @@ void state_machine::append_entries(progress &tracer) {
   ae->set_prev_log_term(prev_log_term);
   ae->set_commit_index(commit_index_);
   ae->set_consistency_index(consistent_log_index_);
-  // ae->set_ts_append_send(ms);
+  ae->set_ts_append_send(
+      to_microseconds(std::chrono::steady_clock::now() - start_));
+  ae->set_read_seq(read_seq_);
   uint64_t size = log_.size();
 
   uint32_t send_count = tracer.append_log_num_;
   BOOST_ASSERT(size <= log_.size());
+  // the entries are serialized once and appended to the message by the
+  // connection without copying
+  std::vector<ptr<const std::string>> payload;
   for (uint64_t i = 0, off = start_offset; off < size && i < send_count;
        off++, i++) {
-    raft_log_entry *p = ae->add_entries();
-    *p = *log_[off];
+    const raft_log_entry *p = log_[off].get();
+    payload.push_back(entry_payload(*p));
     send_last_index = p->index();
 #ifdef TEST_APPEND_TIME
     {
@@ -606,12 +740,12 @@ void state_machine::append_entries(progress &tracer) {
     BOOST_ASSERT(log_[off]->index() == prev_log_index + 1 + i);
   }
 
-  ae->set_heart_beat(ae->entries_size() == 0);
-  if (ae->entries_size() > 0 && send_last_index > 0) {
+  ae->set_heart_beat(payload.empty());
+  if (!payload.empty() && send_last_index > 0) {
     tracer.send_next_index_ = send_last_index + 1;
   }
 
-  auto r = async_send(id, RAFT_APPEND_ENTRIES_REQ, ae);
+  auto r = async_send(id, RAFT_APPEND_ENTRIES_REQ, ae, std::move(payload));
   if (!r) {
     LOG(error) << "send message raft append entries error "
                << r.error().message();
@@ -619,6 +753,29 @@ void state_machine::append_entries(progress &tracer) {
   }
 }
 
+ptr<const std::string>
+state_machine::entry_payload(const raft_log_entry &entry) {
+  using google::protobuf::internal::WireFormatLite;
+  entry_payload_.erase(entry_payload_.begin(),
+                       entry_payload_.upper_bound(consistent_log_index_));
+  auto iter = entry_payload_.find(entry.index());
+  if (iter != entry_payload_.end() && iter->second.first == entry.term()) {
+    return iter->second.second;
+  }
+  auto payload = cs_new<std::string>();
+  {
+    google::protobuf::io::StringOutputStream zs(payload.get());
+    google::protobuf::io::CodedOutputStream os(&zs);
+    os.WriteTag(WireFormatLite::MakeTag(
+        append_entries_request::kEntriesFieldNumber,
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+    os.WriteVarint32(uint32_t(entry.ByteSizeLong()));
+    entry.SerializeWithCachedSizes(&os);
+  }
+  entry_payload_[entry.index()] = std::make_pair(entry.term(), payload);
+  return payload;
+}
+
 void state_machine::become_leader() {
   if (state_ != RAFT_STATE_CANDIDATE) {
     return;
@@ -648,8 +805,12 @@ void state_machine::become_leader() {
     p->match_index_ = last_index;
     p->send_next_index_ = 0;
     p->append_log_num_ = append_log_entries_batch_max_;
+    p->snapshot_index_ = 0;
+    p->read_seq_ = 0;
     BOOST_ASSERT(progress_[id].next_index_ != 0);
   }
+  read_seq_ = 0;
+  read_seq_acked_ = 0;
 
   if (fn_on_become_leader_) {
     fn_on_become_leader_(current_term_);
@@ -668,6 +829,10 @@ void state_machine::become_follower() {
     fn_on_become_follower_(current_term_);
   }
   state_ = RAFT_STATE_FOLLOWER;
+  entry_payload_.clear();
+  leader_read_seq_ = 0;
+  // the reads of the old leader and term cannot be confirmed any more
+  fail_read_index(EC::EC_NOT_LEADER);
 
   LOG(info) << "node " << node_name_ << " become follower at term "
             << current_term_;
@@ -747,9 +912,10 @@ void state_machine::handle_request_vote_request(
       request.term() == current_term_ && log_ok &&
           ((has_voted_for_ && voted_for_ == src_node_id) || !has_voted_for_);
 
-  LOG(trace) << "node " << node_id_ << " handle request vote request "
-             << "current term " << current_term_ << " request term "
-             << request.term() << " granted " << granted;
+  BLOG(trace,
+       "node {} handle request vote request current term {} request term {} "
+       "granted {}",
+       blog_node(node_id_), current_term_, request.term(), granted);
 
   auto response = std::make_shared<request_vote_response>();
   if (granted) {
@@ -782,9 +948,11 @@ void state_machine::handle_request_vote_response(
   uint32_t src_node_id = response.source();
   votes_responded_.insert(src_node_id);
   if (response.vote_granted()) {
-    LOG(trace) << node_name_ << " receive request_vote_response grant from "
-               << id_2_name(src_node_id) << " current term " << current_term_
-               << " response term " << response.term();
+    BLOG(trace,
+         "{} receive request_vote_response grant from {} current term {} "
+         "response term {}",
+         blog_node(node_id_), blog_node(src_node_id), current_term_,
+         response.term());
     votes_granted_.insert(src_node_id);
   }
 
@@ -811,10 +979,10 @@ void state_machine::response_append_entries_response(
   response->set_ts_append_send(ts_append_send);
   response->set_last_log_index(last_index);
   response->set_write_log(write_log);
+  response->set_read_seq(leader_read_seq_);
   if (not heart_beat) {
-    LOG(trace) << "response append entry, node " << id_2_name(node_id_)
-               << " match_index " << response->match_index() << "  to "
-               << id_2_name(to_node_id);
+    BLOG(trace, "response append entry, node {} match_index {} to {}",
+         blog_node(node_id_), response->match_index(), blog_node(to_node_id));
   }
 
   result<void> r = async_send(to_node_id, RAFT_APPEND_ENTRIES_RESP, response);
@@ -833,18 +1001,18 @@ void state_machine::handle_append_entries_request(
 
   if (not heart_beat) {
     if (request.entries_size() > 0) {
-      LOG(trace) << "node: " << node_name_ << " handle append log , index：["
-                 << request.entries(0).index() << ":"
-                 << request.entries(request.entries_size() - 1).index() << "]";
+      BLOG(trace, "node: {} handle append log , index：[{}:{}]",
+           blog_node(node_id_), request.entries(0).index(),
+           request.entries(request.entries_size() - 1).index());
     }
   } else {
-    LOG(trace) << "node " << node_name_ << " receive heart beat "
-               << current_term_ << "...";
+    BLOG(trace, "node {} receive heart beat {}...", blog_node(node_id_),
+         current_term_);
   }
   if (request.term() < current_term_) {
-    LOG(trace) << "node: " << node_name_ << " reject request from "
-               << id_2_name(request.source()) << " term: " << request.term()
-               << " current term " << current_term_;
+    BLOG(trace, "node: {} reject request from {} term: {} current term {}",
+         blog_node(node_id_), blog_node(request.source()), request.term(),
+         current_term_);
     response_append_entries_response(request.source(), request.ts_append_send(),
                                      false, 0, heart_beat, false);
     return; // reject request
@@ -855,6 +1023,7 @@ void state_machine::handle_append_entries_request(
     return;
   } else {
     leader_id_ = request.source();
+    leader_read_seq_ = request.read_seq();
     tick_count_ = 0;
   }
   if (state_ == RAFT_STATE_LEADER) {
@@ -888,14 +1057,14 @@ void state_machine::handle_append_entries_request(
   }
   if (!log_ok) {
     uint64_t prev_log_offset = log_index_to_offset(request.prev_log_index());
-    LOG(trace) << "node: " << node_name_ << " reject request from "
-               << id_2_name(request.source())
-               << " request prev log index:" << request.prev_log_index()
-               << " current last index: " << last_log_index()
-               << " consistent index:" << consistent_log_index_
-               << " request prev log term:" << request.prev_log_term();
+    BLOG(trace,
+         "node: {} reject request from {} request prev log index:{} current "
+         "last index: {} consistent index:{} request prev log term:{}",
+         blog_node(node_id_), blog_node(request.source()),
+         request.prev_log_index(), last_log_index(), consistent_log_index_,
+         request.prev_log_term());
     if (log_.size() > prev_log_offset) {
-      LOG(trace) << "log prev term:" << log_[prev_log_offset]->term();
+      BLOG(trace, "log prev term:{}", log_[prev_log_offset]->term());
     }
     response_append_entries_response(request.source(), request.ts_append_send(),
                                      false, 0, heart_beat, false);
@@ -916,7 +1085,7 @@ void state_machine::handle_append_entries_request(
       for (; log_i < log_.size() && req_i < entries_size; log_i++, req_i++) {
         if (request.entries(req_i).term() != log_[log_i]->term()) {
           // conflict, remove 1 entry, not necessarily send a response message
-          LOG(trace) << "log conflict";
+          BLOG(trace, "log conflict");
           log_.resize(next_offset);
           conflict = true;
           break;
@@ -937,9 +1106,8 @@ void state_machine::handle_append_entries_request(
             check_log_index();
             has_write_log = true;
           }
-          LOG(trace) << "log size > offset; index ["
-                     << log_[next_offset]->index() << ":"
-                     << log_[log_i - 1]->index() << "]";
+          BLOG(trace, "log size > offset; index [{}:{}]",
+               log_[next_offset]->index(), log_[log_i - 1]->index());
           std::vector<ptr<raft_log_entry>> vec(log_.begin() + write_begin_off,
                                                log_.end());
 
@@ -970,9 +1138,8 @@ void state_machine::handle_append_entries_request(
           };
           write_log(std::move(vec), fn_callback);
         } else {
-          LOG(trace) << "log size > offset; index ["
-                     << log_[next_offset]->index() << ":"
-                     << log_[log_i - 1]->index() << "]";
+          BLOG(trace, "log size > offset; index [{}:{}]",
+               log_[next_offset]->index(), log_[log_i - 1]->index());
           response_append_entries_response(
               request.source(), request.ts_append_send(), true,
               request.prev_log_index() + req_i, true, false);
@@ -996,8 +1163,8 @@ void state_machine::handle_append_entries_request(
         check_log_index();
         has_write_log = true;
       }
-      LOG(trace) << "handle append entry, node " << node_id_ << " receive "
-                 << num_entries << " log entries ";
+      BLOG(trace, "handle append entry, node {} receive {} log entries",
+           blog_node(node_id_), num_entries);
 
       auto sm = shared_from_this();
       auto fn_callback = [sm, request, entries_append, num, heart_beat,
@@ -1028,6 +1195,12 @@ void state_machine::handle_append_entries_response(
 
   bool heart_beat = response.heart_beat();
   p.last_reject_ = !response.success();
+  if (p.read_seq_ < response.read_seq()) {
+    p.read_seq_ = response.read_seq();
+    if (state_ == RAFT_STATE_LEADER && !read_waiting_.empty()) {
+      leader_release_read_index();
+    }
+  }
   if (response.success()) {
     if (p.match_index_ < response.match_index()) {
       p.match_index_ = response.match_index();
@@ -1036,12 +1209,23 @@ void state_machine::handle_append_entries_response(
       p.next_index_ = response.match_index() + 1;
       BOOST_ASSERT(p.next_index_ != 0);
     }
+    if (p.snapshot_index_ != 0 && p.match_index_ >= p.snapshot_index_) {
+      LOG(info) << node_name_ << " node " << id_2_name(src_node_id)
+                << " installed snapshot at index " << p.snapshot_index_;
+      p.snapshot_index_ = 0;
+    }
     if (not heart_beat) {
       auto now = std::chrono::steady_clock::now();
       uint64_t ms_since = to_milliseconds(now - start_);
-      LOG(trace) << node_name_ << " " << ms_since << "ms, match index： "
-                 << response.match_index()
-                 << " receive from : " << id_2_name(src_node_id);
+      uint64_t us_since = to_microseconds(now - start_);
+      if (response.ts_append_send() != 0 &&
+          us_since > response.ts_append_send()) {
+        uint64_t rtt = us_since - response.ts_append_send();
+        rtt_us_ = rtt_us_ == 0 ? rtt : (rtt_us_ * 7 + rtt) / 8;
+      }
+      BLOG(trace, "{} {}ms, match index： {} receive from : {}",
+           blog_node(node_id_), ms_since, response.match_index(),
+           blog_node(src_node_id));
 
       leader_advance_commit_index();
     }
@@ -1051,15 +1235,201 @@ void state_machine::handle_append_entries_response(
       if (i->second.next_index_ > 1 &&
           i->second.next_index_ - 1 > consistent_log_index_) {
         i->second.next_index_--;
-        LOG(trace) << "node " << node_name_ << " ->node "
-                   << id_2_name(src_node_id)
-                   << ", next index:" << i->second.next_index_;
+        BLOG(trace, "node {} ->node {}, next index:{}", blog_node(node_id_),
+             blog_node(src_node_id), i->second.next_index_);
         BOOST_ASSERT(i->second.next_index_ > consistent_log_index_);
+      } else if (response.last_log_index() < consistent_log_index_) {
+        // the entries this node needs were truncated
+        leader_send_snapshot(i->second);
       }
     }
   }
 }
 
+void state_machine::leader_send_snapshot(progress &p) {
+  if (p.snapshot_index_ != 0 || !fn_send_snapshot_) {
+    return;
+  }
+  std::optional<log_index_t> index =
+      fn_send_snapshot_(p.node_id_, current_term_, consistent_log_index_);
+  if (!index.has_value()) {
+    return;
+  }
+  LOG(info) << node_name_ << " send snapshot at index " << index.value()
+            << " to node " << id_2_name(p.node_id_);
+  p.snapshot_index_ = index.value();
+  p.snapshot_tick_ = 0;
+}
+
+void state_machine::handle_install_snapshot(uint64_t term, log_index_t index) {
+  if (term < current_term_ || state_ == RAFT_STATE_LEADER ||
+      index <= consistent_log_index_) {
+    return;
+  }
+  if (index < last_log_index()) {
+    log_.erase(log_.begin(), log_.begin() + log_index_to_offset(index) + 1);
+  } else {
+    log_.clear();
+  }
+  consistent_log_index_ = index;
+  commit_index_ = std::max(commit_index_, index);
+  log_state_->set_consistency_index(consistent_log_index_);
+  log_state_->set_commit_index(commit_index_);
+  ptr<raft_log_state> ptr(cs_new<raft_log_state>(*log_state_));
+  write_state(ptr, nullptr);
+  LOG(info) << node_name_ << " install snapshot at index " << index;
+  if (leader_id_ != 0) {
+    response_append_entries_response(leader_id_, 0, true, index, false, false);
+  }
+}
+
+void state_machine::read_index(fn_read_index fn) {
+#ifdef MULTI_THREAD_EXECUTOR
+  std::scoped_lock l(mutex_);
+#endif
+  if (state_ == RAFT_STATE_LEADER) {
+    leader_read_index(std::move(fn));
+    return;
+  }
+  if (state_ != RAFT_STATE_FOLLOWER || leader_id_ == 0) {
+    fn(EC::EC_NOT_LEADER, 0);
+    return;
+  }
+  uint64_t seq = ++read_forward_seq_;
+  auto request = cs_new<read_index_request>();
+  request->set_source(node_id_);
+  request->set_dest(leader_id_);
+  request->set_term(current_term_);
+  request->set_seq(seq);
+  result<void> r = async_send(leader_id_, RAFT_READ_INDEX_REQ, request);
+  if (not r) {
+    fn(EC::EC_NOT_LEADER, 0);
+    return;
+  }
+  read_forward_.insert(
+      std::make_pair(seq, std::make_pair(read_forward_tick_, std::move(fn))));
+}
+
+void state_machine::handle_read_index_request(
+    const read_index_request &request) {
+#ifdef MULTI_THREAD_EXECUTOR
+  std::scoped_lock l(mutex_);
+#endif
+  auto sm = shared_from_this();
+  node_id_t source = request.source();
+  uint64_t seq = request.seq();
+  auto fn = [sm, source, seq](EC ec, log_index_t index) {
+    auto response = cs_new<read_index_response>();
+    response->set_source(sm->node_id_);
+    response->set_dest(source);
+    response->set_term(sm->current_term_);
+    response->set_seq(seq);
+    response->set_error_code(ec);
+    response->set_read_index(index);
+    result<void> r = sm->async_send(source, RAFT_READ_INDEX_RESP, response);
+    if (not r) {
+      LOG(error) << "send message raft read index response error "
+                 << r.error().message();
+    }
+  };
+  if (state_ != RAFT_STATE_LEADER || request.term() != current_term_) {
+    fn(EC::EC_NOT_LEADER, 0);
+    return;
+  }
+  leader_read_index(std::move(fn));
+}
+
+void state_machine::handle_read_index_response(
+    const read_index_response &response) {
+#ifdef MULTI_THREAD_EXECUTOR
+  std::scoped_lock l(mutex_);
+#endif
+  auto i = read_forward_.find(response.seq());
+  if (i == read_forward_.end()) {
+    return;
+  }
+  fn_read_index fn = std::move(i->second.second);
+  read_forward_.erase(i);
+  fn(EC(response.error_code()), response.read_index());
+}
+
+void state_machine::leader_read_index(fn_read_index fn) {
+  // only a round started after this read arrived confirms that no other
+  // leader has committed entries not seen by this node
+  read_waiting_.emplace_back(read_seq_ + 1, std::move(fn));
+  leader_release_read_index();
+}
+
+void state_machine::leader_release_read_index() {
+  std::vector<uint64_t> seqs;
+  for (node_id_t id : nodes_ids_) {
+    if (id == node_id_) {
+      seqs.push_back(read_seq_);
+    } else {
+      auto i = progress_.find(id);
+      seqs.push_back(i == progress_.end() ? 0 : i->second.read_seq_);
+    }
+  }
+  if (!seqs.empty()) {
+    // the last round responded by a majority
+    std::sort(seqs.begin(), seqs.end(), std::greater<uint64_t>());
+    read_seq_acked_ = std::max(read_seq_acked_, seqs[seqs.size() / 2]);
+  }
+  // the commit index of a new leader is not up to date before it commits an
+  // entry of its term
+  if (leader_committed_in_term()) {
+    while (!read_waiting_.empty() &&
+           read_waiting_.front().first <= read_seq_acked_) {
+      fn_read_index fn = std::move(read_waiting_.front().second);
+      read_waiting_.pop_front();
+      fn(EC::EC_OK, commit_index_);
+    }
+  }
+  if (!read_waiting_.empty() && read_waiting_.back().first > read_seq_ &&
+      read_seq_ == read_seq_acked_) {
+    read_seq_++;
+    leader_send_append_entries();
+    if (nodes_ids_.size() == 1) {
+      leader_release_read_index();
+    }
+  }
+}
+
+bool state_machine::leader_committed_in_term() {
+  if (commit_index_ <= consistent_log_index_) {
+    return false;
+  }
+  uint64_t offset = log_index_to_offset(commit_index_);
+  return offset < log_.size() && log_[offset]->term() == current_term_;
+}
+
+void state_machine::fail_read_index(EC ec) {
+  std::deque<std::pair<uint64_t, fn_read_index>> waiting;
+  waiting.swap(read_waiting_);
+  for (auto &w : waiting) {
+    w.second(ec, 0);
+  }
+  std::map<uint64_t, std::pair<uint64_t, fn_read_index>> forward;
+  forward.swap(read_forward_);
+  for (auto &kv : forward) {
+    kv.second.second(ec, 0);
+  }
+}
+
+void state_machine::timeout_read_index() {
+  read_forward_tick_++;
+  while (!read_forward_.empty()) {
+    auto i = read_forward_.begin();
+    if (i->second.first + follower_tick_max_ > read_forward_tick_) {
+      break;
+    }
+    // the request or the response is lost, or the leader has gone
+    fn_read_index fn = std::move(i->second.second);
+    read_forward_.erase(i);
+    fn(EC::EC_NOT_LEADER, 0);
+  }
+}
+
 void state_machine::update_term(uint64_t term) {
   if (term <= current_term_) {
     return;
@@ -1093,6 +1463,8 @@ void state_machine::handle_debug(const std::string &path, std::ostream &os) {
       }
        */
     }
+  } else if (boost::regex_match(path, url_log_batch)) {
+    debug_log_batch(os);
   } else if (boost::regex_match(path, url_log_offset)) {
     size_t size = log_.size();
     if (size > 1) {
@@ -1111,6 +1483,32 @@ void state_machine::handle_debug(const std::string &path, std::ostream &os) {
   }
 }
 
+void state_machine::debug_log_batch(std::ostream &os) {
+  const batch_stat &s = batch_stat_;
+  os << "batch: " << s.num_batch_ << std::endl;
+  os << "entries: " << s.num_entries_ << std::endl;
+  os << "bytes: " << s.num_bytes_ << std::endl;
+  if (s.num_batch_ != 0) {
+    os << "avg entries: " << s.num_entries_ / s.num_batch_ << std::endl;
+    os << "avg bytes: " << s.num_bytes_ / s.num_batch_ << std::endl;
+  }
+  os << "flush full: " << s.num_flush_full_ << std::endl;
+  os << "flush deadline: " << s.num_flush_deadline_ << std::endl;
+  os << "flush idle: " << s.num_flush_idle_ << std::endl;
+  os << "window full: " << s.num_window_full_ << std::endl;
+  os << "rtt us: " << rtt_us_ << std::endl;
+  os << "fsync us: " << fsync_us_ << std::endl;
+  os << "deadline us: " << batch_deadline_us() << std::endl;
+  os << "queued: " << tx_logs_.size() << ", " << tx_logs_bytes_ << " bytes"
+     << std::endl;
+  for (size_t i = 0; i < s.entries_hist_.size(); i++) {
+    if (s.entries_hist_[i] != 0) {
+      os << "entries [" << (1ul << i) << ", " << (2ul << i)
+         << "): " << s.entries_hist_[i] << std::endl;
+    }
+  }
+}
+
 void state_machine::on_recv_message(message_type id, byte_buffer &msg_body) {
   switch (id) {
   case message_type::RAFT_APPEND_ENTRIES_REQ: {
@@ -1165,6 +1563,22 @@ void state_machine::on_recv_message(message_type id, byte_buffer &msg_body) {
     handle_transfer_notify(msg);
     break;
   }
+  case message_type::RAFT_READ_INDEX_REQ: {
+    read_index_request request;
+    result<void> res = buf_to_proto(msg_body, request);
+    if (res) {
+      handle_read_index_request(request);
+    }
+    break;
+  }
+  case message_type::RAFT_READ_INDEX_RESP: {
+    read_index_response response;
+    result<void> res = buf_to_proto(msg_body, response);
+    if (res) {
+      handle_read_index_response(response);
+    }
+    break;
+  }
   default:BOOST_ASSERT_MSG(false, "unknown message");
     break;
   }
@@ -1249,35 +1663,26 @@ void state_machine::update_commit_index(uint64_t index) {
   ptr<raft_log_state> ptr(cs_new<raft_log_state>(*log_state_));
   write_state(ptr, nullptr);
 
-  LOG(trace) << node_name_ << "commit " << off_begin << " : " << off_end;
+  BLOG(trace, "{} commit {} : {}", blog_node(node_id_), off_begin, off_end);
 
+  commit_index_ = commit_index;
+  raft_commit_lag[TO_RG_ID(node_id_)].set(int64_t(inflight_log_num()));
   if (fn_on_commit_entries_) {
-    if (tx_logs_.size() > append_log_entries_batch_max_) {
-      // penalty for a fast CC Block beyond RL Block's processing capability
-      // delay some milliseconds
-#ifdef DELAY_PENALTY
-      uint64_t delay_ms = tx_logs_.size() * 2;
-      ptr<boost::asio::steady_timer> timer(new boost::asio::steady_timer(
-          sender_->get_service(SERVICE_ASYNC_CONTEXT),
-          boost::asio::chrono::milliseconds(delay_ms)));
-      timer->async_wait([timer, vec,
-                         this](const boost::system::error_code &error) {
-        timer.get();
-        if (not error.failed()) {
-          this->fn_on_commit_entries_(EC::EC_OK,
-                                      this->state_ == RAFT_STATE_LEADER, vec);
-        }
-      });
-#else
-      LOG(info) << node_name_ << " log pile up " << tx_logs_.size();
+    // a fast CC Block beyond RL Block's processing capability is slowed down
+    // by the append log credits granted with these entries
+    fn_on_commit_entries_(EC::EC_OK, state_ == RAFT_STATE_LEADER, vec);
+  }
 
-      fn_on_commit_entries_(EC::EC_OK, state_ == RAFT_STATE_LEADER, vec);
-#endif //
-    } else {
-      fn_on_commit_entries_(EC::EC_OK, state_ == RAFT_STATE_LEADER, vec);
+  if (state_ == RAFT_STATE_LEADER) {
+    if (!read_waiting_.empty()) {
+      leader_release_read_index();
+    }
+    // the in flight window has moved
+    auto r = try_flush_append_log();
+    if (not r) {
+      LOG(error) << "flush append log error " << r.error().message();
     }
   }
-  commit_index_ = commit_index;
 }
 
 void state_machine::handle_transfer_leader(const ptr<transfer_leader> msg) {
@@ -1336,9 +1741,12 @@ void state_machine::write_log(std::vector<ptr<raft_log_entry>> &&logs,
   boost::asio::post(log_strand_, [sm, logs, fn] {
     log_write_option opt;
     opt.set_force(fn != nullptr);
+    auto begin = std::chrono::steady_clock::now();
     sm->log_service_->write_log(std::move(logs), opt);
-    boost::asio::post(sm->get_strand(), [fn] {
+    uint64_t us = to_microseconds(std::chrono::steady_clock::now() - begin);
+    boost::asio::post(sm->get_strand(), [sm, fn, us] {
       if (fn) {
+        sm->fsync_us_ = sm->fsync_us_ == 0 ? us : (sm->fsync_us_ * 7 + us) / 8;
         fn(EC::EC_OK);
       }
     });
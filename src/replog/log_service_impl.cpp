@@ -1,5 +1,6 @@
 #include "replog/log_service_impl.h"
 #include "common/logger.hpp"
+#include "common/scoped_time.h"
 #include <boost/filesystem.hpp>
 #include <memory>
 
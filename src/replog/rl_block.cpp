@@ -1,6 +1,5 @@
 #include "replog/rl_block.h"
 #include "common/debug_url.h"
-#include "proto/tx_op_type.h"
 
 rl_block::rl_block(const config &conf, ptr<net_service> service,
                    fn_become_leader f_become_leader,
@@ -12,8 +11,8 @@ rl_block::rl_block(const config &conf, ptr<net_service> service,
       commit_entries_(std::move(f_commit_entries)), cno_(0),
       node_id_(conf.node_id()), node_name_(id_2_name(conf.node_id())),
       ccb_node_id_(std::nullopt), dsb_node_id_(std::nullopt),
-      rlb_strand_(service_->get_service(SERVICE_ASYNC_CONTEXT)),
-      time_("RLB handle") {
+      replay_index_(0), replay_failed_index_(0), replay_failed_ec_(EC::EC_OK),
+      rlb_strand_(service_->get_service(SERVICE_ASYNC_CONTEXT)) {
   log_service_ = cs_new<log_service_impl>(conf, service_);
 
   fn_on_become_leader fn_bl = [this](uint64_t term) { on_become_leader(term); };
@@ -30,6 +29,10 @@ rl_block::rl_block(const config &conf, ptr<net_service> service,
 
   state_machine_ = cs_new<state_machine>(conf, service, fn_bl, fn_bf, fn_commit,
                                          log_service_);
+  state_machine_->set_send_snapshot(
+      [this](node_id_t node_id, uint64_t term, log_index_t min_index) {
+        return send_snapshot(node_id, term, min_index);
+      });
 
   start_ = state_machine_->start_time();
 }
@@ -54,7 +57,6 @@ void rl_block::on_start() {
 void rl_block::on_stop() {
   state_machine_->on_stop();
   log_service_->on_stop();
-  // time_.print();
 }
 
 result<void>
@@ -116,7 +118,32 @@ result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
 }
 
 result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
-                                          const ptr<replay_to_dsb_response>) {
+                                          const ptr<replay_to_dsb_response> m) {
+  handle_replay_to_dsb_response(*m);
+  return outcome::success();
+}
+
+result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<ccb_read_index_request> m) {
+  handle_read_index_request(*m);
+  return outcome::success();
+}
+
+result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<read_index_request> m) {
+  state_machine_->handle_read_index_request(*m);
+  return outcome::success();
+}
+
+result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<read_index_response> m) {
+  state_machine_->handle_read_index_response(*m);
+  return outcome::success();
+}
+
+result<void> rl_block::rlb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<dsb_snapshot_installed> m) {
+  handle_snapshot_installed(*m);
   return outcome::success();
 }
 
@@ -138,6 +165,7 @@ void rl_block::handle_register_ccb(const ccb_register_ccb_request &req) {
   res->set_ok(true);
   if (s.term != req.cno()) {
     LOG(trace) << node_name_ << " receive register_ccb request";
+    ccb_credit_owed_.erase(node_id);
     if (!ccb_node_id_.has_value() && ccb_shards_.empty()) {
       ccb_node_id_ = std::optional<node_id_t>(node_id);
     }
@@ -243,6 +271,7 @@ void rl_block::on_become_leader(uint64_t term) {
     fn_become_leader_(term);
   }
   cno_ = term;
+  release_read_index(EC::EC_NOT_LEADER);
   LOG(trace) << node_name_ << " on become leader";
   // ccb_responsed_[ccb_node_id_] = false;
   // send_report(true);
@@ -253,6 +282,7 @@ void rl_block::on_become_follower(uint64_t term) {
   std::scoped_lock l(mutex_);
 #endif
   cno_ = term;
+  release_read_index(EC::EC_NOT_LEADER);
   if (fn_become_follower_) {
     fn_become_follower_(term);
   }
@@ -279,22 +309,20 @@ void rl_block::on_commit_entries(EC ec, bool is_lead,
     );
   }
   if (ec == EC_OK) {
-    if (is_lead) {
-      response_commit_log(EC::EC_OK, logs
-      );
-    } else {
-// LOG(error) << node_name_ << " not lead node";
-    }
+    // a follower replays the committed logs to its DSBs, which serve the
+    // read only transactions of its CCB
+    response_commit_log(EC::EC_OK, is_lead, logs
+    );
   } else {
     if (is_lead) {
-      response_commit_log(ec, logs
+      response_commit_log(ec, is_lead, logs
       );
     }
   }
 }
 
 void rl_block::response_commit_log(
-    EC ec, const std::vector<ptr<raft_log_entry>> &logs) {
+    EC ec, bool is_lead, const std::vector<ptr<raft_log_entry>> &logs) {
   if (logs.empty()) {
     return;
   }
@@ -313,20 +341,26 @@ void rl_block::response_commit_log(
       commit_msg_map;
   std::unordered_map<node_id_t, ptr<replay_to_dsb_request>>
       replay_msg_map;
+  std::unordered_map<node_id_t, uint64_t> replay_log_index;
+  log_index_t log_index = 0;
   for (
     const ptr<raft_log_entry> &log
       : logs) {
+    log_index = log->index();
     repeated_tx_logs *tx_logs = log->mutable_repeated_tx_logs();
     handle_repeated_tx_logs_to_buffer(
         *tx_logs,
         [
             ec,
+            is_lead,
             shared,
             cno,
+            log_index,
             source,
             current_us,
             &commit_msg_map,
             &replay_msg_map,
+            &replay_log_index,
             &previous_latency,
             &tx_log_index_in_binary](
             log_buffer &buffer
@@ -348,87 +382,69 @@ void rl_block::response_commit_log(
             }
           }
 
-          auto iter = commit_msg_map.find(ccb_node_id);
-          if (iter == commit_msg_map.end()) {
-            commit_msg = cs_new<rlb_commit_entries>();
-            commit_msg_map.insert(std::make_pair(ccb_node_id, commit_msg));
-            commit_msg->set_error_code(ec);
-            commit_msg->set_dest(ccb_node_id);
-            commit_msg->set_source(source);
-            commit_msg->set_cno(cno);
-          } else {
-            commit_msg = iter->second;
-          }
-          commit_msg->mutable_repeated_tx_logs()->
-              append(buffer
-                         .
-                             data(), buffer
-                         .
-                             size()
-          );
-          ptr<tx_log_proto> log_proto(cs_new<tx_log_proto>());
-          bool ok = log_proto->ParseFromArray(buffer.payload_data(), buffer.payload_size());
-          if (!ok) {
-            LOG(error)
-              << shared->node_name_ << " parse log error";
-          }
-          if (shared->dsb_shards_.
-              size()
-              == 1 && shared->dsb_node_id_.
-              has_value()
-              ) {
-            node_id_t dsb_node_id = shared->dsb_node_id_.value();
-            auto iter_replay_msg = replay_msg_map.find(dsb_node_id);
-            if (iter_replay_msg == replay_msg_map.
-                end()
-                ) {
-              replay_msg = cs_new<replay_to_dsb_request>();
-              replay_msg_map.
-                  insert(std::make_pair(dsb_node_id, replay_msg)
-              );
-              replay_msg->
-                  set_dest(dsb_node_id);
-              replay_msg->
-                  set_source(source);
-              replay_msg->
-                  set_cno(cno);
+          if (is_lead) {
+            auto iter = commit_msg_map.find(ccb_node_id);
+            if (iter == commit_msg_map.end()) {
+              commit_msg = cs_new<rlb_commit_entries>();
+              commit_msg_map.insert(std::make_pair(ccb_node_id, commit_msg));
+              commit_msg->set_error_code(ec);
+              commit_msg->set_dest(ccb_node_id);
+              commit_msg->set_source(source);
+              commit_msg->set_cno(cno);
             } else {
-              replay_msg = iter_replay_msg->second;
+              commit_msg = iter->second;
             }
-            replay_msg->mutable_repeated_tx_logs()->
+            commit_msg->mutable_repeated_tx_logs()->
                 append(buffer
                            .
                                data(), buffer
                            .
                                size()
             );
+            shared->ccb_credit_owed_[ccb_node_id] += buffer.size();
+          }
+          shard_map_t shard_map = buffer.shard_map();
+          if (ec != EC::EC_OK || shard_map == 0) {
+            return;
+          }
+          // route by the shard map in log header, DSB filters the operations
+          // of shards it does not own
+          auto fn_replay = [&](node_id_t dsb_node_id) {
+            // several shards of a log may be stored on a same DSB
+            uint64_t &last_index = replay_log_index[dsb_node_id];
+            if (last_index == tx_log_index_in_binary) {
+              return;
+            }
+            last_index = tx_log_index_in_binary;
+            auto iter_replay_msg = replay_msg_map.find(dsb_node_id);
+            if (iter_replay_msg == replay_msg_map.end()) {
+              replay_msg = cs_new<replay_to_dsb_request>();
+              replay_msg_map.insert(std::make_pair(dsb_node_id, replay_msg));
+              replay_msg->set_dest(dsb_node_id);
+              replay_msg->set_source(source);
+              replay_msg->set_cno(cno);
+            } else {
+              replay_msg = iter_replay_msg->second;
+            }
+            replay_msg->set_log_index(log_index);
+            replay_msg->mutable_repeated_tx_logs()->append(buffer.data(),
+                                                           buffer.size());
+          };
+          if (shared->dsb_shards_.size() == 1 &&
+              shared->dsb_node_id_.has_value()) {
+            fn_replay(shared->dsb_node_id_.value());
           } else {
-            ptr<tx_log_proto> proto(cs_new<tx_log_proto>());
-            if (ec == EC::EC_OK && proto->ParseFromArray(buffer.payload_data(), buffer.payload_size())) {
-              for (auto op : proto->operations()) {
-                if (is_write_operation(op.op_type())) {
-                  shard_id_t id = op.tuple_row().shard_id();
-                  auto iter_dsb_node = shared->dsb_shards_.find(id);
-                  if (iter_dsb_node != shared->dsb_shards_.end()) {
-                    node_id_t dsb_node_id = iter_dsb_node->second;
-                    auto iter_replay_msg = replay_msg_map.find(dsb_node_id);
-                    if (iter_replay_msg == replay_msg_map.end()) {
-                      replay_msg = cs_new<replay_to_dsb_request>();
-                      replay_msg_map.insert(std::make_pair(dsb_node_id, replay_msg));
-                      replay_msg->set_dest(dsb_node_id);
-                      replay_msg->set_source(source);
-                      replay_msg->set_cno(cno);
-                    } else {
-                      replay_msg = iter_replay_msg->second;
-                    }
-                    *replay_msg->add_operations() = op;
-                  }
-                }
+            for (const auto &pair : shared->dsb_shards_) {
+              if (shard_map & shard_id_to_map(pair.first)) {
+                fn_replay(pair.second);
               }
             }
           }
         });
   }
+  if (is_lead) {
+    grant_append_log_credit(cno, commit_msg_map);
+  }
   for (auto &pair : commit_msg_map) {
     auto r_send_commit =
         service_->async_send(
@@ -448,6 +464,208 @@ void rl_block::response_commit_log(
         true);
     if (!r) {
       LOG(error) << "async send replay log entries error";
+    } else {
+      replay_inflight_[pair.first].insert(pair.second->log_index());
+    }
+  }
+  if (ec == EC::EC_OK) {
+    replay_index_ = log_index;
+    release_read_index(EC::EC_OK);
+  }
+}
+
+void rl_block::handle_replay_to_dsb_response(
+    const replay_to_dsb_response &res) {
+  auto iter = replay_inflight_.find(res.source());
+  if (iter == replay_inflight_.end()) {
+    return;
+  }
+  iter->second.erase(res.log_index());
+  EC ec = EC(res.error_code());
+  if (ec != EC::EC_OK) {
+    LOG(error) << "DSB " << id_2_name(res.source()) << " replay log "
+               << res.log_index() << " error " << enum2str(ec);
+    if (replay_failed_index_ == 0 || res.log_index() < replay_failed_index_) {
+      replay_failed_index_ = res.log_index();
+      replay_failed_ec_ = ec;
+    }
+  }
+  release_read_index(EC::EC_OK);
+}
+
+void rl_block::handle_read_index_request(const ccb_read_index_request &req) {
+  auto res = cs_new<rlb_read_index_response>();
+  res->set_source(node_id_);
+  res->set_dest(req.source());
+  res->set_cno(cno_);
+  res->set_xid(req.xid());
+  if (req.cno() != cno_) {
+    response_read_index(res, EC::EC_NOT_LEADER, 0);
+    return;
+  }
+  auto shared = shared_from_this();
+  state_machine_->read_index([shared, res](EC ec, log_index_t read_index) {
+    shared->response_read_index(res, ec, read_index);
+  });
+}
+
+void rl_block::response_read_index(ptr<rlb_read_index_response> res, EC ec,
+                                   log_index_t read_index) {
+  if (ec != EC::EC_OK) {
+    // the leader is unknown or has changed
+    res->set_error_code(ec);
+  } else if (replay_failed_index_ != 0 && read_index >= replay_failed_index_) {
+    res->set_error_code(replay_failed_ec_);
+  } else if (applied_index() < read_index) {
+    res->set_read_index(read_index);
+    read_index_waiting_.insert(std::make_pair(read_index, res));
+    return;
+  } else {
+    res->set_error_code(EC::EC_OK);
+    res->set_read_index(read_index);
+  }
+  auto r = service_->async_send(res->dest(), R2C_READ_INDEX_RESP, res);
+  if (!r) {
+    LOG(error) << "send read index response error";
+  }
+}
+
+log_index_t rl_block::applied_index() const {
+  log_index_t index = replay_index_;
+  if (replay_failed_index_ != 0) {
+    index = std::min(index, replay_failed_index_ - 1);
+  }
+  for (const auto &pair : replay_inflight_) {
+    if (!pair.second.empty()) {
+      // the replays of a DSB may be applied out of order
+      index = std::min(index, *pair.second.begin() - 1);
+    }
+  }
+  return index;
+}
+
+void rl_block::release_read_index(EC ec) {
+  if (read_index_waiting_.empty()) {
+    return;
+  }
+  auto begin = read_index_waiting_.begin();
+  auto end = read_index_waiting_.end();
+  if (ec == EC::EC_OK) {
+    end = read_index_waiting_.upper_bound(applied_index());
+  }
+  send_read_index(begin, end, ec);
+  read_index_waiting_.erase(begin, end);
+  if (ec == EC::EC_OK && replay_failed_index_ != 0) {
+    // never applied by the DSB which failed to replay
+    begin = read_index_waiting_.lower_bound(replay_failed_index_);
+    end = read_index_waiting_.end();
+    send_read_index(begin, end, replay_failed_ec_);
+    read_index_waiting_.erase(begin, end);
+  }
+}
+
+void rl_block::send_read_index(read_index_iter begin, read_index_iter end,
+                               EC ec) {
+  for (auto iter = begin; iter != end; ++iter) {
+    ptr<rlb_read_index_response> res = iter->second;
+    res->set_error_code(ec);
+    auto r = service_->async_send(res->dest(), R2C_READ_INDEX_RESP, res);
+    if (!r) {
+      LOG(error) << "send read index response error";
+    }
+  }
+}
+
+std::optional<log_index_t> rl_block::send_snapshot(node_id_t node_id,
+                                                   uint64_t term,
+                                                   log_index_t min_index) {
+  // the snapshot of the DSBs must cover the truncated logs
+  log_index_t index = applied_index();
+  if (index < min_index) {
+    return std::nullopt;
+  }
+  az_id_t az_id = conf_.get_node_conf(node_id).az_id();
+  std::set<std::pair<node_id_t, node_id_t>> sent;
+  for (const auto &pair : dsb_shards_) {
+    std::optional<node_id_t> to_dsb_node;
+    for (node_id_t id : conf_.get_rg_block_nodes(pair.first,
+                                                 BLOCK_TYPE_ID_DSB)) {
+      if (conf_.get_node_conf(id).az_id() == az_id) {
+        to_dsb_node = id;
+        break;
+      }
+    }
+    if (!to_dsb_node.has_value() ||
+        !sent.insert(std::make_pair(pair.second, to_dsb_node.value()))
+             .second) {
+      continue;
+    }
+    auto req = cs_new<rlb_snapshot_request>();
+    req->set_source(node_id_);
+    req->set_dest(pair.second);
+    req->set_cno(cno_);
+    req->set_term(term);
+    req->set_last_included_index(index);
+    req->set_to_dsb_node(to_dsb_node.value());
+    req->set_to_rlb_node(node_id);
+    auto r = service_->async_send(pair.second, R2D_SNAPSHOT_REQ, req);
+    if (!r) {
+      LOG(error) << "send snapshot request error";
+      return std::nullopt;
+    }
+  }
+  if (sent.empty()) {
+    return std::nullopt;
+  }
+  return std::optional<log_index_t>(index);
+}
+
+void rl_block::handle_snapshot_installed(const dsb_snapshot_installed &msg) {
+  std::set<node_id_t> &installed =
+      snapshot_installed_[msg.last_included_index()];
+  installed.insert(msg.source());
+  for (const auto &pair : dsb_shards_) {
+    if (!installed.contains(pair.second)) {
+      return;
+    }
+  }
+  log_index_t index = msg.last_included_index();
+  snapshot_installed_.erase(snapshot_installed_.begin(),
+                            snapshot_installed_.upper_bound(index));
+  // the logs after the index would be replayed again
+  replay_index_ = std::max(replay_index_, index);
+  if (replay_failed_index_ != 0 && replay_failed_index_ <= index) {
+    replay_failed_index_ = 0;
+    replay_failed_ec_ = EC::EC_OK;
+  }
+  state_machine_->handle_install_snapshot(msg.term(), index);
+}
+
+void rl_block::grant_append_log_credit(
+    uint64_t cno,
+    std::unordered_map<node_id_t, ptr<rlb_commit_entries>> &commit_msg_map) {
+  if (state_machine_->append_log_overloaded()) {
+    // hold the credits, they would be granted by the following commits when
+    // the queue has drained
+    return;
+  }
+  for (auto &pair : ccb_credit_owed_) {
+    if (pair.second == 0) {
+      continue;
+    }
+    ptr<rlb_commit_entries> commit_msg;
+    auto iter = commit_msg_map.find(pair.first);
+    if (iter == commit_msg_map.end()) {
+      commit_msg = cs_new<rlb_commit_entries>();
+      commit_msg_map.insert(std::make_pair(pair.first, commit_msg));
+      commit_msg->set_error_code(EC::EC_OK);
+      commit_msg->set_dest(pair.first);
+      commit_msg->set_source(node_id_);
+      commit_msg->set_cno(cno);
+    } else {
+      commit_msg = iter->second;
     }
+    commit_msg->set_credit_bytes(pair.second);
+    pair.second = 0;
   }
 }
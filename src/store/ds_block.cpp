@@ -1,7 +1,9 @@
 #include "store/ds_block.h"
+#include "common/blog.h"
 #include "common/debug_url.h"
 #include "common/define.h"
 #include "common/make_key.h"
+#include "common/metrics.h"
 #include "common/result.hpp"
 #include "common/tx_log.h"
 #include "common/uniform_generator.hpp"
@@ -9,11 +11,41 @@
 #include "proto/proto.h"
 #include "kv/rocks_store.h"
 #include "kv/tkrzw_store.h"
+
+static metric<metric_histogram> dsb_read_us(
+    "tddb_dsb_read_microseconds",
+    "time to read a tuple from the store of DSB, queueing included");
+static metric<metric_counter> dsb_replay_batches(
+    "tddb_dsb_replay_batches_total", "batches of log replayed to DSB");
+static metric<metric_counter> dsb_replay_operations(
+    "tddb_dsb_replay_operations_total", "operations replayed to DSB");
+static metric<metric_histogram> dsb_replay_us(
+    "tddb_dsb_replay_microseconds",
+    "time to write a replayed batch to the store");
+
 ds_block::ds_block(const config &conf, net_service *service)
     : conf_(conf), service_(service), node_id_(conf.node_id()),
       node_name_(id_2_name(conf.node_id())),
       rlb_node_id_(conf.register_to_node_id()), registered_(false), cno_(0),
-      time_("DSB handle"), tuple_gen_(conf.schema_manager().id2table()) {}
+      shard_map_(0),
+      tuple_gen_(conf.schema_manager().id2table()),
+      snapshot_chunk_bytes_(conf.get_block_config().snapshot_chunk_bytes()),
+      snapshot_chunk_inflight_(
+          conf.get_block_config().snapshot_chunk_inflight()),
+      snapshot_strand_(service->get_service(SERVICE_IO)),
+      snapshot_stream_(uint64_t(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count())),
+      warm_up_chunk_bytes_(conf.get_block_config().warm_up_chunk_bytes()),
+      warm_up_chunk_inflight_(
+          conf.get_block_config().warm_up_chunk_inflight()),
+      warm_up_strand_(service->get_service(SERVICE_ASYNC_CONTEXT)) {
+  for (shard_id_t shard_id : conf_.shard_ids()) {
+    shard_ids_.insert(shard_id);
+    shard_map_ |= shard_id_to_map(shard_id);
+  }
+}
 
 void ds_block::handle_debug(const std::string &path, std::ostream &os) {
   if (not boost::regex_match(path, url_json_prefix)) {
@@ -50,7 +82,6 @@ void ds_block::on_stop() {
     thd->join();
   }
   load_threads_.clear();
-  // time_.print();
 }
 
 void ds_block::send_register() {
@@ -90,7 +121,11 @@ void ds_block::send_register() {
 
 result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
                                           const ptr<warm_up_req> m) {
-  LOG(trace) << id_2_name(conf_.node_id()) << " DSB handle warm up";
+  BLOG(trace, "{} DSB handle warm up", blog_node(conf_.node_id()));
+  if (m->tuple_key().empty()) {
+    handle_warm_up_scan(m);
+    return outcome::success();
+  }
   ptr<warm_up_resp> response = cs_new<warm_up_resp>();
   response->set_source(node_id_);
   response->set_dest(m->source());
@@ -106,9 +141,8 @@ result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
       row->set_table_id(key.table_id());
       row->set_shard_id(key.shard_id());
     } else {
-      LOG(trace) << id_2_name(conf_.node_id())
-                 << " DSB cache , cannot find table_id:" << key.table_id()
-                 << ", key:" << key.tuple_id();
+      BLOG(trace, "{} DSB cache , cannot find table_id:{}, key:{}",
+           blog_node(conf_.node_id()), key.table_id(), key.tuple_id());
     }
   }
   result<void> rs =
@@ -120,6 +154,12 @@ result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
   return rs;
 }
 
+result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<warm_up_ack> m) {
+  handle_warm_up_ack(*m);
+  return outcome::success();
+}
+
 result<void>
 ds_block::dsb_handle_message(const ptr<connection> c, message_type,
                              const ptr<client_load_data_request> m) {
@@ -146,8 +186,39 @@ result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
   return outcome::success();
 }
 
+result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<rlb_snapshot_request> m) {
+  handle_snapshot_request(*m);
+  return outcome::success();
+}
+
+result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<dsb_snapshot_chunk> m) {
+  handle_snapshot_chunk(m);
+  return outcome::success();
+}
+
+result<void> ds_block::dsb_handle_message(const ptr<connection>, message_type,
+                                          const ptr<dsb_snapshot_ack> m) {
+  handle_snapshot_ack(*m);
+  return outcome::success();
+}
+
 void ds_block::handle_load_data_request(const client_load_data_request &msg,
                                         ptr<connection> conn) {
+  if (msg.workload() == "ycsb") {
+    uint64_t key_lower = msg.key_lower();
+    uint64_t key_upper = msg.key_upper();
+    LOG(info) << node_name_ << " load data, "
+              << " YCSB key [" << key_lower << ", " << key_upper << "]";
+    auto self = shared_from_this();
+    ptr<std::thread> thd(new std::thread([self, conn, key_lower, key_upper]() {
+      self->load_ycsb(key_lower, key_upper);
+      self->response_load_data_done(conn);
+    }));
+    load_threads_.push_back(thd);
+    return;
+  }
   BOOST_ASSERT(msg.wid_lower() < msg.wid_upper());
   for (uint32_t wid = msg.wid_lower(); wid <= msg.wid_upper(); wid++) {
     wid_.push_back(wid);
@@ -173,7 +244,7 @@ void ds_block::response_load_data_done(ptr<connection> conn) {
 }
 void ds_block::handle_register_dsb_response(
     const rlb_register_dsb_response &response) {
-  LOG(trace) << node_name_ << " on become leader";
+  BLOG(trace, "{} on become leader", blog_node(node_id_));
   std::unique_lock l(register_mutex_);
   if (!response.ok()) {
     return;
@@ -194,6 +265,8 @@ void ds_block::load_data() {
   load_item();
   LOG(info) << node_name_ << " load customer ...";
   load_customer();
+  LOG(info) << node_name_ << " load customer last name index ...";
+  load_customer_last_index();
   LOG(info) << node_name_ << " load stock ...";
   load_stock();
   LOG(info) << node_name_ << " load warehouse ...";
@@ -241,6 +314,31 @@ void ds_block::load_customer() {
     }
   }
 }
+
+// the customer c, c <= NUM_CUSTOMER_LAST_NAME, has the last name c, it is
+// indexed by the key of (wid, did, c)
+void ds_block::load_customer_last_index() {
+  const tpcc_config &c = conf_.get_tpcc_config();
+  uint32_t num_last_name = std::min<uint32_t>(c.num_customer_per_district(),
+                                              NUM_CUSTOMER_LAST_NAME);
+  for (auto wid : wid_) {
+    for (uint32_t did = 1; did <= c.num_district_per_warehouse(); did++) {
+      for (uint32_t name = 1; name <= num_last_name; name++) {
+        uint64_t id = make_customer_key(wid, did, name, c.num_warehouse(),
+                                        c.num_district_per_warehouse());
+        tuple_pb tuple = gen_tuple(TPCC_CUST_LAST_INDEX);
+        tuple_id_t key = uint64_to_key(id);
+        result<void> r =
+            store_->put(TPCC_CUST_LAST_INDEX, key, std::move(tuple));
+        if (!r) {
+          LOG(error) << node_name_ << " load customer last name index error "
+                     << enum2str(r.error().code());
+        }
+      }
+    }
+  }
+}
+
 void ds_block::load_stock() {
   const tpcc_config &c = conf_.get_tpcc_config();
   for (auto wid : wid_) {
@@ -292,8 +390,9 @@ void ds_block::load_order() {
   uniform_generator<uint32_t> generator(num_ol / 3, num_ol * 2 / 3);
 
   for (auto wid : wid_) {
-    for (uint32_t oid = max % wid + 1; oid <= max; oid += num_wh) {
-      for (uint64_t did = 1; did < num_dist; did++) {
+    for (uint32_t oid = first_loaded_order_id(wid, max); oid <= max;
+         oid += num_wh) {
+      for (uint64_t did = 1; did <= num_dist; did++) {
         uint32_t ioid = make_order_key(wid, did, oid, num_wh, num_dist);
         tuple_pb ord_tuple = gen_tuple(TPCC_ORDER);
         tuple_id_t okey = uint64_to_key(ioid);
@@ -313,9 +412,10 @@ void ds_block::load_order() {
             LOG(error) << node_name_ << " load order_line table error " << enum2str(rp.error().code());
           }
         }
-        if (oid > 2100) {
+        if (oid >= first_undelivered_order_id(max)) {
+          tuple_pb new_ord_tuple = gen_tuple(TPCC_NEW_ORDER);
           result<void> rp =
-              store_->put(TPCC_NEW_ORDER, okey, std::move(ord_tuple));
+              store_->put(TPCC_NEW_ORDER, okey, std::move(new_ord_tuple));
           if (!rp) {
             LOG(error) << node_name_ << " load new_order table error " << enum2str(rp.error().code());
           }
@@ -325,6 +425,23 @@ void ds_block::load_order() {
   }
 }
 
+void ds_block::load_ycsb(uint64_t key_lower, uint64_t key_upper) {
+  BOOST_ASSERT(store_);
+  for (uint64_t id = key_lower; id <= key_upper; id++) {
+    tuple_pb tuple = gen_tuple(YCSB_MAIN);
+    tuple_id_t key = uint64_to_key(id);
+    result<void> r = store_->put(YCSB_MAIN, key, std::move(tuple));
+    if (!r) {
+      LOG(error) << node_name_ << " load YCSB table error " << enum2str(r.error().code());
+    }
+  }
+  auto r = store_->sync();
+  if (not r) {
+    LOG(error) << node_name_ << "DSB load error " << enum2str(r.error().code());
+  }
+  LOG(info) << node_name_ << " DSB load YCSB data ";
+}
+
 void ds_block::handle_read_data(const ccb_read_request &request) {
   auto s = shared_from_this();
   auto start = std::chrono::steady_clock::now();
@@ -362,6 +479,7 @@ void ds_block::handle_read_data(const ccb_read_request &request) {
     auto end = std::chrono::steady_clock::now();
     uint64_t us = to_microseconds(end - start);
     response->set_latency_read_dsb(us);
+    dsb_read_us->record(us);
     if (response->has_tuple_row() && !response->tuple_row().tuple().empty()) {
       BOOST_ASSERT(!is_tuple_nil(response->tuple_row().tuple()));
     }
@@ -387,9 +505,25 @@ void ds_block::handle_replay_to_dsb(const ptr<replay_to_dsb_request> msg) {
       operations->push_back(op_ptr);
     }
   } else {
-    handle_repeated_tx_logs_to_proto(
-        msg->repeated_tx_logs(), [operations](ptr<tx_log_proto> logs) {
-          for (tx_operation &op : *logs->mutable_operations()) {
+    auto s = shared_from_this();
+    handle_repeated_tx_logs_to_buffer(
+        *msg->mutable_repeated_tx_logs(), [s, operations](log_buffer &buffer) {
+          shard_map_t shard_map = buffer.shard_map();
+          if ((shard_map & s->shard_map_) == 0) {
+            return;
+          }
+          // only a log writes other DSB's shards need checking shard id
+          bool filter = (shard_map & ~s->shard_map_) != 0;
+          tx_log_proto log;
+          if (not log.ParseFromArray(buffer.payload_data(),
+                                     int(buffer.payload_size()))) {
+            PANIC("error handle tx log");
+          }
+          for (tx_operation &op : *log.mutable_operations()) {
+            if (filter &&
+                not s->shard_ids_.contains(op.tuple_row().shard_id())) {
+              continue;
+            }
             ptr<tx_operation> o(cs_new<tx_operation>());
             o->Swap(&op);
             operations->push_back(o);
@@ -398,17 +532,331 @@ void ds_block::handle_replay_to_dsb(const ptr<replay_to_dsb_request> msg) {
   }
   auto s = shared_from_this();
   node_id_t to_node_id = msg->source();
-  auto fn = [s, to_node_id, operations]() {
+  uint64_t log_index = msg->log_index();
+  auto fn = [s, to_node_id, log_index, operations]() {
+    auto start = std::chrono::steady_clock::now();
     auto r = s->store_->replay(operations);
+    dsb_replay_us->record(
+        uint64_t(to_microseconds(std::chrono::steady_clock::now() - start)));
+    dsb_replay_batches->inc();
+    dsb_replay_operations->inc(operations->size());
+    if (not r) {
+      LOG(error) << " replay log " << log_index << " error "
+                 << r.error().message();
+    }
+    // RLB tracks the applied log index for the replica reads, a failed
+    // replay is answered too, or RLB would wait for it forever
+    auto res = std::make_shared<replay_to_dsb_response>();
+    res->set_source(s->node_id_);
+    res->set_dest(to_node_id);
+    res->set_log_index(log_index);
+    res->set_error_code(r ? EC::EC_OK : r.error().code());
+    auto rs = s->service_->async_send(to_node_id, D2R_WRITE_BATCH_RESP, res);
+    if (not rs) {
+      LOG(error) << " send replay to dsb response error";
+    }
+  };
+  boost::asio::post(service_->get_service(SERVICE_IO), fn);
+}
+
+void ds_block::handle_snapshot_request(const rlb_snapshot_request &request) {
+  auto s = shared_from_this();
+  auto fn = [s, request]() {
+    // the replays acknowledged to RLB are all in this snapshot
+    auto r = s->store_->create_snapshot();
+    if (!r) {
+      LOG(error) << s->node_name_ << " create snapshot error";
+      return;
+    }
+    ptr<snapshot_send> send(cs_new<snapshot_send>());
+    send->request_ = request;
+    send->snapshot_ = r.value();
+    send->stream_ = ++s->snapshot_stream_;
+    send->seq_ = 0;
+    send->acked_ = 0;
+    send->done_ = false;
+    // a new request replaces the previous one to the same DSB
+    s->snapshot_send_[request.to_dsb_node()] = send;
+    LOG(info) << s->node_name_ << " send snapshot at index "
+              << request.last_included_index() << " to "
+              << id_2_name(request.to_dsb_node());
+    s->send_snapshot_chunks(send);
+  };
+  boost::asio::post(snapshot_strand_, fn);
+}
+
+void ds_block::send_snapshot_chunks(ptr<snapshot_send> send) {
+  const rlb_snapshot_request &request = send->request_;
+  // flow control, at most snapshot_chunk_inflight_ chunks not acknowledged
+  while (!send->done_ && send->seq_ - send->acked_ < snapshot_chunk_inflight_) {
+    auto chunk = cs_new<dsb_snapshot_chunk>();
+    auto r = send->snapshot_->next_chunk(snapshot_chunk_bytes_, *chunk);
+    if (!r) {
+      LOG(error) << node_name_ << " read snapshot chunk error";
+      snapshot_send_.erase(request.to_dsb_node());
+      return;
+    }
+    send->done_ = r.value();
+    chunk->set_source(node_id_);
+    chunk->set_dest(request.to_dsb_node());
+    chunk->set_term(request.term());
+    chunk->set_last_included_index(request.last_included_index());
+    chunk->set_to_rlb_node(request.to_rlb_node());
+    chunk->set_seq(send->seq_++);
+    chunk->set_done(send->done_);
+    chunk->set_stream(send->stream_);
+    auto rs = service_->async_send(request.to_dsb_node(), D2D_SNAPSHOT_CHUNK,
+                                   chunk);
+    if (!rs) {
+      LOG(error) << node_name_ << " send snapshot chunk error";
+    }
+  }
+}
+
+void ds_block::handle_snapshot_chunk(const ptr<dsb_snapshot_chunk> chunk) {
+  auto s = shared_from_this();
+  auto fn = [s, chunk]() {
+    ptr<snapshot_recv> &recv = s->snapshot_recv_[chunk->source()];
+    if (recv && chunk->stream() < recv->stream_) {
+      // a chunk of a stream replaced
+      return;
+    }
+    if (!recv || recv->stream_ < chunk->stream()) {
+      recv = cs_new<snapshot_recv>();
+      recv->stream_ = chunk->stream();
+      recv->next_seq_ = 0;
+      recv->done_ = false;
+    }
+    if (recv->done_ || chunk->seq() < recv->next_seq_) {
+      return;
+    }
+    // the chunks are sent on any of the connections to this DSB, install
+    // them in order of seq, so the first one clears the store before the
+    // others are written
+    recv->pending_[chunk->seq()] = chunk;
+    for (auto iter = recv->pending_.find(recv->next_seq_);
+         iter != recv->pending_.end();
+         iter = recv->pending_.find(recv->next_seq_)) {
+      ptr<dsb_snapshot_chunk> next = iter->second;
+      recv->pending_.erase(iter);
+      recv->next_seq_++;
+      if (!s->install_snapshot_chunk(*next)) {
+        recv->done_ = true;
+        recv->pending_.clear();
+        return;
+      }
+    }
+  };
+  boost::asio::post(snapshot_strand_, fn);
+}
+
+bool ds_block::install_snapshot_chunk(const dsb_snapshot_chunk &chunk) {
+  auto r = store_->install_snapshot(chunk);
+  auto ack = cs_new<dsb_snapshot_ack>();
+  ack->set_source(node_id_);
+  ack->set_dest(chunk.source());
+  ack->set_last_included_index(chunk.last_included_index());
+  ack->set_seq(chunk.seq());
+  ack->set_error_code(r ? EC::EC_OK : r.error().code());
+  ack->set_stream(chunk.stream());
+  auto rs = service_->async_send(chunk.source(), D2D_SNAPSHOT_ACK, ack);
+  if (!rs) {
+    LOG(error) << node_name_ << " send snapshot ack error";
+  }
+  if (!r) {
+    return false;
+  }
+  if (!chunk.done()) {
+    return true;
+  }
+  // all the chunks from 0 to this one are installed
+  auto installed = cs_new<dsb_snapshot_installed>();
+  installed->set_source(node_id_);
+  installed->set_dest(chunk.to_rlb_node());
+  installed->set_term(chunk.term());
+  installed->set_last_included_index(chunk.last_included_index());
+  LOG(info) << node_name_ << " installed snapshot at index "
+            << chunk.last_included_index();
+  auto ri = service_->async_send(chunk.to_rlb_node(), D2R_SNAPSHOT_INSTALLED,
+                                 installed);
+  if (!ri) {
+    LOG(error) << node_name_ << " send snapshot installed error";
+  }
+  return false;
+}
+
+void ds_block::handle_snapshot_ack(const dsb_snapshot_ack &ack) {
+  auto s = shared_from_this();
+  auto fn = [s, ack]() {
+    auto iter = s->snapshot_send_.find(ack.source());
+    if (iter == s->snapshot_send_.end() ||
+        iter->second->stream_ != ack.stream()) {
+      return;
+    }
+    ptr<snapshot_send> send = iter->second;
+    if (ack.error_code() != EC::EC_OK) {
+      // the leader would retry when the follower has not installed it
+      LOG(error) << s->node_name_ << " install snapshot error on "
+                 << id_2_name(ack.source());
+      s->snapshot_send_.erase(iter);
+      return;
+    }
+    send->acked_ = std::max(send->acked_, ack.seq() + 1);
+    if (send->done_ && send->acked_ == send->seq_) {
+      s->snapshot_send_.erase(iter);
+      return;
+    }
+    s->send_snapshot_chunks(send);
+  };
+  boost::asio::post(snapshot_strand_, fn);
+}
+
+void ds_block::handle_warm_up_scan(const ptr<warm_up_req> request) {
+  auto s = shared_from_this();
+  auto fn = [s, request]() {
+    ptr<warm_up_send> send(cs_new<warm_up_send>());
+    send->request_ = *request;
+    for (uint32_t table_id : request->table_id()) {
+      send->tables_.push_back(table_id);
+    }
+    if (send->tables_.empty()) {
+      for (table_id_t table_id = 0; table_id < MAX_TABLES; table_id++) {
+        send->tables_.push_back(table_id);
+      }
+    }
+    send->table_index_ = 0;
+    send->rand_.seed(uint32_t(request->term_id()));
+    send->seq_ = 0;
+    send->acked_ = 0;
+    send->done_ = false;
+    // the store key has no shard, the rows of a DSB holding several shards
+    // cannot be told apart by a scan
+    EC ec = EC::EC_OK;
+    if (!s->shard_ids_.contains(request->shard_id())) {
+      ec = EC::EC_NOT_FOUND_ERROR;
+    } else if (s->shard_ids_.size() > 1) {
+      ec = EC::EC_NOT_IMPLEMENTED;
+    }
+    if (ec != EC::EC_OK) {
+      auto chunk = cs_new<warm_up_chunk>();
+      chunk->set_source(s->node_id_);
+      chunk->set_dest(request->source());
+      chunk->set_term_id(request->term_id());
+      chunk->set_shard_id(request->shard_id());
+      chunk->set_stream(request->stream());
+      chunk->set_seq(0);
+      chunk->set_done(true);
+      chunk->set_error_code(ec);
+      auto rs = s->service_->async_send(request->source(), D2C_WARM_UP_CHUNK,
+                                        chunk);
+      if (!rs) {
+        LOG(error) << s->node_name_ << " send warm up chunk error";
+      }
+      return;
+    }
+    // a new request replaces the previous one of the same term
+    s->warm_up_send_[std::make_pair(request->source(), request->term_id())] =
+        send;
+    LOG(info) << s->node_name_ << " warm up shard " << request->shard_id()
+              << " of " << id_2_name(request->source()) << ", "
+              << send->tables_.size() << " tables";
+    s->send_warm_up_chunks(send);
+  };
+  boost::asio::post(warm_up_strand_, fn);
+}
+
+void ds_block::send_warm_up_chunks(ptr<warm_up_send> send) {
+  const warm_up_req &request = send->request_;
+  // flow control, at most warm_up_chunk_inflight_ chunks not cached by CCB
+  while (!send->done_ && send->seq_ - send->acked_ < warm_up_chunk_inflight_) {
+    auto chunk = cs_new<warm_up_chunk>();
+    auto r = next_warm_up_chunk(*send, *chunk);
     if (r) {
-      auto res = std::make_shared<replay_to_dsb_response>();
-      auto rs = s->service_->async_send(to_node_id, D2R_WRITE_BATCH_RESP, res);
-      if (not rs) {
-        LOG(error) << " send replay to dsb response error";
+      send->done_ = r.value();
+    } else {
+      // CCB is told, the rows sent are cached
+      LOG(error) << node_name_ << " read warm up chunk error";
+      send->done_ = true;
+      chunk->set_error_code(r.error().code());
+    }
+    chunk->set_source(node_id_);
+    chunk->set_dest(request.source());
+    chunk->set_term_id(request.term_id());
+    chunk->set_shard_id(request.shard_id());
+    chunk->set_stream(request.stream());
+    chunk->set_seq(send->seq_++);
+    chunk->set_done(send->done_);
+    auto rs = service_->async_send(request.source(), D2C_WARM_UP_CHUNK, chunk);
+    if (!rs) {
+      LOG(error) << node_name_ << " send warm up chunk error";
+    }
+  }
+}
+
+result<bool> ds_block::next_warm_up_chunk(warm_up_send &send,
+                                          warm_up_chunk &chunk) {
+  const warm_up_req &request = send.request_;
+  bool sample = request.percent() > 0 && request.percent() < 1.0;
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  uint64_t bytes = 0;
+  while (bytes < warm_up_chunk_bytes_) {
+    if (send.table_index_ >= send.tables_.size()) {
+      return outcome::success(true);
+    }
+    if (!send.scan_) {
+      auto r = store_->create_scan(send.tables_[send.table_index_],
+                                   request.tuple_id_lower(),
+                                   request.tuple_id_upper());
+      if (!r) {
+        return outcome::failure(r.error().code());
+      }
+      send.scan_ = r.value();
+    }
+    dsb_snapshot_chunk rows;
+    auto r = send.scan_->next_chunk(warm_up_chunk_bytes_ - bytes, rows);
+    if (!r) {
+      return outcome::failure(r.error().code());
+    }
+    for (tuple_row &row : *rows.mutable_rows()) {
+      bytes += row.tuple().size();
+      if (sample && dist(send.rand_) >= request.percent()) {
+        continue;
       }
+      // a scan is served only by a DSB holding the one shard
+      row.set_shard_id(request.shard_id());
+      chunk.add_rows()->Swap(&row);
     }
+    if (r.value()) {
+      // the end of this table
+      send.scan_.reset();
+      send.table_index_++;
+    }
+  }
+  return outcome::success(send.table_index_ >= send.tables_.size());
+}
+
+void ds_block::handle_warm_up_ack(const warm_up_ack &ack) {
+  auto s = shared_from_this();
+  auto fn = [s, ack]() {
+    auto iter =
+        s->warm_up_send_.find(std::make_pair(ack.source(), ack.term_id()));
+    if (iter == s->warm_up_send_.end()) {
+      return;
+    }
+    ptr<warm_up_send> send = iter->second;
+    if (send->request_.stream() != ack.stream()) {
+      // an ack of the stream replaced by a retry
+      return;
+    }
+    // CCB caches the chunks in parallel, the acks are not in order
+    send->acked_++;
+    if (send->done_ && send->acked_ == send->seq_) {
+      s->warm_up_send_.erase(iter);
+      return;
+    }
+    s->send_warm_up_chunks(send);
   };
-  boost::asio::post(service_->get_service(SERVICE_IO), fn);
+  boost::asio::post(warm_up_strand_, fn);
 }
 
 void ds_block::send_error_consistency(node_id_t node_id, message_type mt) {
@@ -174,4 +174,106 @@ result<ptr<tuple_pb>> rocks_store::get(table_id_t table_id, tuple_id_t key) {
   return outcome::success();
 }
 
+// the rows of the keys in [begin, end)
+class rocks_snapshot : public store_snapshot {
+private:
+  rocksdb::DB *db_;
+  const rocksdb::Snapshot *snapshot_;
+  std::unique_ptr<rocksdb::Iterator> iter_;
+  key128 end_;
+
+public:
+  rocks_snapshot(rocksdb::DB *db, const key128 &begin, const key128 &end)
+      : db_(db), snapshot_(db->GetSnapshot()), end_(end) {
+    rocksdb::ReadOptions options;
+    options.snapshot = snapshot_;
+    // a scan is read once, do not evict the hot blocks of the cache
+    options.fill_cache = false;
+    iter_.reset(db_->NewIterator(options));
+    iter_->Seek(rocksdb::Slice(begin));
+  }
+
+  ~rocks_snapshot() override {
+    iter_.reset();
+    db_->ReleaseSnapshot(snapshot_);
+  }
+
+  result<bool> next_chunk(uint64_t max_bytes,
+                          dsb_snapshot_chunk &chunk) override {
+    uint64_t bytes = 0;
+    for (; in_range() && bytes < max_bytes; iter_->Next()) {
+      rocksdb::Slice key = iter_->key();
+      rocksdb::Slice value = iter_->value();
+      key128 k(key.data(), key.size());
+      tuple_row *row = chunk.add_rows();
+      row->set_table_id(k.long1());
+      row->set_tuple_id(k.long2());
+      row->set_tuple(value.data(), value.size());
+      bytes += key.size() + value.size();
+    }
+    EC ec = rocks_to_ec(iter_->status().code());
+    if (ec != EC::EC_OK) {
+      return outcome::failure(ec);
+    }
+    return outcome::success(!in_range());
+  }
+
+private:
+  bool in_range() const {
+    if (!iter_->Valid()) {
+      return false;
+    }
+    key128 k(iter_->key().data(), iter_->key().size());
+    return k.long1() < end_.long1() ||
+           (k.long1() == end_.long1() && k.long2() < end_.long2());
+  }
+};
+
+result<ptr<store_snapshot>> rocks_store::create_snapshot() {
+  ptr<store_snapshot> snapshot(
+      new rocks_snapshot(db_, key128(uint64_t(0), uint64_t(0)),
+                         key128(uint64_t(MAX_TABLES), uint64_t(0))));
+  return outcome::success(snapshot);
+}
+
+result<ptr<store_snapshot>> rocks_store::create_scan(table_id_t table_id,
+                                                     tuple_id_t lower,
+                                                     tuple_id_t upper) {
+  if (table_id >= MAX_TABLES) {
+    return outcome::failure(EC::EC_UNKNOWN_TABLE_ID);
+  }
+  key128 end = upper == 0 ? key128(uint64_t(table_id) + 1, uint64_t(0))
+                          : key128(uint64_t(table_id), uint64_t(upper));
+  key128 begin(uint64_t(table_id), uint64_t(lower));
+  ptr<store_snapshot> snapshot(new rocks_snapshot(db_, begin, end));
+  return outcome::success(snapshot);
+}
+
+result<void> rocks_store::install_snapshot(const dsb_snapshot_chunk &chunk) {
+  rocksdb::WriteBatch batch;
+  if (chunk.seq() == 0) {
+    key128 begin(uint64_t(0), uint64_t(0));
+    key128 end(uint64_t(MAX_TABLES), uint64_t(0));
+    rocksdb::Status s = batch.DeleteRange(rocksdb::Slice(begin),
+                                          rocksdb::Slice(end));
+    if (!s.ok()) {
+      return outcome::failure(rocks_to_ec(s.code()));
+    }
+  }
+  for (const tuple_row &row : chunk.rows()) {
+    key128 k(row.table_id(), row.tuple_id());
+    rocksdb::Status s =
+        batch.Put(rocksdb::Slice(k), rocksdb::Slice(row.tuple()));
+    if (!s.ok()) {
+      return outcome::failure(rocks_to_ec(s.code()));
+    }
+  }
+  rocksdb::Status sw = db_->Write(rocksdb::WriteOptions(), &batch);
+  EC ec = rocks_to_ec(sw.code());
+  if (ec != EC::EC_OK) {
+    return outcome::failure(ec);
+  }
+  return outcome::success();
+}
+
 #endif // DB_TYPE_ROCKS
\ No newline at end of file
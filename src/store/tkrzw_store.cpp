@@ -150,5 +150,99 @@ result<ptr<tuple_pb>> tkrzw_store::get(table_id_t table_id, tuple_id_t key) {
   }
 }
 
+// HashDBM has no point in time view, the rows iterated are not older than
+// the snapshot index, the logs replayed after that index make them consistent
+// the rows of the tables in [table_id, table_end) whose tuple ids are in
+// [lower, upper), no upper bound when upper is 0; HashDBM is not ordered, the
+// rows out of the range are skipped
+class tkrzw_snapshot : public store_snapshot {
+private:
+  tkrzw::HashDBM **dbm_;
+  table_id_t table_id_;
+  table_id_t table_end_;
+  tuple_id_t lower_;
+  tuple_id_t upper_;
+  std::unique_ptr<tkrzw::DBM::Iterator> iter_;
+
+public:
+  tkrzw_snapshot(tkrzw::HashDBM **dbm, table_id_t table_id,
+                 table_id_t table_end, tuple_id_t lower, tuple_id_t upper)
+      : dbm_(dbm), table_id_(table_id), table_end_(table_end), lower_(lower),
+        upper_(upper) {
+    iter_ = dbm_[table_id_]->MakeIterator();
+    iter_->First();
+  }
+
+  result<bool> next_chunk(uint64_t max_bytes,
+                          dsb_snapshot_chunk &chunk) override {
+    uint64_t bytes = 0;
+    while (bytes < max_bytes) {
+      std::string key;
+      std::string value;
+      tkrzw::Status status = iter_->Get(&key, &value);
+      if (status == tkrzw::Status::NOT_FOUND_ERROR) {
+        // the end of this table
+        table_id_++;
+        if (table_id_ >= table_end_) {
+          return outcome::success(true);
+        }
+        iter_ = dbm_[table_id_]->MakeIterator();
+        iter_->First();
+        continue;
+      } else if (!status.IsOK()) {
+        return outcome::failure(status_to_ec(status));
+      }
+      tuple_id_t tuple_id = binary2tupleid(key);
+      bytes += key.size() + value.size();
+      if (tuple_id >= lower_ && (upper_ == 0 || tuple_id < upper_)) {
+        tuple_row *row = chunk.add_rows();
+        row->set_table_id(table_id_);
+        row->set_tuple_id(tuple_id);
+        row->set_tuple(std::move(value));
+      }
+      iter_->Next();
+    }
+    return outcome::success(false);
+  }
+};
+
+result<ptr<store_snapshot>> tkrzw_store::create_snapshot() {
+  ptr<store_snapshot> snapshot(new tkrzw_snapshot(dbm_, 0, MAX_TABLES, 0, 0));
+  return outcome::success(snapshot);
+}
+
+result<ptr<store_snapshot>> tkrzw_store::create_scan(table_id_t table_id,
+                                                     tuple_id_t lower,
+                                                     tuple_id_t upper) {
+  if (table_id >= MAX_TABLES) {
+    return outcome::failure(EC::EC_UNKNOWN_TABLE_ID);
+  }
+  ptr<store_snapshot> snapshot(
+      new tkrzw_snapshot(dbm_, table_id, table_id + 1, lower, upper));
+  return outcome::success(snapshot);
+}
+
+result<void> tkrzw_store::install_snapshot(const dsb_snapshot_chunk &chunk) {
+  if (chunk.seq() == 0) {
+    for (uint32_t i = 0; i < MAX_TABLES; i++) {
+      tkrzw::Status status = dbm_[i]->Clear();
+      if (!status.IsOK()) {
+        return outcome::failure(status_to_ec(status));
+      }
+    }
+  }
+  for (const tuple_row &row : chunk.rows()) {
+    if (row.table_id() >= MAX_TABLES) {
+      return outcome::failure(EC::EC_UNKNOWN_TABLE_ID);
+    }
+    tkrzw::Status status = dbm_[row.table_id()]->Set(
+        tupleid2binary(row.tuple_id()), row.tuple(), true);
+    if (!status.IsOK()) {
+      return outcome::failure(status_to_ec(status));
+    }
+  }
+  return outcome::success();
+}
+
 result<void> tkrzw_store::sync() { return outcome::success(); }
 #endif // DB_TYPE_TK
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <barrier>
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the harness of the micro benchmarks, a case runs fn(thread_index, num_ops)
+// on a number of threads at once; the best of the rounds is kept and the
+// results are written to bench_<name>.json, under BENCH_OUTPUT_DIR if it is
+// set, which py/bench_compare.py compares with a baseline
+//
+// BENCH_MAX_THREADS limits the thread counts, BENCH_ROUNDS the rounds of a
+// case
+
+struct bench_case_result {
+  std::string name_;
+  uint32_t threads_;
+  uint64_t ops_;
+  // the wall time of an operation on a thread
+  double ns_per_op_;
+  // the operations of all the threads per second
+  double ops_per_second_;
+};
+
+class bench_harness {
+private:
+  std::string name_;
+  uint32_t rounds_;
+  std::vector<bench_case_result> results_;
+
+  static uint32_t env_uint(const char *name, uint32_t default_value) {
+    const char *v = std::getenv(name);
+    if (v == nullptr) {
+      return default_value;
+    }
+    return uint32_t(std::max(1L, std::strtol(v, nullptr, 10)));
+  }
+
+public:
+  explicit bench_harness(const std::string &name)
+      : name_(name), rounds_(env_uint("BENCH_ROUNDS", 3)) {}
+
+  ~bench_harness() { write_json(); }
+
+  // 1, 2, 4 ... up to the hardware threads
+  static std::vector<uint32_t> thread_counts() {
+    uint32_t max = env_uint(
+        "BENCH_MAX_THREADS",
+        std::max<uint32_t>(1, std::thread::hardware_concurrency()));
+    std::vector<uint32_t> counts;
+    for (uint32_t n = 1; n <= max; n *= 2) {
+      counts.push_back(n);
+    }
+    if (counts.back() != max) {
+      counts.push_back(max);
+    }
+    return counts;
+  }
+
+  template<class FN>
+  const bench_case_result &run(const std::string &name, uint32_t threads,
+                               uint64_t ops_per_thread, FN &&fn) {
+    double best_ns = 0;
+    for (uint32_t r = 0; r < rounds_; r++) {
+      std::barrier start(threads + 1);
+      std::vector<std::thread> workers;
+      for (uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&start, &fn, t, ops_per_thread] {
+          start.arrive_and_wait();
+          fn(t, ops_per_thread);
+        });
+      }
+      start.arrive_and_wait();
+      auto begin = std::chrono::steady_clock::now();
+      for (std::thread &w : workers) {
+        w.join();
+      }
+      double ns = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+      if (r == 0 || ns < best_ns) {
+        best_ns = ns;
+      }
+    }
+    bench_case_result result;
+    result.name_ = name;
+    result.threads_ = threads;
+    result.ops_ = ops_per_thread * threads;
+    result.ns_per_op_ = best_ns / double(ops_per_thread);
+    result.ops_per_second_ = double(result.ops_) / best_ns * 1e9;
+    std::cout << name_ << " " << name << ", threads: " << threads << ", "
+              << result.ns_per_op_ << " ns/op, " << result.ops_per_second_
+              << " op/s" << std::endl;
+    results_.push_back(result);
+    return results_.back();
+  }
+
+  void write_json() const {
+    boost::json::array cases;
+    for (const bench_case_result &r : results_) {
+      boost::json::object j;
+      j["name"] = r.name_;
+      j["threads"] = r.threads_;
+      j["ops"] = r.ops_;
+      j["ns_per_op"] = r.ns_per_op_;
+      j["ops_per_second"] = r.ops_per_second_;
+      cases.push_back(j);
+    }
+    boost::json::object j;
+    j["bench"] = name_;
+    j["cases"] = cases;
+    std::string path = "bench_" + name_ + ".json";
+    const char *dir = std::getenv("BENCH_OUTPUT_DIR");
+    if (dir != nullptr) {
+      path = std::string(dir) + "/" + path;
+    }
+    std::ofstream f(path);
+    f << boost::json::serialize(j) << std::endl;
+  }
+};
@@ -0,0 +1,219 @@
+#define BOOST_TEST_MODULE BLOG_TEST
+// the trace records are built in, and filtered at runtime
+#define BLOG_MIN_LEVEL BLOG_LEVEL_trace
+#include "common/blog.h"
+#include "common/logger.hpp"
+#include "common/variable.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/log/attributes/value_extraction.hpp>
+#include <boost/log/detail/thread_id.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+enum blog_test_color {
+  COLOR_RED = 0,
+  COLOR_GREEN,
+};
+
+template<>
+enum_strings<blog_test_color>::e2s_t
+    enum_strings<blog_test_color>::enum2str = {{COLOR_RED, "RED"},
+                                               {COLOR_GREEN, "GREEN"}};
+
+template<class... ARGS>
+std::string format_args(const char *format, const ARGS &...args) {
+  uint32_t size = (0 + ... + blog_arg_size(args));
+  std::string buf(size, 0);
+  [[maybe_unused]] char *p = buf.data();
+  (blog_put(p, args), ...);
+  BOOST_CHECK(p == buf.data() + size);
+  return blog_format(format, buf.data(), buf.size());
+}
+
+BOOST_AUTO_TEST_CASE(blog_format_test) {
+  std::string s = "str";
+  BOOST_CHECK(format_args("no args") == "no args");
+  BOOST_CHECK(format_args("{} {} {} {}", 1, -2, uint64_t(3), true) ==
+              "1 -2 3 true");
+  BOOST_CHECK(format_args("[{}] [{}]", s, "lit") == "[str] [lit]");
+  BOOST_CHECK(format_args("{}", COLOR_GREEN) == "GREEN");
+  BOOST_CHECK(format_args("{}", 0.5) == "0.500000");
+  // the placeholders more than the arguments, and the arguments more than
+  // the placeholders
+  BOOST_CHECK(format_args("{} {}", 0) == "0 {}");
+  BOOST_CHECK(format_args("extra", 0, "x") == "extra 0 x");
+}
+
+BOOST_AUTO_TEST_CASE(blog_level_test) {
+  BOOST_CHECK(blog_level_of("trace") == BLOG_LEVEL_trace);
+  BOOST_CHECK(blog_level_of("warning") == BLOG_LEVEL_warning);
+  BOOST_CHECK(blog_level_of("fatal") == BLOG_LEVEL_fatal);
+
+  // the arguments of a record below the runtime level are not evaluated
+  blog_set_level(BLOG_LEVEL_info);
+  uint32_t evaluated = 0;
+  auto arg = [&evaluated]() { return ++evaluated; };
+  BLOG(debug, "{}", arg());
+  BOOST_CHECK(evaluated == 0);
+  BLOG(warning, "{}", arg());
+  BOOST_CHECK(evaluated == 1);
+  blog_flush();
+}
+
+BOOST_AUTO_TEST_CASE(blog_thread_test) {
+  const uint32_t num_threads = 4;
+  const uint32_t num_records = 1000;
+  typedef boost::log::sinks::synchronous_sink<
+      boost::log::sinks::text_ostream_backend>
+      sink_t;
+  auto ss = boost::make_shared<std::stringstream>();
+  auto sink = boost::make_shared<sink_t>();
+  sink->locked_backend()->add_stream(ss);
+  boost::log::core::get()->add_sink(sink);
+  blog_set_level(BLOG_LEVEL_trace);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([t] {
+      for (uint32_t i = 0; i < num_records; i++) {
+        BLOG(trace, "thread {} record {}", t, i);
+      }
+    });
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  blog_flush();
+  boost::log::core::get()->remove_sink(sink);
+  BOOST_CHECK(blog_dropped() == 0);
+  // the records of a thread are written in order
+  std::vector<uint32_t> next(num_threads, 0);
+  std::string line;
+  uint32_t num_lines = 0;
+  while (std::getline(*ss, line)) {
+    uint32_t t = 0;
+    uint32_t i = 0;
+    if (std::sscanf(line.c_str(), "thread %u record %u", &t, &i) != 2) {
+      continue;
+    }
+    BOOST_CHECK(t < num_threads);
+    BOOST_CHECK(i == next[t]);
+    next[t] = i + 1;
+    num_lines++;
+  }
+  BOOST_CHECK(num_lines == num_threads * num_records);
+  blog_set_level(BLOG_LEVEL_info);
+}
+
+BOOST_AUTO_TEST_CASE(blog_wrap_test) {
+  typedef boost::log::sinks::synchronous_sink<
+      boost::log::sinks::text_ostream_backend>
+      sink_t;
+  auto ss = boost::make_shared<std::stringstream>();
+  auto sink = boost::make_shared<sink_t>();
+  sink->locked_backend()->add_stream(ss);
+  boost::log::core::get()->add_sink(sink);
+  blog_set_level(BLOG_LEVEL_trace);
+  uint64_t dropped = blog_dropped();
+  // the records of mixed sizes end at every 8 bytes offset, the ring wraps
+  // several times
+  const uint32_t num_records = 100000;
+  const uint32_t flush_every = 1000;
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < num_records; i++) {
+    std::string s(i % 29, 'x');
+    BLOG(trace, "wrap {} {}", i, s);
+    bytes += sizeof(blog_header) + 1 + 8 + 1 + 4 + s.size();
+    if (i % flush_every == flush_every - 1) {
+      blog_flush();
+    }
+  }
+  blog_flush();
+  boost::log::core::get()->remove_sink(sink);
+  BOOST_CHECK(bytes > 3 * uint64_t(BLOG_RING_BYTES));
+  BOOST_CHECK(blog_dropped() == dropped);
+  uint32_t next = 0;
+  std::string line;
+  while (std::getline(*ss, line)) {
+    uint32_t i = 0;
+    char x[64] = {0};
+    int n = std::sscanf(line.c_str(), "wrap %u %63s", &i, x);
+    if (n < 1) {
+      continue;
+    }
+    BOOST_CHECK(i == next);
+    BOOST_CHECK(std::string(x) == std::string(i % 29, 'x'));
+    next = i + 1;
+  }
+  BOOST_CHECK(next == num_records);
+  blog_set_level(BLOG_LEVEL_info);
+}
+
+BOOST_AUTO_TEST_CASE(blog_attribute_test) {
+  typedef boost::log::sinks::synchronous_sink<
+      boost::log::sinks::text_ostream_backend>
+      sink_t;
+  auto ss = boost::make_shared<std::stringstream>();
+  auto sink = boost::make_shared<sink_t>();
+  sink->locked_backend()->add_stream(ss);
+  // the time in microseconds since the epoch, and the thread of a record
+  sink->set_formatter([](const boost::log::record_view &rec,
+                         boost::log::formatting_ostream &os) {
+    auto ts = boost::log::extract<boost::posix_time::ptime>("TimeStamp", rec);
+    auto tid = boost::log::extract<boost::log::aux::thread::id>("ThreadID", rec);
+    if (ts && tid) {
+      boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+      os << (ts.get() - epoch).total_microseconds() << " " << tid.get() << " "
+         << rec[boost::log::expressions::smessage];
+    }
+  });
+  boost::log::core::get()->add_sink(sink);
+  blog_set_level(BLOG_LEVEL_trace);
+  // the time of the record is the time it is made, in the local time zone
+  // as the TimeStamp of Boost.Log
+  boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+  int64_t begin = (boost::posix_time::microsec_clock::local_time() - epoch)
+                      .total_microseconds();
+  std::stringstream producer;
+  std::thread t([&producer] {
+    producer << boost::log::aux::this_thread::get_id();
+    BLOG(trace, "attribute record");
+  });
+  t.join();
+  int64_t end = (boost::posix_time::microsec_clock::local_time() - epoch)
+                    .total_microseconds();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  blog_flush();
+  boost::log::core::get()->remove_sink(sink);
+  std::string line;
+  bool found = false;
+  while (std::getline(*ss, line)) {
+    std::stringstream ls(line);
+    int64_t us = 0;
+    std::string tid;
+    std::string text;
+    ls >> us >> tid;
+    std::getline(ls, text);
+    if (text != " attribute record") {
+      continue;
+    }
+    found = true;
+    BOOST_CHECK(us >= begin && us <= end);
+    BOOST_CHECK(tid == producer.str());
+  }
+  BOOST_CHECK(found);
+
+  // the ring of an ended thread is taken by the next thread once drained
+  size_t rings = blog_num_rings();
+  for (int i = 0; i < 4; i++) {
+    std::thread r([] { BLOG(trace, "recycle record"); });
+    r.join();
+    blog_flush();
+  }
+  BOOST_CHECK(blog_num_rings() <= rings + 1);
+  blog_set_level(BLOG_LEVEL_info);
+}
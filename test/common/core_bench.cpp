@@ -0,0 +1,243 @@
+#define BOOST_TEST_MODULE CORE_BENCH
+
+#include "bench_harness.h"
+#include "common/byte_buffer.h"
+#include "common/hash_table.h"
+#include "common/ptr.hpp"
+#include "common/read_write_pb.hpp"
+#include "common/tx_log.h"
+#include "common/tx_span.h"
+#include "common/variable.h"
+#include "common/wait_path.h"
+#include "proto/proto.h"
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// the core data structures and the hot paths of the blocks, at different
+// thread counts and contention levels, the results are in bench_*.json
+
+const uint64_t BENCH_HASH_OPS = 2000000;
+const uint64_t BENCH_HASH_COLD_KEYS = 1000000;
+// the transactions in flight of cc_block, fit in the cache
+const uint64_t BENCH_HASH_HOT_KEYS = 1024;
+// the rows updated by every transaction
+const uint64_t BENCH_HASH_CONTENDED_KEYS = 16;
+const uint64_t BENCH_LOG_OPS = 200000;
+const uint64_t BENCH_LOG_OPERATIONS = 10;
+const uint64_t BENCH_FRAME_OPS = 200000;
+const uint64_t BENCH_WAIT_PATH_OPS = 200;
+const uint64_t BENCH_SPAN_OPS = 2000000;
+// the spans a block records for a transaction
+const uint64_t BENCH_SPAN_PER_TX = 4;
+
+std::atomic<uint64_t> sink(0);
+
+tx_log_proto gen_tx_log(uint64_t xid) {
+  tx_log_proto log;
+  log.set_log_type(TX_CMD_RM_COMMIT);
+  log.set_xid(xid);
+  for (uint64_t i = 0; i < BENCH_LOG_OPERATIONS; i++) {
+    tx_operation *op = log.add_operations();
+    op->set_op_type(TX_OP_UPDATE);
+    op->set_sd_id(1);
+    tuple_row *row = op->mutable_tuple_row();
+    row->set_table_id(1);
+    row->set_shard_id(1);
+    row->set_tuple_id(xid * BENCH_LOG_OPERATIONS + i);
+    row->set_tuple(std::string(128, char('a' + i % 26)));
+  }
+  return log;
+}
+
+// num_tx transactions, each waits for the next two, the last one waits for
+// the first
+dependency_set gen_dependency_set(uint64_t num_tx) {
+  dependency_set ds;
+  for (uint64_t x = 1; x <= num_tx; x++) {
+    dependency *d = ds.add_dep();
+    d->set_out(x);
+    if (x + 1 <= num_tx) {
+      d->add_in(x + 1);
+    }
+    if (x + 2 <= num_tx) {
+      d->add_in(x + 2);
+    }
+    if (x == num_tx) {
+      d->add_in(1);
+    }
+  }
+  return ds;
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_bench) {
+  bench_harness harness("hash_table");
+  concurrent_hash_table<uint64_t, uint64_t> cold(BENCH_HASH_COLD_KEYS);
+  for (uint64_t k = 0; k < BENCH_HASH_COLD_KEYS; k++) {
+    cold.insert(k, k);
+  }
+  concurrent_hash_table<uint64_t, uint64_t> hot(BENCH_HASH_HOT_KEYS);
+  for (uint64_t k = 0; k < BENCH_HASH_HOT_KEYS; k++) {
+    hot.insert(k, k);
+  }
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_HASH_OPS / threads;
+    harness.run("find/hot", threads, ops, [&hot](uint32_t t, uint64_t n) {
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < n; i++) {
+        sum += hot.find((i * 7919 + t) % BENCH_HASH_HOT_KEYS).first;
+      }
+      sink += sum;
+    });
+    harness.run("find/cold", threads, ops, [&cold](uint32_t t, uint64_t n) {
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < n; i++) {
+        sum += cold.find((i * 7919 + t * 104729) % BENCH_HASH_COLD_KEYS).first;
+      }
+      sink += sum;
+    });
+    // the accessors of the few keys are write locked by all the threads
+    concurrent_hash_table<uint64_t, uint64_t> contended;
+    harness.run("find_or_insert/contended", threads, ops,
+                [&contended](uint32_t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    contended.find_or_insert(
+                        i % BENCH_HASH_CONTENDED_KEYS,
+                        [](uint64_t &v) { v++; }, [] { return uint64_t(1); });
+                  }
+                });
+  }
+}
+
+BOOST_AUTO_TEST_CASE(wait_path_bench) {
+  bench_harness harness("wait_path");
+  for (uint64_t num_tx : {16, 256, 4096}) {
+    dependency_set ds = gen_dependency_set(num_tx);
+    harness.run("detect_circle/tx:" + std::to_string(num_tx), 1,
+                BENCH_WAIT_PATH_OPS, [&ds](uint32_t, uint64_t n) {
+                  uint64_t found = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    wait_path wp;
+                    wp.add_dependency_set(ds);
+                    wp.detect_circle([&found](const std::vector<xid_t> &c) {
+                      found += c.size();
+                    });
+                  }
+                  sink += found;
+                });
+  }
+}
+
+// the logs of CCB, serialized, framed into the repeated_tx_logs sent to RLB
+// and parsed back as RLB and DSB do
+BOOST_AUTO_TEST_CASE(tx_log_bench) {
+  bench_harness harness("tx_log");
+  tx_log_proto log = gen_tx_log(1);
+  tx_log_binary binary = tx_log_proto_to_binary(log);
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_LOG_OPS / threads;
+    harness.run("tx_log_proto_to_binary", threads, ops,
+                [&log](uint32_t, uint64_t n) {
+                  uint64_t size = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    size += tx_log_proto_to_binary(log).size();
+                  }
+                  sink += size;
+                });
+    harness.run("log_buffer/format", threads, ops,
+                [&binary](uint32_t, uint64_t n) {
+                  repeated_tx_logs logs;
+                  size_t length = log_buffer::add_header_size(binary.size());
+                  for (uint64_t i = 0; i < n; i++) {
+                    logs.resize(length);
+                    log_buffer::format(logs.data(), length,
+                                       const_cast<char *>(binary.data()),
+                                       binary.size(), i, 1,
+                                       shard_id_to_map(1));
+                  }
+                  sink += logs.size();
+                });
+    harness.run("log_buffer/parse", threads, ops,
+                [&binary](uint32_t, uint64_t n) {
+                  size_t length = log_buffer::add_header_size(binary.size());
+                  repeated_tx_logs logs(length, 0);
+                  log_buffer::format(logs.data(), length,
+                                     const_cast<char *>(binary.data()),
+                                     binary.size(), 1, 1, shard_id_to_map(1));
+                  uint64_t num = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    handle_repeated_tx_logs_to_proto(
+                        logs, [&num](const ptr<tx_log_proto> &p) {
+                          num += p->operations_size();
+                        });
+                  }
+                  sink += num;
+                });
+  }
+}
+
+// the framing of the messages of connection, a tx_request serialized with its
+// header into a byte_buffer and parsed back
+BOOST_AUTO_TEST_CASE(message_frame_bench) {
+  bench_harness harness("message_frame");
+  tx_request request;
+  request.set_xid(1);
+  request.set_terminal_id(1);
+  *request.mutable_operations() = gen_tx_log(1).operations();
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_FRAME_OPS / threads;
+    harness.run("proto_to_buf", threads, ops, [&request](uint32_t, uint64_t n) {
+      byte_buffer buffer;
+      for (uint64_t i = 0; i < n; i++) {
+        buffer.reset();
+        auto r = proto_to_buf(buffer, CLIENT_TX_REQ, request, nullptr);
+        BOOST_ASSERT(r);
+      }
+      sink += buffer.read_available_size();
+    });
+    harness.run("buf_to_proto", threads, ops, [&request](uint32_t, uint64_t n) {
+      byte_buffer buffer;
+      auto r = proto_to_buf(buffer, CLIENT_TX_REQ, request, nullptr);
+      BOOST_ASSERT(r);
+      uint64_t num = 0;
+      for (uint64_t i = 0; i < n; i++) {
+        buffer.set_read_pos(0);
+        auto h = buf_to_msg_hdr(buffer);
+        BOOST_ASSERT(h);
+        tx_request parsed;
+        auto rp = buf_to_proto(buffer, parsed);
+        BOOST_ASSERT(rp);
+        num += parsed.operations_size();
+      }
+      sink += num;
+    });
+  }
+}
+
+// the tracing cost of a transaction, a sample decision and the spans of a
+// block, off, at the default 1% rate and with every transaction sampled
+BOOST_AUTO_TEST_CASE(tx_span_bench) {
+  bench_harness harness("tx_span");
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_SPAN_OPS / threads;
+    for (double rate : {0.0, 0.01, 1.0}) {
+      tx_span_set_sample_rate(rate);
+      harness.run("tx/rate:" + std::to_string(uint32_t(rate * 100)) + "%",
+                  threads, ops, [](uint32_t t, uint64_t n) {
+                    uint64_t num = 0;
+                    for (uint64_t i = 0; i < n; i++) {
+                      bool sampled = tx_span_sample();
+                      for (uint64_t k = 0; k < BENCH_SPAN_PER_TX; k++) {
+                        tx_span span;
+                        span.begin(sampled);
+                        span.end(sampled, SPAN_LOCK_WAIT, i, t);
+                      }
+                      num += sampled ? 1 : 0;
+                    }
+                    sink += num;
+                  });
+    }
+  }
+  tx_span_set_sample_rate(TX_SPAN_SAMPLE_RATE);
+}
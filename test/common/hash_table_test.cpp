@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE HASH_TABLE_TEST
+#include "common/hash_table.h"
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(concurrent_hash_table_remove_test) {
+  concurrent_hash_table<uint64_t, uint64_t> table;
+  uint64_t value = 10;
+  BOOST_CHECK(table.insert(1, value));
+  uint64_t removed = 0;
+  BOOST_CHECK(table.remove(1, [&removed](uint64_t v) { removed = v; }));
+  BOOST_CHECK_EQUAL(removed, 10u);
+  // the entry is erased, it is neither found nor removed again
+  BOOST_CHECK(not table.find(1).second);
+  BOOST_CHECK(not table.remove(1, nullptr));
+  // and the key can be inserted again
+  value = 11;
+  BOOST_CHECK(table.insert(1, value));
+  BOOST_CHECK_EQUAL(table.find(1).first, 11u);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_hash_table_find_many_test) {
+  concurrent_hash_table<uint64_t, uint64_t> table;
+  for (uint64_t k = 0; k < 100; k += 2) {
+    uint64_t value = k * 10;
+    BOOST_REQUIRE(table.insert(k, value));
+  }
+  // present, absent and duplicate keys, more than the prefetch distance
+  std::vector<uint64_t> keys;
+  for (uint64_t k = 0; k < 40; k++) {
+    keys.push_back(k * 7 % 120);
+  }
+  keys.push_back(4);
+  keys.push_back(4);
+  std::vector<uint64_t> visited(keys.size(), UINT64_MAX);
+  size_t found = table.find_many(keys, [&visited](size_t i, uint64_t v) {
+    visited[i] = v;
+  });
+  size_t expected = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::pair<uint64_t, bool> p = table.find(keys[i]);
+    if (p.second) {
+      expected++;
+      BOOST_CHECK_EQUAL(visited[i], p.first);
+    } else {
+      BOOST_CHECK_EQUAL(visited[i], UINT64_MAX);
+    }
+  }
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK(expected > 0 && expected < keys.size());
+  // an empty range, and a null visitor only counts
+  BOOST_CHECK_EQUAL(table.find_many(keys.begin(), keys.begin(), nullptr), 0u);
+  BOOST_CHECK_EQUAL(table.find_many(keys, nullptr), expected);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_hash_table_transparent_test) {
+  concurrent_hash_table<std::string, uint64_t> table;
+  uint64_t value = 5;
+  BOOST_REQUIRE(table.insert(std::string("key"), value));
+  // a std::string_view or a literal finds the std::string key
+  std::string_view view("key");
+  BOOST_CHECK(table.find(view).second);
+  BOOST_CHECK_EQUAL(table.find(view).first, table.find(std::string("key")).first);
+  BOOST_CHECK(table.find("key").second);
+  BOOST_CHECK(not table.find(std::string_view("ke")).second);
+  // an integral key of another type finds the same entry as KEY
+  concurrent_hash_table<uint64_t, uint64_t> numbers;
+  BOOST_REQUIRE(numbers.insert(uint64_t(3), value));
+  BOOST_CHECK(numbers.find(int(3)).second);
+  BOOST_CHECK(numbers.find(uint32_t(3)).second);
+  BOOST_CHECK_EQUAL(numbers.find(int(3)).first, numbers.find(uint64_t(3)).first);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_hash_table_null_visitor_test) {
+  concurrent_hash_table<uint64_t, uint64_t> table;
+  uint64_t value = 1;
+  BOOST_REQUIRE(table.insert(1, value));
+  // a nullptr visitor, or a null function pointer, is not invoked
+  BOOST_CHECK(table.find(1, nullptr));
+  void (*fn)(const uint64_t &) = nullptr;
+  BOOST_CHECK(table.find(1, fn));
+  std::pair<uint64_t, bool> p =
+      table.find_or_insert(1, nullptr, [] { return uint64_t(2); });
+  BOOST_CHECK(p.second);
+  BOOST_CHECK_EQUAL(p.first, 1u);
+  BOOST_CHECK(table.remove(1, fn));
+  BOOST_CHECK(not table.find(1).second);
+}
@@ -0,0 +1,56 @@
+#define BOOST_TEST_MODULE HDR_HISTOGRAM_TEST
+#include "common/hdr_histogram.h"
+#include <boost/test/unit_test.hpp>
+
+// within the precision of two significant digits
+static bool near(uint64_t value, uint64_t expected) {
+  return double(value) >= double(expected) * 0.99 &&
+      double(value) <= double(expected) * 1.01 + 1;
+}
+
+BOOST_AUTO_TEST_CASE(hdr_percentile_test) {
+  hdr_histogram h;
+  BOOST_CHECK_EQUAL(h.value_at_percentile(50), 0u);
+  for (uint64_t v = 1; v <= 100000; v++) {
+    h.record(v);
+  }
+  BOOST_CHECK_EQUAL(h.count(), 100000u);
+  BOOST_CHECK(near(h.value_at_percentile(50), 50000));
+  BOOST_CHECK(near(h.value_at_percentile(99), 99000));
+  BOOST_CHECK(near(h.value_at_percentile(99.9), 99900));
+  BOOST_CHECK(near(h.value_at_percentile(100), 100000));
+  BOOST_CHECK(near(h.max(), 100000));
+}
+
+BOOST_AUTO_TEST_CASE(hdr_small_value_test) {
+  hdr_histogram h;
+  for (uint64_t v = 0; v < 200; v++) {
+    h.record(v);
+  }
+  // exact below 256
+  BOOST_CHECK_EQUAL(h.value_at_percentile(50), 99u);
+  BOOST_CHECK_EQUAL(h.value_at_percentile(100), 199u);
+}
+
+BOOST_AUTO_TEST_CASE(hdr_add_test) {
+  hdr_histogram a;
+  hdr_histogram b;
+  for (uint64_t i = 0; i < 99; i++) {
+    a.record(1000);
+  }
+  b.record(1000000);
+  // huge values are clamped
+  b.record(uint64_t(1) << 40);
+  a.add(b);
+  BOOST_CHECK_EQUAL(a.count(), 101u);
+  BOOST_CHECK(near(a.value_at_percentile(50), 1000));
+  BOOST_CHECK(near(a.value_at_percentile(99), 1000000));
+  BOOST_CHECK(a.max() < (uint64_t(1) << 36));
+
+  hdr_histogram c;
+  a.for_each([&c](size_t index, uint64_t count) { c.add_at(index, count); });
+  BOOST_CHECK_EQUAL(c.count(), a.count());
+  BOOST_CHECK_EQUAL(c.value_at_percentile(99), a.value_at_percentile(99));
+  a.reset();
+  BOOST_CHECK_EQUAL(a.count(), 0u);
+}
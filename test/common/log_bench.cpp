@@ -0,0 +1,79 @@
+#define BOOST_TEST_MODULE LOG_BENCH
+// the trace records are built in, and filtered at runtime
+#define BLOG_MIN_LEVEL BLOG_LEVEL_trace
+
+#include "bench_harness.h"
+#include "common/blog.h"
+#include "common/logger.hpp"
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <ostream>
+#include <streambuf>
+
+// the cost of a trace record on a hot path of the blocks, to the thread which
+// logs, with the records filtered and written; LOG formats and writes on the
+// thread, BLOG copies its arguments and formats them in the background
+// the throughput of TPC-C with trace enabled and disabled is the log test
+// parameter of py/bench.py
+
+const uint64_t BENCH_LOG_RECORDS = 200000;
+
+// formats, and discards what is written
+class null_buf : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+
+  std::streamsize xsputn(const char *, std::streamsize n) override {
+    return n;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(log_bench) {
+  bench_harness harness("log");
+  typedef boost::log::sinks::synchronous_sink<
+      boost::log::sinks::text_ostream_backend>
+      sink_t;
+  null_buf buf;
+  auto os = boost::make_shared<std::ostream>(&buf);
+  auto sink = boost::make_shared<sink_t>();
+  sink->locked_backend()->add_stream(os);
+  boost::log::core::get()->add_sink(sink);
+  std::string table = "stock";
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_LOG_RECORDS / threads;
+    blog_set_level(BLOG_LEVEL_info);
+    harness.run("LOG/disabled", threads, ops,
+                [&table](uint32_t t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    LOG(trace) << "tx " << i << " lock " << table << " "
+                               << t;
+                  }
+                });
+    harness.run("BLOG/disabled", threads, ops,
+                [&table](uint32_t t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    BLOG(trace, "tx {} lock {} {}", i, table, t);
+                  }
+                });
+    blog_set_level(BLOG_LEVEL_trace);
+    harness.run("LOG/enabled", threads, ops,
+                [&table](uint32_t t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    LOG(trace) << "tx " << i << " lock " << table << " "
+                               << t;
+                  }
+                });
+    harness.run("BLOG/enabled", threads, ops,
+                [&table](uint32_t t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    BLOG(trace, "tx {} lock {} {}", i, table, t);
+                  }
+                });
+    blog_flush();
+  }
+  blog_set_level(BLOG_LEVEL_info);
+  boost::log::core::get()->remove_sink(sink);
+  std::cout << "BLOG dropped " << blog_dropped() << " records" << std::endl;
+}
@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE METRICS_TEST
+#include "common/metrics.h"
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+enum metrics_test_label {
+  LABEL_A = 0,
+  LABEL_B,
+  LABEL_END,
+};
+
+template<>
+enum_strings<metrics_test_label>::e2s_t
+    enum_strings<metrics_test_label>::enum2str = {{LABEL_A, "A"},
+                                                  {LABEL_B, "B"}};
+
+static metric<metric_counter> test_counter("test_counter_total",
+                                           "a test counter");
+static metric<metric_gauge> test_gauge("test_gauge", "a test gauge");
+static metric_family<metric_histogram, metrics_test_label, LABEL_END>
+    test_histogram("test_histogram", "a test histogram", "label");
+static metric_family<metric_gauge, uint32_t, 4>
+    test_shard_gauge("test_shard_gauge", "a test gauge by shard", "shard");
+
+BOOST_AUTO_TEST_CASE(metrics_bucket_test) {
+  for (uint64_t v = 0; v < 100000; v++) {
+    uint32_t b = metric_histogram::bucket_of(v);
+    BOOST_CHECK(v <= metric_histogram::bucket_upper(b));
+    if (b > 0) {
+      BOOST_CHECK(v > metric_histogram::bucket_upper(b - 1));
+    }
+  }
+  BOOST_CHECK(metric_histogram::bucket_of(UINT64_MAX) ==
+              METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_thread_test) {
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 8; i++) {
+    threads.emplace_back([] {
+      for (uint32_t n = 0; n < 10000; n++) {
+        test_counter->inc();
+        test_gauge->add(1);
+      }
+      // the shard of an ended thread is still summed
+      test_gauge->sub(5000);
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  BOOST_CHECK(test_counter.get().value() == 80000);
+  BOOST_CHECK(test_gauge.get().value() == 40000);
+  test_gauge->set(10);
+  BOOST_CHECK(test_gauge.get().value() == 40010);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_prometheus_test) {
+  test_histogram[LABEL_B].record(3);
+  test_histogram[LABEL_B].record(100);
+  std::stringstream ssm;
+  metrics_prometheus(ssm);
+  std::string text = ssm.str();
+  BOOST_CHECK(text.find("# TYPE test_counter_total counter\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("# TYPE test_histogram histogram\n") !=
+              std::string::npos);
+  // a label value never recorded is not written
+  BOOST_CHECK(text.find("label=\"A\"") == std::string::npos);
+  BOOST_CHECK(text.find("test_histogram_bucket{label=\"B\",le=\"3\"} 1\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("test_histogram_bucket{label=\"B\",le=\"+Inf\"} 2\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("test_histogram_sum{label=\"B\"} 103\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("test_histogram_count{label=\"B\"} 2\n") !=
+              std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_unknown_label_test) {
+  // a label value out of the range, e.g. read from the wire, is counted as
+  // unknown instead of indexing out of the family
+  test_histogram[metrics_test_label(LABEL_END + 7)].record(1);
+  std::stringstream ssm;
+  metrics_prometheus(ssm);
+  BOOST_CHECK(ssm.str().find("test_histogram_count{label=\"unknown\"} 1\n") !=
+              std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_integer_label_test) {
+  // the gauges of the shards are set apart
+  test_shard_gauge[1].set(5);
+  test_shard_gauge[2].set(7);
+  test_shard_gauge[9].set(1);
+  std::stringstream ssm;
+  metrics_prometheus(ssm);
+  std::string text = ssm.str();
+  BOOST_CHECK(text.find("test_shard_gauge{shard=\"1\"} 5\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("test_shard_gauge{shard=\"2\"} 7\n") !=
+              std::string::npos);
+  BOOST_CHECK(text.find("test_shard_gauge{shard=\"unknown\"} 1\n") !=
+              std::string::npos);
+}
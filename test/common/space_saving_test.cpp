@@ -0,0 +1,57 @@
+#define BOOST_TEST_MODULE SPACE_SAVING_TEST
+#include "common/space_saving.h"
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <unordered_map>
+
+struct test_stat {
+  uint64_t n_;
+
+  test_stat() : n_(0) {}
+};
+
+BOOST_AUTO_TEST_CASE(space_saving_exact_test) {
+  space_saving<uint64_t, test_stat> s(4);
+  for (uint64_t k = 1; k <= 4; k++) {
+    for (uint64_t i = 0; i < k; i++) {
+      s.add(k).n_++;
+    }
+  }
+  auto top = s.top(4);
+  BOOST_CHECK(top.size() == 4);
+  for (uint64_t i = 0; i < 4; i++) {
+    BOOST_CHECK(top[i].key_ == 4 - i);
+    BOOST_CHECK(top[i].count_ == 4 - i);
+    BOOST_CHECK(top[i].error_ == 0);
+    BOOST_CHECK(top[i].stat_.n_ == 4 - i);
+  }
+
+  // 5 replaces 1, the key of the minimum count
+  s.add(5);
+  BOOST_CHECK(s.size() == 4);
+  BOOST_CHECK(s.find(1) == nullptr);
+  BOOST_CHECK(s.find(5) != nullptr && s.find(5)->n_ == 0);
+  top = s.top(4);
+  BOOST_CHECK(top[3].count_ == 2);
+}
+
+BOOST_AUTO_TEST_CASE(space_saving_skew_test) {
+  // the hot keys of a skewed stream of many cold keys are kept
+  const uint64_t num_hot = 8;
+  space_saving<uint64_t, test_stat> s(64);
+  std::unordered_map<uint64_t, uint64_t> count;
+  std::mt19937_64 rnd(1);
+  for (uint64_t i = 0; i < 200000; i++) {
+    uint64_t key =
+        (rnd() % 2 == 0) ? rnd() % num_hot : num_hot + rnd() % 100000;
+    s.add(key);
+    count[key]++;
+  }
+  auto top = s.top(num_hot);
+  BOOST_CHECK(top.size() == num_hot);
+  for (const auto &e : top) {
+    BOOST_CHECK(e.key_ < num_hot);
+    BOOST_CHECK(e.count_ >= count[e.key_]);
+    BOOST_CHECK(e.count_ - e.error_ <= count[e.key_]);
+  }
+}
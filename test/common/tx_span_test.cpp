@@ -0,0 +1,103 @@
+#define BOOST_TEST_MODULE TX_SPAN_TEST
+#include "common/tx_span.h"
+#include "common/variable.h"
+#include <boost/json.hpp>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static boost::json::array chrome_trace_events(uint64_t window_ms) {
+  std::stringstream ssm;
+  tx_span_chrome_trace(ssm, window_ms);
+  boost::json::value v = boost::json::parse(ssm.str());
+  return v.as_object()["traceEvents"].as_array();
+}
+
+BOOST_AUTO_TEST_CASE(tx_span_sample_test) {
+  tx_span_set_sample_rate(0.0);
+  for (uint32_t i = 0; i < 1000; i++) {
+    BOOST_CHECK(not tx_span_sample());
+  }
+  tx_span_set_sample_rate(1.0);
+  for (uint32_t i = 0; i < 1000; i++) {
+    BOOST_CHECK(tx_span_sample());
+  }
+  tx_span_set_sample_rate(0.1);
+  uint32_t sampled = 0;
+  for (uint32_t i = 0; i < 100000; i++) {
+    sampled += tx_span_sample() ? 1 : 0;
+  }
+  BOOST_CHECK(sampled > 9000 && sampled < 11000);
+  tx_span_set_sample_rate(TX_SPAN_SAMPLE_RATE);
+}
+
+BOOST_AUTO_TEST_CASE(tx_span_chrome_trace_test) {
+  tx_span span;
+  span.begin(false);
+  span.end(false, SPAN_LOCK_WAIT, 1, 1);
+  BOOST_CHECK(chrome_trace_events(0).empty());
+
+  span.begin(true);
+  span.end(true, SPAN_LOCK_WAIT, 2, 3);
+  uint64_t now = tx_span_now_ns();
+  tx_span_record(SPAN_DSB_READ, 4, 5, now - 2000000, now - 1000000);
+  boost::json::array events = chrome_trace_events(0);
+  BOOST_CHECK_EQUAL(events.size(), 2u);
+  boost::json::object &e = events[1].as_object();
+  BOOST_CHECK_EQUAL(e["name"].as_string(), "dsb_read");
+  BOOST_CHECK_EQUAL(e["ph"].as_string(), "X");
+  BOOST_CHECK_EQUAL(e["dur"].as_double(), 1000.0);
+  boost::json::object &args = e["args"].as_object();
+  BOOST_CHECK_EQUAL(boost::json::value_to<uint64_t>(args["id"]), 4u);
+  BOOST_CHECK_EQUAL(boost::json::value_to<uint64_t>(args["terminal"]), 5u);
+
+  // the spans which end before the window are not served
+  tx_span_record(SPAN_WAL_APPEND, 6, 7, 1000, 2000);
+  BOOST_CHECK_EQUAL(chrome_trace_events(TX_SPAN_WINDOW_MILLIS).size(), 2u);
+}
+
+// the rings are read while they are written, a span is either whole or
+// dropped
+BOOST_AUTO_TEST_CASE(tx_span_concurrent_test) {
+  const uint32_t num_threads = 4;
+  std::atomic<bool> stopped(false);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([t, &stopped] {
+      uint64_t id = 0;
+      while (not stopped.load()) {
+        id++;
+        // the id, begin and end of a span agree with each other
+        tx_span_record(SPAN_RESPONSE, id, t, id * 1000, id * 2000);
+      }
+    });
+  }
+  for (uint32_t i = 0; i < 20; i++) {
+    for (boost::json::value &v : chrome_trace_events(0)) {
+      boost::json::object &e = v.as_object();
+      if (e["name"].as_string() != "response") {
+        continue;
+      }
+      uint64_t id =
+          boost::json::value_to<uint64_t>(e["args"].as_object()["id"]);
+      BOOST_CHECK_EQUAL(e["dur"].as_double(), double(id));
+    }
+  }
+  stopped.store(true);
+  for (std::thread &t : threads) {
+    t.join();
+  }
+}
+
+// the ring of an ended thread is reused by the next thread
+BOOST_AUTO_TEST_CASE(tx_span_ring_reuse_test) {
+  std::thread([] { tx_span_record(SPAN_RESPONSE, 1, 1, 1000, 2000); }).join();
+  size_t num_rings = tx_span_num_rings();
+  for (uint32_t i = 0; i < 8; i++) {
+    std::thread([] { tx_span_record(SPAN_RESPONSE, 1, 1, 1000, 2000); })
+        .join();
+  }
+  BOOST_CHECK_EQUAL(tx_span_num_rings(), num_rings);
+}
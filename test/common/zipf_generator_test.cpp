@@ -0,0 +1,62 @@
+#define BOOST_TEST_MODULE ZIPF_GENERATOR_TEST
+#include "common/zipf_generator.hpp"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(zipf_rank_test) {
+  const uint64_t n = 1000;
+  const uint64_t num_sample = 200000;
+  zipf_generator<uint64_t> gen(n, 0.99);
+  std::vector<uint64_t> count(n, 0);
+  for (uint64_t i = 0; i < num_sample; i++) {
+    uint64_t r = gen.generate();
+    BOOST_REQUIRE(r < n);
+    count[r]++;
+  }
+  // p(rank) is proportional to 1/(rank + 1)^theta
+  BOOST_CHECK(count[0] > count[1]);
+  BOOST_CHECK(count[1] > count[10]);
+  BOOST_CHECK(count[10] > count[n - 1]);
+  double ratio = double(count[0]) / double(count[1]);
+  BOOST_CHECK(ratio > 1.7 && ratio < 2.3);
+}
+
+BOOST_AUTO_TEST_CASE(zipf_scrambled_test) {
+  const uint64_t n = 1000;
+  zipf_generator<uint64_t> gen(n, 0.99);
+  std::vector<uint64_t> count(n, 0);
+  for (uint64_t i = 0; i < 100000; i++) {
+    uint64_t r = gen.generate_scrambled();
+    BOOST_REQUIRE(r < n);
+    count[r]++;
+  }
+  // the hottest value is not rank 0 but as popular
+  uint64_t max = 0;
+  for (uint64_t c : count) {
+    max = std::max(max, c);
+  }
+  BOOST_CHECK(max > 100000 / 20);
+}
+
+BOOST_AUTO_TEST_CASE(zipf_one_value_test) {
+  zipf_generator<uint64_t> gen(1, 0.99);
+  for (int i = 0; i < 100; i++) {
+    BOOST_CHECK_EQUAL(gen.generate(), 0u);
+    BOOST_CHECK_EQUAL(gen.generate_scrambled(), 0u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(zipf_shared_seed_test) {
+  auto dist = std::make_shared<const zipf_distribution<uint64_t>>(1000, 0.99);
+  zipf_generator<uint64_t> gen1(dist, 7);
+  zipf_generator<uint64_t> gen2(dist, 7);
+  zipf_generator<uint64_t> gen3(dist, 8);
+  bool differ = false;
+  for (int i = 0; i < 100; i++) {
+    uint64_t r = gen1.generate();
+    BOOST_CHECK_EQUAL(r, gen2.generate());
+    differ = differ || r != gen3.generate();
+  }
+  // the same seed gives the same sequence, another seed does not
+  BOOST_CHECK(differ);
+}
@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE LOCK_BENCH
+
+#include "common/bench_harness.h"
+#include "access/data_mgr.h"
+#include "common/ptr.hpp"
+#include "concurrency/lock_slot.h"
+#include "concurrency/tx.h"
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// the row locks of CCB and the tuple versions of DSB, at different thread
+// counts and contention levels, the results are in bench_*.json
+
+const uint64_t BENCH_LOCK_OPS = 1000000;
+const uint64_t BENCH_DATA_OPS = 200000;
+const uint64_t BENCH_DATA_KEYS = 100000;
+const uint64_t BENCH_TUPLE_SIZE = 128;
+
+std::atomic<uint64_t> sink(0);
+
+class tx_ctx_mock : public tx_rm {
+public:
+  explicit tx_ctx_mock(xid_t xid, boost::asio::io_context &ctx)
+      : tx_rm(boost::asio::io_context::strand(ctx), xid) {}
+
+  void async_lock_acquire(EC, oid_t) override {}
+};
+
+std::vector<ptr<lock_slot>> gen_lock_slots(uint64_t num) {
+  std::vector<ptr<lock_slot>> slots;
+  for (uint64_t i = 0; i < num; i++) {
+    slots.push_back(ptr<lock_slot>(
+        new lock_slot(nullptr, 1, 1, i, nullptr, nullptr)));
+  }
+  return slots;
+}
+
+std::vector<ptr<tx_rm>> gen_tx(uint32_t num, boost::asio::io_context &ctx) {
+  std::vector<ptr<tx_rm>> tx;
+  for (uint32_t i = 0; i < num; i++) {
+    tx.push_back(ptr<tx_rm>(new tx_ctx_mock(i + 1, ctx)));
+  }
+  return tx;
+}
+
+// the read locks never wait, the fewer the slots the more the threads
+// contend on the mutex of a slot; the write locks are on the slots of a
+// thread, a write lock waiting would build the dependency by the lock_mgr
+BOOST_AUTO_TEST_CASE(lock_slot_bench) {
+  bench_harness harness("lock_slot");
+  boost::asio::io_context ctx;
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_LOCK_OPS / threads;
+    std::vector<ptr<tx_rm>> tx = gen_tx(threads, ctx);
+    for (uint64_t num_slots : {1, 16, 4096}) {
+      std::vector<ptr<lock_slot>> slots = gen_lock_slots(num_slots);
+      harness.run("read/slots:" + std::to_string(num_slots), threads, ops,
+                  [&slots, &tx](uint32_t t, uint64_t n) {
+                    uint64_t acquired = 0;
+                    for (uint64_t i = 0; i < n; i++) {
+                      lock_slot &s = *slots[(i * 7919 + t) % slots.size()];
+                      acquired += s.lock(LOCK_READ_ROW, tx[t], oid_t(i));
+                      s.unlock(tx[t]->xid());
+                    }
+                    sink += acquired;
+                  });
+    }
+    std::vector<ptr<lock_slot>> slots = gen_lock_slots(threads);
+    harness.run("write/private", threads, ops,
+                [&slots, &tx](uint32_t t, uint64_t n) {
+                  uint64_t acquired = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    acquired += slots[t]->lock(LOCK_WRITE_ROW, tx[t], oid_t(i));
+                    slots[t]->unlock(tx[t]->xid());
+                  }
+                  sink += acquired;
+                });
+  }
+}
+
+BOOST_AUTO_TEST_CASE(data_mgr_bench) {
+  bench_harness harness("data_mgr");
+  tuple_pb tuple(BENCH_TUPLE_SIZE, 'a');
+  for (uint32_t threads : bench_harness::thread_counts()) {
+    uint64_t ops = BENCH_DATA_OPS / threads;
+    // the versions of a key are appended, a new data_mgr for every case
+    data_mgr put_mgr;
+    harness.run("put", threads, ops,
+                [&put_mgr, &tuple](uint32_t t, uint64_t n) {
+                  for (uint64_t i = 0; i < n; i++) {
+                    tuple_pb v = tuple;
+                    put_mgr.put((i * 7919 + t) % BENCH_DATA_KEYS,
+                                std::move(v));
+                  }
+                });
+    data_mgr get_mgr;
+    for (uint64_t k = 0; k < BENCH_DATA_KEYS; k++) {
+      tuple_pb v = tuple;
+      get_mgr.put(k, std::move(v));
+    }
+    harness.run("get", threads, ops, [&get_mgr](uint32_t t, uint64_t n) {
+      uint64_t size = 0;
+      for (uint64_t i = 0; i < n; i++) {
+        size += get_mgr.get((i * 7919 + t) % BENCH_DATA_KEYS).first.size();
+      }
+      sink += size;
+    });
+  }
+}
@@ -5,6 +5,7 @@
 #include <boost/test/unit_test.hpp>
 #include <random>
 #include <string>
+#include <thread>
 
 #define TUPLE_ID_MIN 1
 #define TUPLE_ID_MAX 10
@@ -151,4 +152,32 @@ BOOST_AUTO_TEST_CASE(lock_mgr_test) {
   for (auto &l : v) {
     mgr.unlock(l.xid_, l.mode_, l.pred_);
   }
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(lock_contention_test) {
+  lock_contention contention;
+  // the waits are counted by the threads waiting, the grants by others
+  std::thread waiter([&contention]() {
+    for (int i = 0; i < 10; i++) {
+      contention.on_wait(1, 2);
+    }
+    contention.on_wait(2, 1);
+    lock_contention::flush();
+  });
+  waiter.join();
+  contention.on_wait(1, 1);
+  contention.on_granted(1, 100);
+  // not counted before flush
+  BOOST_CHECK(contention.top(0, 0, 1)[0].wait_ == 10);
+  lock_contention::flush();
+  std::vector<lock_hot_key> keys = contention.top(7, 3, 1);
+  BOOST_REQUIRE(keys.size() == 1);
+  BOOST_CHECK(keys[0].table_id_ == 7 && keys[0].shard_id_ == 3);
+  BOOST_CHECK(keys[0].key_ == 1);
+  BOOST_CHECK(keys[0].wait_ == 11);
+  BOOST_CHECK(keys[0].error_ == 0);
+  BOOST_CHECK(keys[0].stat_.conflict_ == 21);
+  BOOST_CHECK(keys[0].stat_.granted_ == 1);
+  BOOST_CHECK(keys[0].stat_.wait_us_ == 100);
+  BOOST_CHECK(contention.top(0, 0, 5).size() == 2);
+}
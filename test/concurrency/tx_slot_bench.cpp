@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE TX_SLOT_BENCH
+#include "common/bench_harness.h"
+#include "common/hash_table.h"
+#include "common/make_int.h"
+#include "concurrency/tx_slot_table.h"
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <malloc.h>
+#include <vector>
+
+// the lookups of the transactions in flight by the messages of cc_block,
+// a concurrent_hash_table per terminal (as cc_block had) and tx_slot_table,
+// and the memory of the tables of the terminals; the lookups are in
+// bench_tx_slot_table.json
+
+const uint32_t BENCH_NUM_TERMINAL = 2000;
+const uint32_t BENCH_TX_PER_TERMINAL = 2;
+const uint64_t BENCH_NUM_LOOKUP = 20000000;
+
+struct bench_tx {
+  explicit bench_tx(xid_t xid) : xid_(xid) {}
+
+  xid_t xid_;
+};
+
+typedef concurrent_hash_table<uint64_t, ptr<bench_tx>> terminal_table_t;
+
+uint64_t heap_used() {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+void report(const std::string &name, uint64_t memory) {
+  std::cout << name << ": " << memory / 1024 << " KB for "
+            << BENCH_NUM_TERMINAL << " terminals" << std::endl;
+}
+
+std::vector<std::pair<uint32_t, xid_t>> lookup_xids() {
+  std::vector<std::pair<uint32_t, xid_t>> xids;
+  for (uint32_t t = 1; t < BENCH_NUM_TERMINAL; t++) {
+    for (uint32_t n = 0; n < BENCH_TX_PER_TERMINAL; n++) {
+      xids.emplace_back(t, make_uint64(t * 16 + n, t));
+    }
+  }
+  return xids;
+}
+
+BOOST_AUTO_TEST_CASE(tx_slot_bench) {
+  bench_harness harness("tx_slot_table");
+  std::vector<std::pair<uint32_t, xid_t>> xids = lookup_xids();
+  uint64_t found_hash = 0;
+  {
+    uint64_t before = heap_used();
+    std::vector<terminal_table_t> tables(BENCH_NUM_TERMINAL);
+    uint64_t memory = heap_used() - before;
+    for (const auto &p : xids) {
+      ptr<bench_tx> tx = cs_new<bench_tx>(p.second);
+      tables[p.first].insert(p.second, tx);
+    }
+    harness.run("find/hash_table_per_terminal", 1, BENCH_NUM_LOOKUP,
+                [&](uint32_t, uint64_t n) {
+                  found_hash = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    const auto &p = xids[(i * 7919) % xids.size()];
+                    auto pair = tables[p.first].find(p.second);
+                    found_hash += pair.first->xid_;
+                  }
+                });
+    report("concurrent_hash_table per terminal", memory);
+  }
+  uint64_t found_slot = 0;
+  {
+    uint64_t before = heap_used();
+    tx_slot_table<bench_tx> table;
+    table.resize(BENCH_NUM_TERMINAL);
+    uint64_t memory = heap_used() - before;
+    for (const auto &p : xids) {
+      table.insert(p.first, p.second, cs_new<bench_tx>(p.second));
+    }
+    harness.run("find/tx_slot_table", 1, BENCH_NUM_LOOKUP,
+                [&](uint32_t, uint64_t n) {
+                  found_slot = 0;
+                  for (uint64_t i = 0; i < n; i++) {
+                    const auto &p = xids[(i * 7919) % xids.size()];
+                    auto pair = table.find(p.first, p.second);
+                    found_slot += pair.first->xid_;
+                  }
+                });
+    report("tx_slot_table", memory);
+  }
+  BOOST_CHECK(found_hash == found_slot);
+}
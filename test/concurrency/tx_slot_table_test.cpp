@@ -0,0 +1,104 @@
+#define BOOST_TEST_MODULE TX_SLOT_TABLE_TEST
+#include "common/make_int.h"
+#include "concurrency/tx_slot_table.h"
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
+
+#define NUM_TEST_TERMINAL 8
+#define NUM_TEST_TX 20000
+
+struct tx_mock {
+  explicit tx_mock(xid_t xid) : xid_(xid) {}
+
+  xid_t xid_;
+};
+
+xid_t test_xid(uint32_t seq, uint32_t terminal_id) {
+  return make_uint64(seq, terminal_id);
+}
+
+BOOST_AUTO_TEST_CASE(tx_slot_table_test) {
+  tx_slot_table<tx_mock> table;
+  table.resize(NUM_TEST_TERMINAL);
+  // more transactions of a terminal than its slots, and a terminal out of
+  // range, are kept in the overflow table
+  std::vector<xid_t> xids;
+  for (uint32_t seq = 1; seq <= TX_SLOTS_PER_TERMINAL * 2; seq++) {
+    xids.push_back(test_xid(seq, 1));
+  }
+  xids.push_back(test_xid(1, NUM_TEST_TERMINAL + 1));
+  for (xid_t xid : xids) {
+    uint32_t terminal_id = uint32_t(xid & 0xffffffff);
+    BOOST_CHECK(table.insert(terminal_id, xid, cs_new<tx_mock>(xid)));
+    BOOST_CHECK(!table.insert(terminal_id, xid, cs_new<tx_mock>(xid)));
+  }
+  for (xid_t xid : xids) {
+    uint32_t terminal_id = uint32_t(xid & 0xffffffff);
+    auto pair = table.find(terminal_id, xid);
+    BOOST_CHECK(pair.second && pair.first->xid_ == xid);
+  }
+  uint64_t num = 0;
+  table.traverse([&num](xid_t xid, const ptr<tx_mock> &tx) {
+    BOOST_CHECK(tx->xid_ == xid);
+    num++;
+  });
+  BOOST_CHECK(num == xids.size());
+  for (xid_t xid : xids) {
+    uint32_t terminal_id = uint32_t(xid & 0xffffffff);
+    BOOST_CHECK(table.remove(terminal_id, xid));
+    BOOST_CHECK(!table.remove(terminal_id, xid));
+    BOOST_CHECK(!table.find(terminal_id, xid).second);
+  }
+}
+
+// a thread of a terminal runs its transactions, while the other threads look
+// up the transactions of all the terminals
+BOOST_AUTO_TEST_CASE(tx_slot_table_concurrent_test) {
+  tx_slot_table<tx_mock> table;
+  table.resize(NUM_TEST_TERMINAL);
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> mismatch(0);
+  std::atomic<uint64_t> failed(0);
+  std::vector<std::thread> readers;
+  for (uint32_t r = 0; r < 2; r++) {
+    readers.emplace_back([&table, &stop, &mismatch] {
+      uint32_t seq = 1;
+      while (!stop.load()) {
+        for (uint32_t t = 1; t < NUM_TEST_TERMINAL; t++) {
+          xid_t xid = test_xid(seq, t);
+          auto pair = table.find(t, xid);
+          if (pair.second && pair.first->xid_ != xid) {
+            mismatch++;
+          }
+        }
+        seq = seq % NUM_TEST_TX + 1;
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (uint32_t t = 1; t < NUM_TEST_TERMINAL; t++) {
+    writers.emplace_back([&table, &failed, t] {
+      for (uint32_t seq = 1; seq <= NUM_TEST_TX; seq++) {
+        xid_t xid = test_xid(seq, t);
+        if (!table.insert(t, xid, cs_new<tx_mock>(xid))) {
+          failed++;
+        }
+        if (seq > TX_SLOTS_PER_TERMINAL) {
+          if (!table.remove(t, test_xid(seq - TX_SLOTS_PER_TERMINAL, t))) {
+            failed++;
+          }
+        }
+      }
+    });
+  }
+  for (std::thread &w : writers) {
+    w.join();
+  }
+  stop.store(true);
+  for (std::thread &r : readers) {
+    r.join();
+  }
+  BOOST_CHECK(mismatch.load() == 0);
+  BOOST_CHECK(failed.load() == 0);
+}
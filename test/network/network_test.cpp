@@ -3,10 +3,16 @@
 #include "common/byte_buffer.h"
 #include "common/gen_config.h"
 #include "common/ptr.hpp"
+#include "network/async_db_client.h"
 #include "network/db_client.h"
+#include "network/frame_compress.h"
 #include "network/net_service.h"
+#include "network/net_shaper.h"
 #include "network/sock_server.h"
+#include "network/timing_wheel.h"
+#include <atomic>
 #include <boost/test/unit_test.hpp>
+#include <thread>
 
 std::string HELLO_MESSAGE = "\
 1abcdefghijklmnopqrstuvwxyz;\
@@ -169,4 +175,290 @@ BOOST_AUTO_TEST_CASE(network_test) {
   for (auto s : server) {
     s->join();
   }
-}
\ No newline at end of file
+}
+
+// the transactions of a client are answered out of order, the odd ones after
+// the next one arrived
+BOOST_AUTO_TEST_CASE(async_db_client_test) {
+  config_option option;
+  option.set_config_share(false);
+  config conf = generate_config(option).second[0];
+  auto service = cs_new<net_service>(conf);
+  auto server = cs_new<sock_server>(conf, service);
+  std::mutex mutex;
+  std::vector<std::pair<ptr<connection>, ptr<tx_response>>> delayed;
+  service->register_handler([&](ptr<connection> conn, message_type id,
+                                byte_buffer &buffer,
+                                msg_hdr *) -> result<void> {
+    BOOST_REQUIRE(id == CLIENT_TX_REQ);
+    tx_request request;
+    auto r = buf_to_proto(buffer, request);
+    BOOST_REQUIRE(r);
+    auto response = cs_new<tx_response>();
+    response->set_client_seq(request.client_seq());
+    // the terminal id tells the callback which request it answers
+    response->set_num_lock(request.terminal_id());
+    std::scoped_lock l(mutex);
+    if (request.terminal_id() % 2 == 1) {
+      delayed.emplace_back(conn, response);
+      return outcome::success();
+    }
+    service->conn_async_send(conn, CLIENT_TX_RESP, response);
+    for (auto &p : delayed) {
+      service->conn_async_send(p.first, CLIENT_TX_RESP, p.second);
+    }
+    delayed.clear();
+    return outcome::success();
+  });
+  server->start();
+
+  const uint32_t num_tx = 1000;
+  boost::asio::io_context context;
+  auto cli = cs_new<async_db_client>(
+      context, conf.this_node_config().az_id(), conf.this_node_config(), 8);
+  while (not cli->connect()) {
+    sleep(1);
+  }
+  uint32_t num_done = 0;
+  uint32_t num_ok = 0;
+  uint32_t failed = 0;
+  bool matched = true;
+  for (uint32_t i = 0; i < num_tx; i++) {
+    auto request = cs_new<tx_request>();
+    request->set_terminal_id(i);
+    cli->async_submit(request, [&, i](EC ec, const tx_response &response) {
+      if (ec == EC::EC_OK) {
+        num_ok++;
+        matched = matched && response.num_lock() == i;
+      } else {
+        failed = i;
+      }
+      if (++num_done == num_tx) {
+        context.stop();
+      }
+    });
+  }
+  BOOST_CHECK(cli->num_outstanding() == num_tx);
+  auto guard = boost::asio::make_work_guard(context);
+  std::thread thd([&context] { context.run(); });
+  // the last request is odd, it is never answered, and fails when the
+  // connection is closed
+  while (cli->num_outstanding() > 1) {
+    usleep(1000);
+  }
+  cli->close();
+  thd.join();
+  BOOST_CHECK(num_done == num_tx);
+  BOOST_CHECK(num_ok == num_tx - 1);
+  BOOST_CHECK(failed == num_tx - 1);
+  BOOST_CHECK(matched);
+  server->stop();
+  server->join();
+}
+
+BOOST_AUTO_TEST_CASE(frame_compress_test) {
+  std::string body;
+  while (body.size() < MESSAGE_BUFFER_SIZE) {
+    body += HELLO_MESSAGE;
+  }
+  const int8_t *data = reinterpret_cast<const int8_t *>(body.data());
+  for (compress_codec codec : {COMPRESS_LZ4, COMPRESS_ZSTD}) {
+    std::vector<int8_t> out(frame_compress_bound(codec, body.size()));
+    size_t n = frame_compress(codec, REQUEST_HELLO, data, body.size(),
+                              out.data(), out.size());
+    BOOST_CHECK(n > 0 && n < body.size());
+    byte_buffer buffer;
+    auto r = frame_decompress(REQUEST_HELLO, out.data(), n, buffer);
+    BOOST_REQUIRE(r);
+    BOOST_CHECK(std::string(reinterpret_cast<const char *>(buffer.read_begin()),
+                            buffer.read_available_size()) == body);
+  }
+  std::stringstream ssm;
+  frame_compress_stats(ssm);
+  BOOST_CHECK(ssm.str().find(enum2str(REQUEST_HELLO)) != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel_test) {
+  boost::asio::io_context context;
+  auto guard = boost::asio::make_work_guard(context);
+  auto wheel = cs_new<timing_wheel>(context, 1000);
+  std::vector<uint64_t> fired;
+  uint64_t begin = steady_clock_us_since_epoch();
+  // beyond the first level, and armed out of order
+  for (uint64_t ms : {300, 5, 12, 5, 1}) {
+    wheel->schedule_at(begin + ms * 1000, [&fired, &context, ms] {
+      fired.push_back(ms);
+      if (fired.size() == 6) {
+        context.stop();
+      }
+    });
+  }
+  wheel_timer cancelled;
+  wheel->arm_after(cancelled, 2000, [&fired] { fired.push_back(0); });
+  wheel_timer rearmed;
+  wheel->arm_after(rearmed, 2000, [&fired] { fired.push_back(0); });
+  wheel->arm_after(rearmed, 20000, [&fired] { fired.push_back(20); });
+  BOOST_CHECK(wheel->size() == 7);
+  BOOST_CHECK(cancelled.cancel());
+  BOOST_CHECK(not cancelled.cancel());
+  context.run();
+  BOOST_CHECK(steady_clock_us_since_epoch() >= begin + 300 * 1000);
+  BOOST_CHECK((fired == std::vector<uint64_t>{1, 5, 5, 12, 20, 300}));
+  BOOST_CHECK(not rearmed.armed());
+  BOOST_CHECK(wheel->size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel_past_deadline_test) {
+  // the nodes at past deadlines fire, and are freed, on the threads running
+  // the context while the others are still scheduling
+  const uint32_t num_thread = 4;
+  const uint32_t num_schedule = 20000;
+  boost::asio::io_context context;
+  auto guard = boost::asio::make_work_guard(context);
+  auto wheel = cs_new<timing_wheel>(context, 1);
+  std::atomic<uint64_t> fired(0);
+  std::vector<std::thread> runners;
+  for (uint32_t i = 0; i < num_thread; i++) {
+    runners.emplace_back([&context] { context.run(); });
+  }
+  std::vector<std::thread> schedulers;
+  for (uint32_t i = 0; i < num_thread; i++) {
+    schedulers.emplace_back([&wheel, &fired] {
+      for (uint32_t n = 0; n < num_schedule; n++) {
+        uint64_t now = steady_clock_us_since_epoch();
+        wheel->schedule_at(now - std::min<uint64_t>(now, n % 3),
+                           [&fired] { fired++; });
+      }
+    });
+  }
+  for (auto &t : schedulers) {
+    t.join();
+  }
+  while (fired.load() < num_thread * num_schedule) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  wheel->stop();
+  guard.reset();
+  context.stop();
+  for (auto &t : runners) {
+    t.join();
+  }
+  BOOST_CHECK(fired.load() == num_thread * num_schedule);
+  BOOST_CHECK(wheel->size() == 0);
+  // a stopped wheel frees the node it does not arm
+  wheel->schedule_after(0, [&fired] { fired++; });
+  BOOST_CHECK(fired.load() == num_thread * num_schedule);
+}
+
+// the messages to a zone shaped by link, sent by a node of the other zone,
+// to_node is set to a node of the shaped zone, from_node to the sender
+static ptr<net_shaper> gen_shaper(net_link_shaping link, timing_wheel &wheel,
+                                  node_id_t &to_node, node_id_t &from_node) {
+  config_option option;
+  option.num_az = 2;
+  option.set_config_share(false);
+  config conf = generate_config(option).second[0];
+  from_node = conf.node_id();
+  link.from_zone_ = conf.this_node_config().az_name();
+  for (const node_config &c : conf.node_server_list()) {
+    if (c.az_name() != link.from_zone_) {
+      link.to_zone_ = c.az_name();
+      to_node = c.node_id();
+    }
+  }
+  conf.get_test_config().add_net_shaping(link);
+  return cs_new<net_shaper>(
+      conf, [&wheel](az_id_t) -> timing_wheel & { return wheel; });
+}
+
+BOOST_AUTO_TEST_CASE(net_shaper_delay_test) {
+  boost::asio::io_context context;
+  auto guard = boost::asio::make_work_guard(context);
+  auto wheel = cs_new<timing_wheel>(context, TIMING_WHEEL_TICK_US);
+  std::thread runner([&context] { context.run(); });
+  node_id_t to_node = 0;
+  node_id_t from_node = 0;
+  net_link_shaping link;
+  link.latency_ms_ = 50;
+  ptr<net_shaper> latency = gen_shaper(link, *wheel, to_node, from_node);
+  // 8 mbps transmits one byte per microsecond
+  link.latency_ms_ = 0;
+  link.bandwidth_mbps_ = 8;
+  ptr<net_shaper> bandwidth = gen_shaper(link, *wheel, to_node, from_node);
+  std::atomic<uint64_t> latency_us(0);
+  std::atomic<uint64_t> bandwidth_us(0);
+  std::atomic<uint32_t> fired(0);
+  uint32_t shaped = 0;
+  uint64_t begin = steady_clock_us_since_epoch();
+  shaped += latency->shape(to_node, 100, [&] {
+    latency_us = steady_clock_us_since_epoch() - begin;
+    fired++;
+  });
+  for (uint32_t i = 0; i < 10; i++) {
+    shaped += bandwidth->shape(to_node, 10000, [&] {
+      bandwidth_us = steady_clock_us_since_epoch() - begin;
+      fired++;
+    });
+  }
+  BOOST_CHECK(shaped == 11);
+  // the zone of the sender is not shaped
+  BOOST_CHECK(not latency->shape(from_node, 100, [] {}));
+  while (fired.load() < shaped) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  wheel->stop();
+  guard.reset();
+  runner.join();
+  BOOST_CHECK(latency_us.load() >= 50 * 1000 - TIMING_WHEEL_TICK_US);
+  BOOST_CHECK(bandwidth_us.load() >= 100 * 1000 - TIMING_WHEEL_TICK_US);
+}
+
+BOOST_AUTO_TEST_CASE(net_shaper_order_test) {
+  // the messages sent by each thread are delivered in the order they are
+  // sent, while the jitter draws a latency per message
+  const uint32_t num_thread = 4;
+  const uint32_t num_message = 2000;
+  boost::asio::io_context context;
+  auto guard = boost::asio::make_work_guard(context);
+  auto wheel = cs_new<timing_wheel>(context, TIMING_WHEEL_TICK_US);
+  std::thread runner([&context] { context.run(); });
+  node_id_t to_node = 0;
+  node_id_t from_node = 0;
+  net_link_shaping link;
+  link.latency_ms_ = 20;
+  link.jitter_ms_ = 20;
+  link.bandwidth_mbps_ = 1000;
+  ptr<net_shaper> shaper = gen_shaper(link, *wheel, to_node, from_node);
+  std::mutex mutex;
+  std::vector<std::vector<uint32_t>> delivered(num_thread);
+  std::atomic<uint32_t> fired(0);
+  std::vector<std::thread> senders;
+  for (uint32_t t = 0; t < num_thread; t++) {
+    senders.emplace_back([&, t] {
+      for (uint32_t n = 0; n < num_message; n++) {
+        if (not shaper->shape(to_node, 100, [&, t, n] {
+              std::scoped_lock l(mutex);
+              delivered[t].push_back(n);
+              fired++;
+            })) {
+          fired++;
+        }
+      }
+    });
+  }
+  for (auto &t : senders) {
+    t.join();
+  }
+  while (fired.load() < num_thread * num_message) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  wheel->stop();
+  guard.reset();
+  runner.join();
+  for (uint32_t t = 0; t < num_thread; t++) {
+    BOOST_REQUIRE(delivered[t].size() == num_message);
+    for (uint32_t n = 0; n < num_message; n++) {
+      BOOST_CHECK(delivered[t][n] == n);
+    }
+  }
+}
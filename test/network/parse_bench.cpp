@@ -0,0 +1,117 @@
+#define BOOST_TEST_MODULE NETWORK_PARSE_BENCH
+
+#include "common/bench_harness.h"
+#include "common/byte_buffer.h"
+#include "common/ptr.hpp"
+#include "common/read_write_pb.hpp"
+#include "proto/proto.h"
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// heap allocations and time per message of parsing the messages on the hot
+// paths, by new T(), and on the arena of message_processor; the times are in
+// bench_network_parse.json
+
+std::atomic<uint64_t> num_alloc(0);
+
+void *operator new(size_t size) {
+  num_alloc.fetch_add(1, std::memory_order_relaxed);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+const uint64_t BENCH_NUM_PARSE = 100000;
+
+void fill_tuple(tuple_row *row, uint64_t id) {
+  row->set_table_id(1);
+  row->set_shard_id(1);
+  row->set_tuple_id(id);
+  row->set_tuple(std::string(128, char('a' + id % 26)));
+}
+
+tx_request gen_tx_request() {
+  tx_request req;
+  req.set_xid(1);
+  req.set_terminal_id(1);
+  for (uint64_t i = 0; i < 15; i++) {
+    tx_operation *op = req.add_operations();
+    op->set_op_type(TX_OP_READ);
+    op->set_sd_id(1);
+    fill_tuple(op->mutable_tuple_row(), i);
+  }
+  return req;
+}
+
+dsb_read_response gen_dsb_read_response() {
+  dsb_read_response res;
+  res.set_xid(1);
+  res.set_oid(1);
+  fill_tuple(res.mutable_tuple_row(), 1);
+  return res;
+}
+
+append_entries_request gen_append_entries_request() {
+  append_entries_request req;
+  req.set_term(1);
+  req.set_prev_log_index(1);
+  for (uint64_t i = 0; i < 8; i++) {
+    raft_log_entry *e = req.add_entries();
+    e->set_term(1);
+    e->set_index(i + 2);
+    e->set_repeated_tx_logs(std::string(1024, 'x'));
+  }
+  return req;
+}
+
+template<typename T>
+void bench_parse(bench_harness &harness, const std::string &name,
+                 const T &msg) {
+  byte_buffer buffer(msg.ByteSizeLong());
+  BOOST_REQUIRE(msg.SerializeToArray(buffer.data(), buffer.size()));
+  buffer.set_write_pos(buffer.size());
+
+  uint64_t alloc_heap = 0;
+  harness.run(name + "/heap", 1, BENCH_NUM_PARSE, [&](uint32_t, uint64_t n) {
+    uint64_t alloc_begin = num_alloc.load();
+    for (uint64_t i = 0; i < n; i++) {
+      buffer.set_read_pos(0);
+      ptr<T> m(new T());
+      auto r = buf_to_proto(buffer, *m);
+      BOOST_ASSERT(r);
+    }
+    alloc_heap = num_alloc.load() - alloc_begin;
+  });
+
+  uint64_t alloc_arena = 0;
+  harness.run(name + "/arena", 1, BENCH_NUM_PARSE, [&](uint32_t, uint64_t n) {
+    uint64_t alloc_begin = num_alloc.load();
+    for (uint64_t i = 0; i < n; i++) {
+      buffer.set_read_pos(0);
+      auto r = buf_to_arena_proto<T>(buffer);
+      BOOST_ASSERT(r);
+    }
+    alloc_arena = num_alloc.load() - alloc_begin;
+  });
+
+  std::cout << name << " " << buffer.size() << " bytes, allocations/message: "
+            << double(alloc_heap) / BENCH_NUM_PARSE << " -> "
+            << double(alloc_arena) / BENCH_NUM_PARSE << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(parse_bench) {
+  bench_harness harness("network_parse");
+  bench_parse(harness, "tx_request", gen_tx_request());
+  bench_parse(harness, "dsb_read_response", gen_dsb_read_response());
+  bench_parse(harness, "append_entries_request",
+              gen_append_entries_request());
+}
@@ -0,0 +1,124 @@
+#define BOOST_TEST_MODULE NETWORK_SEND_BENCH
+
+#include "common/bench_harness.h"
+#include "common/ptr.hpp"
+#include "common/read_write_pb.hpp"
+#include "network/connection.h"
+#include "proto/hello.pb.h"
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+// network throughput of connection::async_send over loopback, in bytes per
+// second and CPU time per message of the sending process; the messages are in
+// bench_network_send.json
+
+const uint64_t BENCH_NUM_MESSAGE = 500000;
+const uint64_t BENCH_NUM_BYTES = 1ull << 30;
+const uint64_t BENCH_SEND_BATCH = 1000;
+
+// the payload of hello, serialized as field 3
+ptr<const std::string> hello_payload(const std::string &str) {
+  hello h;
+  h.set_payload(str);
+  return ptr<const std::string>(cs_new<std::string>(h.SerializeAsString()));
+}
+
+// a round connects, sends num_message messages and waits for all the bytes
+// read by the peer, returns the CPU time of the round
+double send_round(size_t num_message, uint64_t total_bytes,
+                  const ptr<hello> &msg,
+                  const std::vector<ptr<const std::string>> &payload_vec) {
+  boost::asio::io_context ioc;
+  tcp::acceptor acceptor(ioc, tcp::endpoint(boost::asio::ip::make_address(
+                                                "127.0.0.1"),
+                                            0));
+  auto sock = cs_new<tcp::socket>(ioc);
+  sock->connect(acceptor.local_endpoint());
+  tcp::socket peer = acceptor.accept();
+
+  // drain the bytes sent
+  std::thread reader([&peer, total_bytes]() {
+    std::vector<char> buf(1024 * 1024);
+    uint64_t bytes = 0;
+    while (bytes < total_bytes) {
+      boost::system::error_code ec;
+      bytes += peer.read_some(boost::asio::buffer(buf), ec);
+      if (ec.failed()) {
+        break;
+      }
+    }
+  });
+
+  boost::asio::io_context::strand strand(ioc);
+  auto conn = cs_new<connection>(strand, sock, nullptr, true);
+  auto guard = boost::asio::make_work_guard(ioc);
+  std::thread runner([&ioc]() { ioc.run(); });
+
+  std::clock_t cpu_begin = std::clock();
+  for (uint64_t i = 0; i < num_message; i += BENCH_SEND_BATCH) {
+    boost::asio::post(strand, [conn, msg, payload_vec]() {
+      for (uint64_t j = 0; j < BENCH_SEND_BATCH; j++) {
+        auto r = conn->async_send(REQUEST_HELLO, msg, payload_vec);
+        BOOST_ASSERT(r);
+      }
+    });
+  }
+  reader.join();
+  std::clock_t cpu_end = std::clock();
+
+  guard.reset();
+  ioc.stop();
+  runner.join();
+  return double(cpu_end - cpu_begin) * 1000000.0 / CLOCKS_PER_SEC;
+}
+
+void bench_send(bench_harness &harness, size_t message_size,
+                bool shared_payload) {
+  std::string str(message_size, 'x');
+  auto msg = cs_new<hello>();
+  msg->set_id(1);
+  ptr<const std::string> payload = hello_payload(str);
+  std::vector<ptr<const std::string>> payload_vec;
+  if (shared_payload) {
+    payload_vec.push_back(payload);
+  } else {
+    msg->set_payload(str);
+  }
+  uint64_t message_bytes =
+      msg_hdr::size() + msg->ByteSizeLong() +
+      (shared_payload ? payload->size() : 0);
+  uint64_t num_message =
+      std::min(BENCH_NUM_MESSAGE, BENCH_NUM_BYTES / message_bytes);
+  num_message -= num_message % BENCH_SEND_BATCH;
+  uint64_t total_bytes = message_bytes * num_message;
+
+  // the CPU time of the best round
+  double cpu_us = 0;
+  std::string name = std::string(shared_payload ? "shared" : "copied") +
+                     "/size:" + std::to_string(message_size);
+  const bench_case_result &result = harness.run(
+      name, 1, num_message, [&](uint32_t, uint64_t n) {
+        double us = send_round(n, total_bytes, msg, payload_vec);
+        if (cpu_us == 0 || us < cpu_us) {
+          cpu_us = us;
+        }
+      });
+  std::cout << "message size " << message_size
+            << (shared_payload ? ", shared payload" : ", copied") << ": "
+            << uint64_t(result.ops_per_second_ * double(message_bytes) /
+                        (1 << 20))
+            << " MB/s, " << cpu_us / double(num_message)
+            << " CPU us/message" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(send_bench) {
+  bench_harness harness("network_send");
+  for (size_t size : {64, 1024, 16384}) {
+    bench_send(harness, size, false);
+    bench_send(harness, size, true);
+  }
+}
@@ -0,0 +1,161 @@
+#define BOOST_TEST_MODULE NETWORK_SHM_BENCH
+
+#include "common/bench_harness.h"
+#include "common/byte_buffer.h"
+#include "common/ptr.hpp"
+#include "common/read_write_pb.hpp"
+#include "network/shm_ring.h"
+#include "proto/hello.pb.h"
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <thread>
+
+// message rate and round trip latency of the shared memory ring, and of TCP
+// loopback with the same message framing; the results are in
+// bench_network_shm.json
+
+using boost::asio::ip::tcp;
+
+const uint64_t BENCH_NUM_MESSAGE = 1000000;
+const uint64_t BENCH_NUM_ROUND_TRIP = 100000;
+
+hello gen_hello(size_t size) {
+  hello msg;
+  msg.set_id(1);
+  msg.set_payload(std::string(size, 'x'));
+  return msg;
+}
+
+void tcp_write(tcp::socket &sock, byte_buffer &buffer, const hello &msg) {
+  buffer.reset();
+  auto r = proto_to_buf(buffer, REQUEST_HELLO, msg, nullptr);
+  BOOST_ASSERT(r);
+  boost::asio::write(sock, boost::asio::buffer(buffer.data(),
+                                               buffer.get_write_pos()));
+}
+
+void tcp_read(tcp::socket &sock, byte_buffer &buffer) {
+  msg_hdr hdr;
+  boost::asio::read(sock, boost::asio::buffer(static_cast<void *>(&hdr),
+                                              msg_hdr::size()));
+  buffer.reset();
+  buffer.resize_write_available_size(hdr.length() - msg_hdr::size());
+  boost::asio::read(sock, boost::asio::buffer(buffer.data(),
+                                              hdr.length() - msg_hdr::size()));
+}
+
+void report(const std::string &name, size_t size,
+            const bench_case_result &rate, const bench_case_result &rtt) {
+  std::cout << name << ", message size " << size << ": "
+            << uint64_t(rate.ops_per_second_) << " messages/s, round trip "
+            << rtt.ns_per_op_ / 1000.0 << " us" << std::endl;
+}
+
+void bench_shm(bench_harness &harness, size_t size) {
+  auto r1 = shm_ring::create("/tddb_bench_ring_1", SHM_RING_BYTES);
+  auto r2 = shm_ring::create("/tddb_bench_ring_2", SHM_RING_BYTES);
+  BOOST_REQUIRE(r1 && r2);
+  auto w1 = shm_ring::open("/tddb_bench_ring_1");
+  auto w2 = shm_ring::open("/tddb_bench_ring_2");
+  BOOST_REQUIRE(w1 && w2);
+  hello msg = gen_hello(size);
+  std::string suffix = "/size:" + std::to_string(size);
+
+  bench_case_result rate = harness.run(
+      "shm/send" + suffix, 1, BENCH_NUM_MESSAGE, [&](uint32_t, uint64_t n) {
+        std::thread reader([&r1, n]() {
+          byte_buffer buffer;
+          msg_hdr hdr;
+          for (uint64_t i = 0; i < n; i++) {
+            auto r = r1.value()->read(buffer, hdr);
+            BOOST_ASSERT(r);
+          }
+        });
+        for (uint64_t i = 0; i < n; i++) {
+          auto r = w1.value()->write(REQUEST_HELLO, msg);
+          BOOST_ASSERT(r);
+        }
+        reader.join();
+      });
+
+  bench_case_result rtt = harness.run(
+      "shm/round_trip" + suffix, 1, BENCH_NUM_ROUND_TRIP,
+      [&](uint32_t, uint64_t n) {
+        std::thread echo([&r1, &w2, &msg, n]() {
+          byte_buffer buffer;
+          msg_hdr hdr;
+          for (uint64_t i = 0; i < n; i++) {
+            auto r = r1.value()->read(buffer, hdr);
+            BOOST_ASSERT(r);
+            auto w = w2.value()->write(RESPONSE_HELLO, msg);
+            BOOST_ASSERT(w);
+          }
+        });
+        byte_buffer buffer;
+        msg_hdr hdr;
+        for (uint64_t i = 0; i < n; i++) {
+          auto w = w1.value()->write(REQUEST_HELLO, msg);
+          BOOST_ASSERT(w);
+          auto r = r2.value()->read(buffer, hdr);
+          BOOST_ASSERT(r);
+        }
+        echo.join();
+      });
+  report("shm", size, rate, rtt);
+}
+
+void bench_tcp(bench_harness &harness, size_t size) {
+  boost::asio::io_context ioc;
+  tcp::acceptor acceptor(
+      ioc, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+  tcp::socket sock(ioc);
+  sock.connect(acceptor.local_endpoint());
+  tcp::socket peer = acceptor.accept();
+  sock.set_option(tcp::no_delay(true));
+  peer.set_option(tcp::no_delay(true));
+  hello msg = gen_hello(size);
+  std::string suffix = "/size:" + std::to_string(size);
+
+  bench_case_result rate = harness.run(
+      "tcp/send" + suffix, 1, BENCH_NUM_MESSAGE, [&](uint32_t, uint64_t n) {
+        std::thread reader([&peer, n]() {
+          byte_buffer buffer;
+          for (uint64_t i = 0; i < n; i++) {
+            tcp_read(peer, buffer);
+          }
+        });
+        byte_buffer buffer;
+        for (uint64_t i = 0; i < n; i++) {
+          tcp_write(sock, buffer, msg);
+        }
+        reader.join();
+      });
+
+  bench_case_result rtt = harness.run(
+      "tcp/round_trip" + suffix, 1, BENCH_NUM_ROUND_TRIP,
+      [&](uint32_t, uint64_t n) {
+        std::thread echo([&peer, &msg, n]() {
+          byte_buffer buffer;
+          for (uint64_t i = 0; i < n; i++) {
+            tcp_read(peer, buffer);
+            tcp_write(peer, buffer, msg);
+          }
+        });
+        byte_buffer buffer;
+        for (uint64_t i = 0; i < n; i++) {
+          tcp_write(sock, buffer, msg);
+          tcp_read(sock, buffer);
+        }
+        echo.join();
+      });
+  report("tcp", size, rate, rtt);
+}
+
+BOOST_AUTO_TEST_CASE(shm_bench) {
+  bench_harness harness("network_shm");
+  for (size_t size : {64, 1024, 16384}) {
+    bench_shm(harness, size);
+    bench_tcp(harness, size);
+  }
+}
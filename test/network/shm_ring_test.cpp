@@ -0,0 +1,230 @@
+#define BOOST_TEST_MODULE SHM_RING_TEST
+
+#include "common/byte_buffer.h"
+#include "common/ptr.hpp"
+#include "network/shm_ring.h"
+#include "proto/hello.pb.h"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// a small ring, the records wrap every few messages
+const uint64_t TEST_RING_BYTES = 1024;
+
+static hello gen_hello(int id, size_t size) {
+  hello msg;
+  msg.set_id(id);
+  msg.set_payload(std::string(size, char('a' + id % 26)));
+  return msg;
+}
+
+static void check_read(shm_ring &ring, int id, size_t size) {
+  byte_buffer buffer;
+  msg_hdr hdr;
+  BOOST_REQUIRE(ring.read(buffer, hdr));
+  BOOST_CHECK(hdr.type() == REQUEST_HELLO);
+  hello msg;
+  BOOST_REQUIRE(msg.ParseFromArray(buffer.read_begin(),
+                                   int(buffer.get_write_pos())));
+  BOOST_CHECK(msg.id() == id);
+  BOOST_CHECK(msg.payload() == gen_hello(id, size).payload());
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_wrap_test) {
+  auto r = shm_ring::create("/tddb_test_ring_wrap", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  auto w = shm_ring::open("/tddb_test_ring_wrap");
+  BOOST_REQUIRE(w);
+  shm_ring &reader = *r.value();
+  shm_ring &writer = *w.value();
+  // the sizes of the records are not a divisor of the ring, a record which
+  // does not fit the ring end is placed after a skip record
+  for (int i = 0; i < 1000; i++) {
+    size_t size = size_t(i * 37 % 300);
+    BOOST_REQUIRE(writer.write(REQUEST_HELLO, gen_hello(i, size), false));
+    check_read(reader, i, size);
+  }
+  // fill the ring, then read all, the full rings span the ring end
+  int id = 0;
+  for (int round = 0; round < 20; round++) {
+    int begin = id;
+    while (true) {
+      size_t size = size_t(id * 13 % 120);
+      auto rw = writer.write(REQUEST_HELLO, gen_hello(id, size), false);
+      if (not rw) {
+        BOOST_CHECK(rw.error().code() == EC::EC_INSUFFICIENT_SPACE);
+        break;
+      }
+      id++;
+    }
+    BOOST_CHECK(id - begin > 1);
+    for (int i = begin; i < id; i++) {
+      check_read(reader, i, size_t(i * 13 % 120));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_mixed_size_test) {
+  auto r = shm_ring::create("/tddb_test_ring_mixed", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  auto w = shm_ring::open("/tddb_test_ring_mixed");
+  BOOST_REQUIRE(w);
+  ptr<shm_ring> reader = r.value();
+  ptr<shm_ring> writer = w.value();
+  // the sizes, larger than the ring, than a record, or small, are mixed in
+  // the messages to one peer, which are read in the order they are written
+  auto size_of = [](int id) -> size_t {
+    switch (id % 5) {
+    case 0:
+      return TEST_RING_BYTES * 3 + size_t(id);
+    case 1:
+      return TEST_RING_BYTES / 2 + size_t(id % 7);
+    default:
+      return size_t(id % 40);
+    }
+  };
+  const int num_message = 500;
+  std::vector<hello> read;
+  std::thread t([reader, &read]() {
+    byte_buffer buffer;
+    msg_hdr hdr;
+    for (int i = 0; i < num_message; i++) {
+      if (not reader->read(buffer, hdr)) {
+        break;
+      }
+      hello msg;
+      msg.ParseFromArray(buffer.read_begin(), int(buffer.get_write_pos()));
+      read.push_back(msg);
+    }
+  });
+  for (int i = 0; i < num_message; i++) {
+    BOOST_REQUIRE(writer->write(REQUEST_HELLO, gen_hello(i, size_of(i))));
+  }
+  t.join();
+  BOOST_REQUIRE(read.size() == size_t(num_message));
+  for (int i = 0; i < num_message; i++) {
+    BOOST_CHECK(read[i].id() == i);
+    BOOST_CHECK(read[i].payload() == gen_hello(i, size_of(i)).payload());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_stall_test) {
+  auto r = shm_ring::create("/tddb_test_ring_stall", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  auto w = shm_ring::open("/tddb_test_ring_stall");
+  BOOST_REQUIRE(w);
+  shm_ring &writer = *w.value();
+  hello msg = gen_hello(1, 100);
+  while (writer.write(REQUEST_HELLO, msg, false)) {
+  }
+  // the reader does not read, a waiting writer gives up
+  auto rw = writer.write(REQUEST_HELLO, msg, true);
+  BOOST_CHECK(not rw);
+  BOOST_CHECK(rw.error().code() == EC::EC_INSUFFICIENT_SPACE);
+  BOOST_CHECK(not writer.is_closed());
+  // a split message is closed in the middle of it, its records written are
+  // not followed by another message
+  auto r2 = shm_ring::create("/tddb_test_ring_split", TEST_RING_BYTES);
+  BOOST_REQUIRE(r2);
+  auto w2 = shm_ring::open("/tddb_test_ring_split");
+  BOOST_REQUIRE(w2);
+  auto rs = w2.value()->write(REQUEST_HELLO, gen_hello(2, TEST_RING_BYTES * 2));
+  BOOST_CHECK(not rs);
+  BOOST_CHECK(rs.error().code() == EC::EC_NET_UNCONNECTED);
+  BOOST_CHECK(w2.value()->is_closed());
+  byte_buffer buffer;
+  msg_hdr hdr;
+  BOOST_CHECK(not r2.value()->read(buffer, hdr));
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_close_reader_test) {
+  auto r = shm_ring::create("/tddb_test_ring_close_r", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  ptr<shm_ring> reader = r.value();
+  result<void> rr = outcome::success();
+  std::thread t([reader, &rr]() {
+    byte_buffer buffer;
+    msg_hdr hdr;
+    // blocks on the empty ring
+    rr = reader->read(buffer, hdr);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto w = shm_ring::open("/tddb_test_ring_close_r");
+  BOOST_REQUIRE(w);
+  w.value()->close();
+  t.join();
+  BOOST_CHECK(not rr);
+  BOOST_CHECK(rr.error().code() == EC::EC_NET_UNCONNECTED);
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_close_writer_test) {
+  auto r = shm_ring::create("/tddb_test_ring_close_w", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  auto w = shm_ring::open("/tddb_test_ring_close_w");
+  BOOST_REQUIRE(w);
+  ptr<shm_ring> writer = w.value();
+  hello msg = gen_hello(1, 100);
+  while (writer->write(REQUEST_HELLO, msg, false)) {
+  }
+  result<void> rw = outcome::success();
+  std::thread t([writer, &msg, &rw]() {
+    // blocks on the full ring
+    rw = writer->write(REQUEST_HELLO, msg, true);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  r.value()->close();
+  t.join();
+  BOOST_CHECK(not rw);
+  BOOST_CHECK(rw.error().code() == EC::EC_NET_UNCONNECTED);
+  BOOST_CHECK(writer->is_closed());
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_restart_test) {
+  auto r1 = shm_ring::create("/tddb_test_ring_restart", TEST_RING_BYTES);
+  BOOST_REQUIRE(r1);
+  auto w1 = shm_ring::open("/tddb_test_ring_restart");
+  BOOST_REQUIRE(w1);
+  BOOST_CHECK(w1.value()->is_current());
+  // the reader crashes without closing the ring and creates it again
+  auto r2 = shm_ring::create("/tddb_test_ring_restart", TEST_RING_BYTES);
+  BOOST_REQUIRE(r2);
+  BOOST_CHECK(not w1.value()->is_closed());
+  BOOST_CHECK(not w1.value()->is_current());
+  auto w2 = shm_ring::open("/tddb_test_ring_restart");
+  BOOST_REQUIRE(w2);
+  BOOST_CHECK(w2.value()->is_current());
+  BOOST_REQUIRE(w2.value()->write(REQUEST_HELLO, gen_hello(7, 10), false));
+  check_read(*r2.value(), 7, 10);
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_write_from_test) {
+  auto r = shm_ring::create("/tddb_test_ring_write_from", TEST_RING_BYTES);
+  BOOST_REQUIRE(r);
+  auto w = shm_ring::open("/tddb_test_ring_write_from");
+  BOOST_REQUIRE(w);
+  shm_ring &reader = *r.value();
+  shm_ring &writer = *w.value();
+  // a message larger than the ring is written in parts as the reader frees
+  // the ring, the writer never waits
+  std::string data;
+  BOOST_REQUIRE(shm_ring::serialize(REQUEST_HELLO,
+                                    gen_hello(3, TEST_RING_BYTES * 3), data));
+  uint64_t offset = 0;
+  auto rw = writer.write_from(data, offset);
+  BOOST_CHECK(not rw);
+  BOOST_CHECK(rw.error().code() == EC::EC_INSUFFICIENT_SPACE);
+  BOOST_CHECK(offset > 0 && offset < data.size());
+  BOOST_CHECK(not writer.is_closed());
+  std::thread t([&reader]() { check_read(reader, 3, TEST_RING_BYTES * 3); });
+  while (not writer.write_from(data, offset)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  t.join();
+  BOOST_CHECK(offset == data.size());
+  // a small message is one record
+  BOOST_REQUIRE(shm_ring::serialize(REQUEST_HELLO, gen_hello(4, 10), data));
+  offset = 0;
+  BOOST_REQUIRE(writer.write_from(data, offset));
+  check_read(reader, 4, 10);
+}
@@ -0,0 +1,124 @@
+#define BOOST_TEST_MODULE NETWORK_TIMER_BENCH
+
+#include "common/bench_harness.h"
+#include "common/ptr.hpp"
+#include "common/utils.h"
+#include "network/timing_wheel.h"
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// timer churn of the concurrent transactions, every transaction arms its
+// timeout, re-arms it on every operation and cancels it when it ends;
+// steady_timer per transaction, a new steady_timer per re-arm (as the lock
+// waits did), and timing_wheel with the node in the transaction; the timer
+// ops are in bench_network_timer.json
+
+const uint64_t BENCH_NUM_TX = 10000;
+const uint64_t BENCH_NUM_OPS = 20;
+const uint64_t BENCH_TIMEOUT_MS = 500;
+const uint64_t BENCH_FIRE_MS = 100;
+// arm, the re-arms and cancel of a transaction
+const uint64_t BENCH_TIMER_OPS = BENCH_NUM_TX * (BENCH_NUM_OPS + 1);
+
+struct tx_steady_timer {
+  explicit tx_steady_timer(boost::asio::io_context &c) : timer_(c) {}
+
+  boost::asio::steady_timer timer_;
+};
+
+struct tx_wheel_timer {
+  wheel_timer timer_;
+};
+
+void bench_steady_timer() {
+  boost::asio::io_context context;
+  std::vector<ptr<tx_steady_timer>> txs;
+  for (uint64_t i = 0; i < BENCH_NUM_TX; i++) {
+    txs.push_back(cs_new<tx_steady_timer>(context));
+  }
+  for (uint64_t op = 0; op < BENCH_NUM_OPS; op++) {
+    for (ptr<tx_steady_timer> &tx : txs) {
+      // re-arm cancels the wait pending
+      tx->timer_.expires_after(std::chrono::milliseconds(BENCH_TIMEOUT_MS));
+      tx->timer_.async_wait([](const boost::system::error_code &) {});
+    }
+  }
+  for (ptr<tx_steady_timer> &tx : txs) {
+    tx->timer_.cancel();
+  }
+  context.run();
+}
+
+void bench_steady_timer_per_arm() {
+  boost::asio::io_context context;
+  std::vector<ptr<boost::asio::steady_timer>> txs(BENCH_NUM_TX);
+  for (uint64_t op = 0; op < BENCH_NUM_OPS; op++) {
+    for (ptr<boost::asio::steady_timer> &tx : txs) {
+      if (tx) {
+        tx->cancel();
+      }
+      tx.reset(new boost::asio::steady_timer(
+          context, std::chrono::milliseconds(BENCH_TIMEOUT_MS)));
+      tx->async_wait([tx](const boost::system::error_code &) {});
+    }
+  }
+  for (ptr<boost::asio::steady_timer> &tx : txs) {
+    tx->cancel();
+  }
+  context.run();
+}
+
+void bench_timing_wheel() {
+  boost::asio::io_context context;
+  auto wheel = cs_new<timing_wheel>(context, TIMING_WHEEL_TICK_US);
+  std::vector<ptr<tx_wheel_timer>> txs;
+  for (uint64_t i = 0; i < BENCH_NUM_TX; i++) {
+    txs.push_back(cs_new<tx_wheel_timer>());
+  }
+  for (uint64_t op = 0; op < BENCH_NUM_OPS; op++) {
+    for (ptr<tx_wheel_timer> &tx : txs) {
+      wheel->arm_after(tx->timer_, BENCH_TIMEOUT_MS * 1000, [] {});
+    }
+  }
+  for (ptr<tx_wheel_timer> &tx : txs) {
+    tx->timer_.cancel();
+  }
+  BOOST_ASSERT(wheel->size() == 0);
+  context.run();
+}
+
+// all the timeouts expire, the latency of firing, printed only
+void bench_fire() {
+  boost::asio::io_context context;
+  auto wheel = cs_new<timing_wheel>(context, TIMING_WHEEL_TICK_US);
+  std::vector<ptr<tx_wheel_timer>> txs;
+  uint64_t begin_us = steady_clock_us_since_epoch();
+  uint64_t late_us = 0;
+  uint64_t fired = 0;
+  for (uint64_t i = 0; i < BENCH_NUM_TX; i++) {
+    txs.push_back(cs_new<tx_wheel_timer>());
+    uint64_t deadline = begin_us + (i % BENCH_FIRE_MS + 1) * 1000;
+    wheel->arm_at(txs.back()->timer_, deadline, [deadline, &late_us, &fired] {
+      late_us += steady_clock_us_since_epoch() - deadline;
+      fired++;
+    });
+  }
+  context.run();
+  BOOST_CHECK(fired == BENCH_NUM_TX);
+  std::cout << "timing_wheel fired " << fired << " timeouts, late "
+            << double(late_us) / double(fired) << " us on average" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(timer_bench) {
+  bench_harness harness("network_timer");
+  harness.run("steady_timer/per_transaction", 1, BENCH_TIMER_OPS,
+              [](uint32_t, uint64_t) { bench_steady_timer(); });
+  harness.run("steady_timer/per_arm", 1, BENCH_TIMER_OPS,
+              [](uint32_t, uint64_t) { bench_steady_timer_per_arm(); });
+  harness.run("timing_wheel", 1, BENCH_TIMER_OPS,
+              [](uint32_t, uint64_t) { bench_timing_wheel(); });
+  bench_fire();
+}
@@ -0,0 +1,96 @@
+#define BOOST_TEST_MODULE STORE_TEST
+
+#include "common/config.h"
+#include "common/ptr.hpp"
+#include "kv/rocks_store.h"
+#include "kv/tkrzw_store.h"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+const table_id_t SCAN_TABLE = 1;
+const tuple_id_t NUM_TUPLE = 100;
+
+static config gen_store_config(const std::string &name) {
+  boost::filesystem::path dir = boost::filesystem::temp_directory_path();
+  dir.append(name + "_" + boost::filesystem::unique_path().string());
+  config conf;
+  conf.set_db_path(dir.string());
+  return conf;
+}
+
+// the tuple ids of table_id a scan returns, in small chunks
+static std::vector<tuple_id_t> scan_ids(store &s, table_id_t table_id,
+                                        tuple_id_t lower, tuple_id_t upper) {
+  std::vector<tuple_id_t> ids;
+  auto r = s.create_scan(table_id, lower, upper);
+  BOOST_REQUIRE(r);
+  bool done = false;
+  while (not done) {
+    dsb_snapshot_chunk chunk;
+    auto rc = r.value()->next_chunk(64, chunk);
+    BOOST_REQUIRE(rc);
+    done = rc.value();
+    for (const tuple_row &row : chunk.rows()) {
+      BOOST_CHECK(row.table_id() == table_id);
+      BOOST_CHECK(row.tuple() == std::to_string(row.tuple_id()));
+      ids.push_back(row.tuple_id());
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+static std::vector<tuple_id_t> id_range(tuple_id_t lower, tuple_id_t upper) {
+  std::vector<tuple_id_t> ids;
+  for (tuple_id_t id = lower; id < upper; id++) {
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+static void check_scan(store &s) {
+  // the rows of the tables next to SCAN_TABLE are not scanned
+  for (table_id_t table_id = SCAN_TABLE - 1; table_id <= SCAN_TABLE + 1;
+       table_id++) {
+    for (tuple_id_t id = 1; id <= NUM_TUPLE; id++) {
+      BOOST_REQUIRE(s.put(table_id, id, tuple_pb(std::to_string(id))));
+    }
+  }
+  // [lower, upper)
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, 10, 20) == id_range(10, 20));
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, 1, 2) == id_range(1, 2));
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, 20, 20).empty());
+  // no upper bound when upper is 0
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, 90, 0) == id_range(90, NUM_TUPLE + 1));
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, 0, 0) == id_range(1, NUM_TUPLE + 1));
+  BOOST_CHECK(scan_ids(s, SCAN_TABLE, NUM_TUPLE + 1, 0).empty());
+  auto r = s.create_scan(MAX_TABLES, 0, 0);
+  BOOST_CHECK(not r);
+  BOOST_CHECK(r.error().code() == EC::EC_UNKNOWN_TABLE_ID);
+}
+
+#ifdef DB_TYPE_ROCKS
+BOOST_AUTO_TEST_CASE(rocks_store_scan_test) {
+  config conf = gen_store_config("rocks_store_scan");
+  {
+    rocks_store s(conf);
+    check_scan(s);
+    s.close();
+  }
+  boost::filesystem::remove_all(conf.db_path());
+}
+#endif // DB_TYPE_ROCKS
+
+#ifdef DB_TYPE_TK
+BOOST_AUTO_TEST_CASE(tkrzw_store_scan_test) {
+  config conf = gen_store_config("tkrzw_store_scan");
+  {
+    tkrzw_store s(conf);
+    check_scan(s);
+    s.close();
+  }
+  boost::filesystem::remove_all(conf.db_path());
+}
+#endif // DB_TYPE_TK